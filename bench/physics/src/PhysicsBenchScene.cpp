@@ -0,0 +1,200 @@
+#include "PhysicsBenchScene.h"
+
+// Deterministic random number in [0, 1), so every run builds the same scene
+static float PhysicsBenchRandom(unsigned int *state)
+{
+    *state = *state * 1664525u + 1013904223u;
+    return (*state >> 8) / 16777216.0f;
+}
+
+PhysicsBenchScene::PhysicsBenchScene() : world(0)
+{
+    world.addForceField(
+        ds_phys::ForceField::uniform(ds_math::Vector3(0.0f, -9.8f, 0.0f)));
+}
+
+void PhysicsBenchScene::addPlane(const ds_math::Vector3 &direction,
+                                 ds_math::scalar offset)
+{
+    ds_phys::CollisionPlane *plane = new ds_phys::CollisionPlane();
+    plane->direction = ds_math::Vector3::Normalize(direction);
+    plane->offset = offset;
+    world.addCollisionPrimitive(
+        std::unique_ptr<ds_phys::CollisionPrimitive>(plane));
+}
+
+ds_phys::RigidBody *PhysicsBenchScene::addSphere(
+    const ds_math::Vector3 &position, ds_math::scalar radius)
+{
+    ds_phys::CollisionSphere *sphere = new ds_phys::CollisionSphere();
+    sphere->radius = radius;
+
+    ds_math::scalar inertia = 0.4f * radius * radius;
+    return addBody(new ds_phys::RigidBody(), sphere,
+                   ds_math::Vector3(inertia, inertia, inertia), position);
+}
+
+ds_phys::RigidBody *PhysicsBenchScene::addBox(const ds_math::Vector3 &position,
+                                              const ds_math::Vector3 &halfSize)
+{
+    ds_phys::CollisionBox *box = new ds_phys::CollisionBox();
+    box->halfSize = halfSize;
+
+    ds_math::Vector3 squared(halfSize.x * halfSize.x, halfSize.y * halfSize.y,
+                             halfSize.z * halfSize.z);
+    ds_math::Vector3 inertia(squared.y + squared.z, squared.x + squared.z,
+                             squared.x + squared.y);
+    return addBody(new ds_phys::RigidBody(), box, inertia * (1.0f / 3.0f),
+                   position);
+}
+
+ds_phys::RigidBody *
+PhysicsBenchScene::addCapsule(const ds_math::Vector3 &position,
+                              const ds_math::Quaternion &orientation,
+                              ds_math::scalar radius,
+                              ds_math::scalar height)
+{
+    ds_phys::CollisionCapsule *capsule = new ds_phys::CollisionCapsule();
+    capsule->radius = radius;
+    capsule->height = height;
+
+    // Treated as a cylinder as long as the whole capsule
+    ds_math::scalar length = height + 2.0f * radius;
+    ds_math::scalar side = (3.0f * radius * radius + length * length) / 12.0f;
+    ds_phys::RigidBody *body = new ds_phys::RigidBody();
+    body->setOrientation(orientation);
+    return addBody(body, capsule,
+                   ds_math::Vector3(side, 0.5f * radius * radius, side),
+                   position);
+}
+
+ds_phys::RigidBody *
+PhysicsBenchScene::addBody(ds_phys::RigidBody *body,
+                           ds_phys::CollisionPrimitive *primitive,
+                           const ds_math::Vector3 &inertia,
+                           const ds_math::Vector3 &position)
+{
+    body->setMass(1.0f);
+    body->setInertiaTensor(inertia);
+    body->setPosition(position);
+    body->calculateDerivedData();
+
+    primitive->body = body;
+    body->addCollisionPrimitive(primitive);
+
+    world.addRigidBody(body);
+    world.addCollisionPrimitive(
+        std::unique_ptr<ds_phys::CollisionPrimitive>(primitive));
+    bodies.push_back(std::unique_ptr<ds_phys::RigidBody>(body));
+
+    return body;
+}
+
+void PhysicsBenchBoxPyramid(PhysicsBenchScene *scene, unsigned int size)
+{
+    scene->addPlane(ds_math::Vector3(0.0f, 1.0f, 0.0f), 0.0f);
+
+    // Small gaps between the boxes, so that they settle onto each other
+    const ds_math::Vector3 halfSize(0.5f, 0.5f, 0.5f);
+    for (unsigned int layer = 0; layer < size; ++layer)
+    {
+        unsigned int width = size - layer;
+        for (unsigned int i = 0; i < width; ++i)
+        {
+            scene->addBox(ds_math::Vector3((i - 0.5f * (width - 1)) * 1.05f,
+                                           0.5f + layer * 1.01f, 0.0f),
+                          halfSize);
+        }
+    }
+}
+
+void PhysicsBenchSphereRain(PhysicsBenchScene *scene, unsigned int size)
+{
+    scene->addPlane(ds_math::Vector3(0.0f, 1.0f, 0.0f), 0.0f);
+
+    unsigned int state = 1;
+    const unsigned int side = 10;
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        unsigned int layer = i / (side * side);
+        unsigned int x = i % side;
+        unsigned int z = (i / side) % side;
+
+        // Jittered so that the spheres don't land squarely on each other
+        ds_math::Vector3 jitter(PhysicsBenchRandom(&state) - 0.5f, 0.0f,
+                                PhysicsBenchRandom(&state) - 0.5f);
+        scene->addSphere(ds_math::Vector3(x * 1.5f, 5.0f + layer * 2.0f,
+                                          z * 1.5f) +
+                             jitter * 0.5f,
+                         0.5f);
+    }
+}
+
+void PhysicsBenchCapsulePile(PhysicsBenchScene *scene, unsigned int size)
+{
+    // Ground and four walls around a pit 8 units across
+    scene->addPlane(ds_math::Vector3(0.0f, 1.0f, 0.0f), 0.0f);
+    scene->addPlane(ds_math::Vector3(1.0f, 0.0f, 0.0f), -4.0f);
+    scene->addPlane(ds_math::Vector3(-1.0f, 0.0f, 0.0f), -4.0f);
+    scene->addPlane(ds_math::Vector3(0.0f, 0.0f, 1.0f), -4.0f);
+    scene->addPlane(ds_math::Vector3(0.0f, 0.0f, -1.0f), -4.0f);
+
+    unsigned int state = 1;
+    const unsigned int side = 5;
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        unsigned int layer = i / (side * side);
+        unsigned int x = i % side;
+        unsigned int z = (i / side) % side;
+
+        ds_math::Vector3 axis(PhysicsBenchRandom(&state) - 0.5f,
+                              PhysicsBenchRandom(&state) - 0.5f,
+                              PhysicsBenchRandom(&state) - 0.5f);
+        ds_math::scalar angle = PhysicsBenchRandom(&state) * 3.14159f;
+        scene->addCapsule(
+            ds_math::Vector3(x * 1.5f - 3.0f, 2.0f + layer * 1.5f,
+                             z * 1.5f - 3.0f),
+            ds_math::Quaternion::CreateFromAxisAngle(
+                ds_math::Vector3::Normalize(axis + ds_math::Vector3(0.01f)),
+                angle),
+            0.3f, 0.8f);
+    }
+}
+
+void PhysicsBenchPlaneBodies(PhysicsBenchScene *scene, unsigned int size)
+{
+    scene->addPlane(ds_math::Vector3(0.0f, 1.0f, 0.0f), 0.0f);
+
+    unsigned int side = 1;
+    while (side * side < size)
+    {
+        ++side;
+    }
+
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        ds_math::Vector3 position((i % side) * 2.0f, 0.0f, (i / side) * 2.0f);
+        if (i % 2 == 0)
+        {
+            scene->addSphere(position + ds_math::Vector3(0.0f, 0.5f, 0.0f),
+                             0.5f);
+        }
+        else
+        {
+            scene->addBox(position + ds_math::Vector3(0.0f, 0.5f, 0.0f),
+                          ds_math::Vector3(0.5f, 0.5f, 0.5f));
+        }
+    }
+}
+
+const PhysicsBenchSceneInfo *PhysicsBenchGetScenes(unsigned int *count)
+{
+    static const PhysicsBenchSceneInfo scenes[] = {
+        {"box_pyramid", PhysicsBenchBoxPyramid, 20},
+        {"sphere_rain", PhysicsBenchSphereRain, 1000},
+        {"capsule_pile", PhysicsBenchCapsulePile, 200},
+        {"plane_bodies", PhysicsBenchPlaneBodies, 5000}};
+
+    *count = sizeof(scenes) / sizeof(scenes[0]);
+    return scenes;
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "engine/system/physics/PhysicsWorld.h"
+
+/**
+ * Physics world with gravity, owning the bodies added to it.
+ */
+struct PhysicsBenchScene
+{
+    PhysicsBenchScene();
+
+    /**
+     * Add a static plane, everything behind it is solid.
+     *
+     * @param   direction   const ds_math::Vector3 &, plane normal.
+     * @param   offset      ds_math::scalar, distance of the plane from the
+     * origin along its normal.
+     */
+    void addPlane(const ds_math::Vector3 &direction, ds_math::scalar offset);
+
+    /**
+     * Add a sphere with unit mass.
+     *
+     * @param   position   const ds_math::Vector3 &, centre of the sphere.
+     * @param   radius     ds_math::scalar, radius.
+     * @return             ds_phys::RigidBody *, body of the sphere.
+     */
+    ds_phys::RigidBody *addSphere(const ds_math::Vector3 &position,
+                                  ds_math::scalar radius);
+
+    /**
+     * Add a box with unit mass.
+     *
+     * @param   position   const ds_math::Vector3 &, centre of the box.
+     * @param   halfSize   const ds_math::Vector3 &, half its size along each
+     * axis.
+     * @return             ds_phys::RigidBody *, body of the box.
+     */
+    ds_phys::RigidBody *addBox(const ds_math::Vector3 &position,
+                               const ds_math::Vector3 &halfSize);
+
+    /**
+     * Add a capsule with unit mass.
+     *
+     * @param   position      const ds_math::Vector3 &, centre of the capsule.
+     * @param   orientation   const ds_math::Quaternion &, orientation, the
+     * capsule runs along its local y axis.
+     * @param   radius        ds_math::scalar, radius.
+     * @param   height        ds_math::scalar, distance between the centres
+     * of its ends.
+     * @return                ds_phys::RigidBody *, body of the capsule.
+     */
+    ds_phys::RigidBody *addCapsule(const ds_math::Vector3 &position,
+                                   const ds_math::Quaternion &orientation,
+                                   ds_math::scalar radius,
+                                   ds_math::scalar height);
+
+    ds_phys::PhysicsWorld world;
+    std::vector<std::unique_ptr<ds_phys::RigidBody>> bodies;
+
+private:
+    /**
+     * Set up a body with unit mass and add it and its primitive to the
+     * world.
+     *
+     * @param   body        ds_phys::RigidBody *, body.
+     * @param   primitive   ds_phys::CollisionPrimitive *, primitive of the
+     * body.
+     * @param   inertia     const ds_math::Vector3 &, inertia tensor products.
+     * @param   position    const ds_math::Vector3 &, position of the body.
+     * @return              ds_phys::RigidBody *, the body.
+     */
+    ds_phys::RigidBody *addBody(ds_phys::RigidBody *body,
+                                ds_phys::CollisionPrimitive *primitive,
+                                const ds_math::Vector3 &inertia,
+                                const ds_math::Vector3 &position);
+};
+
+/**
+ * Fill a scene, the size sets how many bodies it has.
+ */
+typedef void (*PhysicsBenchSceneBuilder)(PhysicsBenchScene *scene,
+                                         unsigned int size);
+
+/**
+ * Standard scene the benchmark can step.
+ */
+struct PhysicsBenchSceneInfo
+{
+    /** Name of the scene, as given on the command line and reported. */
+    const char *name;
+
+    /** Builds the scene. */
+    PhysicsBenchSceneBuilder build;
+
+    /** Size used unless one is given on the command line. */
+    unsigned int defaultSize;
+};
+
+/**
+ * Pyramid of boxes resting on the ground, size boxes along its base.
+ */
+void PhysicsBenchBoxPyramid(PhysicsBenchScene *scene, unsigned int size);
+
+/**
+ * Size spheres falling in layers onto the ground.
+ */
+void PhysicsBenchSphereRain(PhysicsBenchScene *scene, unsigned int size);
+
+/**
+ * Size capsules in random orientations dropped into a pit walled by
+ * planes.
+ */
+void PhysicsBenchCapsulePile(PhysicsBenchScene *scene, unsigned int size);
+
+/**
+ * Size spheres and boxes spread out and resting on the ground, most of
+ * them not touching each other.
+ */
+void PhysicsBenchPlaneBodies(PhysicsBenchScene *scene, unsigned int size);
+
+/**
+ * Get the standard scenes.
+ *
+ * @param   count   unsigned int *, set to the number of scenes.
+ * @return          const PhysicsBenchSceneInfo *, scenes.
+ */
+const PhysicsBenchSceneInfo *PhysicsBenchGetScenes(unsigned int *count);
@@ -0,0 +1,295 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "PhysicsBenchScene.h"
+
+/**
+ * Options given on the command line.
+ */
+struct PhysicsBenchOptions
+{
+    /** Scene to run, empty to run every scene. */
+    std::string scene;
+
+    /** Number of frames each scene is stepped for. */
+    unsigned int frames;
+
+    /** Size of each scene, 0 to use the scene's default. */
+    unsigned int size;
+
+    /** Number of workers resolving islands, 0 to keep the default. */
+    unsigned int workers;
+
+    /** Contact solver to use. */
+    ds_phys::SolverMode solver;
+
+    /** File the results are written to, empty to write to stdout. */
+    std::string output;
+};
+
+/**
+ * Mean and largest of a value over the frames of a run.
+ */
+struct PhysicsBenchSummary
+{
+    double mean;
+    double max;
+};
+
+/**
+ * Measurements from stepping one scene.
+ */
+struct PhysicsBenchResult
+{
+    const char *name;
+    unsigned int size;
+    unsigned int bodies;
+    unsigned int awakeBodies;
+    PhysicsBenchSummary stepTime;
+    double stepTimeP99;
+    PhysicsBenchSummary contacts;
+    PhysicsBenchSummary islands;
+    PhysicsBenchSummary velocityIterations;
+    PhysicsBenchSummary positionIterations;
+};
+
+static PhysicsBenchSummary PhysicsBenchSummarize(const std::vector<double> &v)
+{
+    PhysicsBenchSummary summary = {0.0, 0.0};
+    for (unsigned int i = 0; i < v.size(); ++i)
+    {
+        summary.mean += v[i];
+        summary.max = std::max(summary.max, v[i]);
+    }
+    if (!v.empty())
+    {
+        summary.mean /= v.size();
+    }
+    return summary;
+}
+
+// Value below which the given fraction of the values lie
+static double PhysicsBenchPercentile(std::vector<double> v, double fraction)
+{
+    if (v.empty())
+    {
+        return 0.0;
+    }
+
+    std::sort(v.begin(), v.end());
+    size_t index = (size_t)(fraction * v.size());
+    return v[std::min(index, v.size() - 1)];
+}
+
+static PhysicsBenchResult PhysicsBenchRun(const PhysicsBenchSceneInfo &info,
+                                          const PhysicsBenchOptions &options)
+{
+    PhysicsBenchScene scene;
+    scene.world.setSolverMode(options.solver);
+    if (options.workers > 0)
+    {
+        scene.world.setWorkerCount(options.workers);
+    }
+
+    PhysicsBenchResult result;
+    result.name = info.name;
+    result.size = options.size > 0 ? options.size : info.defaultSize;
+    info.build(&scene, result.size);
+
+    std::vector<double> stepTimes, contacts, islands, velocityIterations,
+        positionIterations;
+    for (unsigned int frame = 0; frame < options.frames; ++frame)
+    {
+        auto start = std::chrono::steady_clock::now();
+        scene.world.startFrame();
+        scene.world.stepSimulation(1.0f / 60.0f);
+        auto end = std::chrono::steady_clock::now();
+
+        const ds_phys::SolverStats &solverStats =
+            scene.world.getSolverStats();
+        stepTimes.push_back(
+            std::chrono::duration<double, std::milli>(end - start).count());
+        contacts.push_back(scene.world.getContactStats().contactCount);
+        islands.push_back(solverStats.islandCount);
+        velocityIterations.push_back(solverStats.velocityIterations);
+        positionIterations.push_back(solverStats.positionIterations);
+    }
+
+    result.bodies = (unsigned int)scene.bodies.size();
+    result.awakeBodies = 0;
+    for (unsigned int i = 0; i < scene.bodies.size(); ++i)
+    {
+        result.awakeBodies += scene.bodies[i]->getAwake() ? 1 : 0;
+    }
+    result.stepTime = PhysicsBenchSummarize(stepTimes);
+    result.stepTimeP99 = PhysicsBenchPercentile(stepTimes, 0.99);
+    result.contacts = PhysicsBenchSummarize(contacts);
+    result.islands = PhysicsBenchSummarize(islands);
+    result.velocityIterations = PhysicsBenchSummarize(velocityIterations);
+    result.positionIterations = PhysicsBenchSummarize(positionIterations);
+
+    return result;
+}
+
+static void PhysicsBenchWriteSummary(FILE *file,
+                                     const char *name,
+                                     const PhysicsBenchSummary &summary,
+                                     const char *separator)
+{
+    fprintf(file, "      \"%s\": {\"mean\": %.4f, \"max\": %.4f}%s\n", name,
+            summary.mean, summary.max, separator);
+}
+
+static void PhysicsBenchWrite(FILE *file,
+                              const PhysicsBenchOptions &options,
+                              const std::vector<PhysicsBenchResult> &results)
+{
+    fprintf(file, "{\n");
+    fprintf(file, "  \"frames\": %u,\n", options.frames);
+    fprintf(file, "  \"solver\": \"%s\",\n",
+            options.solver == ds_phys::SolverMode::SequentialImpulse
+                ? "impulse"
+                : "resolver");
+    fprintf(file, "  \"scenes\": [\n");
+    for (unsigned int i = 0; i < results.size(); ++i)
+    {
+        const PhysicsBenchResult &result = results[i];
+        fprintf(file, "    {\n");
+        fprintf(file, "      \"name\": \"%s\",\n", result.name);
+        fprintf(file, "      \"size\": %u,\n", result.size);
+        fprintf(file, "      \"bodies\": %u,\n", result.bodies);
+        fprintf(file, "      \"awake_bodies\": %u,\n", result.awakeBodies);
+        fprintf(file,
+                "      \"step_ms\": {\"mean\": %.4f, \"p99\": %.4f, "
+                "\"max\": %.4f},\n",
+                result.stepTime.mean, result.stepTimeP99, result.stepTime.max);
+        PhysicsBenchWriteSummary(file, "contacts", result.contacts, ",");
+        PhysicsBenchWriteSummary(file, "islands", result.islands, ",");
+        PhysicsBenchWriteSummary(file, "velocity_iterations",
+                                 result.velocityIterations, ",");
+        PhysicsBenchWriteSummary(file, "position_iterations",
+                                 result.positionIterations, "");
+        fprintf(file, "    }%s\n", i + 1 < results.size() ? "," : "");
+    }
+    fprintf(file, "  ]\n");
+    fprintf(file, "}\n");
+}
+
+// Get the value of a --flag=value argument, nullptr if it's another flag
+static const char *PhysicsBenchFlag(const char *arg, const char *flag)
+{
+    size_t length = strlen(flag);
+    if (strncmp(arg, flag, length) == 0 && arg[length] == '=')
+    {
+        return arg + length + 1;
+    }
+    return nullptr;
+}
+
+static void PhysicsBenchUsage(const char *program)
+{
+    unsigned int count;
+    const PhysicsBenchSceneInfo *scenes = PhysicsBenchGetScenes(&count);
+
+    fprintf(stderr,
+            "usage: %s [--scene=NAME] [--frames=N] [--size=N] "
+            "[--workers=N] [--solver=impulse|resolver] [--output=FILE]\n",
+            program);
+    fprintf(stderr, "scenes:");
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        fprintf(stderr, " %s", scenes[i].name);
+    }
+    fprintf(stderr, "\n");
+}
+
+int main(int argc, char **argv)
+{
+    PhysicsBenchOptions options;
+    options.frames = 600;
+    options.size = 0;
+    options.workers = 0;
+    options.solver = ds_phys::SolverMode::MostSevereFirst;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *value;
+        if ((value = PhysicsBenchFlag(argv[i], "--scene")))
+        {
+            options.scene = value;
+        }
+        else if ((value = PhysicsBenchFlag(argv[i], "--frames")))
+        {
+            options.frames = (unsigned int)strtoul(value, nullptr, 10);
+        }
+        else if ((value = PhysicsBenchFlag(argv[i], "--size")))
+        {
+            options.size = (unsigned int)strtoul(value, nullptr, 10);
+        }
+        else if ((value = PhysicsBenchFlag(argv[i], "--workers")))
+        {
+            options.workers = (unsigned int)strtoul(value, nullptr, 10);
+        }
+        else if ((value = PhysicsBenchFlag(argv[i], "--solver")) &&
+                 (strcmp(value, "impulse") == 0 ||
+                  strcmp(value, "resolver") == 0))
+        {
+            options.solver = strcmp(value, "impulse") == 0
+                                 ? ds_phys::SolverMode::SequentialImpulse
+                                 : ds_phys::SolverMode::MostSevereFirst;
+        }
+        else if ((value = PhysicsBenchFlag(argv[i], "--output")))
+        {
+            options.output = value;
+        }
+        else
+        {
+            PhysicsBenchUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    unsigned int count;
+    const PhysicsBenchSceneInfo *scenes = PhysicsBenchGetScenes(&count);
+
+    std::vector<PhysicsBenchResult> results;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        if (options.scene.empty() || options.scene == scenes[i].name)
+        {
+            results.push_back(PhysicsBenchRun(scenes[i], options));
+        }
+    }
+
+    if (results.empty())
+    {
+        fprintf(stderr, "unknown scene: %s\n", options.scene.c_str());
+        PhysicsBenchUsage(argv[0]);
+        return 1;
+    }
+
+    FILE *file = stdout;
+    if (!options.output.empty())
+    {
+        file = fopen(options.output.c_str(), "w");
+        if (file == nullptr)
+        {
+            fprintf(stderr, "could not open %s\n", options.output.c_str());
+            return 1;
+        }
+    }
+
+    PhysicsBenchWrite(file, options, results);
+
+    if (file != stdout)
+    {
+        fclose(file);
+    }
+
+    return 0;
+}
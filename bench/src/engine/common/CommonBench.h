@@ -0,0 +1,134 @@
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "engine/common/HandleManager.h"
+#include "engine/common/StreamBuffer.h"
+#include "engine/common/StringIntern.h"
+
+// Insert and then extract state.range(0) fixed size records
+static void StreamBufferInsertExtract(benchmark::State &state)
+{
+    struct Record
+    {
+        float x, y, z;
+        uint32_t id;
+    };
+
+    const int count = state.range(0);
+    Record in = {1.0f, 2.0f, 3.0f, 4};
+    Record out;
+
+    for (auto _ : state)
+    {
+        ds_com::StreamBuffer stream;
+
+        for (int i = 0; i < count; ++i)
+        {
+            stream << in;
+        }
+        for (int i = 0; i < count; ++i)
+        {
+            stream >> out;
+        }
+
+        benchmark::DoNotOptimize(out);
+    }
+
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(StreamBufferInsertExtract)->Arg(64)->Arg(1024);
+
+static void StreamBufferAppend(benchmark::State &state)
+{
+    ds_com::StreamBuffer from;
+    std::vector<char> data(state.range(0), 'a');
+    from.Insert(data.size(), &data[0]);
+
+    for (auto _ : state)
+    {
+        ds_com::StreamBuffer to;
+        ds_com::AppendStreamBuffer(&to, from);
+        benchmark::DoNotOptimize(to.GetDataPtr());
+    }
+
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(StreamBufferAppend)->Arg(256)->Arg(16384);
+
+// Fill the handle manager and then remove every handle
+static void HandleManagerAddRemove(benchmark::State &state)
+{
+    const int count = state.range(0);
+    std::vector<ds::Handle> handles(count);
+    int data = 0;
+
+    // HandleManager is too large to live on the stack
+    std::unique_ptr<ds::HandleManager> handleManager(new ds::HandleManager());
+
+    for (auto _ : state)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            handles[i] = handleManager->Add(&data, 0);
+        }
+        for (int i = 0; i < count; ++i)
+        {
+            handleManager->Remove(handles[i]);
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(HandleManagerAddRemove)->Arg(64)->Arg(4000);
+
+static void HandleManagerGet(benchmark::State &state)
+{
+    const int count = state.range(0);
+    std::vector<ds::Handle> handles(count);
+    std::vector<int> data(count);
+
+    std::unique_ptr<ds::HandleManager> handleManager(new ds::HandleManager());
+    for (int i = 0; i < count; ++i)
+    {
+        handles[i] = handleManager->Add(&data[i], 0);
+    }
+
+    for (auto _ : state)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            benchmark::DoNotOptimize(handleManager->Get(handles[i]));
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(HandleManagerGet)->Arg(64)->Arg(4000);
+
+// StringIntern never releases strings, so bound the number of iterations
+static void StringInternIntern(benchmark::State &state)
+{
+    const std::string string = "ds_msg::PhysicsCollision";
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(ds::StringIntern::Instance().Intern(string));
+    }
+}
+BENCHMARK(StringInternIntern)->Iterations(100000);
+
+static void StringInternGetString(benchmark::State &state)
+{
+    ds::StringIntern::StringId id =
+        ds::StringIntern::Instance().Intern("ds_msg::PhysicsCollision");
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(
+            ds::StringIntern::Instance().GetString(id).size());
+    }
+}
+BENCHMARK(StringInternGetString);
@@ -0,0 +1,87 @@
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "engine/entity/ComponentManager.h"
+#include "math/Vector3.h"
+
+class BenchComponentManager : public ds::ComponentManager<ds_math::Vector3>
+{
+};
+
+static std::vector<ds::Entity> BenchEntities(int count)
+{
+    std::vector<ds::Entity> entities(count);
+
+    for (int i = 0; i < count; ++i)
+    {
+        entities[i].id = i;
+    }
+
+    return entities;
+}
+
+static void ComponentManagerCreate(benchmark::State &state)
+{
+    std::vector<ds::Entity> entities = BenchEntities(state.range(0));
+
+    for (auto _ : state)
+    {
+        BenchComponentManager manager;
+
+        for (unsigned int i = 0; i < entities.size(); ++i)
+        {
+            benchmark::DoNotOptimize(
+                manager.CreateComponentForEntity(entities[i]));
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(ComponentManagerCreate)->Arg(64)->Arg(4096);
+
+static void ComponentManagerLookup(benchmark::State &state)
+{
+    std::vector<ds::Entity> entities = BenchEntities(state.range(0));
+
+    BenchComponentManager manager;
+    for (unsigned int i = 0; i < entities.size(); ++i)
+    {
+        manager.CreateComponentForEntity(entities[i]);
+    }
+
+    for (auto _ : state)
+    {
+        for (unsigned int i = 0; i < entities.size(); ++i)
+        {
+            ds::Instance instance = manager.GetInstanceForEntity(entities[i]);
+            benchmark::DoNotOptimize(manager.GetComponentForInstance(instance));
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(ComponentManagerLookup)->Arg(64)->Arg(4096);
+
+// Create state.range(0) components and then remove them in creation order
+static void ComponentManagerCreateRemove(benchmark::State &state)
+{
+    std::vector<ds::Entity> entities = BenchEntities(state.range(0));
+
+    for (auto _ : state)
+    {
+        BenchComponentManager manager;
+
+        for (unsigned int i = 0; i < entities.size(); ++i)
+        {
+            manager.CreateComponentForEntity(entities[i]);
+        }
+        for (unsigned int i = 0; i < entities.size(); ++i)
+        {
+            manager.RemoveInstance(manager.GetInstanceForEntity(entities[i]));
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(ComponentManagerCreateRemove)->Arg(64)->Arg(4096);
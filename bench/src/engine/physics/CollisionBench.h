@@ -0,0 +1,148 @@
+#include "benchmark/benchmark.h"
+
+#include "engine/system/physics/CollisionFine.h"
+#include "engine/system/physics/RigidBody.h"
+
+/**
+ * Two rigid bodies, overlapping slightly, with one primitive of each type
+ * attached to each body.
+ */
+struct CollisionBenchScene
+{
+    CollisionBenchScene()
+    {
+        setupBody(&bodies[0], ds_math::Vector3(0.0f, 0.0f, 0.0f),
+                  ds_math::Quaternion());
+        setupBody(&bodies[1], ds_math::Vector3(0.8f, 0.9f, 0.1f),
+                  ds_math::Quaternion::CreateFromAxisAngle(
+                      ds_math::Vector3::Normalize(
+                          ds_math::Vector3(1.0f, 1.0f, 0.0f)),
+                      0.4f));
+
+        for (unsigned int i = 0; i < 2; ++i)
+        {
+            boxes[i].body = &bodies[i];
+            boxes[i].halfSize = ds_math::Vector3(0.5f, 0.5f, 0.5f);
+            boxes[i].calculateInternals();
+
+            spheres[i].body = &bodies[i];
+            spheres[i].radius = 0.6f;
+            spheres[i].calculateInternals();
+
+            capsules[i].body = &bodies[i];
+            capsules[i].height = 1.0f;
+            capsules[i].radius = 0.4f;
+            capsules[i].calculateInternals();
+        }
+
+        plane.direction = ds_math::Vector3(0.0f, 1.0f, 0.0f);
+        plane.offset = 0.2f;
+
+        data.contactArray = contacts;
+        data.friction = 0.9f;
+        data.restitution = 0.1f;
+        data.tolerance = 0.1f;
+    }
+
+    static void setupBody(ds_phys::RigidBody *body,
+                          const ds_math::Vector3 &position,
+                          const ds_math::Quaternion &orientation)
+    {
+        body->setMass(1.0f);
+        body->setInertiaTensor(ds_math::Vector3(1.0f, 1.0f, 1.0f));
+        body->setPosition(position);
+        body->setOrientation(orientation);
+        body->calculateDerivedData();
+    }
+
+    enum
+    {
+        MAX_CONTACTS = 256
+    };
+
+    ds_phys::RigidBody bodies[2];
+    ds_phys::CollisionBox boxes[2];
+    ds_phys::CollisionSphere spheres[2];
+    ds_phys::CollisionCapsule capsules[2];
+    ds_phys::CollisionPlane plane;
+    ds_phys::Contact contacts[MAX_CONTACTS];
+    ds_phys::CollisionData data;
+};
+
+static void CollisionBoxAndBox(benchmark::State &state)
+{
+    CollisionBenchScene scene;
+
+    for (auto _ : state)
+    {
+        scene.data.reset(CollisionBenchScene::MAX_CONTACTS);
+        benchmark::DoNotOptimize(ds_phys::CollisionDetector::boxAndBox(
+            scene.boxes[0], scene.boxes[1], &scene.data));
+    }
+}
+BENCHMARK(CollisionBoxAndBox);
+
+static void CollisionBoxAndSphere(benchmark::State &state)
+{
+    CollisionBenchScene scene;
+
+    for (auto _ : state)
+    {
+        scene.data.reset(CollisionBenchScene::MAX_CONTACTS);
+        benchmark::DoNotOptimize(ds_phys::CollisionDetector::boxAndSphere(
+            scene.boxes[0], scene.spheres[1], &scene.data));
+    }
+}
+BENCHMARK(CollisionBoxAndSphere);
+
+static void CollisionSphereAndSphere(benchmark::State &state)
+{
+    CollisionBenchScene scene;
+
+    for (auto _ : state)
+    {
+        scene.data.reset(CollisionBenchScene::MAX_CONTACTS);
+        benchmark::DoNotOptimize(ds_phys::CollisionDetector::sphereAndSphere(
+            scene.spheres[0], scene.spheres[1], &scene.data));
+    }
+}
+BENCHMARK(CollisionSphereAndSphere);
+
+static void CollisionBoxAndHalfSpace(benchmark::State &state)
+{
+    CollisionBenchScene scene;
+
+    for (auto _ : state)
+    {
+        scene.data.reset(CollisionBenchScene::MAX_CONTACTS);
+        benchmark::DoNotOptimize(ds_phys::CollisionDetector::boxAndHalfSpace(
+            scene.boxes[0], scene.plane, &scene.data));
+    }
+}
+BENCHMARK(CollisionBoxAndHalfSpace);
+
+static void CollisionCapsuleAndBox(benchmark::State &state)
+{
+    CollisionBenchScene scene;
+
+    for (auto _ : state)
+    {
+        scene.data.reset(CollisionBenchScene::MAX_CONTACTS);
+        benchmark::DoNotOptimize(ds_phys::CollisionDetector::capsuleAndBox(
+            scene.capsules[0], scene.boxes[1], &scene.data));
+    }
+}
+BENCHMARK(CollisionCapsuleAndBox);
+
+static void CollisionCapsuleAndCapsule(benchmark::State &state)
+{
+    CollisionBenchScene scene;
+
+    for (auto _ : state)
+    {
+        scene.data.reset(CollisionBenchScene::MAX_CONTACTS);
+        benchmark::DoNotOptimize(ds_phys::CollisionDetector::capsuleAndCapsule(
+            scene.capsules[0], scene.capsules[1], &scene.data));
+    }
+}
+BENCHMARK(CollisionCapsuleAndCapsule);
@@ -0,0 +1,151 @@
+#include <memory>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "engine/system/physics/PhysicsWorld.h"
+
+/**
+ * Physics world containing a ground plane and a grid of spheres resting on
+ * it, each sphere touching its neighbours.
+ */
+struct PhysicsWorldBenchScene
+{
+    explicit PhysicsWorldBenchScene(unsigned int count) : world(0)
+    {
+        world.addForceField(
+            ds_phys::ForceField::uniform(ds_math::Vector3(0.0f, -9.8f, 0.0f)));
+
+        ds_phys::CollisionPlane *plane = new ds_phys::CollisionPlane();
+        plane->direction = ds_math::Vector3(0.0f, 1.0f, 0.0f);
+        plane->offset = 0.0f;
+        world.addCollisionPrimitive(
+            std::unique_ptr<ds_phys::CollisionPrimitive>(plane));
+
+        unsigned int side = 1;
+        while (side * side < count)
+        {
+            ++side;
+        }
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            addSphere(ds_math::Vector3((i % side) * 0.95f, 0.45f,
+                                       (i / side) * 0.95f));
+        }
+    }
+
+    void addSphere(const ds_math::Vector3 &position)
+    {
+        ds_phys::RigidBody *body = new ds_phys::RigidBody();
+        body->setMass(1.0f);
+        body->setInertiaTensor(ds_math::Vector3(0.4f, 0.4f, 0.4f));
+        body->setPosition(position);
+        body->setOrientation(ds_math::Quaternion());
+
+        ds_phys::CollisionSphere *sphere = new ds_phys::CollisionSphere();
+        sphere->body = body;
+        sphere->radius = 0.5f;
+        body->addCollisionPrimitive(sphere);
+
+        world.addRigidBody(body);
+        world.addCollisionPrimitive(
+            std::unique_ptr<ds_phys::CollisionPrimitive>(sphere));
+        bodies.push_back(std::unique_ptr<ds_phys::RigidBody>(body));
+    }
+
+    void step(unsigned int frames)
+    {
+        for (unsigned int i = 0; i < frames; ++i)
+        {
+            world.startFrame();
+            world.stepSimulation(1.0f / 120.0f);
+        }
+    }
+
+    ds_phys::PhysicsWorld world;
+    std::vector<std::unique_ptr<ds_phys::RigidBody>> bodies;
+};
+
+static void PhysicsWorldGenerateContacts(benchmark::State &state)
+{
+    PhysicsWorldBenchScene scene((unsigned int)state.range(0));
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(scene.world.generateContacts());
+    }
+}
+BENCHMARK(PhysicsWorldGenerateContacts)->Arg(16)->Arg(64)->Arg(256)->Arg(1024);
+
+static void PhysicsWorldStepResting(benchmark::State &state)
+{
+    PhysicsWorldBenchScene scene((unsigned int)state.range(0));
+
+    // Let the spheres settle and fall asleep
+    scene.step(1200);
+
+    for (auto _ : state)
+    {
+        scene.step(1);
+    }
+
+    state.counters["awakeIslands"] = scene.world.getAwakeIslandCount();
+}
+BENCHMARK(PhysicsWorldStepResting)->Arg(64)->Arg(256)->Arg(1024);
+
+static void PhysicsWorldStepIslands(benchmark::State &state)
+{
+    // Rows of spheres dropped onto the plane, a row touches but the rows
+    // are apart, giving separate islands that are all awake. Kept under
+    // the world's contact limit.
+    const unsigned int rows = 12;
+    const unsigned int spheres = 10;
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        PhysicsWorldBenchScene scene(0);
+        scene.world.setWorkerCount((unsigned int)state.range(0));
+        for (unsigned int i = 0; i < rows; ++i)
+        {
+            for (unsigned int j = 0; j < spheres; ++j)
+            {
+                scene.addSphere(ds_math::Vector3(j * 0.95f, 1.0f + 0.01f * j,
+                                                 i * 2.0f));
+            }
+        }
+        state.ResumeTiming();
+
+        scene.step(30);
+    }
+}
+BENCHMARK(PhysicsWorldStepIslands)->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
+
+static void PhysicsWorldIntegrateBodies(benchmark::State &state)
+{
+    const unsigned int count = (unsigned int)state.range(0);
+
+    std::vector<std::unique_ptr<ds_phys::RigidBody>> bodies;
+    ds_phys::RigidBodyPool pool;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        ds_phys::RigidBody *body = new ds_phys::RigidBody();
+        body->setMass(1.0f);
+        body->setInertiaTensor(ds_math::Vector3(0.4f, 0.4f, 0.4f));
+        body->setOrientation(ds_math::Quaternion());
+        body->setPosition(ds_math::Vector3(i * 1.0f, 10.0f, 0.0f));
+        body->setRotation(ds_math::Vector3(0.1f, 0.2f, 0.3f));
+        body->setAcceleration(ds_math::Vector3(0.0f, -9.8f, 0.0f));
+        bodies.push_back(std::unique_ptr<ds_phys::RigidBody>(body));
+        pool.add(body);
+    }
+
+    for (auto _ : state)
+    {
+        pool.integrate(1.0f / 120.0f);
+    }
+
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(PhysicsWorldIntegrateBodies)->Arg(256)->Arg(4096);
@@ -0,0 +1,61 @@
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "engine/common/CommonBench.h"
+#include "engine/entity/ComponentManagerBench.h"
+#include "engine/physics/CollisionBench.h"
+#include "engine/physics/PhysicsWorldBench.h"
+#include "math/MathBench.h"
+
+/**
+ * Add the given flag to the argument list unless the user has already
+ * provided a value for it.
+ */
+static void AddDefaultFlag(std::vector<char *> *args,
+                           std::vector<std::string> *storage,
+                           const char *flag,
+                           const char *value)
+{
+    for (unsigned int i = 1; i < args->size(); ++i)
+    {
+        if (strncmp((*args)[i], flag, strlen(flag)) == 0)
+        {
+            return;
+        }
+    }
+
+    storage->push_back(std::string(flag) + "=" + value);
+}
+
+int main(int argc, char **argv)
+{
+    // By default repeat every benchmark, report mean/median/stddev and write
+    // the results to bench_results.json so they can be compared between
+    // builds. Any of these can be overridden on the command line.
+    std::vector<char *> args(argv, argv + argc);
+    std::vector<std::string> defaults;
+    AddDefaultFlag(&args, &defaults, "--benchmark_repetitions", "5");
+    AddDefaultFlag(&args, &defaults, "--benchmark_report_aggregates_only",
+                   "true");
+    AddDefaultFlag(&args, &defaults, "--benchmark_out", "bench_results.json");
+    AddDefaultFlag(&args, &defaults, "--benchmark_out_format", "json");
+    for (unsigned int i = 0; i < defaults.size(); ++i)
+    {
+        args.push_back(&defaults[i][0]);
+    }
+
+    int numArgs = (int)args.size();
+    ::benchmark::Initialize(&numArgs, &args[0]);
+    if (::benchmark::ReportUnrecognizedArguments(numArgs, &args[0]))
+    {
+        return 1;
+    }
+
+    ::benchmark::RunSpecifiedBenchmarks();
+    ::benchmark::Shutdown();
+
+    return 0;
+}
@@ -0,0 +1,171 @@
+#include "benchmark/benchmark.h"
+
+#include "math/Matrix4.h"
+#include "math/Quaternion.h"
+#include "math/Vector3.h"
+
+static ds_math::Matrix4 BenchTransformMatrix()
+{
+    return ds_math::Matrix4::CreateTranslationMatrix(1.5f, -2.0f, 3.25f) *
+           ds_math::Matrix4::CreateFromQuaternion(
+               ds_math::Quaternion::CreateFromAxisAngle(
+                   ds_math::Vector3::Normalize(
+                       ds_math::Vector3(1.0f, 2.0f, -0.5f)),
+                   0.7f)) *
+           ds_math::Matrix4::CreateScaleMatrix(2.0f, 0.5f, 1.25f);
+}
+
+static void Matrix4Multiply(benchmark::State &state)
+{
+    ds_math::Matrix4 m1 = BenchTransformMatrix();
+    ds_math::Matrix4 m2 = ds_math::Matrix4::Transpose(m1);
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(m1);
+        benchmark::DoNotOptimize(m1 * m2);
+    }
+}
+BENCHMARK(Matrix4Multiply);
+
+static void Matrix4Inverse(benchmark::State &state)
+{
+    ds_math::Matrix4 m = BenchTransformMatrix();
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(m);
+        benchmark::DoNotOptimize(ds_math::Matrix4::Inverse(m));
+    }
+}
+BENCHMARK(Matrix4Inverse);
+
+static void Matrix4Transpose(benchmark::State &state)
+{
+    ds_math::Matrix4 m = BenchTransformMatrix();
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(m);
+        benchmark::DoNotOptimize(ds_math::Matrix4::Transpose(m));
+    }
+}
+BENCHMARK(Matrix4Transpose);
+
+static void Matrix4TransformVector3(benchmark::State &state)
+{
+    ds_math::Matrix4 m = BenchTransformMatrix();
+    ds_math::Vector3 v(1.0f, -2.0f, 3.0f);
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(v);
+        benchmark::DoNotOptimize(ds_math::Matrix4::Transform(m, v));
+    }
+}
+BENCHMARK(Matrix4TransformVector3);
+
+static void Matrix4TransformInverseVector3(benchmark::State &state)
+{
+    ds_math::Matrix4 m = BenchTransformMatrix();
+    ds_math::Vector3 v(1.0f, -2.0f, 3.0f);
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(v);
+        benchmark::DoNotOptimize(ds_math::Matrix4::TransformInverse(m, v));
+    }
+}
+BENCHMARK(Matrix4TransformInverseVector3);
+
+static void Matrix4CreateFromQuaternion(benchmark::State &state)
+{
+    ds_math::Quaternion q = ds_math::Quaternion::CreateFromAxisAngle(
+        ds_math::Vector3::UnitY, 0.3f);
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(q);
+        benchmark::DoNotOptimize(ds_math::Matrix4::CreateFromQuaternion(q));
+    }
+}
+BENCHMARK(Matrix4CreateFromQuaternion);
+
+static void QuaternionMultiply(benchmark::State &state)
+{
+    ds_math::Quaternion q1 = ds_math::Quaternion::CreateFromAxisAngle(
+        ds_math::Vector3::UnitY, 0.3f);
+    ds_math::Quaternion q2 = ds_math::Quaternion::CreateFromAxisAngle(
+        ds_math::Vector3::UnitX, -1.1f);
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(q1);
+        benchmark::DoNotOptimize(q1 * q2);
+    }
+}
+BENCHMARK(QuaternionMultiply);
+
+static void QuaternionNormalize(benchmark::State &state)
+{
+    ds_math::Quaternion q(1.0f, -2.0f, 0.5f, 3.0f);
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(q);
+        benchmark::DoNotOptimize(ds_math::Quaternion::Normalize(q));
+    }
+}
+BENCHMARK(QuaternionNormalize);
+
+static void QuaternionAddScaledVector(benchmark::State &state)
+{
+    ds_math::Vector3 v(0.1f, -0.2f, 0.3f);
+
+    for (auto _ : state)
+    {
+        ds_math::Quaternion q(0.0f, 0.0f, 0.0f, 1.0f);
+        benchmark::DoNotOptimize(v);
+        q.AddScaledVector(v, 0.016f);
+        benchmark::DoNotOptimize(q);
+    }
+}
+BENCHMARK(QuaternionAddScaledVector);
+
+static void Vector3Cross(benchmark::State &state)
+{
+    ds_math::Vector3 v1(1.0f, -2.0f, 3.0f);
+    ds_math::Vector3 v2(-0.5f, 4.0f, 2.0f);
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(v1);
+        benchmark::DoNotOptimize(ds_math::Vector3::Cross(v1, v2));
+    }
+}
+BENCHMARK(Vector3Cross);
+
+static void Vector3Dot(benchmark::State &state)
+{
+    ds_math::Vector3 v1(1.0f, -2.0f, 3.0f);
+    ds_math::Vector3 v2(-0.5f, 4.0f, 2.0f);
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(v1);
+        benchmark::DoNotOptimize(ds_math::Vector3::Dot(v1, v2));
+    }
+}
+BENCHMARK(Vector3Dot);
+
+static void Vector3Normalize(benchmark::State &state)
+{
+    ds_math::Vector3 v(1.0f, -2.0f, 3.0f);
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(v);
+        benchmark::DoNotOptimize(ds_math::Vector3::Normalize(v));
+    }
+}
+BENCHMARK(Vector3Normalize);
@@ -0,0 +1,11 @@
+# Get and build Google Benchmark
+
+ExternalProject_Add(benchmark
+	GIT_REPOSITORY https://github.com/google/benchmark.git
+	GIT_TAG v1.7.1
+	INSTALL_DIR "${BENCHMARK_ROOT}"
+	CMAKE_ARGS
+		-DCMAKE_INSTALL_PREFIX=<INSTALL_DIR>
+		-DCMAKE_BUILD_TYPE=Release
+		-DBENCHMARK_ENABLE_TESTING=OFF
+	)
\ No newline at end of file
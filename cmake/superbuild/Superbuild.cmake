@@ -107,6 +107,16 @@ else (NOT assimp_FOUND)
   set (ASSIMP_ROOT_DIR ${ASSIMP_INCLUDE_DIRS}/..)
 endif (NOT assimp_FOUND)
 
+# Try to find Google Benchmark
+set(benchmark_DIR ${CMAKE_SOURCE_DIR}/../../external/benchmark/lib/cmake/benchmark)
+find_package(benchmark)
+if (NOT benchmark_FOUND)
+  message("Will download Google Benchmark..")
+  set(BENCHMARK_ROOT ${CMAKE_SOURCE_DIR}/../../external/benchmark)
+  include(${CMAKE_SOURCE_DIR}/External-GoogleBenchmark.cmake)
+  list(APPEND DRUNKEN_SAILOR_ENGINE_DEPENDENCIES benchmark)
+endif (NOT benchmark_FOUND)
+
 set(DS_LUAJIT_WORKAROUND 0 CACHE BOOL "Enable workaround")
 
 ExternalProject_Add(
@@ -126,6 +136,7 @@ ExternalProject_Add(
     -DSFML_ROOT=${SFML_ROOT}
     -DASSIMP_ROOT_DIR=${ASSIMP_ROOT_DIR}
     -DSTB_BASE_DIR=${STB_BASE_DIR}
+    -Dbenchmark_DIR=${benchmark_DIR}
 		-DCMAKE_BUILD_TYPE=${CMAKE_BUILD_TYPE}
     -DCMAKE_INSTALL_PREFIX=<INSTALL_DIR>
 	-DDS_LUAJIT_WORKAROUND=${DS_LUAJIT_WORKAROUND}
@@ -308,10 +308,20 @@ struct ReloadAll
 {
 };
 
+enum class PhysicsCollisionPhase
+{
+    Begin, // Objects started touching this frame
+    Stay,  // Objects were touching last frame and still are
+    End    // Objects stopped touching this frame
+};
+
 struct PhysicsCollision
 {
-    ds::Entity entityA; // Object one involved in collision.
-    ds::Entity entityB; // Object two involved in collision.
+    PhysicsCollisionPhase phase; // How the collision changed.
+    ds::Entity entityA;          // Object one involved in collision.
+    ds::Entity entityB;          // Object two involved in collision, id is
+                                 // PHYSICS_COLLISION_NO_ENTITY for static
+                                 // geometry without an entity.
     ds_math::Vector3
         pointWorldOnA; // Collision point on object one in world space.
     ds_math::Vector3
@@ -320,6 +330,9 @@ struct PhysicsCollision
         normalWorldOnB; // Collision normal in world space on object two.
 };
 
+/** Entity id of static geometry without an entity in a PhysicsCollision. */
+const uint32_t PHYSICS_COLLISION_NO_ENTITY = 0xffffffff;
+
 struct SetMouseLock
 {
     bool enableMouseLock; // TRUE to enable mouse lock, FALSE to disable it
@@ -0,0 +1,376 @@
+#include <algorithm>
+
+#include "engine/system/physics/CollisionCoarse.h"
+
+namespace ds_phys
+{
+const int AabbTree::NULL_NODE;
+
+AabbTree::AabbTree(ds_math::scalar margin)
+    : m_root(NULL_NODE), m_freeList(NULL_NODE), m_proxyCount(0),
+      m_margin(margin)
+{
+}
+
+int AabbTree::allocateNode()
+{
+    if (m_freeList == NULL_NODE)
+    {
+        Node node;
+        node.parent = NULL_NODE;
+        node.height = -1;
+        m_nodes.push_back(node);
+        m_freeList = (int)m_nodes.size() - 1;
+    }
+
+    int nodeId = m_freeList;
+    Node &node = m_nodes[nodeId];
+    m_freeList = node.parent;
+
+    node.parent = NULL_NODE;
+    node.children[0] = NULL_NODE;
+    node.children[1] = NULL_NODE;
+    node.userData = nullptr;
+    node.height = 0;
+
+    return nodeId;
+}
+
+void AabbTree::freeNode(int nodeId)
+{
+    assert(nodeId >= 0 && nodeId < (int)m_nodes.size());
+
+    m_nodes[nodeId].parent = m_freeList;
+    m_nodes[nodeId].height = -1;
+    m_freeList = nodeId;
+}
+
+int AabbTree::createProxy(const BoundingBox &box, void *userData)
+{
+    int proxyId = allocateNode();
+
+    m_nodes[proxyId].box = box.fattened(m_margin);
+    m_nodes[proxyId].userData = userData;
+
+    insertLeaf(proxyId);
+    ++m_proxyCount;
+
+    return proxyId;
+}
+
+void AabbTree::destroyProxy(int proxyId)
+{
+    assert(proxyId >= 0 && proxyId < (int)m_nodes.size());
+    assert(m_nodes[proxyId].isLeaf());
+
+    removeLeaf(proxyId);
+    freeNode(proxyId);
+    --m_proxyCount;
+}
+
+bool AabbTree::moveProxy(int proxyId, const BoundingBox &box)
+{
+    assert(proxyId >= 0 && proxyId < (int)m_nodes.size());
+    assert(m_nodes[proxyId].isLeaf());
+
+    if (m_nodes[proxyId].box.contains(box))
+    {
+        return false;
+    }
+
+    removeLeaf(proxyId);
+    m_nodes[proxyId].box = box.fattened(m_margin);
+    insertLeaf(proxyId);
+
+    return true;
+}
+
+void AabbTree::insertLeaf(int leaf)
+{
+    if (m_root == NULL_NODE)
+    {
+        m_root = leaf;
+        m_nodes[m_root].parent = NULL_NODE;
+        return;
+    }
+
+    // Find the best sibling for the new leaf using the surface area
+    // heuristic.
+    const BoundingBox leafBox = m_nodes[leaf].box;
+    int index = m_root;
+    while (!m_nodes[index].isLeaf())
+    {
+        int child0 = m_nodes[index].children[0];
+        int child1 = m_nodes[index].children[1];
+
+        ds_math::scalar area = m_nodes[index].box.getSurfaceArea();
+        ds_math::scalar combinedArea =
+            BoundingBox::merge(m_nodes[index].box, leafBox).getSurfaceArea();
+
+        // Cost of creating a new parent for this node and the new leaf
+        ds_math::scalar cost = 2 * combinedArea;
+
+        // Minimum cost of pushing the leaf further down the tree
+        ds_math::scalar inheritanceCost = 2 * (combinedArea - area);
+
+        ds_math::scalar childCost[2];
+        for (int i = 0; i < 2; ++i)
+        {
+            const Node &child = m_nodes[i == 0 ? child0 : child1];
+            ds_math::scalar mergedArea =
+                BoundingBox::merge(leafBox, child.box).getSurfaceArea();
+            if (child.isLeaf())
+            {
+                childCost[i] = mergedArea + inheritanceCost;
+            }
+            else
+            {
+                childCost[i] = mergedArea - child.box.getSurfaceArea() +
+                               inheritanceCost;
+            }
+        }
+
+        // Descend according to the minimum cost
+        if (cost < childCost[0] && cost < childCost[1])
+        {
+            break;
+        }
+
+        index = childCost[0] < childCost[1] ? child0 : child1;
+    }
+
+    int sibling = index;
+
+    // Create a new parent for the sibling and the leaf
+    int oldParent = m_nodes[sibling].parent;
+    int newParent = allocateNode();
+    m_nodes[newParent].parent = oldParent;
+    m_nodes[newParent].box = BoundingBox::merge(leafBox, m_nodes[sibling].box);
+    m_nodes[newParent].height = m_nodes[sibling].height + 1;
+    m_nodes[newParent].children[0] = sibling;
+    m_nodes[newParent].children[1] = leaf;
+    m_nodes[sibling].parent = newParent;
+    m_nodes[leaf].parent = newParent;
+
+    if (oldParent != NULL_NODE)
+    {
+        if (m_nodes[oldParent].children[0] == sibling)
+        {
+            m_nodes[oldParent].children[0] = newParent;
+        }
+        else
+        {
+            m_nodes[oldParent].children[1] = newParent;
+        }
+    }
+    else
+    {
+        m_root = newParent;
+    }
+
+    // Walk back up the tree fixing heights and boxes
+    index = m_nodes[leaf].parent;
+    while (index != NULL_NODE)
+    {
+        index = balance(index);
+
+        int child0 = m_nodes[index].children[0];
+        int child1 = m_nodes[index].children[1];
+
+        m_nodes[index].height =
+            1 + std::max(m_nodes[child0].height, m_nodes[child1].height);
+        m_nodes[index].box =
+            BoundingBox::merge(m_nodes[child0].box, m_nodes[child1].box);
+
+        index = m_nodes[index].parent;
+    }
+}
+
+void AabbTree::removeLeaf(int leaf)
+{
+    if (leaf == m_root)
+    {
+        m_root = NULL_NODE;
+        return;
+    }
+
+    int parent = m_nodes[leaf].parent;
+    int grandParent = m_nodes[parent].parent;
+    int sibling = m_nodes[parent].children[0] == leaf
+                      ? m_nodes[parent].children[1]
+                      : m_nodes[parent].children[0];
+
+    if (grandParent != NULL_NODE)
+    {
+        // Destroy the parent and connect the sibling to the grand parent
+        if (m_nodes[grandParent].children[0] == parent)
+        {
+            m_nodes[grandParent].children[0] = sibling;
+        }
+        else
+        {
+            m_nodes[grandParent].children[1] = sibling;
+        }
+        m_nodes[sibling].parent = grandParent;
+        freeNode(parent);
+
+        // Adjust ancestor bounds
+        int index = grandParent;
+        while (index != NULL_NODE)
+        {
+            index = balance(index);
+
+            int child0 = m_nodes[index].children[0];
+            int child1 = m_nodes[index].children[1];
+
+            m_nodes[index].box =
+                BoundingBox::merge(m_nodes[child0].box, m_nodes[child1].box);
+            m_nodes[index].height =
+                1 + std::max(m_nodes[child0].height, m_nodes[child1].height);
+
+            index = m_nodes[index].parent;
+        }
+    }
+    else
+    {
+        m_root = sibling;
+        m_nodes[sibling].parent = NULL_NODE;
+        freeNode(parent);
+    }
+}
+
+int AabbTree::balance(int iA)
+{
+    // Perform a left or right rotation if node A is imbalanced, returns the
+    // new root of the sub-tree.
+    Node *nodes = &m_nodes[0];
+    Node *A = nodes + iA;
+    if (A->isLeaf() || A->height < 2)
+    {
+        return iA;
+    }
+
+    int iB = A->children[0];
+    int iC = A->children[1];
+    Node *B = nodes + iB;
+    Node *C = nodes + iC;
+
+    int heightDifference = C->height - B->height;
+
+    // Rotate C up
+    if (heightDifference > 1)
+    {
+        int iF = C->children[0];
+        int iG = C->children[1];
+        Node *F = nodes + iF;
+        Node *G = nodes + iG;
+
+        // Swap A and C
+        C->children[0] = iA;
+        C->parent = A->parent;
+        A->parent = iC;
+
+        // A's old parent should point to C
+        if (C->parent != NULL_NODE)
+        {
+            if (nodes[C->parent].children[0] == iA)
+            {
+                nodes[C->parent].children[0] = iC;
+            }
+            else
+            {
+                nodes[C->parent].children[1] = iC;
+            }
+        }
+        else
+        {
+            m_root = iC;
+        }
+
+        // Rotate
+        if (F->height > G->height)
+        {
+            C->children[1] = iF;
+            A->children[1] = iG;
+            G->parent = iA;
+            A->box = BoundingBox::merge(B->box, G->box);
+            C->box = BoundingBox::merge(A->box, F->box);
+
+            A->height = 1 + std::max(B->height, G->height);
+            C->height = 1 + std::max(A->height, F->height);
+        }
+        else
+        {
+            C->children[1] = iG;
+            A->children[1] = iF;
+            F->parent = iA;
+            A->box = BoundingBox::merge(B->box, F->box);
+            C->box = BoundingBox::merge(A->box, G->box);
+
+            A->height = 1 + std::max(B->height, F->height);
+            C->height = 1 + std::max(A->height, G->height);
+        }
+
+        return iC;
+    }
+
+    // Rotate B up
+    if (heightDifference < -1)
+    {
+        int iD = B->children[0];
+        int iE = B->children[1];
+        Node *D = nodes + iD;
+        Node *E = nodes + iE;
+
+        // Swap A and B
+        B->children[0] = iA;
+        B->parent = A->parent;
+        A->parent = iB;
+
+        // A's old parent should point to B
+        if (B->parent != NULL_NODE)
+        {
+            if (nodes[B->parent].children[0] == iA)
+            {
+                nodes[B->parent].children[0] = iB;
+            }
+            else
+            {
+                nodes[B->parent].children[1] = iB;
+            }
+        }
+        else
+        {
+            m_root = iB;
+        }
+
+        // Rotate
+        if (D->height > E->height)
+        {
+            B->children[1] = iD;
+            A->children[0] = iE;
+            E->parent = iA;
+            A->box = BoundingBox::merge(C->box, E->box);
+            B->box = BoundingBox::merge(A->box, D->box);
+
+            A->height = 1 + std::max(C->height, E->height);
+            B->height = 1 + std::max(A->height, D->height);
+        }
+        else
+        {
+            B->children[1] = iE;
+            A->children[0] = iD;
+            D->parent = iA;
+            A->box = BoundingBox::merge(C->box, D->box);
+            B->box = BoundingBox::merge(A->box, E->box);
+
+            A->height = 1 + std::max(C->height, D->height);
+            B->height = 1 + std::max(A->height, E->height);
+        }
+
+        return iB;
+    }
+
+    return iA;
+}
+}
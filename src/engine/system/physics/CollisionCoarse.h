@@ -0,0 +1,419 @@
+#pragma once
+
+#include <cassert>
+#include <vector>
+
+#include "math/Precision.h"
+#include "math/Vector3.h"
+
+namespace ds_phys
+{
+/**
+ * Axis-aligned bounding box used by the coarse (broadphase) collision
+ * detection.
+ */
+struct BoundingBox
+{
+    /** Minimum corner of the box. */
+    ds_math::Vector3 min;
+
+    /** Maximum corner of the box. */
+    ds_math::Vector3 max;
+
+    /**
+     * Default constructor, creates an empty box at the origin.
+     */
+    BoundingBox()
+    {
+    }
+
+    /**
+     * Create a bounding box from its minimum and maximum corners.
+     *
+     * @param   min   const ds_math::Vector3 &, minimum corner of the box.
+     * @param   max   const ds_math::Vector3 &, maximum corner of the box.
+     */
+    BoundingBox(const ds_math::Vector3 &min, const ds_math::Vector3 &max)
+        : min(min), max(max)
+    {
+    }
+
+    /**
+     * Check whether this box overlaps another.
+     *
+     * Boxes that only touch are considered overlapping.
+     *
+     * @param   other   const BoundingBox &, box to test against.
+     * @return          bool, true if the boxes overlap, false otherwise.
+     */
+    bool overlaps(const BoundingBox &other) const
+    {
+        return min.x <= other.max.x && max.x >= other.min.x &&
+               min.y <= other.max.y && max.y >= other.min.y &&
+               min.z <= other.max.z && max.z >= other.min.z;
+    }
+
+    /**
+     * Check whether this box entirely contains another.
+     *
+     * @param   other   const BoundingBox &, box to test.
+     * @return          bool, true if other lies within this box.
+     */
+    bool contains(const BoundingBox &other) const
+    {
+        return min.x <= other.min.x && min.y <= other.min.y &&
+               min.z <= other.min.z && max.x >= other.max.x &&
+               max.y >= other.max.y && max.z >= other.max.z;
+    }
+
+    /**
+     * Get the surface area of the box, used as the cost metric when building
+     * the bounding volume hierarchy.
+     *
+     * @return   ds_math::scalar, surface area of the box.
+     */
+    ds_math::scalar getSurfaceArea() const
+    {
+        ds_math::Vector3 d = max - min;
+        return 2 * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+
+    /**
+     * Grow the box by the given margin on every side.
+     *
+     * @param   margin   ds_math::scalar, distance to grow the box by.
+     * @return           BoundingBox, enlarged box.
+     */
+    BoundingBox fattened(ds_math::scalar margin) const
+    {
+        ds_math::Vector3 m(margin, margin, margin);
+        return BoundingBox(min - m, max + m);
+    }
+
+    /**
+     * Find where a ray enters the box.
+     *
+     * @param   origin        const ds_math::Vector3 &, start of the ray.
+     * @param   direction     const ds_math::Vector3 &, direction of the ray,
+     * need not be normalized.
+     * @param   maxDistance   ds_math::scalar, furthest distance along the
+     * ray, in multiples of direction.
+     * @param   distance      ds_math::scalar *, distance the ray enters the
+     * box at, 0 if it starts inside.
+     * @return                bool, true if the ray enters the box within
+     * maxDistance.
+     */
+    bool intersectsRay(const ds_math::Vector3 &origin,
+                       const ds_math::Vector3 &direction,
+                       ds_math::scalar maxDistance,
+                       ds_math::scalar *distance) const
+    {
+        ds_math::scalar entryDistance = 0;
+        ds_math::scalar exitDistance = maxDistance;
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+            if (direction[i] == 0)
+            {
+                if (origin[i] < min[i] || origin[i] > max[i])
+                {
+                    return false;
+                }
+                continue;
+            }
+
+            ds_math::scalar inverse = 1 / direction[i];
+            ds_math::scalar t0 = (min[i] - origin[i]) * inverse;
+            ds_math::scalar t1 = (max[i] - origin[i]) * inverse;
+            if (t0 > t1)
+            {
+                ds_math::scalar t = t0;
+                t0 = t1;
+                t1 = t;
+            }
+
+            entryDistance = t0 > entryDistance ? t0 : entryDistance;
+            exitDistance = t1 < exitDistance ? t1 : exitDistance;
+            if (entryDistance > exitDistance)
+            {
+                return false;
+            }
+        }
+
+        *distance = entryDistance;
+        return true;
+    }
+
+    /**
+     * Create the smallest box that encloses two boxes.
+     *
+     * @param   a   const BoundingBox &, first box.
+     * @param   b   const BoundingBox &, second box.
+     * @return      BoundingBox, box enclosing both a and b.
+     */
+    static BoundingBox merge(const BoundingBox &a, const BoundingBox &b)
+    {
+        return BoundingBox(
+            ds_math::Vector3(a.min.x < b.min.x ? a.min.x : b.min.x,
+                             a.min.y < b.min.y ? a.min.y : b.min.y,
+                             a.min.z < b.min.z ? a.min.z : b.min.z),
+            ds_math::Vector3(a.max.x > b.max.x ? a.max.x : b.max.x,
+                             a.max.y > b.max.y ? a.max.y : b.max.y,
+                             a.max.z > b.max.z ? a.max.z : b.max.z));
+    }
+};
+
+/**
+ * Dynamic bounding volume hierarchy of axis-aligned boxes.
+ *
+ * Each leaf (proxy) stores a "fat" box, the box it was given enlarged by a
+ * margin, so that objects moving a small amount each frame do not need to be
+ * re-inserted into the tree. The tree is kept balanced with AVL style
+ * rotations so queries remain logarithmic in the number of proxies.
+ *
+ * Nodes are stored in a single array and refer to each other by index,
+ * freed nodes are recycled through a free list.
+ */
+class AabbTree
+{
+public:
+    /** Index used to indicate the absence of a node. */
+    static const int NULL_NODE = -1;
+
+    /**
+     * Constructor.
+     *
+     * @param   margin   ds_math::scalar, distance leaf boxes are enlarged by.
+     */
+    AabbTree(ds_math::scalar margin = (ds_math::scalar)0.1);
+
+    /**
+     * Insert a new proxy into the tree.
+     *
+     * @param   box        const BoundingBox &, tight bounds of the proxy.
+     * @param   userData   void *, data to associate with the proxy.
+     * @return             int, id of the proxy created.
+     */
+    int createProxy(const BoundingBox &box, void *userData);
+
+    /**
+     * Remove a proxy from the tree.
+     *
+     * @param   proxyId   int, id of the proxy to remove.
+     */
+    void destroyProxy(int proxyId);
+
+    /**
+     * Update the bounds of a proxy.
+     *
+     * The proxy is only re-inserted if the new bounds are no longer
+     * contained by its fat box.
+     *
+     * @param   proxyId   int, id of the proxy to update.
+     * @param   box       const BoundingBox &, new tight bounds of the proxy.
+     * @return            bool, true if the proxy was re-inserted.
+     */
+    bool moveProxy(int proxyId, const BoundingBox &box);
+
+    /**
+     * Get the user data associated with a proxy.
+     *
+     * @param   proxyId   int, id of the proxy.
+     * @return            void *, user data given when the proxy was created.
+     */
+    void *getUserData(int proxyId) const
+    {
+        assert(proxyId >= 0 && proxyId < (int)m_nodes.size());
+        return m_nodes[proxyId].userData;
+    }
+
+    /**
+     * Get the fat box stored for a proxy.
+     *
+     * @param   proxyId   int, id of the proxy.
+     * @return            const BoundingBox &, fat box of the proxy.
+     */
+    const BoundingBox &getFatBox(int proxyId) const
+    {
+        assert(proxyId >= 0 && proxyId < (int)m_nodes.size());
+        return m_nodes[proxyId].box;
+    }
+
+    /**
+     * Get the number of proxies in the tree.
+     *
+     * @return   unsigned int, number of proxies.
+     */
+    unsigned int getProxyCount() const
+    {
+        return m_proxyCount;
+    }
+
+    /**
+     * Get the height of the tree, an empty tree has a height of 0.
+     *
+     * @return   int, height of the tree.
+     */
+    int getHeight() const
+    {
+        return m_root == NULL_NODE ? 0 : m_nodes[m_root].height + 1;
+    }
+
+    /**
+     * Find all proxies whose fat box overlaps the given box.
+     *
+     * The callback is invoked as callback(int proxyId) and should return
+     * true to continue the query or false to stop it.
+     *
+     * @param   box        const BoundingBox &, box to query.
+     * @param   callback   T &, callback invoked for each overlapping proxy.
+     */
+    template <typename T>
+    void query(const BoundingBox &box, T &callback) const;
+
+    /**
+     * Find all proxies whose fat box, grown by the given extents, a ray
+     * enters within its current maximum distance.
+     *
+     * The callback is invoked as callback(int proxyId, scalar maxDistance)
+     * and returns the new maximum distance: less to clip the ray, such as
+     * the distance of the closest hit so far, maxDistance to continue
+     * unchanged or a negative value to stop the query.
+     *
+     * @param   origin        const ds_math::Vector3 &, start of the ray.
+     * @param   direction     const ds_math::Vector3 &, direction of the ray.
+     * @param   maxDistance   ds_math::scalar, furthest distance along the
+     * ray, in multiples of direction.
+     * @param   extents       const ds_math::Vector3 &, half size of a box
+     * swept along the ray, zero for a ray.
+     * @param   callback      T &, callback invoked for each proxy entered.
+     */
+    template <typename T>
+    void rayCast(const ds_math::Vector3 &origin,
+                 const ds_math::Vector3 &direction,
+                 ds_math::scalar maxDistance,
+                 const ds_math::Vector3 &extents,
+                 T &callback) const;
+
+private:
+    /** Maximum depth of the traversal stack used by queries. */
+    static const int MAX_STACK_SIZE = 256;
+
+    /**
+     * Node in the tree, leaves have no children.
+     */
+    struct Node
+    {
+        /** Bounds of this node (fat box for leaves). */
+        BoundingBox box;
+        /** User data, only valid for leaves. */
+        void *userData;
+        /** Parent node index, or the next free node when on the free list. */
+        int parent;
+        /** Child node indices. */
+        int children[2];
+        /** Height of the node, leaves are 0 and free nodes are -1. */
+        int height;
+
+        bool isLeaf() const
+        {
+            return children[0] == NULL_NODE;
+        }
+    };
+
+    int allocateNode();
+    void freeNode(int nodeId);
+    void insertLeaf(int leaf);
+    void removeLeaf(int leaf);
+    int balance(int nodeId);
+
+    /** Node storage. */
+    std::vector<Node> m_nodes;
+    /** Root node index. */
+    int m_root;
+    /** Head of the free list. */
+    int m_freeList;
+    /** Number of proxies in the tree. */
+    unsigned int m_proxyCount;
+    /** Distance leaf boxes are enlarged by. */
+    ds_math::scalar m_margin;
+};
+
+template <typename T>
+void AabbTree::query(const BoundingBox &box, T &callback) const
+{
+    int stack[MAX_STACK_SIZE];
+    int count = 0;
+
+    if (m_root != NULL_NODE)
+    {
+        stack[count++] = m_root;
+    }
+
+    while (count > 0)
+    {
+        const Node &node = m_nodes[stack[--count]];
+
+        if (node.box.overlaps(box))
+        {
+            if (node.isLeaf())
+            {
+                if (!callback((int)(&node - &m_nodes[0])))
+                {
+                    return;
+                }
+            }
+            else
+            {
+                assert(count + 2 <= MAX_STACK_SIZE &&
+                       "AabbTree query stack overflow.");
+                stack[count++] = node.children[0];
+                stack[count++] = node.children[1];
+            }
+        }
+    }
+}
+
+template <typename T>
+void AabbTree::rayCast(const ds_math::Vector3 &origin,
+                       const ds_math::Vector3 &direction,
+                       ds_math::scalar maxDistance,
+                       const ds_math::Vector3 &extents,
+                       T &callback) const
+{
+    int stack[MAX_STACK_SIZE];
+    int count = 0;
+
+    if (m_root != NULL_NODE)
+    {
+        stack[count++] = m_root;
+    }
+
+    while (count > 0)
+    {
+        const Node &node = m_nodes[stack[--count]];
+
+        BoundingBox box(node.box.min - extents, node.box.max + extents);
+        ds_math::scalar distance;
+        if (!box.intersectsRay(origin, direction, maxDistance, &distance))
+        {
+            continue;
+        }
+
+        if (node.isLeaf())
+        {
+            maxDistance = callback((int)(&node - &m_nodes[0]), maxDistance);
+            if (maxDistance < 0)
+            {
+                return;
+            }
+        }
+        else
+        {
+            assert(count + 2 <= MAX_STACK_SIZE &&
+                   "AabbTree ray cast stack overflow.");
+            stack[count++] = node.children[0];
+            stack[count++] = node.children[1];
+        }
+    }
+}
+}
@@ -29,13 +29,16 @@
 #include <cstdio>
 #include <cstdlib>
 #include <iostream>
+#include <limits>
 #include <memory.h>
 
 #include <engine/system/physics/CollisionFine.h>
+#include <engine/system/physics/ConvexCollision.h>
 
 using namespace ds_phys;
 
-CollisionPrimitive::CollisionPrimitive() : body(nullptr)
+CollisionPrimitive::CollisionPrimitive(CollisionPrimitiveType type)
+    : body(nullptr), layer(1), mask(0xffffffff), m_type(type)
 {
 }
 
@@ -47,6 +50,366 @@ void CollisionPrimitive::calculateInternals()
     }
 }
 
+ds_math::Vector3
+CollisionPrimitive::getPointInLocalSpace(const ds_math::Vector3 &point) const
+{
+    return getDirectionInLocalSpace(point - getAxis(3));
+}
+
+ds_math::Vector3 CollisionPrimitive::getDirectionInLocalSpace(
+    const ds_math::Vector3 &direction) const
+{
+    return ds_math::Vector3(ds_math::Vector3::Dot(direction, getAxis(0)),
+                            ds_math::Vector3::Dot(direction, getAxis(1)),
+                            ds_math::Vector3::Dot(direction, getAxis(2)));
+}
+
+ds_math::Vector3 CollisionPrimitive::getDirectionInWorldSpace(
+    const ds_math::Vector3 &direction) const
+{
+    return getAxis(0) * direction.x + getAxis(1) * direction.y +
+           getAxis(2) * direction.z;
+}
+
+/**
+ * Get the world-space bounds of a box in a primitive's space.
+ */
+static BoundingBox transformBounds(const ds_math::Matrix4 &transform,
+                                   const BoundingBox &local)
+{
+    ds_math::Vector3 halfSize = (local.max - local.min) * 0.5f;
+    ds_math::Vector3 centre = (local.max + local.min) * 0.5f;
+
+    // Project the local bounds onto each world axis, as for a box
+    ds_math::Vector3 extents;
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        extents[i] = fabs(transform[0][i]) * halfSize.x +
+                     fabs(transform[1][i]) * halfSize.y +
+                     fabs(transform[2][i]) * halfSize.z;
+    }
+
+    centre = ds_math::Matrix4::Transform(transform, centre);
+    return BoundingBox(centre - extents, centre + extents);
+}
+
+bool CollisionBox::calculateBoundingBox(BoundingBox *box) const
+{
+    // Project the box's half sizes onto each world axis
+    ds_math::Vector3 extents;
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        extents[i] = fabs(transform[0][i]) * halfSize.x +
+                     fabs(transform[1][i]) * halfSize.y +
+                     fabs(transform[2][i]) * halfSize.z;
+    }
+
+    ds_math::Vector3 centre = getAxis(3);
+    box->min = centre - extents;
+    box->max = centre + extents;
+
+    return true;
+}
+
+bool CollisionSphere::calculateBoundingBox(BoundingBox *box) const
+{
+    ds_math::Vector3 centre = getAxis(3);
+    ds_math::Vector3 extents(radius, radius, radius);
+    box->min = centre - extents;
+    box->max = centre + extents;
+
+    return true;
+}
+
+bool CollisionCapsule::calculateBoundingBox(BoundingBox *box) const
+{
+    // Capsule runs along its local y axis
+    ds_math::Vector3 halfSegment = getAxis(1) * (height / 2.0f);
+    ds_math::Vector3 extents(fabs(halfSegment.x) + radius,
+                             fabs(halfSegment.y) + radius,
+                             fabs(halfSegment.z) + radius);
+
+    ds_math::Vector3 centre = getAxis(3);
+    box->min = centre - extents;
+    box->max = centre + extents;
+
+    return true;
+}
+
+CollisionHeightfield::CollisionHeightfield()
+    : CollisionPrimitive(CollisionPrimitiveType::Heightfield),
+      scale(1.0f, 1.0f, 1.0f), m_width(0), m_depth(0), m_minHeight(0),
+      m_maxHeight(0)
+{
+}
+
+void CollisionHeightfield::setHeights(
+    const std::vector<ds_math::scalar> &heights,
+    unsigned int width,
+    unsigned int depth)
+{
+    assert(width >= 2 && depth >= 2 && heights.size() == width * depth &&
+           "Heightfield needs at least 2x2 samples.");
+
+    m_heights = heights;
+    m_width = width;
+    m_depth = depth;
+
+    auto range = std::minmax_element(m_heights.begin(), m_heights.end());
+    m_minHeight = *range.first;
+    m_maxHeight = *range.second;
+}
+
+ds_math::Vector3 CollisionHeightfield::getTriangle(
+    int x, int z, unsigned int half, ds_math::Vector3 *vertices) const
+{
+    // Both triangles share the diagonal from (x, z + 1) to (x + 1, z)
+    vertices[0] = getSample(x, z + 1);
+    vertices[1] = getSample(x + 1, z);
+    vertices[2] = half == 0 ? getSample(x, z) : getSample(x + 1, z + 1);
+
+    ds_math::Vector3 normal = ds_math::Vector3::Normalize(
+        ds_math::Vector3::Cross(vertices[1] - vertices[0],
+                                vertices[2] - vertices[0]));
+    return normal.y < 0 ? -normal : normal;
+}
+
+bool CollisionHeightfield::getTriangleAt(const ds_math::Vector3 &point,
+                                         ds_math::Vector3 *vertices,
+                                         ds_math::Vector3 *normal) const
+{
+    ds_math::scalar cellX = point.x / scale.x + (m_width - 1) / 2.0f;
+    ds_math::scalar cellZ = point.z / scale.z + (m_depth - 1) / 2.0f;
+    if (m_width < 2 || m_depth < 2 || cellX < 0 || cellZ < 0 ||
+        cellX > m_width - 1 || cellZ > m_depth - 1)
+    {
+        return false;
+    }
+
+    int x = std::min((int)cellX, (int)m_width - 2);
+    int z = std::min((int)cellZ, (int)m_depth - 2);
+
+    // The first triangle holds the corner at (x, z)
+    unsigned int half = (cellX - x) + (cellZ - z) <= 1 ? 0 : 1;
+    *normal = getTriangle(x, z, half, vertices);
+    return true;
+}
+
+bool CollisionHeightfield::getCells(
+    const BoundingBox &box, int *minX, int *minZ, int *maxX, int *maxZ) const
+{
+    if (m_width < 2 || m_depth < 2 || box.min.y > m_maxHeight * scale.y)
+    {
+        return false;
+    }
+
+    ds_math::scalar lowX = box.min.x / scale.x + (m_width - 1) / 2.0f;
+    ds_math::scalar highX = box.max.x / scale.x + (m_width - 1) / 2.0f;
+    ds_math::scalar lowZ = box.min.z / scale.z + (m_depth - 1) / 2.0f;
+    ds_math::scalar highZ = box.max.z / scale.z + (m_depth - 1) / 2.0f;
+    if (highX < 0 || highZ < 0 || lowX > m_width - 1 || lowZ > m_depth - 1)
+    {
+        return false;
+    }
+
+    *minX = std::max((int)floor(lowX), 0);
+    *minZ = std::max((int)floor(lowZ), 0);
+    *maxX = std::min((int)floor(highX), (int)m_width - 2);
+    *maxZ = std::min((int)floor(highZ), (int)m_depth - 2);
+    return true;
+}
+
+BoundingBox CollisionHeightfield::getLocalBounds() const
+{
+    ds_math::Vector3 halfSize(fabs(scale.x) * (m_width - 1) / 2.0f, 0,
+                              fabs(scale.z) * (m_depth - 1) / 2.0f);
+    return BoundingBox(
+        ds_math::Vector3(-halfSize.x, m_minHeight * scale.y, -halfSize.z),
+        ds_math::Vector3(halfSize.x, m_maxHeight * scale.y, halfSize.z));
+}
+
+bool CollisionHeightfield::calculateBoundingBox(BoundingBox *box) const
+{
+    *box = transformBounds(transform, getLocalBounds());
+    return true;
+}
+
+CollisionConvexHull::CollisionConvexHull()
+    : CollisionPrimitive(CollisionPrimitiveType::ConvexHull)
+{
+}
+
+void CollisionConvexHull::setVertices(
+    const std::vector<ds_math::Vector3> &vertices)
+{
+    assert(!vertices.empty() && "Convex hull needs at least one point.");
+
+    m_vertices = vertices;
+    m_localBounds = BoundingBox(vertices[0], vertices[0]);
+    for (const ds_math::Vector3 &vertex : vertices)
+    {
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+            m_localBounds.min[i] = std::min(m_localBounds.min[i], vertex[i]);
+            m_localBounds.max[i] = std::max(m_localBounds.max[i], vertex[i]);
+        }
+    }
+}
+
+ds_math::Vector3
+CollisionConvexHull::getSupport(const ds_math::Vector3 &direction) const
+{
+    ds_math::Vector3 local = getDirectionInLocalSpace(direction);
+
+    unsigned int furthest = 0;
+    ds_math::scalar furthestDistance =
+        ds_math::Vector3::Dot(m_vertices[0], local);
+    for (unsigned int i = 1; i < m_vertices.size(); ++i)
+    {
+        ds_math::scalar distance = ds_math::Vector3::Dot(m_vertices[i], local);
+        if (distance > furthestDistance)
+        {
+            furthest = i;
+            furthestDistance = distance;
+        }
+    }
+
+    return ds_math::Matrix4::Transform(transform, m_vertices[furthest]);
+}
+
+bool CollisionConvexHull::calculateBoundingBox(BoundingBox *box) const
+{
+    *box = transformBounds(transform, m_localBounds);
+    return true;
+}
+
+CollisionCompound::CollisionCompound()
+    : CollisionPrimitive(CollisionPrimitiveType::Compound), m_tree(0)
+{
+}
+
+CollisionPrimitive *
+CollisionCompound::addChild(std::unique_ptr<CollisionPrimitive> &&child)
+{
+    assert(child && child->getType() != CollisionPrimitiveType::Compound &&
+           "Compound children can't be compounds.");
+
+    // Bounds of the child in the compound's space
+    CollisionPrimitive *added = child.get();
+    added->transform = added->offset;
+    BoundingBox box;
+    bool bounded = added->calculateBoundingBox(&box);
+    assert(bounded && "Compound children must be bounded.");
+    (void)bounded;
+
+    m_localBounds =
+        m_children.empty() ? box : BoundingBox::merge(m_localBounds, box);
+    m_tree.createProxy(box,
+                       reinterpret_cast<void *>((intptr_t)m_children.size()));
+    m_children.push_back(std::move(child));
+
+    added->body = body;
+    added->transform = transform * added->offset;
+    return added;
+}
+
+void CollisionCompound::calculateInternals()
+{
+    CollisionPrimitive::calculateInternals();
+
+    for (const std::unique_ptr<CollisionPrimitive> &child : m_children)
+    {
+        child->body = body;
+        child->transform = transform * child->offset;
+    }
+}
+
+bool CollisionCompound::calculateBoundingBox(BoundingBox *box) const
+{
+    *box = transformBounds(transform, m_localBounds);
+    return true;
+}
+
+namespace
+{
+/**
+ * Support mapping of a convex primitive, a box, sphere, capsule or convex
+ * hull, for ConvexCollision. Spheres and capsules are given by their core
+ * and radius.
+ */
+class PrimitiveShape : public ConvexShape
+{
+public:
+    explicit PrimitiveShape(const CollisionPrimitive &primitive)
+        : m_primitive(primitive)
+    {
+        if (primitive.getType() == CollisionPrimitiveType::Sphere)
+        {
+            radius = static_cast<const CollisionSphere &>(primitive).radius;
+        }
+        else if (primitive.getType() == CollisionPrimitiveType::Capsule)
+        {
+            radius = static_cast<const CollisionCapsule &>(primitive).radius;
+        }
+    }
+
+    virtual ds_math::Vector3
+    getSupport(const ds_math::Vector3 &direction) const
+    {
+        switch (m_primitive.getType())
+        {
+        case CollisionPrimitiveType::Box:
+        {
+            const CollisionBox &box =
+                static_cast<const CollisionBox &>(m_primitive);
+            ds_math::Vector3 point = box.getAxis(3);
+            for (unsigned int i = 0; i < 3; ++i)
+            {
+                ds_math::Vector3 axis = box.getAxis(i);
+                point += axis * (ds_math::Vector3::Dot(direction, axis) >= 0
+                                     ? box.halfSize[i]
+                                     : -box.halfSize[i]);
+            }
+            return point;
+        }
+        case CollisionPrimitiveType::Capsule:
+        {
+            // Capsule runs along its local y axis
+            const CollisionCapsule &capsule =
+                static_cast<const CollisionCapsule &>(m_primitive);
+            ds_math::Vector3 halfSegment =
+                capsule.getAxis(1) * (capsule.height / 2.0f);
+            return ds_math::Vector3::Dot(direction, halfSegment) >= 0
+                       ? capsule.getAxis(3) + halfSegment
+                       : capsule.getAxis(3) - halfSegment;
+        }
+        case CollisionPrimitiveType::ConvexHull:
+            return static_cast<const CollisionConvexHull &>(m_primitive)
+                .getSupport(direction);
+        default:
+            return m_primitive.getAxis(3);
+        }
+    }
+
+    virtual ds_math::Vector3 getCentre() const
+    {
+        if (m_primitive.getType() == CollisionPrimitiveType::ConvexHull)
+        {
+            const BoundingBox &bounds =
+                static_cast<const CollisionConvexHull &>(m_primitive)
+                    .getLocalBounds();
+            return ds_math::Matrix4::Transform(m_primitive.getTransform(),
+                                               (bounds.min + bounds.max) *
+                                                   0.5f);
+        }
+        return m_primitive.getAxis(3);
+    }
+
+private:
+    const CollisionPrimitive &m_primitive;
+};
+}
+
 bool IntersectionTests::sphereAndHalfSpace(const CollisionSphere &sphere,
                                            const CollisionPlane &plane)
 {
@@ -90,7 +453,9 @@ static inline bool overlapOnAxis(const CollisionBox &one,
                                  ds_math::Vector3 axis,
                                  const ds_math::Vector3 &toCentre)
 {
-    // if (ds_math::Vector3::Dot(axis, axis) < 0.0001) return true;
+    // Cross products of almost parallel axes can't separate the boxes
+    if (ds_math::Vector3::Dot(axis, axis) < 0.0001)
+        return true;
 
     // Project the half-size of one onto axis
     ds_math::scalar oneProject = transformToAxis(one, axis);
@@ -185,100 +550,636 @@ bool IntersectionTests::boxAndHalfSpace(const CollisionBox &box,
     return boxDistance <= plane.offset;
 }
 
-unsigned CollisionDetector::sphereAndHalfSpace(const CollisionSphere &sphere,
-                                               const CollisionPlane &plane,
-                                               CollisionData *data)
+bool IntersectionTests::rayAndSphere(const ds_math::Vector3 &origin,
+                                     const ds_math::Vector3 &direction,
+                                     ds_math::scalar maxDistance,
+                                     const ds_math::Vector3 &centre,
+                                     ds_math::scalar radius,
+                                     RayIntersection *hit)
 {
-    // Make sure we have contacts
-    if (data->contactsLeft <= 0)
-        return 0;
-
-    // Cache the sphere position
-    ds_math::Vector3 position = sphere.getAxis(3);
-
-    // Find the distance from the plane
-    ds_math::scalar ballDistance =
-        ds_math::Vector3::Dot(plane.direction, position) - sphere.radius -
-        plane.offset;
-
-    if (ballDistance >= 0)
-        return 0;
+    ds_math::Vector3 offset = origin - centre;
+    ds_math::scalar b = ds_math::Vector3::Dot(offset, direction);
+    ds_math::scalar c = ds_math::Vector3::Dot(offset, offset) - radius * radius;
 
-    // Create the contact - it has a normal in the plane direction.
-    Contact *contact = data->contacts;
-    contact->contactNormal = plane.direction;
-    contact->penetration = -ballDistance;
-    contact->contactPoint =
-        position - plane.direction * (ballDistance + sphere.radius);
+    if (c <= 0)
+    {
+        hit->distance = 0;
+        hit->normal = -direction;
+        return true;
+    }
 
+    // Starting outside and pointing away, or missing altogether
+    ds_math::scalar discriminant = b * b - c;
+    if (b > 0 || discriminant < 0)
+    {
+        return false;
+    }
 
-    contact->setBodyData(
-        sphere.body ? (sphere.body->getMass() == 0 ? nullptr : sphere.body)
-                    : (nullptr),
-        plane.body ? (plane.body->getMass() == 0 ? nullptr : plane.body)
-                   : (nullptr),
-        data->friction, data->restitution);
+    ds_math::scalar distance = -b - sqrt(discriminant);
+    if (distance > maxDistance)
+    {
+        return false;
+    }
 
-    data->addContacts(1);
-    return 1;
+    hit->distance = distance;
+    hit->normal = ds_math::Vector3::Normalize(offset + direction * distance);
+    return true;
 }
 
-unsigned CollisionDetector::sphereAndSphere(const CollisionSphere &one,
-                                            const CollisionSphere &two,
-                                            CollisionData *data)
+bool IntersectionTests::rayAndSegment(const ds_math::Vector3 &origin,
+                                      const ds_math::Vector3 &direction,
+                                      ds_math::scalar maxDistance,
+                                      const ds_math::Vector3 &start,
+                                      const ds_math::Vector3 &end,
+                                      ds_math::scalar radius,
+                                      RayIntersection *hit)
 {
-    // Make sure we have contacts
-    if (data->contactsLeft <= 0)
-        return 0;
-    if ((((one.body) && (one.body->getMass() == 0)) || !(one.body)) &&
-        (((two.body) && (two.body->getMass() == 0)) || !(two.body)))
-        return 0;
+    // The capsule is the cylinder around the segment and a sphere at each
+    // end, the ray meets it where it first meets any of them
+    bool found = false;
+    RayIntersection nearest;
+    nearest.distance = maxDistance;
+
+    RayIntersection cap;
+    for (const ds_math::Vector3 *centre : {&start, &end})
+    {
+        if (rayAndSphere(origin, direction, nearest.distance, *centre, radius,
+                         &cap))
+        {
+            nearest = cap;
+            found = true;
+        }
+    }
 
-    // Cache the sphere positions
-    ds_math::Vector3 positionOne = one.getAxis(3);
-    ds_math::Vector3 positionTwo = two.getAxis(3);
+    ds_math::Vector3 axis = end - start;
+    ds_math::scalar lengthSquared = ds_math::Vector3::Dot(axis, axis);
+    if (lengthSquared > 0)
+    {
+        // Remove the parts along the axis, leaving a circle in the plane
+        // across it
+        ds_math::Vector3 offset = origin - start;
+        ds_math::Vector3 acrossOffset =
+            offset -
+            axis * (ds_math::Vector3::Dot(offset, axis) / lengthSquared);
+        ds_math::Vector3 acrossDirection =
+            direction -
+            axis * (ds_math::Vector3::Dot(direction, axis) / lengthSquared);
+
+        ds_math::scalar a =
+            ds_math::Vector3::Dot(acrossDirection, acrossDirection);
+        ds_math::scalar b =
+            ds_math::Vector3::Dot(acrossOffset, acrossDirection);
+        ds_math::scalar c = ds_math::Vector3::Dot(acrossOffset, acrossOffset) -
+                            radius * radius;
+
+        ds_math::scalar distance = -1;
+        if (c <= 0)
+        {
+            distance = 0;
+        }
+        else if (a > 0 && b < 0 && b * b - a * c >= 0)
+        {
+            distance = (-b - sqrt(b * b - a * c)) / a;
+        }
 
-    // Find the vector between the objects
-    ds_math::Vector3 midline = positionOne - positionTwo;
-    ds_math::scalar size = midline.Magnitude();
+        if (distance >= 0 && distance <= nearest.distance)
+        {
+            ds_math::Vector3 point = offset + direction * distance;
+            ds_math::scalar along =
+                ds_math::Vector3::Dot(point, axis) / lengthSquared;
+            if (along >= 0 && along <= 1)
+            {
+                nearest.distance = distance;
+                nearest.normal =
+                    distance > 0
+                        ? ds_math::Vector3::Normalize(point - axis * along)
+                        : -direction;
+                found = true;
+            }
+        }
+    }
 
-    // See if it is large enough.
-    if (size <= 0.0f || size >= one.radius + two.radius)
+    if (found)
     {
-        return 0;
+        *hit = nearest;
     }
+    return found;
+}
 
-    // We manually create the normal, because we have the
-    // size to hand.
-    ds_math::Vector3 normal = midline * ((1.0) / size);
-
-    Contact *contact = data->contacts;
-    contact->contactNormal = normal;
-    contact->contactPoint = positionOne + midline * 0.5;
-    contact->penetration = (one.radius + two.radius - size);
+bool IntersectionTests::rayAndHalfSpace(const ds_math::Vector3 &origin,
+                                        const ds_math::Vector3 &direction,
+                                        ds_math::scalar maxDistance,
+                                        const CollisionPlane &plane,
+                                        ds_math::scalar radius,
+                                        RayIntersection *hit)
+{
+    ds_math::scalar height =
+        ds_math::Vector3::Dot(plane.direction, origin) - plane.offset - radius;
+    if (height <= 0)
+    {
+        hit->distance = 0;
+        hit->normal = -direction;
+        return true;
+    }
 
-    contact->setBodyData(
-        one.body ? (one.body->getMass() == 0 ? nullptr : one.body) : (nullptr),
-        two.body ? (two.body->getMass() == 0 ? nullptr : two.body) : (nullptr),
-        data->friction, data->restitution);
+    ds_math::scalar speed = ds_math::Vector3::Dot(plane.direction, direction);
+    if (speed >= 0 || -height / speed > maxDistance)
+    {
+        return false;
+    }
 
-    data->addContacts(1);
-    return 1;
+    hit->distance = -height / speed;
+    hit->normal = plane.direction;
+    return true;
 }
 
-
-/*
- * This function checks if the two boxes overlap
- * along the given axis, returning the ammount of overlap.
- * The final parameter toCentre
- * is used to pass in the vector between the boxes centre
- * points, to avoid having to recalculate it each time.
+/**
+ * Check whether a point on the plane of a triangle lies within it.
  */
-static inline ds_math::scalar
-penetrationOnAxis(const CollisionBox &one,
-                  const CollisionBox &two,
-                  const ds_math::Vector3 &axis,
-                  const ds_math::Vector3 &toCentre)
+static bool pointInTriangle(const ds_math::Vector3 &point,
+                            const ds_math::Vector3 *vertices)
+{
+    ds_math::Vector3 normal = ds_math::Vector3::Cross(
+        vertices[1] - vertices[0], vertices[2] - vertices[0]);
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        const ds_math::Vector3 &start = vertices[i];
+        const ds_math::Vector3 &end = vertices[(i + 1) % 3];
+        if (ds_math::Vector3::Dot(
+                ds_math::Vector3::Cross(end - start, point - start), normal) <
+            0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool IntersectionTests::rayAndTriangle(const ds_math::Vector3 &origin,
+                                       const ds_math::Vector3 &direction,
+                                       ds_math::scalar maxDistance,
+                                       const ds_math::Vector3 *vertices,
+                                       ds_math::scalar radius,
+                                       RayIntersection *hit)
+{
+    ds_math::Vector3 normal = ds_math::Vector3::Cross(
+        vertices[1] - vertices[0], vertices[2] - vertices[0]);
+    ds_math::scalar area = ds_math::Vector3::Magnitude(normal);
+    if (area <= 0)
+    {
+        return false;
+    }
+    normal = normal * (1.0f / area);
+
+    // Face the start of the ray
+    ds_math::scalar height =
+        ds_math::Vector3::Dot(origin - vertices[0], normal);
+    if (height < 0)
+    {
+        normal = -normal;
+        height = -height;
+    }
+
+    bool found = false;
+    RayIntersection nearest;
+    nearest.distance = maxDistance;
+
+    // The face, pushed out by the radius
+    ds_math::scalar speed = ds_math::Vector3::Dot(direction, normal);
+    ds_math::scalar distance = -1;
+    if (height <= radius)
+    {
+        distance = 0;
+    }
+    else if (speed < 0)
+    {
+        distance = (height - radius) / -speed;
+    }
+
+    if (distance >= 0 && distance <= nearest.distance)
+    {
+        ds_math::Vector3 point = origin + direction * distance;
+        point -= normal * ds_math::Vector3::Dot(point - vertices[0], normal);
+        if (pointInTriangle(point, vertices))
+        {
+            nearest.distance = distance;
+            nearest.normal = distance > 0 ? normal : -direction;
+            found = true;
+        }
+    }
+
+    // The rounded edges and corners of a grown triangle
+    if (radius > 0)
+    {
+        RayIntersection edge;
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+            if (rayAndSegment(origin, direction, nearest.distance,
+                              vertices[i], vertices[(i + 1) % 3], radius,
+                              &edge))
+            {
+                nearest = edge;
+                found = true;
+            }
+        }
+    }
+
+    if (found)
+    {
+        *hit = nearest;
+    }
+    return found;
+}
+
+bool IntersectionTests::rayAndHeightfield(
+    const ds_math::Vector3 &origin,
+    const ds_math::Vector3 &direction,
+    ds_math::scalar maxDistance,
+    const CollisionHeightfield &heightfield,
+    ds_math::scalar radius,
+    RayIntersection *hit)
+{
+    const int width = (int)heightfield.getWidth();
+    const int depth = (int)heightfield.getDepth();
+    const ds_math::Vector3 &scale = heightfield.scale;
+    if (width < 2 || depth < 2)
+    {
+        return false;
+    }
+
+    // Work in the heightfield's space
+    ds_math::Vector3 start = heightfield.getPointInLocalSpace(origin);
+    ds_math::Vector3 heading = heightfield.getDirectionInLocalSpace(direction);
+
+    // Clip the ray to the grown bounds of the heightfield
+    BoundingBox bounds = heightfield.getLocalBounds().fattened(radius);
+    ds_math::scalar enter, fromEnd;
+    if (!bounds.intersectsRay(start, heading, maxDistance, &enter) ||
+        !bounds.intersectsRay(start + heading * maxDistance, -heading,
+                              maxDistance, &fromEnd))
+    {
+        return false;
+    }
+    ds_math::scalar leave = maxDistance - fromEnd;
+
+    // Cells this far from the ray's cell may be touched by the grown
+    // triangles
+    int reach = (int)ceil(radius / std::min(scale.x, scale.z));
+
+    // Walk the cells the ray passes over, in order
+    ds_math::Vector3 point = start + heading * enter;
+    ds_math::scalar cell[2] = {point.x / scale.x + (width - 1) / 2.0f,
+                               point.z / scale.z + (depth - 1) / 2.0f};
+    ds_math::scalar speed[2] = {heading.x / scale.x, heading.z / scale.z};
+    int index[2], step[2];
+    ds_math::scalar next[2], delta[2];
+    for (unsigned int i = 0; i < 2; ++i)
+    {
+        index[i] = (int)floor(cell[i]);
+        step[i] = speed[i] > 0 ? 1 : -1;
+        if (speed[i] != 0)
+        {
+            ds_math::scalar boundary =
+                (ds_math::scalar)(speed[i] > 0 ? index[i] + 1 : index[i]);
+            next[i] = enter + (boundary - cell[i]) / speed[i];
+            delta[i] = 1.0f / fabs(speed[i]);
+        }
+        else
+        {
+            next[i] = std::numeric_limits<ds_math::scalar>::max();
+            delta[i] = 0;
+        }
+    }
+
+    bool found = false;
+    RayIntersection nearest;
+    nearest.distance = maxDistance;
+
+    // Any hit is found by the time the walk passes it, so stop there
+    ds_math::scalar cellEnter = enter;
+    while (cellEnter <= std::min(leave, nearest.distance))
+    {
+        int minX = std::max(index[0] - reach, 0);
+        int maxX = std::min(index[0] + reach, width - 2);
+        int minZ = std::max(index[1] - reach, 0);
+        int maxZ = std::min(index[1] + reach, depth - 2);
+        for (int z = minZ; z <= maxZ; ++z)
+        {
+            for (int x = minX; x <= maxX; ++x)
+            {
+                for (unsigned int half = 0; half < 2; ++half)
+                {
+                    ds_math::Vector3 vertices[3];
+                    heightfield.getTriangle(x, z, half, vertices);
+
+                    RayIntersection triangle;
+                    if (rayAndTriangle(start, heading, nearest.distance,
+                                       vertices, radius, &triangle))
+                    {
+                        nearest = triangle;
+                        found = true;
+                    }
+                }
+            }
+        }
+
+        unsigned int axis = next[0] < next[1] ? 0 : 1;
+        cellEnter = next[axis];
+        next[axis] += delta[axis];
+        index[axis] += step[axis];
+    }
+
+    if (!found)
+    {
+        return false;
+    }
+
+    hit->distance = nearest.distance;
+    hit->normal = heightfield.getDirectionInWorldSpace(nearest.normal);
+    return true;
+}
+
+/**
+ * Find where a ray, in the box's space, enters a box centred on the origin
+ * and aligned with the axes.
+ */
+static bool rayAndAlignedBox(const ds_math::Vector3 &origin,
+                             const ds_math::Vector3 &direction,
+                             ds_math::scalar maxDistance,
+                             const ds_math::Vector3 &halfSize,
+                             RayIntersection *hit)
+{
+    BoundingBox box(-halfSize, halfSize);
+    ds_math::scalar distance;
+    if (!box.intersectsRay(origin, direction, maxDistance, &distance))
+    {
+        return false;
+    }
+
+    hit->distance = distance;
+    hit->normal = -direction;
+    if (distance > 0)
+    {
+        // The ray entered through the face it reached last
+        ds_math::scalar latest = -1;
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+            if (direction[i] != 0)
+            {
+                ds_math::scalar entry =
+                    ((direction[i] > 0 ? -halfSize[i] : halfSize[i]) -
+                     origin[i]) /
+                    direction[i];
+                if (entry > latest)
+                {
+                    latest = entry;
+                    hit->normal = ds_math::Vector3(0, 0, 0);
+                    hit->normal[i] = direction[i] > 0 ? -1.0f : 1.0f;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool IntersectionTests::rayAndBox(const ds_math::Vector3 &origin,
+                                  const ds_math::Vector3 &direction,
+                                  ds_math::scalar maxDistance,
+                                  const CollisionBox &box,
+                                  ds_math::scalar radius,
+                                  RayIntersection *hit)
+{
+    // Work in the box's space
+    ds_math::Vector3 offset = origin - box.getAxis(3);
+    ds_math::Vector3 localOrigin, localDirection;
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        localOrigin[i] = ds_math::Vector3::Dot(offset, box.getAxis(i));
+        localDirection[i] = ds_math::Vector3::Dot(direction, box.getAxis(i));
+    }
+
+    bool found = false;
+    RayIntersection nearest;
+    nearest.distance = maxDistance;
+    RayIntersection part;
+
+    if (radius <= 0)
+    {
+        found = rayAndAlignedBox(localOrigin, localDirection, maxDistance,
+                                 box.halfSize, &nearest);
+    }
+    else
+    {
+        // A rounded box is the box grown along each axis in turn, and a
+        // capsule along each edge
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+            ds_math::Vector3 halfSize = box.halfSize;
+            halfSize[i] += radius;
+            if (rayAndAlignedBox(localOrigin, localDirection,
+                                 nearest.distance, halfSize, &part))
+            {
+                nearest = part;
+                found = true;
+            }
+        }
+
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+            unsigned int j = (i + 1) % 3;
+            unsigned int k = (i + 2) % 3;
+            for (unsigned int corner = 0; corner < 4; ++corner)
+            {
+                ds_math::Vector3 start;
+                start[i] = -box.halfSize[i];
+                start[j] = corner & 1 ? box.halfSize[j] : -box.halfSize[j];
+                start[k] = corner & 2 ? box.halfSize[k] : -box.halfSize[k];
+                ds_math::Vector3 end = start;
+                end[i] = box.halfSize[i];
+
+                if (rayAndSegment(localOrigin, localDirection,
+                                  nearest.distance, start, end, radius,
+                                  &part))
+                {
+                    nearest = part;
+                    found = true;
+                }
+            }
+        }
+    }
+
+    if (!found)
+    {
+        return false;
+    }
+
+    // Back to world space
+    hit->distance = nearest.distance;
+    hit->normal = box.getAxis(0) * nearest.normal.x +
+                  box.getAxis(1) * nearest.normal.y +
+                  box.getAxis(2) * nearest.normal.z;
+    return true;
+}
+
+bool IntersectionTests::rayAndPrimitive(const ds_math::Vector3 &origin,
+                                        const ds_math::Vector3 &direction,
+                                        ds_math::scalar maxDistance,
+                                        const CollisionPrimitive &primitive,
+                                        ds_math::scalar radius,
+                                        RayIntersection *hit)
+{
+    switch (primitive.getType())
+    {
+    case CollisionPrimitiveType::Box:
+        return rayAndBox(origin, direction, maxDistance,
+                         static_cast<const CollisionBox &>(primitive), radius,
+                         hit);
+    case CollisionPrimitiveType::Sphere:
+        return rayAndSphere(
+            origin, direction, maxDistance, primitive.getAxis(3),
+            static_cast<const CollisionSphere &>(primitive).radius + radius,
+            hit);
+    case CollisionPrimitiveType::Plane:
+        return rayAndHalfSpace(origin, direction, maxDistance,
+                               static_cast<const CollisionPlane &>(primitive),
+                               radius, hit);
+    case CollisionPrimitiveType::Capsule:
+    {
+        // Capsule runs along its local y axis
+        const CollisionCapsule &capsule =
+            static_cast<const CollisionCapsule &>(primitive);
+        ds_math::Vector3 halfSegment =
+            capsule.getAxis(1) * (capsule.height / 2.0f);
+        return rayAndSegment(origin, direction, maxDistance,
+                             capsule.getAxis(3) - halfSegment,
+                             capsule.getAxis(3) + halfSegment,
+                             capsule.radius + radius, hit);
+    }
+    case CollisionPrimitiveType::Heightfield:
+        return rayAndHeightfield(
+            origin, direction, maxDistance,
+            static_cast<const CollisionHeightfield &>(primitive), radius, hit);
+    case CollisionPrimitiveType::ConvexHull:
+        return ConvexCollision::rayCast(origin, direction, maxDistance,
+                                        PrimitiveShape(primitive), radius,
+                                        &hit->distance, &hit->normal);
+    case CollisionPrimitiveType::Compound:
+    {
+        // Nearest hit of the children the ray reaches
+        bool found = false;
+        auto test = [&](const CollisionPrimitive &child,
+                        ds_math::scalar distance) {
+            if (rayAndPrimitive(origin, direction, distance, child, radius,
+                                hit))
+            {
+                found = true;
+                return hit->distance;
+            }
+            return distance;
+        };
+        static_cast<const CollisionCompound &>(primitive).rayCastChildren(
+            origin, direction, maxDistance, radius, test);
+        return found;
+    }
+    default:
+        return false;
+    }
+}
+
+unsigned CollisionDetector::sphereAndHalfSpace(const CollisionSphere &sphere,
+                                               const CollisionPlane &plane,
+                                               CollisionData *data)
+{
+    // Make sure we have contacts
+    if (data->contactsLeft <= 0)
+        return 0;
+
+    // Cache the sphere position
+    ds_math::Vector3 position = sphere.getAxis(3);
+
+    // Find the distance from the plane
+    ds_math::scalar ballDistance =
+        ds_math::Vector3::Dot(plane.direction, position) - sphere.radius -
+        plane.offset;
+
+    if (ballDistance >= 0)
+        return 0;
+
+    // Create the contact - it has a normal in the plane direction.
+    Contact *contact = data->contacts;
+    contact->contactNormal = plane.direction;
+    contact->penetration = -ballDistance;
+    contact->contactPoint =
+        position - plane.direction * (ballDistance + sphere.radius);
+
+
+    contact->setBodyData(
+        sphere.body ? (sphere.body->getMass() == 0 ? nullptr : sphere.body)
+                    : (nullptr),
+        plane.body ? (plane.body->getMass() == 0 ? nullptr : plane.body)
+                   : (nullptr),
+        data->friction, data->restitution);
+
+    data->addContacts(1);
+    return 1;
+}
+
+unsigned CollisionDetector::sphereAndSphere(const CollisionSphere &one,
+                                            const CollisionSphere &two,
+                                            CollisionData *data)
+{
+    // Make sure we have contacts
+    if (data->contactsLeft <= 0)
+        return 0;
+    if ((((one.body) && (one.body->getMass() == 0)) || !(one.body)) &&
+        (((two.body) && (two.body->getMass() == 0)) || !(two.body)))
+        return 0;
+
+    // Cache the sphere positions
+    ds_math::Vector3 positionOne = one.getAxis(3);
+    ds_math::Vector3 positionTwo = two.getAxis(3);
+
+    // Find the vector between the objects
+    ds_math::Vector3 midline = positionOne - positionTwo;
+    ds_math::scalar size = midline.Magnitude();
+
+    // See if it is large enough.
+    if (size <= 0.0f || size >= one.radius + two.radius)
+    {
+        return 0;
+    }
+
+    // We manually create the normal, because we have the
+    // size to hand.
+    ds_math::Vector3 normal = midline * ((1.0) / size);
+
+    Contact *contact = data->contacts;
+    contact->contactNormal = normal;
+    contact->contactPoint = positionOne + midline * 0.5;
+    contact->penetration = (one.radius + two.radius - size);
+
+    contact->setBodyData(
+        one.body ? (one.body->getMass() == 0 ? nullptr : one.body) : (nullptr),
+        two.body ? (two.body->getMass() == 0 ? nullptr : two.body) : (nullptr),
+        data->friction, data->restitution);
+
+    data->addContacts(1);
+    return 1;
+}
+
+
+/*
+ * This function checks if the two boxes overlap
+ * along the given axis, returning the ammount of overlap.
+ * The final parameter toCentre
+ * is used to pass in the vector between the boxes centre
+ * points, to avoid having to recalculate it each time.
+ */
+static inline ds_math::scalar
+penetrationOnAxis(const CollisionBox &one,
+                  const CollisionBox &two,
+                  const ds_math::Vector3 &axis,
+                  const ds_math::Vector3 &toCentre)
 {
     // Project the half-size of one onto axis
     ds_math::scalar oneProject = transformToAxis(one, axis);
@@ -576,7 +1477,8 @@ unsigned CollisionDetector::boxAndPoint(const CollisionBox &box,
         return 0;
 
     // Transform the point into box coordinates
-    ds_math::Vector3 relPt = ds_math::Matrix4::Inverse(box.transform) * point;
+    ds_math::Vector3 relPt =
+        ds_math::Matrix4::TransformInverse(box.transform, point);
 
     ds_math::Vector3 normal;
 
@@ -637,7 +1539,7 @@ unsigned CollisionDetector::boxAndSphere(const CollisionBox &box,
     // Transform the centre of the sphere into box coordinates
     ds_math::Vector3 centre = sphere.getAxis(3);
     ds_math::Vector3 relCentre =
-        ds_math::Matrix4::Inverse(box.transform) * centre;
+        ds_math::Matrix4::TransformInverse(box.transform, centre);
 
     // Early out check to see if we can exclude the contact
     if (fabs(relCentre.x) - sphere.radius > box.halfSize.x ||
@@ -1154,3 +2056,810 @@ unsigned CollisionDetector::capsuleAndCapsule(const CollisionCapsule &cap1,
 
     return totalResult;
 }
+
+namespace
+{
+/** Most contacts generated between a shape and a heightfield. */
+const unsigned int MAX_HEIGHTFIELD_CONTACTS = 8;
+
+/**
+ * Contacts between a shape and a heightfield, in the heightfield's space,
+ * gathered before they are written so that a point found by several
+ * triangles is only reported once.
+ */
+class HeightfieldContacts
+{
+public:
+    HeightfieldContacts() : m_count(0)
+    {
+    }
+
+    /**
+     * Add a contact, merging it with a contact at the same point. Once full
+     * the shallowest contact is replaced by any deeper one.
+     *
+     * @param   point         const ds_math::Vector3 &, contact point.
+     * @param   normal        const ds_math::Vector3 &, unit normal from the
+     * heightfield towards the shape.
+     * @param   penetration   ds_math::scalar, depth of the contact.
+     */
+    void add(const ds_math::Vector3 &point,
+             const ds_math::Vector3 &normal,
+             ds_math::scalar penetration)
+    {
+        unsigned int index = m_count;
+        for (unsigned int i = 0; i < m_count; ++i)
+        {
+            ds_math::Vector3 offset = m_points[i] - point;
+            if (ds_math::Vector3::Dot(offset, offset) < 1e-6f)
+            {
+                index = i;
+                break;
+            }
+        }
+
+        if (index == m_count && m_count == MAX_HEIGHTFIELD_CONTACTS)
+        {
+            index = 0;
+            for (unsigned int i = 1; i < m_count; ++i)
+            {
+                if (m_penetrations[i] < m_penetrations[index])
+                {
+                    index = i;
+                }
+            }
+        }
+
+        if (index == m_count)
+        {
+            ++m_count;
+        }
+        else if (penetration <= m_penetrations[index])
+        {
+            return;
+        }
+
+        m_points[index] = point;
+        m_normals[index] = normal;
+        m_penetrations[index] = penetration;
+    }
+
+    /**
+     * Write the contacts to the collision data in world-space.
+     *
+     * @param   shape   const CollisionPrimitive &, shape touching the
+     * heightfield.
+     * @param   field   const CollisionHeightfield &, heightfield.
+     * @param   data    CollisionData *, collision data to write to.
+     * @return          unsigned, number of contacts written.
+     */
+    unsigned write(const CollisionPrimitive &shape,
+                   const CollisionHeightfield &field,
+                   CollisionData *data) const
+    {
+        unsigned written = 0;
+        for (unsigned int i = 0;
+             i < m_count && written < (unsigned)data->contactsLeft; ++i)
+        {
+            Contact *contact = data->contacts + written++;
+            contact->contactPoint =
+                ds_math::Matrix4::Transform(field.getTransform(), m_points[i]);
+            contact->contactNormal =
+                field.getDirectionInWorldSpace(m_normals[i]);
+            contact->penetration = m_penetrations[i];
+            contact->setBodyData(getMovableBody(shape), getMovableBody(field),
+                                 data->friction, data->restitution);
+        }
+
+        if (written > 0)
+        {
+            data->addContacts(written);
+        }
+        return written;
+    }
+
+    /**
+     * Get the body of a primitive if it can move, contacts are given
+     * nullptr in place of immovable bodies.
+     */
+    static RigidBody *getMovableBody(const CollisionPrimitive &primitive)
+    {
+        return primitive.body && primitive.body->hasFiniteMass()
+                   ? primitive.body
+                   : nullptr;
+    }
+
+private:
+    /** Contact points. */
+    ds_math::Vector3 m_points[MAX_HEIGHTFIELD_CONTACTS];
+
+    /** Contact normals. */
+    ds_math::Vector3 m_normals[MAX_HEIGHTFIELD_CONTACTS];
+
+    /** Contact penetrations. */
+    ds_math::scalar m_penetrations[MAX_HEIGHTFIELD_CONTACTS];
+
+    /** Number of contacts. */
+    unsigned int m_count;
+};
+
+/**
+ * Find the point on a triangle closest to a point.
+ */
+ds_math::Vector3 closestPointOnTriangle(const ds_math::Vector3 &point,
+                                        const ds_math::Vector3 *vertices)
+{
+    const ds_math::Vector3 &a = vertices[0];
+    const ds_math::Vector3 &b = vertices[1];
+    const ds_math::Vector3 &c = vertices[2];
+    ds_math::Vector3 ab = b - a;
+    ds_math::Vector3 ac = c - a;
+
+    // Check each corner's region, then each edge's, else the face
+    ds_math::Vector3 ap = point - a;
+    ds_math::scalar d1 = ds_math::Vector3::Dot(ab, ap);
+    ds_math::scalar d2 = ds_math::Vector3::Dot(ac, ap);
+    if (d1 <= 0 && d2 <= 0)
+    {
+        return a;
+    }
+
+    ds_math::Vector3 bp = point - b;
+    ds_math::scalar d3 = ds_math::Vector3::Dot(ab, bp);
+    ds_math::scalar d4 = ds_math::Vector3::Dot(ac, bp);
+    if (d3 >= 0 && d4 <= d3)
+    {
+        return b;
+    }
+
+    ds_math::scalar vc = d1 * d4 - d3 * d2;
+    if (vc <= 0 && d1 >= 0 && d3 <= 0)
+    {
+        return a + ab * (d1 / (d1 - d3));
+    }
+
+    ds_math::Vector3 cp = point - c;
+    ds_math::scalar d5 = ds_math::Vector3::Dot(ab, cp);
+    ds_math::scalar d6 = ds_math::Vector3::Dot(ac, cp);
+    if (d6 >= 0 && d5 <= d6)
+    {
+        return c;
+    }
+
+    ds_math::scalar vb = d5 * d2 - d1 * d6;
+    if (vb <= 0 && d2 >= 0 && d6 <= 0)
+    {
+        return a + ac * (d2 / (d2 - d6));
+    }
+
+    ds_math::scalar va = d3 * d6 - d5 * d4;
+    if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0)
+    {
+        return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+    }
+
+    ds_math::scalar denominator = 1.0f / (va + vb + vc);
+    return a + ab * (vb * denominator) + ac * (vc * denominator);
+}
+
+/**
+ * Find the point on a segment closest to a point.
+ */
+ds_math::Vector3 closestPointOnSegment(const ds_math::Vector3 &point,
+                                       const ds_math::Vector3 &start,
+                                       const ds_math::Vector3 &end)
+{
+    ds_math::Vector3 segment = end - start;
+    ds_math::scalar lengthSquared = ds_math::Vector3::Dot(segment, segment);
+    if (lengthSquared <= 0)
+    {
+        return start;
+    }
+
+    ds_math::scalar along =
+        ds_math::Vector3::Dot(point - start, segment) / lengthSquared;
+    return start + segment * std::min(std::max(along, 0.0f), 1.0f);
+}
+
+/**
+ * Add the contacts of a sphere, in the heightfield's space, with the
+ * triangles beneath it.
+ */
+void addSphereContacts(const CollisionHeightfield &field,
+                       const ds_math::Vector3 &centre,
+                       ds_math::scalar radius,
+                       HeightfieldContacts *contacts)
+{
+    ds_math::Vector3 extents(radius, radius, radius);
+    int minX, minZ, maxX, maxZ;
+    if (!field.getCells(BoundingBox(centre - extents, centre + extents),
+                        &minX, &minZ, &maxX, &maxZ))
+    {
+        return;
+    }
+
+    for (int z = minZ; z <= maxZ; ++z)
+    {
+        for (int x = minX; x <= maxX; ++x)
+        {
+            for (unsigned int half = 0; half < 2; ++half)
+            {
+                ds_math::Vector3 vertices[3];
+                ds_math::Vector3 normal =
+                    field.getTriangle(x, z, half, vertices);
+                ds_math::scalar height =
+                    ds_math::Vector3::Dot(centre - vertices[0], normal);
+
+                if (height < 0)
+                {
+                    // A centre under the surface is pushed straight back
+                    // out by the triangle it is under
+                    ds_math::Vector3 surface = centre - normal * height;
+                    if (pointInTriangle(surface, vertices))
+                    {
+                        contacts->add(surface, normal, radius - height);
+                    }
+                    continue;
+                }
+
+                ds_math::Vector3 closest =
+                    closestPointOnTriangle(centre, vertices);
+                ds_math::Vector3 offset = centre - closest;
+                ds_math::scalar distanceSquared =
+                    ds_math::Vector3::Dot(offset, offset);
+                if (distanceSquared < radius * radius)
+                {
+                    ds_math::scalar distance = sqrt(distanceSquared);
+                    contacts->add(closest,
+                                  distance > 0 ? offset * (1.0f / distance)
+                                               : normal,
+                                  radius - distance);
+                }
+            }
+        }
+    }
+}
+}
+
+unsigned
+CollisionDetector::sphereAndHeightfield(const CollisionSphere &sphere,
+                                        const CollisionHeightfield &field,
+                                        CollisionData *data)
+{
+    // Make sure we have contacts
+    if (data->contactsLeft <= 0)
+        return 0;
+    if (!HeightfieldContacts::getMovableBody(sphere) &&
+        !HeightfieldContacts::getMovableBody(field))
+        return 0;
+
+    HeightfieldContacts contacts;
+    addSphereContacts(field, field.getPointInLocalSpace(sphere.getAxis(3)),
+                      sphere.radius, &contacts);
+    return contacts.write(sphere, field, data);
+}
+
+unsigned CollisionDetector::boxAndHeightfield(const CollisionBox &box,
+                                              const CollisionHeightfield &field,
+                                              CollisionData *data)
+{
+    // Make sure we have contacts
+    if (data->contactsLeft <= 0)
+        return 0;
+    if (!HeightfieldContacts::getMovableBody(box) &&
+        !HeightfieldContacts::getMovableBody(field))
+        return 0;
+
+    // Work in the heightfield's space
+    ds_math::Vector3 centre = field.getPointInLocalSpace(box.getAxis(3));
+    ds_math::Vector3 axes[3];
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        axes[i] = field.getDirectionInLocalSpace(box.getAxis(i));
+    }
+
+    ds_math::Vector3 extents;
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        extents[i] = fabs(axes[0][i]) * box.halfSize.x +
+                     fabs(axes[1][i]) * box.halfSize.y +
+                     fabs(axes[2][i]) * box.halfSize.z;
+    }
+
+    int minX, minZ, maxX, maxZ;
+    if (!field.getCells(BoundingBox(centre - extents, centre + extents),
+                        &minX, &minZ, &maxX, &maxZ))
+    {
+        return 0;
+    }
+
+    HeightfieldContacts contacts;
+
+    // Corners of the box under the surface, as against a half-space
+    for (unsigned int i = 0; i < 8; ++i)
+    {
+        ds_math::Vector3 vertex =
+            centre + axes[0] * (i & 1 ? box.halfSize.x : -box.halfSize.x) +
+            axes[1] * (i & 2 ? box.halfSize.y : -box.halfSize.y) +
+            axes[2] * (i & 4 ? box.halfSize.z : -box.halfSize.z);
+
+        ds_math::Vector3 vertices[3], normal;
+        if (field.getTriangleAt(vertex, vertices, &normal))
+        {
+            ds_math::scalar height =
+                ds_math::Vector3::Dot(vertex - vertices[0], normal);
+            if (height < 0)
+            {
+                // Halfway between the corner and the surface
+                contacts.add(vertex - normal * (height * 0.5f), normal,
+                             -height);
+            }
+        }
+    }
+
+    // Samples poking into the box push it out through the nearest face,
+    // unless that would push it into the ground
+    for (int z = minZ; z <= maxZ + 1; ++z)
+    {
+        for (int x = minX; x <= maxX + 1; ++x)
+        {
+            ds_math::Vector3 sample = field.getSample(x, z);
+            ds_math::Vector3 offset = sample - centre;
+
+            ds_math::scalar shallowest = -1;
+            ds_math::Vector3 normal;
+            for (unsigned int i = 0; i < 3; ++i)
+            {
+                ds_math::scalar along =
+                    ds_math::Vector3::Dot(offset, axes[i]);
+                ds_math::scalar depth = box.halfSize[i] - fabs(along);
+                if (depth <= 0)
+                {
+                    shallowest = -1;
+                    break;
+                }
+                if (shallowest < 0 || depth < shallowest)
+                {
+                    shallowest = depth;
+                    normal = along > 0 ? -axes[i] : axes[i];
+                }
+            }
+
+            if (shallowest > 0 && normal.y > 0)
+            {
+                contacts.add(sample, normal, shallowest);
+            }
+        }
+    }
+
+    return contacts.write(box, field, data);
+}
+
+unsigned
+CollisionDetector::capsuleAndHeightfield(const CollisionCapsule &cap,
+                                         const CollisionHeightfield &field,
+                                         CollisionData *data)
+{
+    // Make sure we have contacts
+    if (data->contactsLeft <= 0)
+        return 0;
+    if (!HeightfieldContacts::getMovableBody(cap) &&
+        !HeightfieldContacts::getMovableBody(field))
+        return 0;
+
+    // Work in the heightfield's space, capsule runs along its local y axis
+    ds_math::Vector3 centre = field.getPointInLocalSpace(cap.getAxis(3));
+    ds_math::Vector3 halfSegment =
+        field.getDirectionInLocalSpace(cap.getAxis(1)) * (cap.height / 2.0f);
+    ds_math::Vector3 start = centre - halfSegment;
+    ds_math::Vector3 end = centre + halfSegment;
+
+    HeightfieldContacts contacts;
+    addSphereContacts(field, start, cap.radius, &contacts);
+    addSphereContacts(field, end, cap.radius, &contacts);
+
+    // Samples poking into the side of the capsule
+    ds_math::Vector3 extents(fabs(halfSegment.x) + cap.radius,
+                             fabs(halfSegment.y) + cap.radius,
+                             fabs(halfSegment.z) + cap.radius);
+    int minX, minZ, maxX, maxZ;
+    if (field.getCells(BoundingBox(centre - extents, centre + extents), &minX,
+                       &minZ, &maxX, &maxZ))
+    {
+        for (int z = minZ; z <= maxZ + 1; ++z)
+        {
+            for (int x = minX; x <= maxX + 1; ++x)
+            {
+                ds_math::Vector3 sample = field.getSample(x, z);
+                ds_math::Vector3 offset =
+                    closestPointOnSegment(sample, start, end) - sample;
+                ds_math::scalar distanceSquared =
+                    ds_math::Vector3::Dot(offset, offset);
+                if (distanceSquared >= cap.radius * cap.radius)
+                {
+                    continue;
+                }
+
+                ds_math::scalar distance = sqrt(distanceSquared);
+                ds_math::Vector3 normal = distance > 0
+                                              ? offset * (1.0f / distance)
+                                              : ds_math::Vector3(0, 1, 0);
+                if (normal.y > 0)
+                {
+                    contacts.add(sample, normal, cap.radius - distance);
+                }
+            }
+        }
+    }
+
+    return contacts.write(cap, field, data);
+}
+
+unsigned
+CollisionDetector::convexHullAndHeightfield(const CollisionConvexHull &hull,
+                                            const CollisionHeightfield &field,
+                                            CollisionData *data)
+{
+    // Make sure we have contacts
+    if (data->contactsLeft <= 0)
+        return 0;
+    if (!HeightfieldContacts::getMovableBody(hull) &&
+        !HeightfieldContacts::getMovableBody(field))
+        return 0;
+
+    // Work in the heightfield's space
+    const std::vector<ds_math::Vector3> &points = hull.getVertices();
+    std::vector<ds_math::Vector3> vertices(points.size());
+    BoundingBox bounds;
+    for (unsigned int i = 0; i < points.size(); ++i)
+    {
+        vertices[i] = field.getPointInLocalSpace(
+            ds_math::Matrix4::Transform(hull.getTransform(), points[i]));
+        bounds = i == 0 ? BoundingBox(vertices[i], vertices[i])
+                        : BoundingBox::merge(
+                              bounds, BoundingBox(vertices[i], vertices[i]));
+    }
+
+    int minX, minZ, maxX, maxZ;
+    if (!field.getCells(bounds, &minX, &minZ, &maxX, &maxZ))
+    {
+        return 0;
+    }
+
+    HeightfieldContacts contacts;
+
+    // Corners of the hull under the surface, as against a half-space
+    for (const ds_math::Vector3 &vertex : vertices)
+    {
+        ds_math::Vector3 triangle[3], normal;
+        if (field.getTriangleAt(vertex, triangle, &normal))
+        {
+            ds_math::scalar height =
+                ds_math::Vector3::Dot(vertex - triangle[0], normal);
+            if (height < 0)
+            {
+                // Halfway between the corner and the surface
+                contacts.add(vertex - normal * (height * 0.5f), normal,
+                             -height);
+            }
+        }
+    }
+
+    // Samples poking into the hull push it out the nearest way, unless that
+    // would push it into the ground
+    PrimitiveShape shape(hull);
+    for (int z = minZ; z <= maxZ + 1; ++z)
+    {
+        for (int x = minX; x <= maxX + 1; ++x)
+        {
+            ds_math::Vector3 sample = field.getSample(x, z);
+            if (!bounds.overlaps(BoundingBox(sample, sample)))
+            {
+                continue;
+            }
+
+            ConvexContact contact;
+            if (ConvexCollision::findContact(
+                    shape,
+                    ConvexPoint(ds_math::Matrix4::Transform(
+                        field.getTransform(), sample)),
+                    &contact))
+            {
+                ds_math::Vector3 normal =
+                    field.getDirectionInLocalSpace(contact.normal);
+                if (normal.y > 0)
+                {
+                    contacts.add(sample, normal, contact.penetration);
+                }
+            }
+        }
+    }
+
+    return contacts.write(hull, field, data);
+}
+
+unsigned CollisionDetector::convexHullAndConvex(const CollisionConvexHull &hull,
+                                                const CollisionPrimitive &shape,
+                                                CollisionData *data)
+{
+    // Make sure we have contacts
+    if (data->contactsLeft <= 0)
+        return 0;
+
+    RigidBody *one = HeightfieldContacts::getMovableBody(hull);
+    RigidBody *two = HeightfieldContacts::getMovableBody(shape);
+    if (!one && !two)
+        return 0;
+
+    ConvexContact found;
+    if (!ConvexCollision::findContact(PrimitiveShape(hull),
+                                      PrimitiveShape(shape), &found))
+    {
+        return 0;
+    }
+
+    Contact *contact = data->contacts;
+    contact->contactPoint = found.point;
+    contact->contactNormal = found.normal;
+    contact->penetration = found.penetration;
+    contact->setBodyData(one, two, data->friction, data->restitution);
+
+    data->addContacts(1);
+    return 1;
+}
+
+unsigned CollisionDetector::convexHullAndHalfSpace(
+    const CollisionConvexHull &hull,
+    const CollisionPlane &plane,
+    CollisionData *data)
+{
+    // Most corners reported, more add nothing to a resting contact
+    const unsigned int maxContacts = 4;
+
+    // Make sure we have contacts
+    if (data->contactsLeft <= 0)
+        return 0;
+
+    RigidBody *one = HeightfieldContacts::getMovableBody(hull);
+    RigidBody *two = HeightfieldContacts::getMovableBody(plane);
+    if (!one && !two)
+        return 0;
+
+    // Work in the hull's space
+    ds_math::Vector3 direction = hull.getDirectionInLocalSpace(plane.direction);
+    ds_math::scalar offset =
+        plane.offset - ds_math::Vector3::Dot(plane.direction, hull.getAxis(3));
+
+    // Keep the deepest corners behind the plane
+    const std::vector<ds_math::Vector3> &vertices = hull.getVertices();
+    unsigned int deepest[maxContacts];
+    ds_math::scalar depths[maxContacts];
+    unsigned int count = 0;
+    for (unsigned int i = 0; i < vertices.size(); ++i)
+    {
+        ds_math::scalar depth =
+            offset - ds_math::Vector3::Dot(vertices[i], direction);
+        if (depth < 0)
+        {
+            continue;
+        }
+
+        unsigned int index = count;
+        if (count == maxContacts)
+        {
+            index = (unsigned int)(std::min_element(depths, depths + count) -
+                                   depths);
+            if (depth <= depths[index])
+            {
+                continue;
+            }
+        }
+        else
+        {
+            ++count;
+        }
+
+        deepest[index] = i;
+        depths[index] = depth;
+    }
+
+    count = std::min(count, (unsigned int)data->contactsLeft);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        // Halfway between the corner and the plane
+        ds_math::Vector3 vertex = ds_math::Matrix4::Transform(
+            hull.getTransform(), vertices[deepest[i]]);
+
+        Contact *contact = data->contacts + i;
+        contact->contactPoint = vertex + plane.direction * (depths[i] * 0.5f);
+        contact->contactNormal = plane.direction;
+        contact->penetration = depths[i];
+        contact->setBodyData(one, two, data->friction, data->restitution);
+    }
+
+    if (count > 0)
+    {
+        data->addContacts(count);
+    }
+    return count;
+}
+
+unsigned
+CollisionDetector::compoundAndPrimitive(const CollisionCompound &compound,
+                                        const CollisionPrimitive &primitive,
+                                        CollisionData *data)
+{
+    // Make sure we have contacts
+    if (data->contactsLeft <= 0)
+        return 0;
+
+    unsigned count = 0;
+    auto test = [&](const CollisionPrimitive &child) {
+        count += primitiveAndPrimitive(child, primitive, data);
+        return data->contactsLeft > 0;
+    };
+
+    // Only the children the primitive's bounds overlap can touch it
+    BoundingBox bounds;
+    if (primitive.calculateBoundingBox(&bounds))
+    {
+        compound.queryChildren(bounds, test);
+    }
+    else
+    {
+        for (unsigned int i = 0; i < compound.getChildCount(); ++i)
+        {
+            if (!test(compound.getChild(i)))
+            {
+                break;
+            }
+        }
+    }
+
+    return count;
+}
+
+namespace
+{
+/** Signature shared by every entry of the collision dispatch table. */
+typedef unsigned (*CollisionFunction)(const CollisionPrimitive &,
+                                      const CollisionPrimitive &,
+                                      CollisionData *);
+
+/**
+ * Adapt a typed collision routine to the table signature.
+ */
+template <typename A, typename B,
+          unsigned (*Function)(const A &, const B &, CollisionData *)>
+unsigned dispatch(const CollisionPrimitive &one,
+                  const CollisionPrimitive &two,
+                  CollisionData *data)
+{
+    return Function(static_cast<const A &>(one), static_cast<const B &>(two),
+                    data);
+}
+
+/**
+ * Adapt a typed collision routine to the table signature, with the
+ * primitives given in the opposite order to the routine.
+ */
+template <typename A, typename B,
+          unsigned (*Function)(const A &, const B &, CollisionData *)>
+unsigned dispatchSwapped(const CollisionPrimitive &one,
+                         const CollisionPrimitive &two,
+                         CollisionData *data)
+{
+    return Function(static_cast<const A &>(two), static_cast<const B &>(one),
+                    data);
+}
+
+typedef CollisionDetector CD;
+
+/**
+ * Collision routine for each pair of primitive types, indexed by
+ * [type of first primitive][type of second primitive].
+ */
+const CollisionFunction
+    collisionTable[(int)CollisionPrimitiveType::Count]
+                  [(int)CollisionPrimitiveType::Count] = {
+        // Box
+        {&dispatch<CollisionBox, CollisionBox, &CD::boxAndBox>,
+         &dispatch<CollisionBox, CollisionSphere, &CD::boxAndSphere>,
+         &dispatch<CollisionBox, CollisionPlane, &CD::boxAndHalfSpace>,
+         &dispatchSwapped<CollisionCapsule, CollisionBox, &CD::capsuleAndBox>,
+         &dispatch<CollisionBox, CollisionHeightfield,
+                   &CD::boxAndHeightfield>,
+         &dispatchSwapped<CollisionConvexHull, CollisionPrimitive,
+                          &CD::convexHullAndConvex>,
+         &dispatchSwapped<CollisionCompound, CollisionPrimitive,
+                          &CD::compoundAndPrimitive>},
+        // Sphere
+        {&dispatchSwapped<CollisionBox, CollisionSphere, &CD::boxAndSphere>,
+         &dispatch<CollisionSphere, CollisionSphere, &CD::sphereAndSphere>,
+         &dispatch<CollisionSphere, CollisionPlane, &CD::sphereAndHalfSpace>,
+         &dispatchSwapped<CollisionCapsule, CollisionSphere,
+                          &CD::capsuleAndSphere>,
+         &dispatch<CollisionSphere, CollisionHeightfield,
+                   &CD::sphereAndHeightfield>,
+         &dispatchSwapped<CollisionConvexHull, CollisionPrimitive,
+                          &CD::convexHullAndConvex>,
+         &dispatchSwapped<CollisionCompound, CollisionPrimitive,
+                          &CD::compoundAndPrimitive>},
+        // Plane
+        {&dispatchSwapped<CollisionBox, CollisionPlane, &CD::boxAndHalfSpace>,
+         &dispatchSwapped<CollisionSphere, CollisionPlane,
+                          &CD::sphereAndHalfSpace>,
+         nullptr,
+         &dispatchSwapped<CollisionCapsule, CollisionPlane,
+                          &CD::capsuleAndHalfSpace>,
+         nullptr,
+         &dispatchSwapped<CollisionConvexHull, CollisionPlane,
+                          &CD::convexHullAndHalfSpace>,
+         &dispatchSwapped<CollisionCompound, CollisionPrimitive,
+                          &CD::compoundAndPrimitive>},
+        // Capsule
+        {&dispatch<CollisionCapsule, CollisionBox, &CD::capsuleAndBox>,
+         &dispatch<CollisionCapsule, CollisionSphere, &CD::capsuleAndSphere>,
+         &dispatch<CollisionCapsule, CollisionPlane, &CD::capsuleAndHalfSpace>,
+         &dispatch<CollisionCapsule, CollisionCapsule,
+                   &CD::capsuleAndCapsule>,
+         &dispatch<CollisionCapsule, CollisionHeightfield,
+                   &CD::capsuleAndHeightfield>,
+         &dispatchSwapped<CollisionConvexHull, CollisionPrimitive,
+                          &CD::convexHullAndConvex>,
+         &dispatchSwapped<CollisionCompound, CollisionPrimitive,
+                          &CD::compoundAndPrimitive>},
+        // Heightfield
+        {&dispatchSwapped<CollisionBox, CollisionHeightfield,
+                          &CD::boxAndHeightfield>,
+         &dispatchSwapped<CollisionSphere, CollisionHeightfield,
+                          &CD::sphereAndHeightfield>,
+         nullptr,
+         &dispatchSwapped<CollisionCapsule, CollisionHeightfield,
+                          &CD::capsuleAndHeightfield>,
+         nullptr,
+         &dispatchSwapped<CollisionConvexHull, CollisionHeightfield,
+                          &CD::convexHullAndHeightfield>,
+         &dispatchSwapped<CollisionCompound, CollisionPrimitive,
+                          &CD::compoundAndPrimitive>},
+        // Convex hull
+        {&dispatch<CollisionConvexHull, CollisionPrimitive,
+                   &CD::convexHullAndConvex>,
+         &dispatch<CollisionConvexHull, CollisionPrimitive,
+                   &CD::convexHullAndConvex>,
+         &dispatch<CollisionConvexHull, CollisionPlane,
+                   &CD::convexHullAndHalfSpace>,
+         &dispatch<CollisionConvexHull, CollisionPrimitive,
+                   &CD::convexHullAndConvex>,
+         &dispatch<CollisionConvexHull, CollisionHeightfield,
+                   &CD::convexHullAndHeightfield>,
+         &dispatch<CollisionConvexHull, CollisionPrimitive,
+                   &CD::convexHullAndConvex>,
+         &dispatchSwapped<CollisionCompound, CollisionPrimitive,
+                          &CD::compoundAndPrimitive>},
+        // Compound, the other primitive is tested against its children
+        {&dispatch<CollisionCompound, CollisionPrimitive,
+                   &CD::compoundAndPrimitive>,
+         &dispatch<CollisionCompound, CollisionPrimitive,
+                   &CD::compoundAndPrimitive>,
+         &dispatch<CollisionCompound, CollisionPrimitive,
+                   &CD::compoundAndPrimitive>,
+         &dispatch<CollisionCompound, CollisionPrimitive,
+                   &CD::compoundAndPrimitive>,
+         &dispatch<CollisionCompound, CollisionPrimitive,
+                   &CD::compoundAndPrimitive>,
+         &dispatch<CollisionCompound, CollisionPrimitive,
+                   &CD::compoundAndPrimitive>,
+         &dispatch<CollisionCompound, CollisionPrimitive,
+                   &CD::compoundAndPrimitive>}};
+}
+
+unsigned CollisionDetector::primitiveAndPrimitive(const CollisionPrimitive &one,
+                                                  const CollisionPrimitive &two,
+                                                  CollisionData *data)
+{
+    CollisionFunction function =
+        collisionTable[(int)one.getType()][(int)two.getType()];
+
+    return function ? function(one, two, data) : 0;
+}
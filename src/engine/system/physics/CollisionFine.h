@@ -27,6 +27,11 @@
 #pragma once
 
 #include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <engine/system/physics/CollisionCoarse.h>
 #include <engine/system/physics/Contacts.h>
 #include <engine/system/physics/RigidBody.h>
 #include <math/Matrix4.h>
@@ -56,6 +61,24 @@ namespace ds_phys
 // forward declaration of CollisionPrimitive friends
 class IntersectionTests;
 class CollisionDetector;
+class CollisionCompound;
+
+/**
+ * Shape of a collision primitive, used to dispatch pairs of primitives to
+ * the matching collision detection routine.
+ */
+enum class CollisionPrimitiveType
+{
+    Box,
+    Sphere,
+    Plane,
+    Capsule,
+    Heightfield,
+    ConvexHull,
+    Compound,
+    // Number of primitive types, not a valid type
+    Count
+};
 
 /**
  * Base collision primitive.
@@ -71,6 +94,7 @@ public:
     */
     friend class IntersectionTests;
     friend class CollisionDetector;
+    friend class CollisionCompound;
 
     /**
     * The rigid body that is represented by this primitive.
@@ -82,10 +106,24 @@ public:
     */
     ds_math::Matrix4 offset;
 
+    /**
+     * Collision layers the primitive is in, one bit per layer. Every
+     * primitive starts in the first layer only.
+     */
+    uint32_t layer;
+
+    /**
+     * Collision layers the primitive collides with, one bit per layer.
+     * Every primitive starts colliding with every layer.
+     */
+    uint32_t mask;
+
     /**
      * Constructor.
+     *
+     * @param   type   CollisionPrimitiveType, shape of the primitive.
      */
-    CollisionPrimitive();
+    explicit CollisionPrimitive(CollisionPrimitiveType type);
     /**
      * Destructor.
      */
@@ -93,10 +131,46 @@ public:
     {
     }
 
+    /**
+     * Get the shape of this primitive.
+     *
+     * @return   CollisionPrimitiveType, shape of the primitive.
+     */
+    CollisionPrimitiveType getType() const
+    {
+        return m_type;
+    }
+
+    /**
+     * Whether this primitive and another are in layers the other collides
+     * with.
+     *
+     * @param   other   const CollisionPrimitive &, other primitive.
+     * @return          bool, true if the pair may collide.
+     */
+    bool canCollideWith(const CollisionPrimitive &other) const
+    {
+        return (layer & other.mask) != 0 && (other.layer & mask) != 0;
+    }
+
     /**
     * Calculates the internals for the primitive.
     */
-    void calculateInternals();
+    virtual void calculateInternals();
+
+    /**
+     * Calculates the world space bounding box of the primitive from the
+     * transform found by the last call to calculateInternals.
+     *
+     * @param   box   BoundingBox *, box to store the result in.
+     * @return        bool, false if the primitive is unbounded (such as a
+     * plane), in which case box is left untouched.
+     */
+    virtual bool calculateBoundingBox(BoundingBox *box) const
+    {
+        (void)box;
+        return false;
+    }
 
     /**
     * This is a convenience function to allow access to the
@@ -118,6 +192,35 @@ public:
         return transform;
     }
 
+    /**
+     * Convert a point from world-space to the primitive's space.
+     *
+     * @param   point   const ds_math::Vector3 &, point in world-space.
+     * @return          ds_math::Vector3, point in the primitive's space.
+     */
+    ds_math::Vector3 getPointInLocalSpace(const ds_math::Vector3 &point) const;
+
+    /**
+     * Convert a direction from world-space to the primitive's space.
+     *
+     * @param   direction   const ds_math::Vector3 &, direction in
+     * world-space.
+     * @return              ds_math::Vector3, direction in the primitive's
+     * space.
+     */
+    ds_math::Vector3
+    getDirectionInLocalSpace(const ds_math::Vector3 &direction) const;
+
+    /**
+     * Convert a direction from the primitive's space to world-space.
+     *
+     * @param   direction   const ds_math::Vector3 &, direction in the
+     * primitive's space.
+     * @return              ds_math::Vector3, direction in world-space.
+     */
+    ds_math::Vector3
+    getDirectionInWorldSpace(const ds_math::Vector3 &direction) const;
+
 protected:
     /**
     * The resultant transform of the primitive. This is
@@ -126,7 +229,9 @@ protected:
     */
     ds_math::Matrix4 transform;
 
-
+private:
+    /** Shape of the primitive. */
+    CollisionPrimitiveType m_type;
 }; // end class CollisionPrimitive
 
 /**
@@ -135,10 +240,16 @@ protected:
 class CollisionBox : public CollisionPrimitive
 {
 public:
+    CollisionBox() : CollisionPrimitive(CollisionPrimitiveType::Box)
+    {
+    }
+
     /**
     * Holds the half-sizes of the box along each of its local axes.
     */
     ds_math::Vector3 halfSize;
+
+    virtual bool calculateBoundingBox(BoundingBox *box) const;
 }; // end class CollisionBox
 
 /**
@@ -147,10 +258,16 @@ public:
 class CollisionSphere : public CollisionPrimitive
 {
 public:
+    CollisionSphere() : CollisionPrimitive(CollisionPrimitiveType::Sphere)
+    {
+    }
+
     /**
      * Radius of the sphere.
      */
     ds_math::scalar radius;
+
+    virtual bool calculateBoundingBox(BoundingBox *box) const;
 };
 
 /**
@@ -159,6 +276,10 @@ public:
 class CollisionPlane : public CollisionPrimitive
 {
 public:
+    CollisionPlane() : CollisionPrimitive(CollisionPrimitiveType::Plane)
+    {
+    }
+
     /**
      * Plane normal.
      */
@@ -176,10 +297,390 @@ public:
 class CollisionCapsule : public CollisionPrimitive
 {
 public:
+    CollisionCapsule() : CollisionPrimitive(CollisionPrimitiveType::Capsule)
+    {
+    }
+
     /** Height of the capsule */
     ds_math::scalar height;
     /** Radius of the capsule */
     ds_math::scalar radius;
+
+    virtual bool calculateBoundingBox(BoundingBox *box) const;
+};
+
+/**
+ * Collision heightfield class, a grid of heights such as a terrain.
+ *
+ * In the heightfield's own space the grid lies across the xz plane centred
+ * on the origin, with sample (x, z) at
+ * ((x - (width - 1) / 2) * scale.x, height * scale.y,
+ * (z - (depth - 1) / 2) * scale.z), matching the vertices of a
+ * TerrainResource. Each cell is split into two triangles along the diagonal
+ * from sample (x, z + 1) to sample (x + 1, z), as the terrain mesh is.
+ *
+ * Shapes are only tested against the cells under their bounding box, so
+ * the cost of a contact doesn't depend on the size of the heightfield.
+ */
+class CollisionHeightfield : public CollisionPrimitive
+{
+public:
+    CollisionHeightfield();
+
+    /**
+     * Set the heights of the samples.
+     *
+     * @param   heights   const std::vector<ds_math::scalar> &, width * depth
+     * heights, row by row, as given by TerrainResource::GetHeightArray.
+     * @param   width     unsigned int, number of samples in each row, at
+     * least 2.
+     * @param   depth     unsigned int, number of rows, at least 2.
+     */
+    void setHeights(const std::vector<ds_math::scalar> &heights,
+                    unsigned int width,
+                    unsigned int depth);
+
+    /**
+     * Get the number of samples in each row.
+     *
+     * @return   unsigned int, number of samples in each row.
+     */
+    unsigned int getWidth() const
+    {
+        return m_width;
+    }
+
+    /**
+     * Get the number of rows of samples.
+     *
+     * @return   unsigned int, number of rows.
+     */
+    unsigned int getDepth() const
+    {
+        return m_depth;
+    }
+
+    /**
+     * Get the position of a sample in the heightfield's space.
+     *
+     * @param   x   int, column of the sample.
+     * @param   z   int, row of the sample.
+     * @return      ds_math::Vector3, position of the sample.
+     */
+    ds_math::Vector3 getSample(int x, int z) const
+    {
+        return ds_math::Vector3(
+            ((ds_math::scalar)x - (m_width - 1) / 2.0f) * scale.x,
+            m_heights[z * m_width + x] * scale.y,
+            ((ds_math::scalar)z - (m_depth - 1) / 2.0f) * scale.z);
+    }
+
+    /**
+     * Get one of the two triangles of a cell, in the heightfield's space.
+     *
+     * @param   x          int, column of the cell.
+     * @param   z          int, row of the cell.
+     * @param   half       unsigned int, 0 or 1.
+     * @param   vertices   ds_math::Vector3 *, set to the three corners.
+     * @return             ds_math::Vector3, upward facing unit normal.
+     */
+    ds_math::Vector3 getTriangle(int x,
+                                 int z,
+                                 unsigned int half,
+                                 ds_math::Vector3 *vertices) const;
+
+    /**
+     * Find the triangle directly above or below a point, in the
+     * heightfield's space.
+     *
+     * @param   point      const ds_math::Vector3 &, point in the
+     * heightfield's space.
+     * @param   vertices   ds_math::Vector3 *, set to the three corners of
+     * the triangle.
+     * @param   normal     ds_math::Vector3 *, set to the upward facing unit
+     * normal of the triangle.
+     * @return             bool, false if the point is outside the grid, in
+     * which case vertices and normal are left untouched.
+     */
+    bool getTriangleAt(const ds_math::Vector3 &point,
+                       ds_math::Vector3 *vertices,
+                       ds_math::Vector3 *normal) const;
+
+    /**
+     * Get the bounds of the heightfield in its own space.
+     *
+     * @return   BoundingBox, bounds of every sample.
+     */
+    BoundingBox getLocalBounds() const;
+
+    /**
+     * Get the cells under a box in the heightfield's space, clamped to the
+     * grid.
+     *
+     * @param   box    const BoundingBox &, box in the heightfield's space.
+     * @param   minX   int *, first column.
+     * @param   minZ   int *, first row.
+     * @param   maxX   int *, last column.
+     * @param   maxZ   int *, last row.
+     * @return         bool, false if the box misses the grid, in which case
+     * the range is left untouched.
+     */
+    bool getCells(const BoundingBox &box,
+                  int *minX,
+                  int *minZ,
+                  int *maxX,
+                  int *maxZ) const;
+
+    /**
+     * Spacing of the samples along x and z, and scale applied to the
+     * heights along y.
+     */
+    ds_math::Vector3 scale;
+
+    virtual bool calculateBoundingBox(BoundingBox *box) const;
+
+private:
+    /** Height of each sample, row by row. */
+    std::vector<ds_math::scalar> m_heights;
+
+    /** Number of samples in each row. */
+    unsigned int m_width;
+
+    /** Number of rows. */
+    unsigned int m_depth;
+
+    /** Lowest sample height, before scaling. */
+    ds_math::scalar m_minHeight;
+
+    /** Highest sample height, before scaling. */
+    ds_math::scalar m_maxHeight;
+};
+
+/**
+ * Collision convex hull class, the convex hull of a set of points.
+ *
+ * Contacts with other convex primitives are found with GJK and EPA (see
+ * ConvexCollision), one contact per pair each step, which the world's
+ * contact manifolds gather into a patch over a few steps. The points need
+ * not all be corners of the hull, but every point is visited by each
+ * support query, so points inside it only cost time.
+ */
+class CollisionConvexHull : public CollisionPrimitive
+{
+public:
+    CollisionConvexHull();
+
+    /**
+     * Set the points the hull is wrapped around.
+     *
+     * @param   vertices   const std::vector<ds_math::Vector3> &, points in
+     * the hull's space, at least one.
+     */
+    void setVertices(const std::vector<ds_math::Vector3> &vertices);
+
+    /**
+     * Get the points the hull is wrapped around.
+     *
+     * @return   const std::vector<ds_math::Vector3> &, points in the hull's
+     * space.
+     */
+    const std::vector<ds_math::Vector3> &getVertices() const
+    {
+        return m_vertices;
+    }
+
+    /**
+     * Get the bounds of the hull in its own space, cached when the points
+     * are set.
+     *
+     * @return   const BoundingBox &, bounds of every point.
+     */
+    const BoundingBox &getLocalBounds() const
+    {
+        return m_localBounds;
+    }
+
+    /**
+     * Get the point of the hull furthest along a direction, in world-space.
+     *
+     * @param   direction   const ds_math::Vector3 &, direction in
+     * world-space, need not be normalized.
+     * @return              ds_math::Vector3, furthest point in world-space.
+     */
+    ds_math::Vector3 getSupport(const ds_math::Vector3 &direction) const;
+
+    virtual bool calculateBoundingBox(BoundingBox *box) const;
+
+private:
+    /** Points the hull is wrapped around. */
+    std::vector<ds_math::Vector3> m_vertices;
+
+    /** Bounds of the points. */
+    BoundingBox m_localBounds;
+};
+
+/**
+ * Collision compound class, a rigid group of bounded primitives that takes
+ * part in pair generation as a single primitive.
+ *
+ * Each child's offset places it in the compound's space and can't change
+ * once the child is added. The bounds of the children in that space are
+ * kept in a tree built as they are added, so a shape touching the compound
+ * is only tested against the children its bounds overlap. The transforms
+ * of the children are updated with the compound's, and the compound's
+ * layer and mask stand for all of them.
+ */
+class CollisionCompound : public CollisionPrimitive
+{
+public:
+    CollisionCompound();
+
+    /**
+     * Add a child.
+     *
+     * @pre   The child is bounded and not a compound.
+     *
+     * @param   child   std::unique_ptr<CollisionPrimitive> &&, child, with
+     * its offset in the compound's space.
+     * @return          CollisionPrimitive *, child added.
+     */
+    CollisionPrimitive *addChild(std::unique_ptr<CollisionPrimitive> &&child);
+
+    /**
+     * Get the number of children.
+     *
+     * @return   unsigned int, number of children.
+     */
+    unsigned int getChildCount() const
+    {
+        return (unsigned int)m_children.size();
+    }
+
+    /**
+     * Get a child.
+     *
+     * @param   index   unsigned int, index of the child.
+     * @return          const CollisionPrimitive &, child.
+     */
+    const CollisionPrimitive &getChild(unsigned int index) const
+    {
+        return *m_children[index];
+    }
+
+    /**
+     * Get the bounds of every child in the compound's space.
+     *
+     * @return   const BoundingBox &, bounds of the children.
+     */
+    const BoundingBox &getLocalBounds() const
+    {
+        return m_localBounds;
+    }
+
+    /**
+     * Find the children whose bounds overlap a box.
+     *
+     * The callback is invoked as callback(const CollisionPrimitive &child)
+     * and should return true to continue the query or false to stop it.
+     *
+     * @param   box        const BoundingBox &, box in world-space.
+     * @param   callback   T &, callback invoked for each child.
+     */
+    template <typename T>
+    void queryChildren(const BoundingBox &box, T &callback) const;
+
+    /**
+     * Find the children whose bounds, grown by a radius, a ray enters.
+     *
+     * The callback is invoked as
+     * callback(const CollisionPrimitive &child, scalar maxDistance) and
+     * returns the new maximum distance, as for AabbTree::rayCast.
+     *
+     * @param   origin        const ds_math::Vector3 &, start of the ray in
+     * world-space.
+     * @param   direction     const ds_math::Vector3 &, unit direction in
+     * world-space.
+     * @param   maxDistance   ds_math::scalar, length of the ray.
+     * @param   radius        ds_math::scalar, distance to grow the bounds
+     * by.
+     * @param   callback      T &, callback invoked for each child.
+     */
+    template <typename T>
+    void rayCastChildren(const ds_math::Vector3 &origin,
+                         const ds_math::Vector3 &direction,
+                         ds_math::scalar maxDistance,
+                         ds_math::scalar radius,
+                         T &callback) const;
+
+    /**
+     * Calculates the internals for the compound and its children.
+     */
+    virtual void calculateInternals();
+
+    virtual bool calculateBoundingBox(BoundingBox *box) const;
+
+private:
+    /** Children of the compound. */
+    std::vector<std::unique_ptr<CollisionPrimitive>> m_children;
+
+    /** Bounds of each child in the compound's space. */
+    AabbTree m_tree;
+
+    /** Bounds of every child in the compound's space. */
+    BoundingBox m_localBounds;
+};
+
+template <typename T>
+void CollisionCompound::queryChildren(const BoundingBox &box,
+                                      T &callback) const
+{
+    // Bounds of the box in the compound's space
+    ds_math::Vector3 centre = getPointInLocalSpace((box.min + box.max) * 0.5f);
+    ds_math::Vector3 halfSize = (box.max - box.min) * 0.5f;
+    ds_math::Vector3 extents;
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        extents[i] = fabs(transform[i][0]) * halfSize.x +
+                     fabs(transform[i][1]) * halfSize.y +
+                     fabs(transform[i][2]) * halfSize.z;
+    }
+
+    auto visit = [&](int proxyId) {
+        return callback(
+            *m_children[(intptr_t)m_tree.getUserData(proxyId)]);
+    };
+    m_tree.query(BoundingBox(centre - extents, centre + extents), visit);
+}
+
+template <typename T>
+void CollisionCompound::rayCastChildren(const ds_math::Vector3 &origin,
+                                        const ds_math::Vector3 &direction,
+                                        ds_math::scalar maxDistance,
+                                        ds_math::scalar radius,
+                                        T &callback) const
+{
+    auto visit = [&](int proxyId, ds_math::scalar distance) {
+        return callback(
+            *m_children[(intptr_t)m_tree.getUserData(proxyId)], distance);
+    };
+    m_tree.rayCast(getPointInLocalSpace(origin),
+                   getDirectionInLocalSpace(direction), maxDistance,
+                   ds_math::Vector3(radius, radius, radius), visit);
+}
+
+/**
+ * Where a ray first meets a shape.
+ */
+struct RayIntersection
+{
+    /** Distance along the ray, 0 if the ray starts inside the shape. */
+    ds_math::scalar distance;
+
+    /**
+     * Surface normal where the ray meets the shape, facing the ray. The
+     * reverse of the ray direction if the ray starts inside the shape.
+     */
+    ds_math::Vector3 normal;
 };
 
 /**
@@ -235,6 +736,163 @@ public:
     static bool boxAndHalfSpace(const CollisionBox &box,
                                 const CollisionPlane &plane);
 
+    /**
+     * @name Ray Tests
+     *
+     * Each ray test finds where a ray first meets a shape within a
+     * maximum distance. The shape may be grown by a radius, which gives
+     * where a sphere of that radius swept along the ray first touches the
+     * shape. The ray direction must be normalized.
+     */
+    /*@{*/
+
+    /**
+     * Ray and sphere intersection test.
+     *
+     * @param   origin        const ds_math::Vector3 &, start of the ray.
+     * @param   direction     const ds_math::Vector3 &, unit direction.
+     * @param   maxDistance   ds_math::scalar, length of the ray.
+     * @param   centre        const ds_math::Vector3 &, centre of the sphere.
+     * @param   radius        ds_math::scalar, radius of the sphere.
+     * @param   hit           RayIntersection *, where the ray meets the
+     * sphere, only written if it does.
+     * @return                bool, true if the ray meets the sphere.
+     */
+    static bool rayAndSphere(const ds_math::Vector3 &origin,
+                             const ds_math::Vector3 &direction,
+                             ds_math::scalar maxDistance,
+                             const ds_math::Vector3 &centre,
+                             ds_math::scalar radius,
+                             RayIntersection *hit);
+
+    /**
+     * Ray and capsule intersection test, the capsule given by the segment
+     * along its middle.
+     *
+     * @param   origin        const ds_math::Vector3 &, start of the ray.
+     * @param   direction     const ds_math::Vector3 &, unit direction.
+     * @param   maxDistance   ds_math::scalar, length of the ray.
+     * @param   start         const ds_math::Vector3 &, start of the segment.
+     * @param   end           const ds_math::Vector3 &, end of the segment.
+     * @param   radius        ds_math::scalar, radius of the capsule.
+     * @param   hit           RayIntersection *, where the ray meets the
+     * capsule, only written if it does.
+     * @return                bool, true if the ray meets the capsule.
+     */
+    static bool rayAndSegment(const ds_math::Vector3 &origin,
+                              const ds_math::Vector3 &direction,
+                              ds_math::scalar maxDistance,
+                              const ds_math::Vector3 &start,
+                              const ds_math::Vector3 &end,
+                              ds_math::scalar radius,
+                              RayIntersection *hit);
+
+    /**
+     * Ray and half-space intersection test.
+     *
+     * @param   origin        const ds_math::Vector3 &, start of the ray.
+     * @param   direction     const ds_math::Vector3 &, unit direction.
+     * @param   maxDistance   ds_math::scalar, length of the ray.
+     * @param   plane         const CollisionPlane &, plane bounding the
+     * half-space.
+     * @param   radius        ds_math::scalar, distance to grow the
+     * half-space by.
+     * @param   hit           RayIntersection *, where the ray meets the
+     * half-space, only written if it does.
+     * @return                bool, true if the ray meets the half-space.
+     */
+    static bool rayAndHalfSpace(const ds_math::Vector3 &origin,
+                                const ds_math::Vector3 &direction,
+                                ds_math::scalar maxDistance,
+                                const CollisionPlane &plane,
+                                ds_math::scalar radius,
+                                RayIntersection *hit);
+
+    /**
+     * Ray and triangle intersection test.
+     *
+     * @param   origin        const ds_math::Vector3 &, start of the ray.
+     * @param   direction     const ds_math::Vector3 &, unit direction.
+     * @param   maxDistance   ds_math::scalar, length of the ray.
+     * @param   vertices      const ds_math::Vector3 *, three corners of the
+     * triangle.
+     * @param   radius        ds_math::scalar, distance to grow the triangle
+     * by.
+     * @param   hit           RayIntersection *, where the ray meets the
+     * triangle, only written if it does.
+     * @return                bool, true if the ray meets the triangle.
+     */
+    static bool rayAndTriangle(const ds_math::Vector3 &origin,
+                               const ds_math::Vector3 &direction,
+                               ds_math::scalar maxDistance,
+                               const ds_math::Vector3 *vertices,
+                               ds_math::scalar radius,
+                               RayIntersection *hit);
+
+    /**
+     * Ray and heightfield intersection test, walking the cells along the
+     * ray.
+     *
+     * @param   origin        const ds_math::Vector3 &, start of the ray.
+     * @param   direction     const ds_math::Vector3 &, unit direction.
+     * @param   maxDistance   ds_math::scalar, length of the ray.
+     * @param   heightfield   const CollisionHeightfield &, heightfield to
+     * test.
+     * @param   radius        ds_math::scalar, distance to grow the
+     * heightfield by.
+     * @param   hit           RayIntersection *, where the ray meets the
+     * heightfield, only written if it does.
+     * @return                bool, true if the ray meets the heightfield.
+     */
+    static bool rayAndHeightfield(const ds_math::Vector3 &origin,
+                                  const ds_math::Vector3 &direction,
+                                  ds_math::scalar maxDistance,
+                                  const CollisionHeightfield &heightfield,
+                                  ds_math::scalar radius,
+                                  RayIntersection *hit);
+
+    /**
+     * Ray and box intersection test. A grown box has rounded edges and
+     * corners.
+     *
+     * @param   origin        const ds_math::Vector3 &, start of the ray.
+     * @param   direction     const ds_math::Vector3 &, unit direction.
+     * @param   maxDistance   ds_math::scalar, length of the ray.
+     * @param   box           const CollisionBox &, box to test.
+     * @param   radius        ds_math::scalar, distance to grow the box by.
+     * @param   hit           RayIntersection *, where the ray meets the box,
+     * only written if it does.
+     * @return                bool, true if the ray meets the box.
+     */
+    static bool rayAndBox(const ds_math::Vector3 &origin,
+                          const ds_math::Vector3 &direction,
+                          ds_math::scalar maxDistance,
+                          const CollisionBox &box,
+                          ds_math::scalar radius,
+                          RayIntersection *hit);
+
+    /**
+     * Ray and primitive intersection test, dispatching on the type of the
+     * primitive. The primitive's internals must be up to date.
+     *
+     * @param   origin        const ds_math::Vector3 &, start of the ray.
+     * @param   direction     const ds_math::Vector3 &, unit direction.
+     * @param   maxDistance   ds_math::scalar, length of the ray.
+     * @param   primitive     const CollisionPrimitive &, primitive to test.
+     * @param   radius        ds_math::scalar, distance to grow the
+     * primitive by.
+     * @param   hit           RayIntersection *, where the ray meets the
+     * primitive, only written if it does.
+     * @return                bool, true if the ray meets the primitive.
+     */
+    static bool rayAndPrimitive(const ds_math::Vector3 &origin,
+                                const ds_math::Vector3 &direction,
+                                ds_math::scalar maxDistance,
+                                const CollisionPrimitive &primitive,
+                                ds_math::scalar radius,
+                                RayIntersection *hit);
+    /*@}*/
+
 
 }; // end IntersectionTests
 
@@ -323,6 +981,16 @@ struct CollisionData
 class CollisionDetector
 {
 public:
+    /**
+     * Does a collision test on any two primitives, dispatching on the type
+     * of each primitive to the matching routine below.
+     *
+     * Pairs of planes never generate contacts.
+     */
+    static unsigned primitiveAndPrimitive(const CollisionPrimitive &one,
+                                          const CollisionPrimitive &two,
+                                          CollisionData *data);
+
     static unsigned sphereAndHalfSpace(const CollisionSphere &sphere,
                                        const CollisionPlane &plane,
                                        CollisionData *data);
@@ -369,6 +1037,61 @@ public:
     static unsigned capsuleAndCapsule(const CollisionCapsule &cap1,
                                       const CollisionCapsule &cap2,
                                       CollisionData *data);
+
+    /**
+     * @name Heightfield Collisions
+     *
+     * Shapes are tested against the triangles of the cells under their
+     * bounding box. The samples in those cells are also tested against the
+     * shape, so that peaks poking into a box or capsule push it away.
+     * Contacts at the same point, such as a sphere on a sample shared by
+     * several triangles, are only reported once.
+     */
+    /*@{*/
+    static unsigned sphereAndHeightfield(const CollisionSphere &sphere,
+                                         const CollisionHeightfield &field,
+                                         CollisionData *data);
+
+    static unsigned boxAndHeightfield(const CollisionBox &box,
+                                      const CollisionHeightfield &field,
+                                      CollisionData *data);
+
+    static unsigned capsuleAndHeightfield(const CollisionCapsule &cap,
+                                          const CollisionHeightfield &field,
+                                          CollisionData *data);
+
+    /**
+     * Convex hull and heightfield collision, the corners of the hull under
+     * the surface and the samples inside the hull.
+     */
+    static unsigned convexHullAndHeightfield(const CollisionConvexHull &hull,
+                                             const CollisionHeightfield &field,
+                                             CollisionData *data);
+    /*@}*/
+
+    /**
+     * Convex hull and convex primitive collision, using GJK and EPA. The
+     * shape may be a box, sphere, capsule or convex hull.
+     */
+    static unsigned convexHullAndConvex(const CollisionConvexHull &hull,
+                                        const CollisionPrimitive &shape,
+                                        CollisionData *data);
+
+    /**
+     * Convex hull and half-space collision, a contact for each of the
+     * deepest corners of the hull behind the plane.
+     */
+    static unsigned convexHullAndHalfSpace(const CollisionConvexHull &hull,
+                                           const CollisionPlane &plane,
+                                           CollisionData *data);
+
+    /**
+     * Compound and primitive collision, the primitive is tested against
+     * each child its bounds overlap. The primitive may be a compound too.
+     */
+    static unsigned compoundAndPrimitive(const CollisionCompound &compound,
+                                         const CollisionPrimitive &primitive,
+                                         CollisionData *data);
 }; // end CollisionDetector
 
 } // end namespace
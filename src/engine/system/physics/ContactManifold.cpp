@@ -0,0 +1,213 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "engine/system/physics/ContactManifold.h"
+
+namespace ds_phys
+{
+ContactManifold::ContactManifold(ds_math::scalar threshold)
+    : lastStep(0), m_pointCount(0), m_freshPoints(0), m_threshold(threshold),
+      m_friction(0), m_restitution(0)
+{
+    m_body[0] = nullptr;
+    m_body[1] = nullptr;
+}
+
+ds_math::Vector3
+ContactManifold::getWorldPoint(const ContactManifoldPoint &point,
+                               unsigned int body) const
+{
+    if (m_body[body])
+    {
+        return m_body[body]->getPointInWorldSpace(point.localPoint[body]);
+    }
+
+    return point.localPoint[body];
+}
+
+void ContactManifold::refresh()
+{
+    const ds_math::scalar thresholdSquared = m_threshold * m_threshold;
+
+    m_freshPoints = 0;
+
+    unsigned int i = 0;
+    while (i < m_pointCount)
+    {
+        ContactManifoldPoint &point = m_points[i];
+
+        ds_math::Vector3 a = getWorldPoint(point, 0);
+        ds_math::Vector3 b = getWorldPoint(point, 1);
+        ds_math::Vector3 offset = b - a;
+
+        // Both positions started at the contact point, so the offset along
+        // the normal is how much deeper the bodies now are
+        ds_math::scalar depth = ds_math::Vector3::Dot(offset, point.normal);
+        ds_math::Vector3 slide = offset - point.normal * depth;
+
+        point.penetration = point.basePenetration + depth;
+        point.point = (a + b) * 0.5f;
+
+        if (point.penetration < -m_threshold ||
+            ds_math::Vector3::Dot(slide, slide) > thresholdSquared)
+        {
+            m_points[i] = m_points[--m_pointCount];
+        }
+        else
+        {
+            ++i;
+        }
+    }
+}
+
+void ContactManifold::addContact(const Contact &contact)
+{
+    RigidBody *body[2] = {contact.body[0], contact.body[1]};
+    ds_math::Vector3 normal = contact.contactNormal;
+
+    // Keep the bodies in the order the manifold first saw them
+    if (!body[0] || (m_pointCount > 0 && body[0] != m_body[0]))
+    {
+        std::swap(body[0], body[1]);
+        normal = -normal;
+    }
+
+    if (m_pointCount == 0)
+    {
+        m_body[0] = body[0];
+        m_body[1] = body[1];
+    }
+    assert(body[0] == m_body[0] && body[1] == m_body[1]);
+
+    ContactManifoldPoint point;
+    for (unsigned int i = 0; i < 2; ++i)
+    {
+        point.localPoint[i] =
+            body[i] ? body[i]->getPointInLocalSpace(contact.contactPoint)
+                    : contact.contactPoint;
+    }
+    point.normal = normal;
+    point.basePenetration = contact.penetration;
+    point.penetration = contact.penetration;
+    point.point = contact.contactPoint;
+
+    // Replace the nearest point close enough to be the same contact, that
+    // hasn't already been replaced by another contact since the refresh
+    ds_math::scalar nearest = m_threshold * m_threshold;
+    unsigned int index = m_pointCount;
+    for (unsigned int i = 0; i < m_pointCount; ++i)
+    {
+        if (m_freshPoints & (1u << i))
+        {
+            continue;
+        }
+
+        ds_math::Vector3 offset = m_points[i].point - contact.contactPoint;
+        ds_math::scalar distance = ds_math::Vector3::Dot(offset, offset);
+        if (distance <= nearest)
+        {
+            nearest = distance;
+            index = i;
+        }
+    }
+
+    if (index < m_pointCount)
+    {
+        point.impulse = m_points[index].impulse;
+    }
+    else if (m_pointCount < MAX_POINTS)
+    {
+        ++m_pointCount;
+    }
+    else
+    {
+        index = getReplacedPoint(contact.contactPoint);
+    }
+
+    m_points[index] = point;
+    m_freshPoints |= 1u << index;
+
+    m_friction = contact.friction;
+    m_restitution = contact.restitution;
+}
+
+unsigned int
+ContactManifold::getReplacedPoint(const ds_math::Vector3 &point) const
+{
+    assert(m_pointCount == MAX_POINTS);
+
+    unsigned int deepest = 0;
+    for (unsigned int i = 1; i < MAX_POINTS; ++i)
+    {
+        if (m_points[i].penetration > m_points[deepest].penetration)
+        {
+            deepest = i;
+        }
+    }
+
+    // Area of the quadrilateral left by replacing each point, found from
+    // its diagonals. Points added since the refresh are kept if possible.
+    unsigned int replaced = deepest == 0 ? 1 : 0;
+    ds_math::scalar largest = -1;
+    bool replacedFresh = true;
+    for (unsigned int i = 0; i < MAX_POINTS; ++i)
+    {
+        bool fresh = (m_freshPoints & (1u << i)) != 0;
+        if (i == deepest || (fresh && !replacedFresh))
+        {
+            continue;
+        }
+
+        ds_math::Vector3 corners[MAX_POINTS];
+        for (unsigned int j = 0; j < MAX_POINTS; ++j)
+        {
+            corners[j] = j == i ? point : m_points[j].point;
+        }
+
+        ds_math::Vector3 normal = ds_math::Vector3::Cross(
+            corners[0] - corners[2], corners[1] - corners[3]);
+        ds_math::scalar area = ds_math::Vector3::Dot(normal, normal);
+        if (area > largest || (replacedFresh && !fresh))
+        {
+            largest = area;
+            replaced = i;
+            replacedFresh = fresh;
+        }
+    }
+
+    return replaced;
+}
+
+void ContactManifold::getContact(unsigned int index, Contact *contact) const
+{
+    assert(index < m_pointCount);
+
+    const ContactManifoldPoint &point = m_points[index];
+    contact->body[0] = m_body[0];
+    contact->body[1] = m_body[1];
+    contact->contactPoint = point.point;
+    contact->contactNormal = point.normal;
+    contact->penetration = point.penetration;
+    contact->impulse = point.impulse;
+    contact->friction = m_friction;
+    contact->restitution = m_restitution;
+}
+
+unsigned int ContactManifold::getPointCount() const
+{
+    return m_pointCount;
+}
+
+ContactManifoldPoint &ContactManifold::getPoint(unsigned int index)
+{
+    assert(index < m_pointCount);
+
+    return m_points[index];
+}
+
+RigidBody *ContactManifold::getBody(unsigned int index) const
+{
+    return m_body[index];
+}
+}
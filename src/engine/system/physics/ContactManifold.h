@@ -0,0 +1,153 @@
+#pragma once
+
+#include "engine/system/physics/Contacts.h"
+#include "engine/system/physics/RigidBody.h"
+#include "math/Precision.h"
+#include "math/Vector3.h"
+
+namespace ds_phys
+{
+/**
+ * Contact point kept by a contact manifold between steps.
+ */
+struct ContactManifoldPoint
+{
+    /**
+     * Contact point in the local space of each body, or in world-space if
+     * there is no body.
+     */
+    ds_math::Vector3 localPoint[2];
+
+    /** Contact normal, pointing from the second body to the first. */
+    ds_math::Vector3 normal;
+
+    /** Penetration when the point was last generated. */
+    ds_math::scalar basePenetration;
+
+    /** Penetration once the point has moved with the bodies. */
+    ds_math::scalar penetration;
+
+    /** Contact point in world-space, midway between the two bodies. */
+    ds_math::Vector3 point;
+
+    /** Impulse applied at the point last step, in world-space. */
+    ds_math::Vector3 impulse;
+};
+
+/**
+ * Contact points between one pair of collision primitives, kept from step
+ * to step.
+ *
+ * Many collision routines only generate the single deepest contact, so a
+ * box resting on a box only has one point each step. The manifold keeps
+ * the earlier points that are still touching, so that such a box is
+ * supported at several corners, and keeps the impulse each point received
+ * so that it can be used to warm start the solver.
+ */
+class ContactManifold
+{
+public:
+    /** Maximum number of points kept. */
+    const static unsigned int MAX_POINTS = 4;
+
+    /**
+     * ContactManifold constructor.
+     *
+     * @param   threshold   ds_math::scalar, distance the bodies may move
+     * apart at a point, either along the normal or sliding, before it is
+     * dropped.
+     */
+    explicit ContactManifold(ds_math::scalar threshold = 0.02f);
+
+    /**
+     * Move the points with their bodies and drop the points whose bodies
+     * have separated or slid apart there.
+     */
+    void refresh();
+
+    /**
+     * Add a newly generated contact, replacing the point it matches. The
+     * matched point keeps its impulse. Points should be refreshed first.
+     *
+     * @param   contact   const Contact &, generated contact.
+     */
+    void addContact(const Contact &contact);
+
+    /**
+     * Fill in a contact for one of the points, ready to be solved.
+     *
+     * @param   index     unsigned int, index of the point.
+     * @param   contact   Contact *, contact to fill in, with the friction and
+     * restitution of the last contact added.
+     */
+    void getContact(unsigned int index, Contact *contact) const;
+
+    /**
+     * Get the number of points.
+     *
+     * @return   unsigned int, number of points.
+     */
+    unsigned int getPointCount() const;
+
+    /**
+     * Get a point.
+     *
+     * @param   index   unsigned int, index of the point.
+     * @return          ContactManifoldPoint &, point.
+     */
+    ContactManifoldPoint &getPoint(unsigned int index);
+
+    /**
+     * Get the bodies the points belong to, the first is only nullptr if
+     * the manifold is empty.
+     *
+     * @param   index   unsigned int, 0 or 1.
+     * @return          RigidBody *, body.
+     */
+    RigidBody *getBody(unsigned int index) const;
+
+    /** Step in which a contact was last added. */
+    unsigned int lastStep;
+
+private:
+    /**
+     * Get a point's position on one of the bodies in world-space.
+     *
+     * @param   point   const ContactManifoldPoint &, point.
+     * @param   body    unsigned int, 0 or 1.
+     * @return          ds_math::Vector3, position.
+     */
+    ds_math::Vector3 getWorldPoint(const ContactManifoldPoint &point,
+                                   unsigned int body) const;
+
+    /**
+     * Choose the point to replace with a new point when the manifold is
+     * full, keeping the deepest point and the largest contact area.
+     *
+     * @param   point   const ds_math::Vector3 &, new point.
+     * @return          unsigned int, index of the point to replace.
+     */
+    unsigned int getReplacedPoint(const ds_math::Vector3 &point) const;
+
+    /** Bodies of the points, the first is never nullptr. */
+    RigidBody *m_body[2];
+
+    /** Points of the manifold. */
+    ContactManifoldPoint m_points[MAX_POINTS];
+
+    /** Number of points. */
+    unsigned int m_pointCount;
+
+    /** Bit set for each point added or replaced since the last refresh. */
+    unsigned int m_freshPoints;
+
+    /** Distance apart at which points are dropped. */
+    ds_math::scalar m_threshold;
+
+    /** Friction of the last contact added. */
+    ds_math::scalar m_friction;
+
+    /** Restitution of the last contact added. */
+    ds_math::scalar m_restitution;
+};
+}
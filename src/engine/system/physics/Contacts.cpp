@@ -54,9 +54,11 @@ void Contact::matchAwakeState()
     bool isAwake1 = body[1]->getAwake();
     if (isAwake0 ^ isAwake1)
     {
-        if (isAwake0)
+        // Immovable bodies are never woken, they may be shared by islands
+        // that are resolved in parallel.
+        if (isAwake0 && body[1]->hasFiniteMass())
             body[1]->setAwake();
-        else
+        else if (isAwake1 && body[0]->hasFiniteMass())
             body[0]->setAwake();
     }
 }
@@ -157,6 +159,14 @@ void Contact::calculateContactBasis()
     m_contactToWorld[2] = contactTan[1];
 }
 
+void Contact::getInverseInertiaTensorWorld(const RigidBody *body,
+                                           Matrix3 *inverseInertiaTensor)
+{
+    if (body->hasFiniteMass())
+        body->getInverseInertiaTensorWorld(inverseInertiaTensor);
+    else
+        *inverseInertiaTensor = Matrix3(0.0f);
+}
 
 static void applyImpulseToBody(RigidBody *body,
                                const Vector3 &relContactPos,
@@ -172,8 +182,12 @@ static void applyImpulseToBody(RigidBody *body,
         rotChange = inverseInertiaTensor * impulsiveTorque;
         velChange = (impulse * body->getInverseMass());
 
-        body->addVelocity(velChange);
-        body->addRotation(rotChange);
+        // Immovable bodies are only read, see matchAwakeState
+        if (body->hasFiniteMass())
+        {
+            body->addVelocity(velChange);
+            body->addRotation(rotChange);
+        }
     }
 }
 
@@ -185,7 +199,7 @@ void Contact::applyImpulse(const ds_math::Vector3 &impulse,
     ///@todo Check if this implementation is correct. As far as I can tell, it
     /// should be.
     Matrix3 inverseInertiaTensor;
-    body->getInverseInertiaTensorWorld(&inverseInertiaTensor);
+    getInverseInertiaTensorWorld(body, &inverseInertiaTensor);
     applyImpulseToBody(body, m_relativeContactPosition[0], impulse,
                        inverseInertiaTensor, *velocityChange, *rotationChange);
 }
@@ -197,9 +211,9 @@ void Contact::applyVelocityChange(ds_math::Vector3 velocityChange[2],
     // Calculate world-space impulse
     Matrix3 inverseInertiaTensor[2];
 
-    body[0]->getInverseInertiaTensorWorld(&inverseInertiaTensor[0]);
+    getInverseInertiaTensorWorld(body[0], &inverseInertiaTensor[0]);
     if (body[1])
-        body[1]->getInverseInertiaTensorWorld(&inverseInertiaTensor[1]);
+        getInverseInertiaTensorWorld(body[1], &inverseInertiaTensor[1]);
 
     Vector3 impulse =
         m_contactToWorld *
@@ -297,7 +311,7 @@ static void calculateAngularMove(RigidBody *body,
             Vector3 targetDirection =
                 Vector3::Cross(contactRelPos, contactNormal);
             Matrix3 iiTensor;
-            body->getInverseInertiaTensorWorld(&iiTensor);
+            Contact::getInverseInertiaTensorWorld(body, &iiTensor);
             angularChange =
                 (iiTensor * targetDirection) * (angularMove / angularInertia);
         }
@@ -319,7 +333,7 @@ static void calculateLinearMove(const scalar &linearMove,
 
 static void applyLinearMoveToBody(RigidBody *body, const Vector3 &linearChange)
 {
-    if (body)
+    if (body && body->hasFiniteMass())
     {
         Vector3 pos;
         body->getPosition(&pos);
@@ -331,7 +345,7 @@ static void applyLinearMoveToBody(RigidBody *body, const Vector3 &linearChange)
 static void applyAngularMoveToBody(RigidBody *body,
                                    const Vector3 &angularChange)
 {
-    if (body)
+    if (body && body->hasFiniteMass())
     {
         Quaternion q;
         body->getOrientation(&q);
@@ -355,7 +369,7 @@ void Contact::applyPositionChange(ds_math::Vector3 linearChange[2],
     {
         if (body[i])
         {
-            body[i]->getInverseInertiaTensorWorld(&iiTensor[i]);
+            getInverseInertiaTensorWorld(body[i], &iiTensor[i]);
 
             calculateFrictionlessInertia(
                 body[i], iiTensor[i], m_relativeContactPosition[i], contactNormal,
@@ -387,7 +401,7 @@ void Contact::applyPositionChange(ds_math::Vector3 linearChange[2],
             applyLinearMoveToBody(body[i], contactNormal * linearMove[i]);
             applyAngularMoveToBody(body[i], angularChange[i]);
 
-            if (body[i]->getAwake())
+            if (body[i]->getAwake() && body[i]->hasFiniteMass())
                 body[i]->calculateDerivedData();
 
 
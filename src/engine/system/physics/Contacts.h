@@ -8,6 +8,7 @@
 namespace ds_phys
 {
 class ContactResolver;
+class SequentialImpulseSolver;
 
 /**
  * Contains the information relevant about a contact for collision resolution.
@@ -17,6 +18,7 @@ class ContactResolver;
 class Contact
 {
     friend class ContactResolver;
+    friend class SequentialImpulseSolver;
 
 public:
     /**
@@ -49,6 +51,14 @@ public:
 	 */
 	ds_math::scalar penetration;
 
+	/**
+	 * Total impulse applied at the contact by the sequential impulse
+	 * solver, in world-space.
+	 * @remark Used as the starting impulse when solving, so should be zero
+	 * or the impulse the same contact received last step.
+	 */
+	ds_math::Vector3 impulse;
+
 	/**
 	 * Helper method to set the non-contact-specific data.
 	 * @param rb1 The first rigid body
@@ -57,6 +67,14 @@ public:
 	 * @param restitution The restitution coefficient
 	 */
 	void setBodyData(RigidBody* rb1, RigidBody* rb2, ds_math::scalar friction, ds_math::scalar restitution);
+
+	/**
+	 * Gets the world-space inverse inertia tensor of a body, bodies with
+	 * infinite mass can't be rotated by contacts either.
+	 * @param body The rigid body.
+	 * @param inverseInertiaTensor (out) The inverse inertia tensor.
+	 */
+	static void getInverseInertiaTensorWorld(const RigidBody* body, ds_math::Matrix3* inverseInertiaTensor);
 protected:
 
 	/**
@@ -82,6 +100,37 @@ protected:
 	 */
 	ds_math::Vector3 m_relativeContactPosition[2];
 
+	/**
+	 * The inverse of the effective mass along the normal and each of the
+	 * two tangents, used by the sequential impulse solver.
+	 */
+	ds_math::scalar m_effectiveMass[3];
+
+	/**
+	 * The normal velocity the sequential impulse solver aims for, from
+	 * restitution, or the gap left to close.
+	 */
+	ds_math::scalar m_velocityBias;
+
+	/**
+	 * The contact-space axes used by the sequential impulse solver, the
+	 * normal followed by two tangents.
+	 */
+	ds_math::Vector3 m_axes[3];
+
+	/**
+	 * The contact point in the local space of each body, or world-space if
+	 * there is no body, used by the sequential impulse solver to track the
+	 * penetration as bodies are moved apart.
+	 */
+	ds_math::Vector3 m_localContactPoint[2];
+
+	/**
+	 * The impulse accumulated by the sequential impulse solver this step,
+	 * in contact-space.
+	 */
+	ds_math::Vector3 m_accumulatedImpulse;
+
 	/**
 	 * Updates the internal state of the contact based for the given collision duration.
 	 * @param duration The duration of the contact.
@@ -0,0 +1,764 @@
+#include <algorithm>
+#include <cmath>
+
+#include "engine/system/physics/ConvexCollision.h"
+
+namespace ds_phys
+{
+// Most iterations of each algorithm, both converge in far fewer for the
+// shapes found in a scene.
+static const unsigned int MAX_GJK_ITERATIONS = 64;
+static const unsigned int MAX_EPA_ITERATIONS = 64;
+static const unsigned int MAX_ADVANCE_ITERATIONS = 32;
+
+// Largest polytope EPA builds.
+static const unsigned int MAX_EPA_VERTICES = MAX_EPA_ITERATIONS + 4;
+static const unsigned int MAX_EPA_FACES = 2 * MAX_EPA_VERTICES;
+static const unsigned int MAX_EPA_EDGES = 3 * MAX_EPA_FACES;
+
+// Distance below which cores are taken to touch.
+static const ds_math::scalar GJK_TOLERANCE = 1e-5f;
+
+// Distance the polytope may fall short of the boundary of the difference
+// when EPA stops.
+static const ds_math::scalar EPA_TOLERANCE = 1e-4f;
+
+// Gap at which a ray is taken to have reached the shape.
+static const ds_math::scalar ADVANCE_TOLERANCE = 1e-4f;
+
+namespace
+{
+/**
+ * Point of the difference of the cores of two shapes, with the points of
+ * each core that give it.
+ */
+struct SupportPoint
+{
+    /** Point of the difference, one - two. */
+    ds_math::Vector3 point;
+
+    /** Point of the first core. */
+    ds_math::Vector3 one;
+
+    /** Point of the second core. */
+    ds_math::Vector3 two;
+};
+
+SupportPoint getSupport(const ConvexShape &one,
+                        const ConvexShape &two,
+                        const ds_math::Vector3 &direction)
+{
+    SupportPoint support;
+    support.one = one.getSupport(direction);
+    support.two = two.getSupport(-direction);
+    support.point = support.one - support.two;
+    return support;
+}
+
+/**
+ * Up to four points of the difference, with the weights giving the point
+ * of their hull closest to the origin.
+ */
+struct Simplex
+{
+    SupportPoint points[4];
+    ds_math::scalar weights[4];
+    unsigned int count;
+
+    /**
+     * Get the point given by the weights.
+     */
+    ds_math::Vector3 getPoint() const
+    {
+        ds_math::Vector3 point;
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            point += points[i].point * weights[i];
+        }
+        return point;
+    }
+
+    /**
+     * Drop the points with no weight.
+     */
+    void compact()
+    {
+        unsigned int kept = 0;
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            if (weights[i] > 0)
+            {
+                points[kept] = points[i];
+                weights[kept] = weights[i];
+                ++kept;
+            }
+        }
+        count = kept;
+    }
+};
+
+/**
+ * Get the weights of the point of a segment closest to the origin.
+ */
+void getSegmentWeights(const ds_math::Vector3 &a,
+                       const ds_math::Vector3 &b,
+                       ds_math::scalar *weights)
+{
+    ds_math::Vector3 ab = b - a;
+    ds_math::scalar lengthSquared = ds_math::Vector3::Dot(ab, ab);
+    ds_math::scalar along =
+        lengthSquared > 0 ? -ds_math::Vector3::Dot(a, ab) / lengthSquared : 0;
+    along = std::min(std::max(along, 0.0f), 1.0f);
+    weights[0] = 1 - along;
+    weights[1] = along;
+}
+
+/**
+ * Get the weights of the point of a triangle closest to the origin, by
+ * finding the region of the triangle the origin lies in.
+ */
+void getTriangleWeights(const ds_math::Vector3 &a,
+                        const ds_math::Vector3 &b,
+                        const ds_math::Vector3 &c,
+                        ds_math::scalar *weights)
+{
+    ds_math::Vector3 ab = b - a;
+    ds_math::Vector3 ac = c - a;
+
+    weights[0] = weights[1] = weights[2] = 0;
+
+    ds_math::scalar d1 = -ds_math::Vector3::Dot(ab, a);
+    ds_math::scalar d2 = -ds_math::Vector3::Dot(ac, a);
+    if (d1 <= 0 && d2 <= 0)
+    {
+        weights[0] = 1;
+        return;
+    }
+
+    ds_math::scalar d3 = -ds_math::Vector3::Dot(ab, b);
+    ds_math::scalar d4 = -ds_math::Vector3::Dot(ac, b);
+    if (d3 >= 0 && d4 <= d3)
+    {
+        weights[1] = 1;
+        return;
+    }
+
+    ds_math::scalar vc = d1 * d4 - d3 * d2;
+    if (vc <= 0 && d1 >= 0 && d3 <= 0)
+    {
+        ds_math::scalar along = d1 / (d1 - d3);
+        weights[0] = 1 - along;
+        weights[1] = along;
+        return;
+    }
+
+    ds_math::scalar d5 = -ds_math::Vector3::Dot(ab, c);
+    ds_math::scalar d6 = -ds_math::Vector3::Dot(ac, c);
+    if (d6 >= 0 && d5 <= d6)
+    {
+        weights[2] = 1;
+        return;
+    }
+
+    ds_math::scalar vb = d5 * d2 - d1 * d6;
+    if (vb <= 0 && d2 >= 0 && d6 <= 0)
+    {
+        ds_math::scalar along = d2 / (d2 - d6);
+        weights[0] = 1 - along;
+        weights[2] = along;
+        return;
+    }
+
+    ds_math::scalar va = d3 * d6 - d5 * d4;
+    if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0)
+    {
+        ds_math::scalar along = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        weights[1] = 1 - along;
+        weights[2] = along;
+        return;
+    }
+
+    ds_math::scalar denominator = 1.0f / (va + vb + vc);
+    weights[1] = vb * denominator;
+    weights[2] = vc * denominator;
+    weights[0] = 1 - weights[1] - weights[2];
+}
+
+/**
+ * Find the point of the simplex closest to the origin and drop the points
+ * not needed to give it.
+ *
+ * @return   bool, true if the simplex is a tetrahedron holding the origin.
+ */
+bool reduceSimplex(Simplex *simplex)
+{
+    SupportPoint *points = simplex->points;
+    ds_math::scalar *weights = simplex->weights;
+
+    switch (simplex->count)
+    {
+    case 1:
+        weights[0] = 1;
+        break;
+    case 2:
+        getSegmentWeights(points[0].point, points[1].point, weights);
+        break;
+    case 3:
+        getTriangleWeights(points[0].point, points[1].point, points[2].point,
+                           weights);
+        break;
+    case 4:
+    {
+        // Faces with the origin on the far side from the fourth point, a
+        // flat tetrahedron has the origin outside every face
+        static const unsigned int faces[4][4] = {
+            {0, 1, 2, 3}, {0, 1, 3, 2}, {0, 2, 3, 1}, {1, 2, 3, 0}};
+
+        bool outside = false;
+        ds_math::scalar nearest = 0;
+        ds_math::scalar nearestWeights[4] = {0, 0, 0, 0};
+        for (const unsigned int *face : faces)
+        {
+            const ds_math::Vector3 &a = points[face[0]].point;
+            const ds_math::Vector3 &b = points[face[1]].point;
+            const ds_math::Vector3 &c = points[face[2]].point;
+            ds_math::Vector3 normal = ds_math::Vector3::Cross(b - a, c - a);
+            ds_math::scalar origin = -ds_math::Vector3::Dot(normal, a);
+            ds_math::scalar opposite =
+                ds_math::Vector3::Dot(normal, points[face[3]].point - a);
+            if (origin * opposite > 0)
+            {
+                continue;
+            }
+
+            ds_math::scalar faceWeights[3];
+            getTriangleWeights(a, b, c, faceWeights);
+            ds_math::Vector3 point =
+                a * faceWeights[0] + b * faceWeights[1] + c * faceWeights[2];
+            ds_math::scalar distanceSquared =
+                ds_math::Vector3::Dot(point, point);
+            if (!outside || distanceSquared < nearest)
+            {
+                outside = true;
+                nearest = distanceSquared;
+                nearestWeights[face[0]] = faceWeights[0];
+                nearestWeights[face[1]] = faceWeights[1];
+                nearestWeights[face[2]] = faceWeights[2];
+                nearestWeights[face[3]] = 0;
+            }
+        }
+
+        if (!outside)
+        {
+            return true;
+        }
+        std::copy(nearestWeights, nearestWeights + 4, weights);
+        break;
+    }
+    }
+
+    simplex->compact();
+    return false;
+}
+
+/**
+ * Run GJK on the cores of two shapes.
+ *
+ * @return   bool, true if the cores overlap, in which case the simplex
+ * holds the origin or lies on it.
+ */
+bool runGjk(const ConvexShape &one, const ConvexShape &two, Simplex *simplex)
+{
+    ds_math::Vector3 direction = two.getCentre() - one.getCentre();
+    if (ds_math::Vector3::Dot(direction, direction) <= 0)
+    {
+        direction = ds_math::Vector3::UnitX;
+    }
+
+    simplex->points[0] = getSupport(one, two, direction);
+    simplex->count = 1;
+
+    for (unsigned int i = 0; i < MAX_GJK_ITERATIONS; ++i)
+    {
+        if (reduceSimplex(simplex))
+        {
+            return true;
+        }
+
+        ds_math::Vector3 closest = simplex->getPoint();
+        ds_math::scalar distanceSquared =
+            ds_math::Vector3::Dot(closest, closest);
+        if (distanceSquared <= GJK_TOLERANCE * GJK_TOLERANCE)
+        {
+            return true;
+        }
+
+        // Stop once a new point gets no closer to the origin
+        SupportPoint support = getSupport(one, two, -closest);
+        ds_math::scalar progress =
+            distanceSquared - ds_math::Vector3::Dot(closest, support.point);
+        if (progress <= distanceSquared * 1e-6f)
+        {
+            return false;
+        }
+
+        simplex->points[simplex->count++] = support;
+    }
+
+    return false;
+}
+
+/**
+ * Get the weights of the projection of the origin onto a triangle's plane.
+ */
+void getPlaneWeights(const ds_math::Vector3 &a,
+                     const ds_math::Vector3 &b,
+                     const ds_math::Vector3 &c,
+                     ds_math::scalar *weights)
+{
+    ds_math::Vector3 ab = b - a;
+    ds_math::Vector3 ac = c - a;
+    ds_math::Vector3 ao = -a;
+    ds_math::scalar d00 = ds_math::Vector3::Dot(ab, ab);
+    ds_math::scalar d01 = ds_math::Vector3::Dot(ab, ac);
+    ds_math::scalar d11 = ds_math::Vector3::Dot(ac, ac);
+    ds_math::scalar d20 = ds_math::Vector3::Dot(ao, ab);
+    ds_math::scalar d21 = ds_math::Vector3::Dot(ao, ac);
+    ds_math::scalar denominator = d00 * d11 - d01 * d01;
+    if (denominator <= 0)
+    {
+        weights[0] = 1;
+        weights[1] = weights[2] = 0;
+        return;
+    }
+
+    weights[1] = (d11 * d20 - d01 * d21) / denominator;
+    weights[2] = (d00 * d21 - d01 * d20) / denominator;
+    weights[0] = 1 - weights[1] - weights[2];
+}
+
+/**
+ * Grow a simplex lying on the origin into a tetrahedron around it.
+ *
+ * @return   bool, false if the difference is too thin to hold one.
+ */
+bool growSimplex(const ConvexShape &one,
+                 const ConvexShape &two,
+                 Simplex *simplex)
+{
+    static const ds_math::Vector3 axes[3] = {
+        ds_math::Vector3::UnitX, ds_math::Vector3::UnitY,
+        ds_math::Vector3::UnitZ};
+
+    if (simplex->count == 1)
+    {
+        for (unsigned int i = 0; i < 6 && simplex->count == 1; ++i)
+        {
+            SupportPoint support =
+                getSupport(one, two, i < 3 ? axes[i] : -axes[i - 3]);
+            ds_math::Vector3 offset =
+                support.point - simplex->points[0].point;
+            if (ds_math::Vector3::Dot(offset, offset) > GJK_TOLERANCE)
+            {
+                simplex->points[simplex->count++] = support;
+            }
+        }
+    }
+
+    if (simplex->count == 2)
+    {
+        ds_math::Vector3 a = simplex->points[0].point;
+        ds_math::Vector3 ab = simplex->points[1].point - a;
+
+        // Search around the segment, starting from the axis most across it
+        unsigned int axis = 0;
+        for (unsigned int i = 1; i < 3; ++i)
+        {
+            if (fabs(ab[i]) < fabs(ab[axis]))
+            {
+                axis = i;
+            }
+        }
+        ds_math::Vector3 across[2];
+        across[0] = ds_math::Vector3::Cross(ab, axes[axis]);
+        across[1] = ds_math::Vector3::Cross(ab, across[0]);
+        for (unsigned int i = 0; i < 4 && simplex->count == 2; ++i)
+        {
+            SupportPoint support = getSupport(
+                one, two, i < 2 ? across[i] : -across[i - 2]);
+            ds_math::Vector3 normal =
+                ds_math::Vector3::Cross(ab, support.point - a);
+            if (ds_math::Vector3::Dot(normal, normal) > GJK_TOLERANCE)
+            {
+                simplex->points[simplex->count++] = support;
+            }
+        }
+    }
+
+    if (simplex->count == 3)
+    {
+        ds_math::Vector3 a = simplex->points[0].point;
+        ds_math::Vector3 normal =
+            ds_math::Vector3::Cross(simplex->points[1].point - a,
+                                    simplex->points[2].point - a);
+        for (unsigned int i = 0; i < 2 && simplex->count == 3; ++i)
+        {
+            SupportPoint support =
+                getSupport(one, two, i == 0 ? normal : -normal);
+            if (fabs(ds_math::Vector3::Dot(normal, support.point - a)) >
+                GJK_TOLERANCE)
+            {
+                simplex->points[simplex->count++] = support;
+            }
+        }
+    }
+
+    return simplex->count == 4;
+}
+
+/**
+ * Face of the polytope built by EPA, wound so that its normal faces out.
+ */
+struct PolytopeFace
+{
+    unsigned int vertices[3];
+    ds_math::Vector3 normal;
+    ds_math::scalar distance;
+};
+
+/**
+ * Polytope EPA expands towards the boundary of the difference of the
+ * cores.
+ */
+class Polytope
+{
+public:
+    /**
+     * Start from a tetrahedron holding the origin.
+     */
+    explicit Polytope(const Simplex &simplex) : m_vertexCount(4), m_faceCount(0)
+    {
+        std::copy(simplex.points, simplex.points + 4, m_vertices);
+
+        // Wind the faces so that the fourth point is behind the first
+        ds_math::Vector3 a = m_vertices[0].point;
+        ds_math::Vector3 normal =
+            ds_math::Vector3::Cross(m_vertices[1].point - a,
+                                    m_vertices[2].point - a);
+        if (ds_math::Vector3::Dot(normal, m_vertices[3].point - a) > 0)
+        {
+            std::swap(m_vertices[0], m_vertices[1]);
+        }
+
+        m_valid = addFace(0, 1, 2) && addFace(0, 3, 1) && addFace(0, 2, 3) &&
+                  addFace(1, 3, 2);
+    }
+
+    /**
+     * Expand the polytope until its face closest to the origin lies on the
+     * boundary of the difference.
+     *
+     * @return   const PolytopeFace *, closest face, nullptr if the
+     * polytope has degenerated.
+     */
+    const PolytopeFace *expand(const ConvexShape &one, const ConvexShape &two)
+    {
+        if (!m_valid)
+        {
+            return nullptr;
+        }
+
+        for (unsigned int i = 0; i < MAX_EPA_ITERATIONS; ++i)
+        {
+            const PolytopeFace &closest = m_faces[getClosestFace()];
+            SupportPoint support = getSupport(one, two, closest.normal);
+            if (ds_math::Vector3::Dot(closest.normal, support.point) -
+                        closest.distance <
+                    EPA_TOLERANCE ||
+                m_vertexCount == MAX_EPA_VERTICES)
+            {
+                return &closest;
+            }
+
+            if (!addVertex(support))
+            {
+                return nullptr;
+            }
+        }
+
+        return &m_faces[getClosestFace()];
+    }
+
+    /**
+     * Get a vertex of the polytope.
+     */
+    const SupportPoint &getVertex(unsigned int index) const
+    {
+        return m_vertices[index];
+    }
+
+private:
+    /**
+     * Add a face, pointing its normal away from the origin side it faces.
+     *
+     * @return   bool, false if the face is degenerate or there is no room.
+     */
+    bool addFace(unsigned int a, unsigned int b, unsigned int c)
+    {
+        if (m_faceCount == MAX_EPA_FACES)
+        {
+            return false;
+        }
+
+        const ds_math::Vector3 &pa = m_vertices[a].point;
+        ds_math::Vector3 normal = ds_math::Vector3::Cross(
+            m_vertices[b].point - pa, m_vertices[c].point - pa);
+        ds_math::scalar length = ds_math::Vector3::Magnitude(normal);
+        if (length <= 1e-12f)
+        {
+            return false;
+        }
+
+        PolytopeFace &face = m_faces[m_faceCount++];
+        face.vertices[0] = a;
+        face.vertices[1] = b;
+        face.vertices[2] = c;
+        face.normal = normal * (1.0f / length);
+        face.distance = ds_math::Vector3::Dot(face.normal, pa);
+        return true;
+    }
+
+    /**
+     * Add a vertex, replacing the faces it can see with faces joining it to
+     * the edge of the hole they leave.
+     *
+     * @return   bool, false if the polytope has degenerated.
+     */
+    bool addVertex(const SupportPoint &support)
+    {
+        unsigned int edges[MAX_EPA_EDGES][2];
+        unsigned int edgeCount = 0;
+
+        for (unsigned int i = 0; i < m_faceCount;)
+        {
+            const PolytopeFace &face = m_faces[i];
+            if (ds_math::Vector3::Dot(
+                    face.normal,
+                    support.point - m_vertices[face.vertices[0]].point) <= 0)
+            {
+                ++i;
+                continue;
+            }
+
+            // Edges shared by two visible faces are inside the hole
+            for (unsigned int j = 0; j < 3; ++j)
+            {
+                unsigned int a = face.vertices[j];
+                unsigned int b = face.vertices[(j + 1) % 3];
+
+                unsigned int shared = edgeCount;
+                for (unsigned int k = 0; k < edgeCount; ++k)
+                {
+                    if (edges[k][0] == b && edges[k][1] == a)
+                    {
+                        shared = k;
+                        break;
+                    }
+                }
+
+                if (shared < edgeCount)
+                {
+                    edges[shared][0] = edges[edgeCount - 1][0];
+                    edges[shared][1] = edges[edgeCount - 1][1];
+                    --edgeCount;
+                }
+                else if (edgeCount < MAX_EPA_EDGES)
+                {
+                    edges[edgeCount][0] = a;
+                    edges[edgeCount][1] = b;
+                    ++edgeCount;
+                }
+            }
+
+            m_faces[i] = m_faces[--m_faceCount];
+        }
+
+        if (edgeCount == 0)
+        {
+            return false;
+        }
+
+        unsigned int vertex = m_vertexCount++;
+        m_vertices[vertex] = support;
+        for (unsigned int i = 0; i < edgeCount; ++i)
+        {
+            if (!addFace(edges[i][0], edges[i][1], vertex))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Get the index of the face closest to the origin.
+     */
+    unsigned int getClosestFace() const
+    {
+        unsigned int closest = 0;
+        for (unsigned int i = 1; i < m_faceCount; ++i)
+        {
+            if (m_faces[i].distance < m_faces[closest].distance)
+            {
+                closest = i;
+            }
+        }
+        return closest;
+    }
+
+    SupportPoint m_vertices[MAX_EPA_VERTICES];
+    PolytopeFace m_faces[MAX_EPA_FACES];
+    unsigned int m_vertexCount;
+    unsigned int m_faceCount;
+    bool m_valid;
+};
+
+}
+
+bool ConvexCollision::findContact(const ConvexShape &one,
+                                  const ConvexShape &two,
+                                  ConvexContact *contact)
+{
+    Simplex simplex;
+    ds_math::Vector3 pointOne, pointTwo;
+    ds_math::scalar radii = one.radius + two.radius;
+
+    if (!runGjk(one, two, &simplex))
+    {
+        // Cores apart, the shapes only overlap if their radii do
+        for (unsigned int i = 0; i < simplex.count; ++i)
+        {
+            pointOne += simplex.points[i].one * simplex.weights[i];
+            pointTwo += simplex.points[i].two * simplex.weights[i];
+        }
+
+        ds_math::Vector3 offset = pointOne - pointTwo;
+        ds_math::scalar distance = ds_math::Vector3::Magnitude(offset);
+        if (distance >= radii || distance <= 0)
+        {
+            return false;
+        }
+
+        contact->normal = offset * (1.0f / distance);
+        contact->penetration = radii - distance;
+    }
+    else
+    {
+        // Cores overlap, find how far apart they must move
+        if (!growSimplex(one, two, &simplex))
+        {
+            return false;
+        }
+
+        Polytope polytope(simplex);
+        const PolytopeFace *face = polytope.expand(one, two);
+        if (face == nullptr)
+        {
+            return false;
+        }
+
+        ds_math::scalar weights[3];
+        const SupportPoint &a = polytope.getVertex(face->vertices[0]);
+        const SupportPoint &b = polytope.getVertex(face->vertices[1]);
+        const SupportPoint &c = polytope.getVertex(face->vertices[2]);
+        getPlaneWeights(a.point, b.point, c.point, weights);
+        pointOne = a.one * weights[0] + b.one * weights[1] + c.one * weights[2];
+        pointTwo = a.two * weights[0] + b.two * weights[1] + c.two * weights[2];
+
+        // The face normal points the way the first core would have to move
+        // to reach the origin, so the first shape is pushed back along it
+        contact->normal = -face->normal;
+        contact->penetration = std::max(face->distance, 0.0f) + radii;
+    }
+
+    // Midway between the deepest points of the two shapes
+    contact->point = (pointOne - contact->normal * one.radius + pointTwo +
+                      contact->normal * two.radius) *
+                     0.5f;
+    return true;
+}
+
+ds_math::scalar ConvexCollision::getDistance(const ConvexShape &one,
+                                             const ConvexShape &two,
+                                             ds_math::Vector3 *pointOne,
+                                             ds_math::Vector3 *pointTwo)
+{
+    Simplex simplex;
+    if (runGjk(one, two, &simplex))
+    {
+        return 0;
+    }
+
+    ds_math::Vector3 closestOne, closestTwo;
+    for (unsigned int i = 0; i < simplex.count; ++i)
+    {
+        closestOne += simplex.points[i].one * simplex.weights[i];
+        closestTwo += simplex.points[i].two * simplex.weights[i];
+    }
+
+    *pointOne = closestOne;
+    *pointTwo = closestTwo;
+    return ds_math::Vector3::Magnitude(closestOne - closestTwo);
+}
+
+bool ConvexCollision::rayCast(const ds_math::Vector3 &origin,
+                              const ds_math::Vector3 &direction,
+                              ds_math::scalar maxDistance,
+                              const ConvexShape &shape,
+                              ds_math::scalar radius,
+                              ds_math::scalar *distance,
+                              ds_math::Vector3 *normal)
+{
+    ds_math::scalar grown = shape.radius + radius;
+    ds_math::scalar travelled = 0;
+
+    // Step along the ray by the gap to the shape over how fast the ray
+    // closes it, which never steps past the shape
+    for (unsigned int i = 0; i < MAX_ADVANCE_ITERATIONS; ++i)
+    {
+        ConvexPoint point(origin + direction * travelled);
+        ds_math::Vector3 onShape, onPoint;
+        ds_math::scalar gap =
+            getDistance(shape, point, &onShape, &onPoint) - grown;
+
+        if (gap <= ADVANCE_TOLERANCE)
+        {
+            *distance = travelled;
+            if (travelled > 0 && gap + grown > 0)
+            {
+                *normal = ds_math::Vector3::Normalize(onPoint - onShape);
+            }
+            else
+            {
+                *normal = -direction;
+            }
+            return true;
+        }
+
+        ds_math::Vector3 away = (onPoint - onShape) * (1.0f / (gap + grown));
+        ds_math::scalar approach = -ds_math::Vector3::Dot(direction, away);
+        if (approach <= 0)
+        {
+            return false;
+        }
+
+        travelled += gap / approach;
+        if (travelled > maxDistance)
+        {
+            return false;
+        }
+    }
+
+    return false;
+}
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include "math/Precision.h"
+#include "math/Vector3.h"
+
+namespace ds_phys
+{
+/**
+ * Convex shape given by its support mapping, in world-space.
+ *
+ * Rounded shapes such as spheres and capsules are given by their core (a
+ * point or a segment) and a radius, which keeps the tests exact for them.
+ */
+class ConvexShape
+{
+public:
+    /**
+     * ConvexShape constructor.
+     *
+     * @param   radius   ds_math::scalar, distance the core is grown by.
+     */
+    explicit ConvexShape(ds_math::scalar radius = 0) : radius(radius)
+    {
+    }
+
+    /**
+     * ConvexShape destructor.
+     */
+    virtual ~ConvexShape()
+    {
+    }
+
+    /**
+     * Get the point of the core furthest along a direction.
+     *
+     * @param   direction   const ds_math::Vector3 &, direction, need not be
+     * normalized.
+     * @return              ds_math::Vector3, furthest point.
+     */
+    virtual ds_math::Vector3
+    getSupport(const ds_math::Vector3 &direction) const = 0;
+
+    /**
+     * Get a point inside the core, used as the starting guess.
+     *
+     * @return   ds_math::Vector3, point inside the core.
+     */
+    virtual ds_math::Vector3 getCentre() const = 0;
+
+    /** Distance the core is grown by on every side. */
+    ds_math::scalar radius;
+};
+
+/**
+ * Convex shape whose core is a single point, a sphere if it has a radius.
+ */
+class ConvexPoint : public ConvexShape
+{
+public:
+    /**
+     * ConvexPoint constructor.
+     *
+     * @param   point    const ds_math::Vector3 &, the point.
+     * @param   radius   ds_math::scalar, distance the point is grown by.
+     */
+    explicit ConvexPoint(const ds_math::Vector3 &point,
+                         ds_math::scalar radius = 0)
+        : ConvexShape(radius), m_point(point)
+    {
+    }
+
+    virtual ds_math::Vector3 getSupport(const ds_math::Vector3 &) const
+    {
+        return m_point;
+    }
+
+    virtual ds_math::Vector3 getCentre() const
+    {
+        return m_point;
+    }
+
+private:
+    /** The point. */
+    ds_math::Vector3 m_point;
+};
+
+/**
+ * Where two convex shapes touch.
+ */
+struct ConvexContact
+{
+    /** Unit normal, pointing from the second shape to the first. */
+    ds_math::Vector3 normal;
+
+    /** Depth the shapes overlap by along the normal. */
+    ds_math::scalar penetration;
+
+    /** Point midway between the deepest points of each shape. */
+    ds_math::Vector3 point;
+};
+
+/**
+ * Collision tests between any two convex shapes, using GJK to find the
+ * distance between their cores and EPA to find how far the cores overlap.
+ */
+class ConvexCollision
+{
+public:
+    /**
+     * Find the contact between two convex shapes, if they overlap.
+     *
+     * @param   one       const ConvexShape &, first shape.
+     * @param   two       const ConvexShape &, second shape.
+     * @param   contact   ConvexContact *, set to the contact, only written
+     * if the shapes overlap.
+     * @return            bool, true if the shapes overlap.
+     */
+    static bool findContact(const ConvexShape &one,
+                            const ConvexShape &two,
+                            ConvexContact *contact);
+
+    /**
+     * Find the closest points of the cores of two convex shapes, ignoring
+     * their radii.
+     *
+     * @param   one        const ConvexShape &, first shape.
+     * @param   two        const ConvexShape &, second shape.
+     * @param   pointOne   ds_math::Vector3 *, set to the closest point on
+     * the first core.
+     * @param   pointTwo   ds_math::Vector3 *, set to the closest point on
+     * the second core.
+     * @return             ds_math::scalar, distance between the cores, 0
+     * if they overlap, in which case the points are left untouched.
+     */
+    static ds_math::scalar getDistance(const ConvexShape &one,
+                                       const ConvexShape &two,
+                                       ds_math::Vector3 *pointOne,
+                                       ds_math::Vector3 *pointTwo);
+
+    /**
+     * Find where a ray first meets a convex shape, by conservative
+     * advancement.
+     *
+     * @param   origin        const ds_math::Vector3 &, start of the ray.
+     * @param   direction     const ds_math::Vector3 &, unit direction.
+     * @param   maxDistance   ds_math::scalar, length of the ray.
+     * @param   shape         const ConvexShape &, shape to test.
+     * @param   radius        ds_math::scalar, distance to grow the shape by,
+     * on top of its own radius.
+     * @param   distance      ds_math::scalar *, set to the distance along
+     * the ray, 0 if it starts inside the shape.
+     * @param   normal        ds_math::Vector3 *, set to the surface normal,
+     * the reverse of the direction if the ray starts inside the shape.
+     * @return                bool, true if the ray meets the shape.
+     */
+    static bool rayCast(const ds_math::Vector3 &origin,
+                        const ds_math::Vector3 &direction,
+                        ds_math::scalar maxDistance,
+                        const ConvexShape &shape,
+                        ds_math::scalar radius,
+                        ds_math::scalar *distance,
+                        ds_math::Vector3 *normal);
+};
+}
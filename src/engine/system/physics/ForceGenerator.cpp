@@ -165,6 +165,16 @@ void ForceRegistry::remove(RigidBody *body,
     }
 }
 
+void ForceRegistry::remove(RigidBody *body)
+{
+    m_registrations.erase(
+        std::remove_if(m_registrations.begin(), m_registrations.end(),
+                       [&](const ForceRegistration &reg) {
+                           return reg.body == body;
+                       }),
+        m_registrations.end());
+}
+
 void ForceRegistry::clear()
 {
     m_registrations.clear();
@@ -194,8 +204,33 @@ void ForceRegistry::updateForces(ds_math::scalar duration)
     std::for_each(m_registrations.begin(), m_registrations.end(),
                   [&](const ForceRegistration &reg) {
                       // Apply forces from force generator (fg) to the rigid
-                      // body
+                      // body. Sleeping bodies are included, a generator
+                      // registered on one is meant to wake it. Gravity is a
+                      // world force field, so it doesn't keep bodies awake.
                       reg.fg->updateForce(reg.body, duration);
                   });
 }
+
+ForceField ForceField::uniform(const ds_math::Vector3 &acceleration)
+{
+    ForceField field = {ForceFieldType::Uniform, acceleration,
+                        ds_math::Vector3(), 0, 0};
+    return field;
+}
+
+ForceField ForceField::directional(const ds_math::Vector3 &force)
+{
+    ForceField field = {ForceFieldType::Directional, force, ds_math::Vector3(),
+                        0, 0};
+    return field;
+}
+
+ForceField ForceField::radial(const ds_math::Vector3 &centre,
+                              ds_math::scalar strength,
+                              ds_math::scalar radius)
+{
+    ForceField field = {ForceFieldType::Radial, ds_math::Vector3(), centre,
+                        strength, radius};
+    return field;
+}
 }
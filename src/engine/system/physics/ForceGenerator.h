@@ -221,6 +221,13 @@ public:
      */
     void remove(RigidBody *body, const std::shared_ptr<IForceGenerator> &fg);
 
+    /**
+     * Remove every association of a rigid body.
+     *
+     * @param   body   RigidBody *, rigid body.
+     */
+    void remove(RigidBody *body);
+
     /**
      * Removes all rigid body and force generator registrations from the force
      * registry.
@@ -232,7 +239,7 @@ public:
     /**
      * Allows each registered force generator to apply forces to its paired
      * rigid body. Also removes force generators that are no longer applying
-     * forces.
+     * forces. Rigid bodies that are asleep are skipped.
      *
      * @param   duration   scalar, time since last frame.
      */
@@ -256,4 +263,80 @@ protected:
 
 private:
 };
+
+/**
+ * Kinds of force field.
+ */
+enum class ForceFieldType
+{
+    /** Constant acceleration, such as gravity. */
+    Uniform,
+    /** Constant force whatever the mass of the body, such as wind. */
+    Directional,
+    /** Acceleration towards a point, fading out to nothing at a radius. */
+    Radial
+};
+
+/**
+ * Force applied to every awake body in a physics world.
+ *
+ * Unlike force generators, which are registered once per body, force fields
+ * are applied by the world to all of its bodies in a single pass. Bodies
+ * with infinite mass are never affected.
+ */
+struct ForceField
+{
+    /**
+     * Create a field giving every body the same acceleration.
+     *
+     * @param   acceleration   const ds_math::Vector3 &, acceleration.
+     * @return                 ForceField, field.
+     */
+    static ForceField uniform(const ds_math::Vector3 &acceleration);
+
+    /**
+     * Create a field applying the same force to every body.
+     *
+     * @param   force   const ds_math::Vector3 &, force.
+     * @return          ForceField, field.
+     */
+    static ForceField directional(const ds_math::Vector3 &force);
+
+    /**
+     * Create a field accelerating bodies towards a point. The acceleration
+     * falls off linearly with distance, to nothing at the radius.
+     *
+     * @param   centre     const ds_math::Vector3 &, point bodies are pulled
+     * towards.
+     * @param   strength   ds_math::scalar, acceleration at the centre,
+     * negative to push bodies away.
+     * @param   radius     ds_math::scalar, distance beyond which bodies are
+     * not affected.
+     * @return             ForceField, field.
+     */
+    static ForceField radial(const ds_math::Vector3 &centre,
+                             ds_math::scalar strength,
+                             ds_math::scalar radius);
+
+    /** Kind of field. */
+    ForceFieldType type;
+
+    /**
+     * Acceleration of a uniform field or force of a directional field, in
+     * world-space.
+     */
+    ds_math::Vector3 vector;
+
+    /** Centre of a radial field, in world-space. */
+    ds_math::Vector3 centre;
+
+    /** Acceleration at the centre of a radial field. */
+    ds_math::scalar strength;
+
+    /** Radius of a radial field. */
+    ds_math::scalar radius;
+};
+
+/** Identifies a force field added to a physics world. */
+typedef int ForceFieldID;
 }
@@ -0,0 +1,251 @@
+#pragma once
+
+#include <cassert>
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ds_phys
+{
+/**
+ * Pool of objects of one type, allocated from slabs of slots.
+ *
+ * Free slots are kept in a list, so creating and destroying objects only
+ * touches the global allocator when every slab is full. Slabs are never
+ * moved or freed before the pool is, so the address of an object stays the
+ * same for as long as it lives. Objects still alive when the pool is
+ * destroyed are destroyed with it.
+ */
+template <typename T>
+class ObjectPool
+{
+public:
+    /**
+     * ObjectPool constructor.
+     *
+     * @param   slabSize   unsigned int, number of objects each slab has room
+     * for.
+     */
+    explicit ObjectPool(unsigned int slabSize = 64);
+
+    /**
+     * ObjectPool destructor, destroys the objects still alive.
+     */
+    ~ObjectPool();
+
+    /**
+     * Create an object in a free slot, adding a slab if there are none.
+     *
+     * @param   args   Args &&..., arguments passed to the constructor.
+     * @return         T *, object created.
+     */
+    template <typename... Args>
+    T *create(Args &&... args);
+
+    /**
+     * Destroy an object created by this pool, freeing its slot.
+     *
+     * @param   object   T *, object to destroy, may be nullptr.
+     */
+    void destroy(T *object);
+
+    /**
+     * Get whether an object was created by this pool and is still alive.
+     *
+     * @param   object   const T *, object.
+     * @return           bool, true if the object is alive in this pool.
+     */
+    bool owns(const T *object) const;
+
+    /**
+     * Make room for at least the given number of objects without adding
+     * slabs later.
+     *
+     * @param   count   unsigned int, number of objects.
+     */
+    void reserve(unsigned int count);
+
+    /**
+     * Get the number of objects alive.
+     *
+     * @return   unsigned int, number of objects.
+     */
+    unsigned int size() const;
+
+    /**
+     * Get the number of objects there is room for without adding slabs.
+     *
+     * @return   unsigned int, number of slots.
+     */
+    unsigned int capacity() const;
+
+private:
+    ObjectPool(const ObjectPool &) = delete;
+    ObjectPool &operator=(const ObjectPool &) = delete;
+
+    /** Storage for one object, the object comes first. */
+    struct Slot
+    {
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+        /** Next free slot, if this one is free. */
+        Slot *next;
+        /** Whether the slot holds an object. */
+        bool alive;
+    };
+
+    /**
+     * Add a slab, putting its slots on the free list.
+     */
+    void addSlab();
+
+    /**
+     * Find the slot an object lies in.
+     *
+     * @param   object   const T *, object.
+     * @return           const Slot *, slot, nullptr if the object isn't in
+     * any of the slabs.
+     */
+    const Slot *findSlot(const T *object) const;
+
+    /** Slabs of slots, never moved. */
+    std::vector<std::unique_ptr<Slot[]>> m_slabs;
+
+    /** First free slot, nullptr if every slot is used. */
+    Slot *m_free;
+
+    /** Number of slots in each slab. */
+    unsigned int m_slabSize;
+
+    /** Number of objects alive. */
+    unsigned int m_size;
+};
+
+template <typename T>
+ObjectPool<T>::ObjectPool(unsigned int slabSize)
+    : m_free(nullptr), m_slabSize(slabSize > 0 ? slabSize : 1), m_size(0)
+{
+}
+
+template <typename T>
+ObjectPool<T>::~ObjectPool()
+{
+    for (unsigned int i = 0; i < m_slabs.size(); ++i)
+    {
+        for (unsigned int j = 0; j < m_slabSize; ++j)
+        {
+            Slot &slot = m_slabs[i][j];
+            if (slot.alive)
+            {
+                reinterpret_cast<T *>(&slot.storage)->~T();
+            }
+        }
+    }
+}
+
+template <typename T>
+template <typename... Args>
+T *ObjectPool<T>::create(Args &&... args)
+{
+    if (m_free == nullptr)
+    {
+        addSlab();
+    }
+
+    Slot *slot = m_free;
+    T *object = new (&slot->storage) T(std::forward<Args>(args)...);
+
+    m_free = slot->next;
+    slot->next = nullptr;
+    slot->alive = true;
+    ++m_size;
+
+    return object;
+}
+
+template <typename T>
+void ObjectPool<T>::destroy(T *object)
+{
+    if (object == nullptr)
+    {
+        return;
+    }
+
+    // The object is the first member of its slot
+    Slot *slot = reinterpret_cast<Slot *>(object);
+    assert(findSlot(object) == slot && slot->alive &&
+           "Tried to destroy an object not alive in this pool.");
+
+    object->~T();
+
+    slot->alive = false;
+    slot->next = m_free;
+    m_free = slot;
+    --m_size;
+}
+
+template <typename T>
+bool ObjectPool<T>::owns(const T *object) const
+{
+    const Slot *slot = findSlot(object);
+    return slot != nullptr && slot->alive;
+}
+
+template <typename T>
+void ObjectPool<T>::reserve(unsigned int count)
+{
+    while (capacity() < count)
+    {
+        addSlab();
+    }
+}
+
+template <typename T>
+unsigned int ObjectPool<T>::size() const
+{
+    return m_size;
+}
+
+template <typename T>
+unsigned int ObjectPool<T>::capacity() const
+{
+    return (unsigned int)m_slabs.size() * m_slabSize;
+}
+
+template <typename T>
+void ObjectPool<T>::addSlab()
+{
+    std::unique_ptr<Slot[]> slab(new Slot[m_slabSize]);
+
+    // Free slots are handed out in address order
+    for (unsigned int i = m_slabSize; i-- > 0;)
+    {
+        slab[i].alive = false;
+        slab[i].next = m_free;
+        m_free = &slab[i];
+    }
+
+    m_slabs.push_back(std::move(slab));
+}
+
+template <typename T>
+const typename ObjectPool<T>::Slot *
+ObjectPool<T>::findSlot(const T *object) const
+{
+    const char *address = reinterpret_cast<const char *>(object);
+    std::less<const char *> less;
+    for (unsigned int i = 0; i < m_slabs.size(); ++i)
+    {
+        const Slot *first = m_slabs[i].get();
+        const char *begin = reinterpret_cast<const char *>(first);
+        if (!less(address, begin) &&
+            less(address, begin + m_slabSize * sizeof(Slot)))
+        {
+            return first + (address - begin) / sizeof(Slot);
+        }
+    }
+    return nullptr;
+}
+}
@@ -1,8 +1,10 @@
 #include <algorithm>
+#include <chrono>
 #include <sstream>
 
 #include "engine/json/Json.h"
 #include "engine/message/MessageHelper.h"
+#include "engine/resource/TerrainResource.h"
 #include "engine/system/physics/Physics.h"
 
 namespace ds_lua
@@ -60,9 +62,10 @@ namespace ds
 {
 // TODO: Update these values for m_physicsWorld constructor
 Physics::Physics()
-    : m_physicsWorld(0, 0),
-      m_gravityFg(new ds_phys::Gravity(ds_math::Vector3(0.0f, -9.8f, 0.0f)))
+    : m_physicsWorld(0, 0)
 {
+    m_gravityField = m_physicsWorld.addForceField(
+        ds_phys::ForceField::uniform(ds_math::Vector3(0.0f, -9.8f, 0.0f)));
     // addPlane(ds_math::Vector3(0, 1, 0), 0);
 }
 
@@ -78,7 +81,29 @@ bool Physics::Initialize(const char *configFile)
 
 void Physics::SetGravity(const ds_math::Vector3 &gravity)
 {
-    m_gravityFg->setGravity(gravity);
+    m_physicsWorld.setForceField(m_gravityField,
+                                 ds_phys::ForceField::uniform(gravity));
+}
+
+ds_phys::ForceFieldID Physics::AddForceField(const ds_phys::ForceField &field)
+{
+    return m_physicsWorld.addForceField(field);
+}
+
+void Physics::SetForceField(ds_phys::ForceFieldID id,
+                            const ds_phys::ForceField &field)
+{
+    m_physicsWorld.setForceField(id, field);
+}
+
+void Physics::RemoveForceField(ds_phys::ForceFieldID id)
+{
+    m_physicsWorld.removeForceField(id);
+}
+
+void Physics::SetCollisionEventLayers(uint32_t layers)
+{
+    m_physicsWorld.setCollisionEventLayers(layers);
 }
 
 void Physics::AddForceGenerator(Entity entity,
@@ -100,21 +125,44 @@ void Physics::AddForceGenerator(Entity entity,
 ds_phys::CollisionPrimitiveID Physics::addPlane(const ds_math::Vector3 &norm,
                                                 ds_math::scalar offset)
 {
-    ds_phys::CollisionPlane *plane = new ds_phys::CollisionPlane();
+    ds_phys::CollisionPrimitiveID id;
+    ds_phys::CollisionPlane *plane = m_physicsWorld.createPlane(&id);
     plane->direction = ds_math::Vector3::Normalize(norm);
     plane->offset = offset;
-    return m_physicsWorld.addCollisionPrimitive(
-        std::unique_ptr<ds_phys::CollisionPrimitive>(plane));
+    return id;
 }
 
 unsigned Physics::getUpdateRate(uint32_t screenRefreshRate) const
 {
-    return screenRefreshRate * 2;
+    // Steps are fixed by the step scheduler, which also decides how many a
+    // frame can afford. Fast bodies are swept rather than relying on small
+    // steps, see ds_phys::RigidBody::setContinuousCollision
+    return 0;
 }
 
 unsigned Physics::getMaxConsecutiveUpdates() const
 {
-    return 1;
+    return m_stepScheduler.getMaxSteps();
+}
+
+void Physics::SetStepSize(float stepSize)
+{
+    m_stepScheduler.setStepSize(stepSize);
+}
+
+void Physics::SetStepBudget(double budget)
+{
+    m_stepScheduler.setBudget(budget);
+}
+
+void Physics::SetMaxSteps(unsigned int maxSteps)
+{
+    m_stepScheduler.setMaxSteps(maxSteps);
+}
+
+const ds_phys::StepSchedulerStats &Physics::GetStepStats() const
+{
+    return m_stepScheduler.getStats();
 }
 
 ds_phys::RigidBody *Physics::getRigidBody(Entity entity)
@@ -131,6 +179,60 @@ ds_phys::RigidBody *Physics::getRigidBody(Entity entity)
     return body;
 }
 
+bool Physics::getRigidBodyEntity(const ds_phys::RigidBody *body,
+                                 Entity *entity) const
+{
+    auto it = m_bodyEntities.find(body);
+    if (it != m_bodyEntities.end())
+    {
+        *entity = it->second;
+        return true;
+    }
+    return false;
+}
+
+bool Physics::raycast(const ds_math::Vector3 &origin,
+                      const ds_math::Vector3 &direction,
+                      ds_math::scalar maxDistance,
+                      ds_phys::QueryHit *hit) const
+{
+    return m_physicsWorld.raycast(origin, direction, maxDistance, hit);
+}
+
+bool Physics::sweepSphere(const ds_math::Vector3 &origin,
+                          ds_math::scalar radius,
+                          const ds_math::Vector3 &direction,
+                          ds_math::scalar maxDistance,
+                          ds_phys::QueryHit *hit) const
+{
+    return m_physicsWorld.sweepSphere(origin, radius, direction, maxDistance,
+                                      hit);
+}
+
+unsigned int Physics::raycastBatch(const ds_phys::RaycastQuery *queries,
+                                   unsigned int queryCount,
+                                   ds_phys::QueryHit *hits)
+{
+    return m_physicsWorld.raycastBatch(queries, queryCount, hits);
+}
+
+unsigned int Physics::overlapSphere(
+    const ds_math::Vector3 &centre,
+    ds_math::scalar radius,
+    std::vector<ds_phys::CollisionPrimitive *> *results) const
+{
+    return m_physicsWorld.overlapSphere(centre, radius, results);
+}
+
+unsigned int
+Physics::overlapBox(const ds_math::Vector3 &centre,
+                    const ds_math::Vector3 &halfSize,
+                    const ds_math::Quaternion &orientation,
+                    std::vector<ds_phys::CollisionPrimitive *> *results) const
+{
+    return m_physicsWorld.overlapBox(centre, halfSize, orientation, results);
+}
+
 void Physics::Update(float deltaTime)
 {
 
@@ -138,15 +240,27 @@ void Physics::Update(float deltaTime)
 
     ProcessEvents(&m_messagesReceived);
 
-    if (deltaTime > 0.0f)
+    m_stepScheduler.beginFrame(deltaTime);
+    while (m_stepScheduler.nextStep())
     {
+        auto start = std::chrono::steady_clock::now();
+
         m_physicsWorld.startFrame();
+        m_physicsWorld.stepSimulation(m_stepScheduler.getStepSize());
 
-        m_physicsWorld.stepSimulation(deltaTime);
+        m_stepScheduler.recordStep(
+            std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start)
+                .count());
+    }
 
+    if (m_stepScheduler.getStats().steps > 0)
+    {
         // std::cout << m_physicsWorld.m_rigidBodies[0]->getPosition() <<
         // std::endl;
         PropagateTransform();
+
+        PostCollisionEvents();
     }
 
     m_messagesReceived.Clear();
@@ -240,6 +354,79 @@ void Physics::PropagateTransform()
     }
 }
 
+void Physics::PostCollisionEvents()
+{
+    m_collisionEvents.clear();
+    m_physicsWorld.collectCollisionEvents(&m_collisionEvents);
+
+    for (const ds_phys::CollisionEvent &event : m_collisionEvents)
+    {
+        Entity entities[2] = {};
+        bool hasEntity[2];
+        for (unsigned int i = 0; i < 2; ++i)
+        {
+            // The body of a removed primitive may have been destroyed, and
+            // its address given to a new body since
+            if (event.primitive[i] == nullptr)
+            {
+                auto it = m_removedBodyEntities.find(event.body[i]);
+                hasEntity[i] = it != m_removedBodyEntities.end();
+                if (hasEntity[i])
+                {
+                    entities[i] = it->second;
+                }
+            }
+            else
+            {
+                hasEntity[i] =
+                    getRigidBodyEntity(event.body[i], &entities[i]);
+            }
+        }
+
+        if (!hasEntity[0] && !hasEntity[1])
+        {
+            continue;
+        }
+
+        // Object one always has an entity, the event's normal points from
+        // its second primitive to its first
+        unsigned int a = hasEntity[0] ? 0 : 1;
+
+        ds_msg::PhysicsCollision collisionMsg;
+        switch (event.type)
+        {
+        case ds_phys::CollisionEventType::Begin:
+            collisionMsg.phase = ds_msg::PhysicsCollisionPhase::Begin;
+            break;
+        case ds_phys::CollisionEventType::Stay:
+            collisionMsg.phase = ds_msg::PhysicsCollisionPhase::Stay;
+            break;
+        case ds_phys::CollisionEventType::End:
+            collisionMsg.phase = ds_msg::PhysicsCollisionPhase::End;
+            break;
+        }
+        collisionMsg.entityA = entities[a];
+        if (hasEntity[1 - a])
+        {
+            collisionMsg.entityB = entities[1 - a];
+        }
+        else
+        {
+            collisionMsg.entityB.id = ds_msg::PHYSICS_COLLISION_NO_ENTITY;
+        }
+        collisionMsg.normalWorldOnB = a == 0 ? event.normal : -event.normal;
+        collisionMsg.pointWorldOnB = event.point;
+        collisionMsg.pointWorldOnA =
+            event.point - collisionMsg.normalWorldOnB * event.penetration;
+
+        ds_msg::AppendMessage(&m_messagesGenerated,
+                              ds_msg::MessageType::PhysicsCollision,
+                              sizeof(ds_msg::PhysicsCollision), &collisionMsg);
+    }
+
+    m_removedBodyEntities.clear();
+}
+
 void Physics::Shutdown()
 {
     // TODO: loop thru each physics component and free rigid bodies
@@ -329,6 +516,21 @@ void Physics::ProcessEvents(ds_msg::MessageStream *messages)
             // If valid, remove it from component manager
             if (physics.IsValid())
             {
+                ds_phys::RigidBody *body =
+                    m_physicsComponentManager->GetRigidBody(physics);
+                if (body != nullptr)
+                {
+                    // Kept until the end events of its pairs are sent
+                    auto it = m_bodyEntities.find(body);
+                    if (it != m_bodyEntities.end())
+                    {
+                        m_removedBodyEntities[body] = it->second;
+                        m_bodyEntities.erase(it);
+                    }
+
+                    // Returns the body and its primitives to the pools
+                    m_physicsWorld.destroyRigidBody(body);
+                }
                 m_physicsComponentManager->RemoveInstance(physics);
             }
 
@@ -441,6 +643,9 @@ void Physics::CreatePhysicsComponent(Entity entity, const char *componentData)
         float dataRestitution = 0.6f;
         float dataDamping = 0.3f;
         float dataAngularDamping = 0.21f;
+        bool dataContinuousCollision = false;
+        uint32_t dataLayer = 1;
+        uint32_t dataMask = 0xffffffff;
 
         if (root["restitution"] != nullptr)
         {
@@ -454,10 +659,25 @@ void Physics::CreatePhysicsComponent(Entity entity, const char *componentData)
         {
             dataAngularDamping = json::parseFloat(root["angularDamping"]);
         }
+        if (root["continuousCollision"] != nullptr)
+        {
+            dataContinuousCollision =
+                json::parseBool(root["continuousCollision"]);
+        }
+        // Collision layers and masks are bit sets, each shape may override
+        // the component's
+        if (root["layer"] != nullptr)
+        {
+            dataLayer = (uint32_t)json::parseNumber(root["layer"]);
+        }
+        if (root["mask"] != nullptr)
+        {
+            dataMask = (uint32_t)json::parseNumber(root["mask"]);
+        }
 
 
         // Create rigid body component
-        ds_phys::RigidBody *body = new ds_phys::RigidBody();
+        ds_phys::RigidBody *body = m_physicsWorld.createRigidBody();
 
         std::vector<float> invMasses;
         std::vector<ds_math::Vector3> offsets;
@@ -563,6 +783,18 @@ void Physics::CreatePhysicsComponent(Entity entity, const char *componentData)
                     inverseInertiaTensors.push_back(tmpInverseInertiaTensor);
                 }
 
+                uint32_t layer = dataLayer;
+                uint32_t mask = dataMask;
+                if (collisionShape["layer"] != nullptr)
+                {
+                    layer =
+                        (uint32_t)json::parseNumber(collisionShape["layer"]);
+                }
+                if (collisionShape["mask"] != nullptr)
+                {
+                    mask = (uint32_t)json::parseNumber(collisionShape["mask"]);
+                }
+
                 std::string type;
                 if (collisionShape["type"] != nullptr)
                 {
@@ -602,16 +834,15 @@ void Physics::CreatePhysicsComponent(Entity entity, const char *componentData)
 
 
                     // Create box
-                    auto *box = new ds_phys::CollisionBox();
+                    auto *box = m_physicsWorld.createBox();
                     box->halfSize = dimensions;
                     box->body = body;
+                    box->layer = layer;
+                    box->mask = mask;
                     box->offset =
                         ds_math::Matrix4::CreateTranslationMatrix(offsets[i]);
 
                     body->addCollisionPrimitive(box);
-
-                    m_physicsWorld.addCollisionPrimitive(
-                        std::unique_ptr<ds_phys::CollisionPrimitive>(box));
                 }
                 else if (type == "sphere")
                 {
@@ -628,16 +859,15 @@ void Physics::CreatePhysicsComponent(Entity entity, const char *componentData)
                         continue;
                     }
 
-                    auto *sphere = new ds_phys::CollisionSphere();
+                    auto *sphere = m_physicsWorld.createSphere();
                     sphere->radius = radius;
                     sphere->body = body;
+                    sphere->layer = layer;
+                    sphere->mask = mask;
                     sphere->offset =
                         ds_math::Matrix4::CreateTranslationMatrix(offsets[i]);
 
                     body->addCollisionPrimitive(sphere);
-
-                    m_physicsWorld.addCollisionPrimitive(
-                        std::unique_ptr<ds_phys::CollisionPrimitive>(sphere));
                 }
                 else if (type == "capsule")
                 {
@@ -666,17 +896,78 @@ void Physics::CreatePhysicsComponent(Entity entity, const char *componentData)
 
                     std::cout << "radius: " << radius << " height: " << height
                               << std::endl;
-                    auto *capsule = new ds_phys::CollisionCapsule();
+                    auto *capsule = m_physicsWorld.createCapsule();
                     capsule->body = body;
+                    capsule->layer = layer;
+                    capsule->mask = mask;
                     capsule->radius = radius;
                     capsule->height = height;
                     capsule->offset =
                         ds_math::Matrix4::CreateTranslationMatrix(offsets[i]);
 
                     body->addCollisionPrimitive(capsule);
+                }
+                else if (type == "heightfield")
+                {
+                    std::string heightmap;
+                    if (collisionShape["heightmap"] != nullptr)
+                    {
+                        json::parseString(collisionShape["heightmap"],
+                                          &heightmap);
+                    }
+                    else
+                    {
+                        std::cerr << "Collision shape " << i << " (" << name
+                                  << ") needs heightmap field." << std::endl;
+                        continue;
+                    }
+
+                    // Load the heights the same way the terrain is rendered
+                    ResourceFactory factory;
+                    factory.RegisterCreator<TerrainResource>(
+                        TerrainResource::CreateFromFile);
+                    std::unique_ptr<TerrainResource> terrain =
+                        factory.CreateResource<TerrainResource>(heightmap);
+                    if (terrain == nullptr)
+                    {
+                        std::cerr << "Collision shape " << i << " (" << name
+                                  << ") failed to load heightmap " << heightmap
+                                  << "." << std::endl;
+                        continue;
+                    }
 
-                    m_physicsWorld.addCollisionPrimitive(
-                        std::unique_ptr<ds_phys::CollisionPrimitive>(capsule));
+                    if (collisionShape["heightScale"] != nullptr)
+                    {
+                        terrain->SetHeightScale(
+                            json::parseFloat(collisionShape["heightScale"]));
+                    }
+
+                    auto *heightfield = m_physicsWorld.createHeightfield();
+                    if (collisionShape["scale"] != nullptr)
+                    {
+                        JsonArray scale;
+                        json::parseArray(collisionShape["scale"], &scale);
+
+                        assert(scale.size() == 3);
+                        // Take first 3 values of array
+                        for (unsigned int j = 0; j < 3; ++j)
+                        {
+                            heightfield->scale[j] = json::parseFloat(scale[j]);
+                        }
+                    }
+                    heightfield->setHeights(terrain->GetHeightArray(),
+                                            terrain->GetHeightmapWidth(),
+                                            terrain->GetHeightmapHeight());
+                    heightfield->body = body;
+                    heightfield->layer = layer;
+                    heightfield->mask = mask;
+                    heightfield->offset =
+                        ds_math::Matrix4::CreateTranslationMatrix(offsets[i]);
+
+                    // Heightfields never move
+                    invMasses[i] = 0.0f;
+
+                    body->addCollisionPrimitive(heightfield);
                 }
                 else
                 {
@@ -784,9 +1075,14 @@ void Physics::CreatePhysicsComponent(Entity entity, const char *componentData)
             // body->setRestitution(dataRestitution);
             body->setLinearDamping(dataDamping);
             body->setAngularDamping(dataAngularDamping);
+            body->setContinuousCollision(dataContinuousCollision);
 
-            m_physicsWorld.addForceGenerator(body, m_gravityFg);
-            m_physicsWorld.addRigidBody(body);
+            body->calculateDerivedData();
+            m_bodyEntities[body] = entity;
+        }
+        else
+        {
+            m_physicsWorld.destroyRigidBody(body);
         }
     }
 }
@@ -1,8 +1,12 @@
 #pragma once
 
+#include <unordered_map>
+#include <vector>
+
 #include "engine/system/ISystem.h"
 #include "engine/system/physics/PhysicsComponentManager.h"
 #include "engine/system/physics/PhysicsWorld.h"
+#include "engine/system/physics/StepScheduler.h"
 #include "engine/system/scene/TransformComponentManager.h"
 
 namespace ds
@@ -95,7 +99,8 @@ public:
                                            ds_math::scalar offset);
 
     /**
-     * Get the update rate of the physics system.
+     * Get the update rate of the physics system, 0 as it's given the whole
+     * frame time and splits it into steps itself, see SetStepBudget.
      *
      * @param    screenRefreshRate   uit32_t, screen refresh rate.
      * @return                       unsigned, update rate of the physics
@@ -111,6 +116,37 @@ public:
      */
     virtual unsigned getMaxConsecutiveUpdates() const;
 
+    /**
+     * Set the simulation time of each physics step.
+     *
+     * @param   stepSize   float, step size, in seconds, greater than 0.
+     */
+    void SetStepSize(float stepSize);
+
+    /**
+     * Set the CPU time allowed for physics steps each frame. Once a frame
+     * would go over it, the rest of the frame's time is dropped, so the
+     * simulation slows down instead of falling further behind.
+     *
+     * @param   budget   double, budget, in milliseconds, 0 for no limit.
+     */
+    void SetStepBudget(double budget);
+
+    /**
+     * Set the most physics steps taken in one frame.
+     *
+     * @param   maxSteps   unsigned int, number of steps, 0 for no limit.
+     */
+    void SetMaxSteps(unsigned int maxSteps);
+
+    /**
+     * Get the steps taken over the last frame, the time they cost and the
+     * simulation time dropped to stay in budget.
+     *
+     * @return   const ds_phys::StepSchedulerStats &, stats.
+     */
+    const ds_phys::StepSchedulerStats &GetStepStats() const;
+
     /**
      * Get a pointer to the rigid body associated with given entity.
      *
@@ -128,6 +164,130 @@ public:
      */
     void SetGravity(const ds_math::Vector3 &gravity);
 
+    /**
+     * Add a force field applied to every rigid body, such as wind or an
+     * attractor, see ds_phys::PhysicsWorld::addForceField.
+     *
+     * @param   field   const ds_phys::ForceField &, field to add.
+     * @return          ds_phys::ForceFieldID, id of the field added.
+     */
+    ds_phys::ForceFieldID AddForceField(const ds_phys::ForceField &field);
+
+    /**
+     * Replace a force field.
+     *
+     * @param   id      ds_phys::ForceFieldID, id of the field.
+     * @param   field   const ds_phys::ForceField &, field to replace it with.
+     */
+    void SetForceField(ds_phys::ForceFieldID id,
+                       const ds_phys::ForceField &field);
+
+    /**
+     * Remove a force field.
+     *
+     * @param   id   ds_phys::ForceFieldID, id of the field.
+     */
+    void RemoveForceField(ds_phys::ForceFieldID id);
+
+    /**
+     * Set the collision layers PhysicsCollision messages are sent for, see
+     * ds_phys::PhysicsWorld::setCollisionEventLayers.
+     *
+     * @param   layers   uint32_t, layer bits, 0 to send none.
+     */
+    void SetCollisionEventLayers(uint32_t layers);
+
+    /**
+     * Get the entity a rigid body belongs to.
+     *
+     * @param   body     const ds_phys::RigidBody *, rigid body.
+     * @param   entity   Entity *, set to the entity of the body, only
+     * written if the body belongs to one.
+     * @return           bool, true if the body belongs to an entity.
+     */
+    bool getRigidBodyEntity(const ds_phys::RigidBody *body,
+                            Entity *entity) const;
+
+    /**
+     * Find the first collision primitive along a ray, see
+     * ds_phys::PhysicsWorld::raycast.
+     *
+     * @param   origin        const ds_math::Vector3 &, start of the ray.
+     * @param   direction     const ds_math::Vector3 &, direction of the ray.
+     * @param   maxDistance   ds_math::scalar, length of the ray.
+     * @param   hit           ds_phys::QueryHit *, first hit.
+     * @return                bool, true if the ray hit a primitive.
+     */
+    bool raycast(const ds_math::Vector3 &origin,
+                 const ds_math::Vector3 &direction,
+                 ds_math::scalar maxDistance,
+                 ds_phys::QueryHit *hit) const;
+
+    /**
+     * Find the first collision primitive a swept sphere touches, see
+     * ds_phys::PhysicsWorld::sweepSphere.
+     *
+     * @param   origin        const ds_math::Vector3 &, starting centre of
+     * the sphere.
+     * @param   radius        ds_math::scalar, radius of the sphere.
+     * @param   direction     const ds_math::Vector3 &, direction of the
+     * sweep.
+     * @param   maxDistance   ds_math::scalar, length of the sweep.
+     * @param   hit           ds_phys::QueryHit *, first hit.
+     * @return                bool, true if the sphere hit a primitive.
+     */
+    bool sweepSphere(const ds_math::Vector3 &origin,
+                     ds_math::scalar radius,
+                     const ds_math::Vector3 &direction,
+                     ds_math::scalar maxDistance,
+                     ds_phys::QueryHit *hit) const;
+
+    /**
+     * Cast many rays or sphere sweeps at once, see
+     * ds_phys::PhysicsWorld::raycastBatch.
+     *
+     * @param   queries      const ds_phys::RaycastQuery *, queries to cast.
+     * @param   queryCount   unsigned int, number of queries.
+     * @param   hits         ds_phys::QueryHit *, first hit of each query.
+     * @return               unsigned int, number of queries that hit.
+     */
+    unsigned int raycastBatch(const ds_phys::RaycastQuery *queries,
+                              unsigned int queryCount,
+                              ds_phys::QueryHit *hits);
+
+    /**
+     * Find every collision primitive that overlaps a sphere, see
+     * ds_phys::PhysicsWorld::overlapSphere.
+     *
+     * @param   centre    const ds_math::Vector3 &, centre of the sphere.
+     * @param   radius    ds_math::scalar, radius of the sphere.
+     * @param   results   std::vector<ds_phys::CollisionPrimitive *> *,
+     * primitives found are appended.
+     * @return            unsigned int, number of primitives found.
+     */
+    unsigned int
+    overlapSphere(const ds_math::Vector3 &centre,
+                  ds_math::scalar radius,
+                  std::vector<ds_phys::CollisionPrimitive *> *results) const;
+
+    /**
+     * Find every collision primitive that overlaps a box, see
+     * ds_phys::PhysicsWorld::overlapBox.
+     *
+     * @param   centre        const ds_math::Vector3 &, centre of the box.
+     * @param   halfSize      const ds_math::Vector3 &, half size of the box.
+     * @param   orientation   const ds_math::Quaternion &, orientation of the
+     * box.
+     * @param   results       std::vector<ds_phys::CollisionPrimitive *> *,
+     * primitives found are appended.
+     * @return                unsigned int, number of primitives found.
+     */
+    unsigned int
+    overlapBox(const ds_math::Vector3 &centre,
+               const ds_math::Vector3 &halfSize,
+               const ds_math::Quaternion &orientation,
+               std::vector<ds_phys::CollisionPrimitive *> *results) const;
+
 private:
     /**
      * Process the engine events.
@@ -165,6 +325,12 @@ private:
      */
     void PropagateTransform();
 
+    /**
+     * Send a PhysicsCollision message for each collision event since the
+     * last frame, in one batch.
+     */
+    void PostCollisionEvents();
+
     /** Messaging */
     ds_msg::MessageStream m_messagesGenerated, m_messagesReceived;
 
@@ -175,7 +341,24 @@ private:
 
     ds_phys::PhysicsWorld m_physicsWorld;
 
-    std::shared_ptr<ds_phys::Gravity> m_gravityFg;
+    /** Splits frame time into steps within the CPU time budget. */
+    ds_phys::StepScheduler m_stepScheduler;
+
+    /** Entity of each rigid body, to report what queries hit. */
+    std::unordered_map<const ds_phys::RigidBody *, Entity> m_bodyEntities;
+
+    /**
+     * Entity of each rigid body destroyed since the collision events were
+     * last sent, to report the end of its pairs.
+     */
+    std::unordered_map<const ds_phys::RigidBody *, Entity>
+        m_removedBodyEntities;
+
+    /** Collision events gathered each frame, kept to reuse the storage. */
+    std::vector<ds_phys::CollisionEvent> m_collisionEvents;
+
+    /** Uniform force field applying gravity to every body. */
+    ds_phys::ForceFieldID m_gravityField;
     // ds_phys::ImpulseGenerator *m_impulseFg;
     ds_phys::RigidBody m_body;
 };
@@ -1,4 +1,5 @@
 #include <iostream>
+#include <vector>
 
 #include "math/Vector3.h"
 
@@ -197,13 +198,320 @@ ds_phys::CollisionPrimitiveID l_GetRigidBody(lua_State *L)
     return 1;
 }
 
+/**
+ * Get the physics system from the lua state, leaving the stack unchanged.
+ */
+static ds::Physics *GetPhysics(lua_State *L)
+{
+    // Push physics system pointer to stack
+    lua_getglobal(L, "__" META_NAME);
+
+    // If item on stack isn't user data (our physics system)
+    if (!lua_isuserdata(L, -1))
+    {
+        // Error
+        luaL_error(L, "Physics system isn't registered.");
+    }
+
+    ds::Physics *p = (ds::Physics *)lua_touserdata(L, -1);
+    assert(p != NULL);
+
+    // Pop physics system pointer off lua stack
+    lua_pop(L, 1);
+
+    return p;
+}
+
+/**
+ * Push a copy of a vector to the lua stack.
+ */
+static void PushVector3(lua_State *L, const ds_math::Vector3 &v)
+{
+    ds_math::Vector3 *copy =
+        (ds_math::Vector3 *)lua_newuserdata(L, sizeof(ds_math::Vector3));
+    *copy = v;
+
+    luaL_getmetatable(L, "Vector3");
+    lua_setmetatable(L, -2);
+}
+
+/**
+ * Push an entity to the lua stack.
+ */
+static void PushEntity(lua_State *L, ds::Entity entity)
+{
+    ds::Entity *copy = (ds::Entity *)lua_newuserdata(L, sizeof(ds::Entity));
+    *copy = entity;
+
+    luaL_getmetatable(L, "Entity");
+    lua_setmetatable(L, -2);
+}
+
+/**
+ * Push a query hit to the lua stack as a table of entity, point, normal and
+ * distance. The entity is nil for static collision primitives.
+ */
+static void PushQueryHit(lua_State *L,
+                         const ds::Physics *p,
+                         const ds_phys::QueryHit &hit)
+{
+    lua_newtable(L);
+
+    ds::Entity entity;
+    if (p->getRigidBodyEntity(hit.body, &entity))
+    {
+        PushEntity(L, entity);
+        lua_setfield(L, -2, "entity"); // table.entity = entity
+    }
+
+    PushVector3(L, hit.point);
+    lua_setfield(L, -2, "point"); // table.point = point
+
+    PushVector3(L, hit.normal);
+    lua_setfield(L, -2, "normal"); // table.normal = normal
+
+    lua_pushnumber(L, hit.distance);
+    lua_setfield(L, -2, "distance"); // table.distance = distance
+}
+
+/**
+ * Push the entities of a list of collision primitives to the lua stack as
+ * an array, skipping static primitives.
+ */
+static void
+PushPrimitiveEntities(lua_State *L,
+                      const ds::Physics *p,
+                      const std::vector<ds_phys::CollisionPrimitive *> &found)
+{
+    lua_newtable(L);
+
+    int index = 1;
+    for (const ds_phys::CollisionPrimitive *primitive : found)
+    {
+        ds::Entity entity;
+        if (p->getRigidBodyEntity(primitive->body, &entity))
+        {
+            PushEntity(L, entity);
+            lua_rawseti(L, -2, index++);
+        }
+    }
+}
+
+static int l_Raycast(lua_State *L)
+{
+    // Get number of arguments provided
+    int n = lua_gettop(L);
+    int expected = 3;
+    if (n != expected)
+    {
+        return luaL_error(L, "Got %d arguments, expected %d.", n, expected);
+    }
+
+    ds::Physics *p = GetPhysics(L);
+
+    ds_math::Vector3 *origin =
+        (ds_math::Vector3 *)luaL_checkudata(L, 1, "Vector3");
+    ds_math::Vector3 *direction =
+        (ds_math::Vector3 *)luaL_checkudata(L, 2, "Vector3");
+    ds_math::scalar maxDistance = (ds_math::scalar)luaL_checknumber(L, 3);
+
+    ds_phys::QueryHit hit;
+    if (p->raycast(*origin, *direction, maxDistance, &hit))
+    {
+        PushQueryHit(L, p, hit);
+    }
+    else
+    {
+        lua_pushnil(L);
+    }
+
+    assert(lua_gettop(L) == n + 1);
+
+    return 1;
+}
+
+static int l_SweepSphere(lua_State *L)
+{
+    // Get number of arguments provided
+    int n = lua_gettop(L);
+    int expected = 4;
+    if (n != expected)
+    {
+        return luaL_error(L, "Got %d arguments, expected %d.", n, expected);
+    }
+
+    ds::Physics *p = GetPhysics(L);
+
+    ds_math::Vector3 *origin =
+        (ds_math::Vector3 *)luaL_checkudata(L, 1, "Vector3");
+    ds_math::scalar radius = (ds_math::scalar)luaL_checknumber(L, 2);
+    ds_math::Vector3 *direction =
+        (ds_math::Vector3 *)luaL_checkudata(L, 3, "Vector3");
+    ds_math::scalar maxDistance = (ds_math::scalar)luaL_checknumber(L, 4);
+
+    ds_phys::QueryHit hit;
+    if (p->sweepSphere(*origin, radius, *direction, maxDistance, &hit))
+    {
+        PushQueryHit(L, p, hit);
+    }
+    else
+    {
+        lua_pushnil(L);
+    }
+
+    assert(lua_gettop(L) == n + 1);
+
+    return 1;
+}
+
+static int l_RaycastBatch(lua_State *L)
+{
+    // Get number of arguments provided
+    int n = lua_gettop(L);
+    int expected = 1;
+    if (n != expected)
+    {
+        return luaL_error(L, "Got %d arguments, expected %d.", n, expected);
+    }
+
+    ds::Physics *p = GetPhysics(L);
+
+    // Array of {origin, direction, max_distance, radius} tables, radius is
+    // optional
+    luaL_checktype(L, 1, LUA_TTABLE);
+    size_t count = lua_objlen(L, 1);
+
+    std::vector<ds_phys::RaycastQuery> queries(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        ds_phys::RaycastQuery &query = queries[i];
+
+        lua_rawgeti(L, 1, (int)i + 1);
+        luaL_checktype(L, -1, LUA_TTABLE);
+
+        lua_getfield(L, -1, "origin");
+        query.origin = *(ds_math::Vector3 *)luaL_checkudata(L, -1, "Vector3");
+        lua_getfield(L, -2, "direction");
+        query.direction =
+            *(ds_math::Vector3 *)luaL_checkudata(L, -1, "Vector3");
+        lua_getfield(L, -3, "max_distance");
+        query.maxDistance = (ds_math::scalar)luaL_checknumber(L, -1);
+        lua_getfield(L, -4, "radius");
+        query.radius = (ds_math::scalar)luaL_optnumber(L, -1, 0);
+
+        // Pop the fields and the query table
+        lua_pop(L, 5);
+    }
+
+    std::vector<ds_phys::QueryHit> hits(count);
+    p->raycastBatch(queries.data(), (unsigned int)count, hits.data());
+
+    // Misses are false so that the array has no holes
+    lua_createtable(L, (int)count, 0);
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (hits[i].primitive != nullptr)
+        {
+            PushQueryHit(L, p, hits[i]);
+        }
+        else
+        {
+            lua_pushboolean(L, 0);
+        }
+        lua_rawseti(L, -2, (int)i + 1);
+    }
+
+    assert(lua_gettop(L) == n + 1);
+
+    return 1;
+}
+
+static int l_OverlapSphere(lua_State *L)
+{
+    // Get number of arguments provided
+    int n = lua_gettop(L);
+    int expected = 2;
+    if (n != expected)
+    {
+        return luaL_error(L, "Got %d arguments, expected %d.", n, expected);
+    }
+
+    ds::Physics *p = GetPhysics(L);
+
+    ds_math::Vector3 *centre =
+        (ds_math::Vector3 *)luaL_checkudata(L, 1, "Vector3");
+    ds_math::scalar radius = (ds_math::scalar)luaL_checknumber(L, 2);
+
+    std::vector<ds_phys::CollisionPrimitive *> found;
+    p->overlapSphere(*centre, radius, &found);
+    PushPrimitiveEntities(L, p, found);
+
+    assert(lua_gettop(L) == n + 1);
+
+    return 1;
+}
+
+static int l_OverlapBox(lua_State *L)
+{
+    // Get number of arguments provided
+    int n = lua_gettop(L);
+    int expected = 3;
+    if (n != expected)
+    {
+        return luaL_error(L, "Got %d arguments, expected %d.", n, expected);
+    }
+
+    ds::Physics *p = GetPhysics(L);
+
+    ds_math::Vector3 *centre =
+        (ds_math::Vector3 *)luaL_checkudata(L, 1, "Vector3");
+    ds_math::Vector3 *halfSize =
+        (ds_math::Vector3 *)luaL_checkudata(L, 2, "Vector3");
+    ds_math::Quaternion *orientation =
+        (ds_math::Quaternion *)luaL_checkudata(L, 3, "Quaternion");
+
+    std::vector<ds_phys::CollisionPrimitive *> found;
+    p->overlapBox(*centre, *halfSize, *orientation, &found);
+    PushPrimitiveEntities(L, p, found);
+
+    assert(lua_gettop(L) == n + 1);
+
+    return 1;
+}
+
+static int l_SetCollisionEventLayers(lua_State *L)
+{
+    // Get number of arguments provided
+    int n = lua_gettop(L);
+    int expected = 1;
+    if (n != expected)
+    {
+        return luaL_error(L, "Got %d arguments, expected %d.", n, expected);
+    }
+
+    ds::Physics *p = GetPhysics(L);
+
+    p->SetCollisionEventLayers((uint32_t)luaL_checknumber(L, 1));
+
+    assert(lua_gettop(L) == n);
+
+    return 0;
+}
+
 ds::ScriptBindingSet LoadPhysicsScriptBindings()
 {
     ds::ScriptBindingSet scriptBindings;
     scriptBindings.AddFunction("add_force_generator", l_AddForceGenerator);
     scriptBindings.AddFunction("add_plane", l_AddPlane);
     scriptBindings.AddFunction("get_rigid_body", l_GetRigidBody);
+    scriptBindings.AddFunction("overlap_box", l_OverlapBox);
+    scriptBindings.AddFunction("overlap_sphere", l_OverlapSphere);
+    scriptBindings.AddFunction("raycast", l_Raycast);
+    scriptBindings.AddFunction("raycast_batch", l_RaycastBatch);
+    scriptBindings.AddFunction("set_collision_event_layers",
+                               l_SetCollisionEventLayers);
     scriptBindings.AddFunction("set_gravity", l_SetGravity);
+    scriptBindings.AddFunction("sweep_sphere", l_SweepSphere);
 
     return scriptBindings;
 }
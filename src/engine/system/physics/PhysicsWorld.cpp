@@ -1,4 +1,7 @@
 #include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <thread>
 
 #include "engine/system/physics/PhysicsWorld.h"
 
@@ -7,19 +10,40 @@ namespace ds_phys
 
 
 PhysicsWorld::PhysicsWorld(unsigned int maxContacts, unsigned int iterations)
-    : m_currentCPID(0), m_contactResolver(1024)
+    : m_contactResolver(1024),
+      m_workerPool(std::max(std::thread::hardware_concurrency(), 1u)),
+      m_solverMode(SolverMode::MostSevereFirst), m_stepCount(0),
+      m_collisionEventLayers(0xffffffff),
+      m_primitiveSlots(1, {CollisionPrimitiveType::Count, -1, 0}),
+      m_contacts(maxContacts > 0 ? maxContacts : DEFAULT_CONTACT_CAPACITY),
+      m_contactBudget(0), m_contactBudgetPair(0), m_currentForceFieldID(0)
 {
-    m_rigidBodies.reserve(100);
+    m_contactStats = ContactStats();
+    m_solverStats = SolverStats();
+    m_contactStats.capacity = (unsigned int)m_contacts.size();
+
     // m_collisionConfiguration = new btDefaultCollisionConfiguration();
     // m_dispatcher = new btCollisionDispatcher(m_collisionConfiguration);
     // m_broadPhase = new btDbvtBroadphase();
     // m_collisionWorld = new btCollisionWorld(m_dispatcher, m_broadphase,
     //                                         m_collisionConfiguration);
-    m_collisionData.contactArray = m_contacts;
+    m_collisionData.contactArray = m_contacts.data();
 }
 
 PhysicsWorld::~PhysicsWorld()
 {
+    // Pooled primitives are destroyed with their pools
+    for (PrimitiveArray &array : m_primitiveArrays)
+    {
+        for (unsigned int i = 0; i < array.primitives.size(); ++i)
+        {
+            if (!array.pooled[i])
+            {
+                delete array.primitives[i];
+            }
+        }
+    }
+
     // // Delete collision world;
     // delete m_collisionWorld;
 
@@ -36,294 +60,1665 @@ PhysicsWorld::~PhysicsWorld()
 void PhysicsWorld::startFrame()
 {
     // Remove all forces from accumulators in each rigidbody
-    std::for_each(m_rigidBodies.begin(), m_rigidBodies.end(),
-                  [](RigidBody *rigidBody) {
-                      if (rigidBody != nullptr)
-                      {
-                          rigidBody->clearAccumulators();
-                          rigidBody->calculateDerivedData();
-                      }
-                  });
+    m_rigidBodies.clearAccumulators();
+    for (unsigned int i = 0; i < m_rigidBodies.size(); ++i)
+    {
+        m_rigidBodies.getBody(i)->calculateDerivedData();
+    }
 }
 
 void PhysicsWorld::stepSimulation(ds_math::scalar duration)
 {
     // duration = duration;
-    // Update force generators
+    // Update force generators, then apply the fields shared by every body
     m_forceRegistry.updateForces(duration);
+    m_rigidBodies.applyForceFields(m_forceFields.data(),
+                                   (unsigned int)m_forceFields.size());
 
-    // Integrate rigid bodies
-    std::for_each(m_rigidBodies.begin(), m_rigidBodies.end(),
-                  [&](RigidBody *rigidBody) {
-                      if (rigidBody != nullptr)
-                      {
-                          rigidBody->integrate(duration);
-                      }
-                  });
+    ++m_stepCount;
 
-    unsigned int got = generateContacts();
+    // Remember where fast bodies start so they can be swept once moved
+    m_continuousStarts.clear();
+    for (unsigned int i = 0; i < m_rigidBodies.size(); ++i)
+    {
+        RigidBody *rigidBody = m_rigidBodies.getBody(i);
+        if (rigidBody->getContinuousCollision() && rigidBody->getAwake())
+        {
+            ContinuousStart start = {rigidBody, rigidBody->getPosition()};
+            m_continuousStarts.push_back(start);
+        }
+    }
 
-    // Resolve contacts
-    m_contactResolver.resolveContacts(m_contacts, got, duration);
-}
+    // Integrate rigid bodies, islands are put to sleep as a whole below
+    m_rigidBodies.integrate(duration);
 
-void PhysicsWorld::addRigidBody(RigidBody *rigidBody)
-{
-    //@todo Remove when propper loading is done.
+    advanceContinuousBodies();
 
-    // rigidBody->setRotation(ds_math::Vector3(0, 0, 0));
-    // rigidBody->setLinearDamping(0.95f);
-    // rigidBody->setAngularDamping(0.80f);
-    rigidBody->clearAccumulators();
-    // rigidBody->setAcceleration(0.0f, -10.0f, 0.0f);
-    rigidBody->setCanSleep(true);
+    unsigned int got = generateContacts();
 
-    rigidBody->setAwake();
+    updateCollisionPairs(got);
 
-    rigidBody->calculateDerivedData();
+    if (m_solverMode == SolverMode::SequentialImpulse)
+    {
+        updateManifolds(got);
+        buildIslands(m_manifoldContacts.data(),
+                     (unsigned int)m_manifoldContacts.size());
+    }
+    else
+    {
+        buildIslands(m_contacts.data(), got);
+    }
 
-    m_rigidBodies.push_back(rigidBody);
-}
+    resolveIslands(duration);
 
-void PhysicsWorld::removeRigidBody(RigidBody *rigidBody)
-{
-    while (rigidBody->getCollisionPrimitiveCount() > 0)
+    if (m_solverMode == SolverMode::SequentialImpulse)
     {
-        removeCollisionPrimitive(rigidBody->getCollisionPrimitive(0));
-        rigidBody->removeCollisionPrimitive(0);
+        storeManifoldImpulses();
     }
 
-    std::vector<RigidBody *>::iterator it =
-        std::find(m_rigidBodies.begin(), m_rigidBodies.end(), rigidBody);
-
-    if (it != m_rigidBodies.end())
+    // Track how much each body is still moving once contacts have been
+    // resolved, resting islands are put to sleep next step
+    for (unsigned int i = 0; i < m_rigidBodies.size(); ++i)
     {
-        // TODO: Leaves gap in memory, look at not using RigidBody *, for cache
-        // coherency
-        m_rigidBodies.erase(it);
+        RigidBody *rigidBody = m_rigidBodies.getBody(i);
+        if (rigidBody->getAwake())
+        {
+            rigidBody->updateMotion(duration);
+        }
     }
 }
 
-void PhysicsWorld::addForceGenerator(
-    RigidBody *rigidBody, std::shared_ptr<IForceGenerator> forceGenerator)
+void PhysicsWorld::resolveIslands(ds_math::scalar duration)
 {
-    m_forceRegistry.add(rigidBody, forceGenerator);
-}
+    // Hand out the biggest islands first so that the workers finish at
+    // about the same time
+    m_solverIslands.clear();
+    unsigned int contactCount = 0;
+    for (unsigned int i = 0; i < m_islands.size(); ++i)
+    {
+        const Island &island = m_islands[i];
+        if (island.awake && !island.loose && island.contactCount > 0)
+        {
+            m_solverIslands.push_back(i);
+            contactCount += island.contactCount;
+        }
+    }
+    std::sort(m_solverIslands.begin(), m_solverIslands.end(),
+              [this](unsigned int a, unsigned int b) {
+                  return m_islands[a].contactCount >
+                             m_islands[b].contactCount ||
+                         (m_islands[a].contactCount ==
+                              m_islands[b].contactCount &&
+                          a < b);
+              });
 
-void PhysicsWorld::removeForceGenerator(
-    RigidBody *rigidBody, std::shared_ptr<IForceGenerator> forceGenerator)
-{
-    m_forceRegistry.remove(rigidBody, forceGenerator);
-}
+    // Each worker needs its own resolver as it tracks iteration counts
+    m_islandResolvers.assign(m_workerPool.getWorkerCount(),
+                             m_contactResolver);
+    m_workerSolverStats.assign(m_workerPool.getWorkerCount(), SolverStats());
 
-CollisionPrimitiveID PhysicsWorld::addCollisionPrimitive(
-    std::unique_ptr<CollisionPrimitive> &&primitive)
-{
-    m_collisionPrimitives[++m_currentCPID] = std::move(primitive);
-    return m_currentCPID;
-}
+    auto resolve = [&](const Island &island, ContactResolver &resolver,
+                       SolverStats &stats) {
+        Contact *contacts = &m_islandContacts[island.contactStart];
+        if (m_solverMode == SolverMode::SequentialImpulse)
+        {
+            m_impulseSolver.resolveContacts(contacts, island.contactCount,
+                                            duration);
+            stats.velocityIterations +=
+                m_impulseSolver.getVelocityIterations();
+            stats.positionIterations +=
+                m_impulseSolver.getPositionIterations();
+        }
+        else
+        {
+            resolver.resolveContacts(contacts, island.contactCount, duration);
+            stats.velocityIterations += resolver.velocityIterationCount;
+            stats.positionIterations += resolver.positionIterationCount;
+        }
+        ++stats.islandCount;
+        stats.contactCount += island.contactCount;
+    };
 
-CollisionPrimitive *PhysicsWorld::getCollisionPrimitive(CollisionPrimitiveID id)
-{
-    auto iter = m_collisionPrimitives.find(id);
-    if (iter != m_collisionPrimitives.end())
+    auto resolveIsland = [&](unsigned int task, unsigned int worker) {
+        resolve(m_islands[m_solverIslands[task]], m_islandResolvers[worker],
+                m_workerSolverStats[worker]);
+    };
+
+    if (contactCount >= MIN_PARALLEL_CONTACTS)
     {
-        return iter->second.get();
+        m_workerPool.run((unsigned int)m_solverIslands.size(), resolveIsland);
     }
-    return nullptr;
-}
-
-CollisionPrimitiveID
-PhysicsWorld::getCollisionPrimitiveID(CollisionPrimitive *primitive)
-{
-    for (auto iter = m_collisionPrimitives.begin();
-         iter != m_collisionPrimitives.end(); iter++)
+    else
     {
-        if (primitive == iter->second.get())
+        for (unsigned int i = 0; i < m_solverIslands.size(); ++i)
         {
-            return iter->first;
+            resolveIsland(i, 0);
         }
     }
-    return 0;
-}
 
-std::unique_ptr<CollisionPrimitive>
-PhysicsWorld::removeCollisionPrimitive(CollisionPrimitiveID id)
-{
-    auto iter = m_collisionPrimitives.find(id);
-    if (iter != m_collisionPrimitives.end())
+    // Contacts on bodies outside the world may share bodies with any
+    // island, resolve them last on this thread
+    if (!m_islands.empty() && m_islands.back().loose)
     {
-        auto tmp = std::move(iter->second);
-        m_collisionPrimitives.erase(iter);
-        return tmp;
+        resolve(m_islands.back(), m_contactResolver, m_workerSolverStats[0]);
+    }
+
+    m_solverStats = SolverStats();
+    for (const SolverStats &stats : m_workerSolverStats)
+    {
+        m_solverStats.islandCount += stats.islandCount;
+        m_solverStats.contactCount += stats.contactCount;
+        m_solverStats.velocityIterations += stats.velocityIterations;
+        m_solverStats.positionIterations += stats.positionIterations;
     }
-    return std::unique_ptr<CollisionPrimitive>();
 }
 
-std::unique_ptr<CollisionPrimitive>
-PhysicsWorld::removeCollisionPrimitive(CollisionPrimitive *primitive)
+PhysicsWorld::ContactPairKey
+PhysicsWorld::getContactPairKey(CollisionPrimitiveID a, CollisionPrimitiveID b)
 {
-    for (auto iter = m_collisionPrimitives.begin();
-         iter != m_collisionPrimitives.end(); iter++)
+    return ((ContactPairKey)(uint32_t)a << 32) | (uint32_t)b;
+}
+
+void PhysicsWorld::updateManifolds(unsigned int contactCount)
+{
+    m_manifoldContacts.clear();
+    m_manifoldPoints.clear();
+
+    // Contacts from the same pair are generated together
+    unsigned int start = 0;
+    while (start < contactCount)
     {
-        if (primitive == iter->second.get())
+        ContactPairKey key = m_contactPairs[start];
+        unsigned int end = start + 1;
+        while (end < contactCount && m_contactPairs[end] == key)
         {
-            auto tmp = std::move(iter->second);
-            m_collisionPrimitives.erase(iter);
-            return tmp;
+            ++end;
         }
-    }
-    return std::unique_ptr<CollisionPrimitive>();
-}
 
-static unsigned generateCollisions(CollisionPrimitive* b0, CollisionPrimitive* b1, CollisionData& data) {
-	if (!data.hasMoreContacts()) return 0;
-	if (!b0) return 0;
-	if (!b1) return 0;
-	if (b0->body) {
-		if (b1->body) {
-			if ((!b0->body->hasFiniteMass()) && (!b1->body->hasFiniteMass())) return 0;
-		} else {
-			if (!b0->body->hasFiniteMass()) return 0;
-		}
-	} else {
-		if (b1->body) {
-			if (!b1->body->hasFiniteMass()) return 0;
-		}
-	}
-	if ((b0->body == b1->body) && (b0->body != nullptr)) return 0;
+        ContactManifold &manifold = m_manifolds[key];
+        manifold.refresh();
+        manifold.lastStep = m_stepCount;
+        for (unsigned int i = start; i < end; ++i)
+        {
+            manifold.addContact(m_contacts[i]);
+        }
 
+        start = end;
+    }
 
-    if (CollisionBox *b0Ptr = dynamic_cast<CollisionBox *>(b0)) {
-    	if (CollisionBox *b1Ptr = dynamic_cast<CollisionBox *>(b1)) {
-            return CollisionDetector::boxAndBox(*b0Ptr, *b1Ptr, &data);
-        }
-        else if (CollisionSphere *b1Ptr = dynamic_cast<CollisionSphere *>(b1))
+    // Pairs that weren't generated this step may have only just separated,
+    // keep their points until the bodies have moved apart. Pairs that are
+    // asleep aren't tested, keep those untouched so that they warm start
+    // when they wake.
+    for (auto it = m_manifolds.begin(); it != m_manifolds.end();)
+    {
+        ContactManifold &manifold = it->second;
+
+        if (manifold.lastStep != m_stepCount)
         {
-            return CollisionDetector::boxAndSphere(*b0Ptr, *b1Ptr, &data);
+            for (unsigned int i = 0; i < 2; ++i)
+            {
+                const RigidBody *body = manifold.getBody(i);
+                if (body != nullptr && body->hasFiniteMass() &&
+                    body->getAwake())
+                {
+                    manifold.refresh();
+                    manifold.lastStep = m_stepCount;
+                    break;
+                }
+            }
         }
-        else if (CollisionPlane *b1Ptr = dynamic_cast<CollisionPlane *>(b1))
+
+        if (manifold.getPointCount() == 0)
         {
-            return CollisionDetector::boxAndHalfSpace(*b0Ptr, *b1Ptr, &data);
+            it = m_manifolds.erase(it);
+            continue;
         }
-        else if (CollisionCapsule *b1Ptr = dynamic_cast<CollisionCapsule *>(b1))
+
+        if (manifold.lastStep == m_stepCount)
         {
-            return CollisionDetector::capsuleAndBox(*b1Ptr, *b0Ptr, &data);
+            for (unsigned int i = 0; i < manifold.getPointCount(); ++i)
+            {
+                Contact contact;
+                manifold.getContact(i, &contact);
+                m_manifoldContacts.push_back(contact);
+                m_manifoldPoints.push_back(&manifold.getPoint(i));
+            }
         }
+
+        ++it;
+    }
+}
+
+void PhysicsWorld::updateCollisionPairs(unsigned int contactCount)
+{
+    if (m_collisionEventLayers == 0)
+    {
+        m_collisionPairs.clear();
+        return;
     }
-    else if (CollisionSphere *b0Ptr = dynamic_cast<CollisionSphere *>(b0))
+
+    // Keep the deepest contact of each pair, facing the first primitive
+    for (unsigned int i = 0; i < contactCount; ++i)
     {
-        if (CollisionBox *b1Ptr = dynamic_cast<CollisionBox *>(b1))
+        ContactPairKey key = m_contactPairs[i];
+        const Contact &contact = m_contacts[i];
+
+        CollisionPrimitive *first =
+            getCollisionPrimitive((CollisionPrimitiveID)(key >> 32));
+        CollisionPrimitive *second =
+            getCollisionPrimitive((CollisionPrimitiveID)(uint32_t)key);
+        if (((first->layer | second->layer) & m_collisionEventLayers) == 0)
         {
-            return CollisionDetector::boxAndSphere(*b1Ptr, *b0Ptr, &data);
+            continue;
         }
-        else if (CollisionSphere *b1Ptr = dynamic_cast<CollisionSphere *>(b1))
+
+        // Immovable bodies are left out of contacts, so find which
+        // primitive the first body is from the body that is there
+        bool flipped = contact.body[0] != nullptr
+                           ? contact.body[0] != first->body
+                           : contact.body[1] != second->body;
+
+        CollisionPair &pair = m_collisionPairs[key];
+        if (pair.lastStep == m_stepCount &&
+            contact.penetration <= pair.penetration)
         {
-            return CollisionDetector::sphereAndSphere(*b0Ptr, *b1Ptr, &data);
+            continue;
         }
-        else if (CollisionPlane *b1Ptr = dynamic_cast<CollisionPlane *>(b1))
+
+        pair.primitive[0] = first;
+        pair.primitive[1] = second;
+        pair.body[0] = first->body;
+        pair.body[1] = second->body;
+        pair.touching = true;
+        pair.lastStep = m_stepCount;
+        pair.point = contact.contactPoint;
+        pair.normal = flipped ? -contact.contactNormal : contact.contactNormal;
+        pair.penetration = contact.penetration;
+    }
+
+    // Pairs without contacts have separated, unless nothing was awake to
+    // test them
+    for (auto &entry : m_collisionPairs)
+    {
+        CollisionPair &pair = entry.second;
+        if (!pair.touching || pair.lastStep == m_stepCount)
         {
-            return CollisionDetector::sphereAndHalfSpace(*b0Ptr, *b1Ptr, &data);
+            continue;
         }
-        else if (CollisionCapsule *b1Ptr = dynamic_cast<CollisionCapsule *>(b1))
+
+        for (const CollisionPrimitive *primitive : pair.primitive)
         {
-            return CollisionDetector::capsuleAndSphere(*b1Ptr, *b0Ptr, &data);
+            if (primitive == nullptr ||
+                (primitive->body != nullptr &&
+                 primitive->body->hasFiniteMass() &&
+                 primitive->body->getAwake()))
+            {
+                pair.touching = false;
+                break;
+            }
         }
     }
-    else if (CollisionPlane *b0Ptr = dynamic_cast<CollisionPlane *>(b0))
+}
+
+void PhysicsWorld::setCollisionEventLayers(uint32_t layers)
+{
+    m_collisionEventLayers = layers;
+}
+
+uint32_t PhysicsWorld::getCollisionEventLayers() const
+{
+    return m_collisionEventLayers;
+}
+
+void PhysicsWorld::collectCollisionEvents(std::vector<CollisionEvent> *events)
+{
+    // Report the pairs in a fixed order, the map has none
+    std::vector<ContactPairKey> keys;
+    keys.reserve(m_collisionPairs.size());
+    for (const auto &entry : m_collisionPairs)
+    {
+        keys.push_back(entry.first);
+    }
+    std::sort(keys.begin(), keys.end());
+
+    for (ContactPairKey key : keys)
     {
-        if (CollisionBox *b1Ptr = dynamic_cast<CollisionBox *>(b1))
+        auto it = m_collisionPairs.find(key);
+        CollisionPair &pair = it->second;
+
+        // Nothing was reported for a pair removed before it was collected
+        if (!pair.wasTouching &&
+            (pair.primitive[0] == nullptr || pair.primitive[1] == nullptr))
         {
-            return CollisionDetector::boxAndHalfSpace(*b1Ptr, *b0Ptr, &data);
+            m_collisionPairs.erase(it);
+            continue;
         }
-        else if (CollisionSphere *b1Ptr = dynamic_cast<CollisionSphere *>(b1))
+
+        CollisionEvent event;
+        event.primitive[0] = pair.primitive[0];
+        event.primitive[1] = pair.primitive[1];
+        event.body[0] = pair.body[0];
+        event.body[1] = pair.body[1];
+        event.point = pair.point;
+        event.normal = pair.normal;
+        event.penetration = pair.penetration;
+
+        if (!pair.wasTouching)
         {
-            return CollisionDetector::sphereAndHalfSpace(*b1Ptr, *b0Ptr, &data);
+            event.type = CollisionEventType::Begin;
+            events->push_back(event);
         }
-        else if (/*CollisionPlane *b1Ptr = */ dynamic_cast<CollisionPlane *>(
-            b1))
+        else if (pair.touching)
         {
-            // Skip
+            event.type = CollisionEventType::Stay;
+            events->push_back(event);
         }
-        else if (CollisionCapsule *b1Ptr = dynamic_cast<CollisionCapsule *>(b1))
+
+        if (!pair.touching)
         {
-            return CollisionDetector::capsuleAndHalfSpace(*b1Ptr, *b0Ptr,
-                                                          &data);
+            event.type = CollisionEventType::End;
+            events->push_back(event);
+            m_collisionPairs.erase(it);
+            continue;
         }
+
+        pair.wasTouching = true;
     }
-    else if (CollisionCapsule *b0Ptr = dynamic_cast<CollisionCapsule *>(b0))
+}
+
+void PhysicsWorld::storeManifoldImpulses()
+{
+    for (unsigned int i = 0; i < m_islandContacts.size(); ++i)
     {
-        if (CollisionBox *b1Ptr = dynamic_cast<CollisionBox *>(b1))
-        {
-            return CollisionDetector::capsuleAndBox(*b0Ptr, *b1Ptr, &data);
-        }
-        else if (CollisionSphere *b1Ptr = dynamic_cast<CollisionSphere *>(b1))
+        m_manifoldPoints[m_islandContactSources[i]]->impulse =
+            m_islandContacts[i].impulse;
+    }
+}
+
+void PhysicsWorld::removeManifolds(const RigidBody *body,
+                                   CollisionPrimitiveID id)
+{
+    for (auto it = m_manifolds.begin(); it != m_manifolds.end();)
+    {
+        bool remove = (body != nullptr && (it->second.getBody(0) == body ||
+                                           it->second.getBody(1) == body)) ||
+                      (CollisionPrimitiveID)(it->first >> 32) == id ||
+                      (CollisionPrimitiveID)(uint32_t)it->first == id;
+
+        if (remove)
         {
-            return CollisionDetector::capsuleAndSphere(*b0Ptr, *b1Ptr, &data);
+            it = m_manifolds.erase(it);
         }
-        else if (CollisionPlane *b1Ptr = dynamic_cast<CollisionPlane *>(b1))
+        else
         {
-            return CollisionDetector::capsuleAndHalfSpace(*b0Ptr, *b1Ptr,
-                                                          &data);
+            ++it;
         }
-        else if (CollisionCapsule *b1Ptr = dynamic_cast<CollisionCapsule *>(b1))
+    }
+}
+
+void PhysicsWorld::setSolverMode(SolverMode mode)
+{
+    if (mode != m_solverMode)
+    {
+        m_manifolds.clear();
+        m_solverMode = mode;
+    }
+}
+
+SolverMode PhysicsWorld::getSolverMode() const
+{
+    return m_solverMode;
+}
+
+SequentialImpulseSolver &PhysicsWorld::getImpulseSolver()
+{
+    return m_impulseSolver;
+}
+
+unsigned int PhysicsWorld::getManifoldCount() const
+{
+    return (unsigned int)m_manifolds.size();
+}
+
+unsigned int PhysicsWorld::getWorkerCount() const
+{
+    return m_workerPool.getWorkerCount();
+}
+
+void PhysicsWorld::setWorkerCount(unsigned int workerCount)
+{
+    m_workerPool.setWorkerCount(workerCount);
+}
+
+unsigned int PhysicsWorld::getAwakeIslandCount() const
+{
+    unsigned int count = 0;
+    for (const Island &island : m_islands)
+    {
+        if (island.awake)
         {
-            return CollisionDetector::capsuleAndCapsule(*b0Ptr, *b1Ptr, &data);
+            ++count;
         }
     }
+    return count;
+}
 
-    return 0;
+int PhysicsWorld::getIslandBodyIndex(const RigidBody *body) const
+{
+    if (body == nullptr || !body->hasFiniteMass())
+    {
+        return -1;
+    }
+
+    return m_rigidBodies.getIndex(body);
 }
 
+unsigned int PhysicsWorld::findIslandRoot(unsigned int body)
+{
+    while (m_islandParents[body] != body)
+    {
+        // Path halving
+        m_islandParents[body] = m_islandParents[m_islandParents[body]];
+        body = m_islandParents[body];
+    }
+    return body;
+}
 
-unsigned int PhysicsWorld::generateContacts()
+void PhysicsWorld::linkIslandBodies(const RigidBody *a, const RigidBody *b)
 {
-    m_collisionData.reset(PhysicsWorld::MAX_CONTACTS);
-    m_collisionData.friction = (ds_math::scalar)0.9;
-    m_collisionData.restitution = (ds_math::scalar)0.6;
-    m_collisionData.tolerance = (ds_math::scalar)0.1;
+    int indexA = getIslandBodyIndex(a);
+    int indexB = getIslandBodyIndex(b);
 
-    if (!m_collisionData.hasMoreContacts())
+    if (indexA < 0 || indexB < 0)
     {
-        return m_collisionData.contactCount;
+        return;
+    }
+
+    unsigned int rootA = findIslandRoot(indexA);
+    unsigned int rootB = findIslandRoot(indexB);
+
+    // The lowest index is always the root so that islands are found in the
+    // same order every run
+    if (rootA < rootB)
+    {
+        m_islandParents[rootB] = rootA;
+    }
+    else if (rootB < rootA)
+    {
+        m_islandParents[rootA] = rootB;
+    }
+}
+
+void PhysicsWorld::buildIslands(const Contact *contacts,
+                                unsigned int contactCount)
+{
+    unsigned int bodyCount = m_rigidBodies.size();
+
+    m_islandParents.resize(bodyCount);
+    for (unsigned int i = 0; i < bodyCount; ++i)
+    {
+        m_islandParents[i] = i;
+    }
+
+    // Bodies in contact this step share an island
+    for (unsigned int i = 0; i < contactCount; ++i)
+    {
+        linkIslandBodies(contacts[i].body[0], contacts[i].body[1]);
+    }
+
+    // Contacts between sleeping bodies are not generated, keep the bodies
+    // of each sleeping island together so that it wakes as a whole
+    for (unsigned int i = 0; i < bodyCount; ++i)
+    {
+        if (m_sleepGroups[i] >= 0)
+        {
+            linkIslandBodies(m_rigidBodies.getBody(i),
+                             m_rigidBodies.getBody(m_sleepGroups[i]));
+        }
     }
 
-    // Calculate internals for all rigid bodies
-    for (auto iter = m_collisionPrimitives.begin();
-         iter != m_collisionPrimitives.end(); iter++)
+    // Number the islands in order of their lowest body index
+    m_islands.clear();
+    m_bodyIslands.resize(bodyCount);
+    for (unsigned int i = 0; i < bodyCount; ++i)
     {
-        if (iter->second)
+        unsigned int root = findIslandRoot(i);
+        if (root == i)
+        {
+            m_bodyIslands[i] = (unsigned int)m_islands.size();
+            Island island = {0, 0, 0, 0, false, false};
+            m_islands.push_back(island);
+        }
+        else
         {
-            iter->second->calculateInternals();
+            m_bodyIslands[i] = m_bodyIslands[root];
         }
+        ++m_islands[m_bodyIslands[i]].bodyCount;
+    }
+
+    // Contacts on a body that was never added to the world, or that don't
+    // involve any island body, are resolved together at the end
+    unsigned int looseIsland = (unsigned int)m_islands.size();
+    Island loose = {0, 0, 0, 0, true, true};
+    m_islands.push_back(loose);
+
+    // Gather the bodies of each island, in index order, and find which
+    // islands are awake
+    unsigned int start = 0;
+    for (Island &island : m_islands)
+    {
+        island.bodyStart = start;
+        start += island.bodyCount;
+        island.bodyCount = 0;
+    }
+    m_islandBodies.resize(bodyCount);
+    for (unsigned int i = 0; i < bodyCount; ++i)
+    {
+        Island &island = m_islands[m_bodyIslands[i]];
+        m_islandBodies[island.bodyStart + island.bodyCount++] = i;
+        island.awake = island.awake || m_rigidBodies.getBody(i)->getAwake();
     }
 
-    // Calculate internals for all rigid bodies
-    for (auto iter = m_collisionPrimitives.begin();
-         iter != m_collisionPrimitives.end(); iter++)
+    for (Island &island : m_islands)
     {
-        if (iter->second)
+        if (!island.awake || island.bodyCount == 0)
+        {
+            continue;
+        }
+
+        const unsigned int *bodies = &m_islandBodies[island.bodyStart];
+
+        // An awake body touched the island, wake it as a unit
+        bool resting = true;
+        for (unsigned int i = 0; i < island.bodyCount; ++i)
         {
-            auto *cpPtr1 = iter->second.get();
-            auto iter2 = iter;
-            for (++iter2; iter2 != m_collisionPrimitives.end(); iter2++)
+            RigidBody *body = m_rigidBodies.getBody(bodies[i]);
+            if (!body->getAwake())
             {
-                if (iter2->second)
-                {
-                    auto *cpPtr2 = iter2->second.get();
-                    generateCollisions(cpPtr1, cpPtr2, m_collisionData);
-                }
+                body->setAwake();
+            }
+            m_sleepGroups[bodies[i]] = -1;
+            resting = resting && body->isResting();
+        }
+
+        // Every body has come to rest, put the whole island to sleep
+        if (resting)
+        {
+            for (unsigned int i = 0; i < island.bodyCount; ++i)
+            {
+                m_rigidBodies.getBody(bodies[i])->setAwake(false);
+                m_sleepGroups[bodies[i]] = (int)bodies[0];
             }
+            island.awake = false;
         }
     }
 
-    // CollisionDetector::boxAndHalfSpace(m_box, m_plane, &m_collisionData);
-    // CollisionDetector::boxAndHalfSpace(m_box2, m_plane, &m_collisionData);
-    // CollisionDetector::boxAndBox(m_box, m_box2, &m_collisionData);
+    // Gather the contacts of each island, keeping their generated order
+    m_contactIslands.resize(contactCount);
+    for (unsigned int i = 0; i < contactCount; ++i)
+    {
+        int index = getIslandBodyIndex(contacts[i].body[0]);
+        if (index < 0)
+        {
+            index = getIslandBodyIndex(contacts[i].body[1]);
+        }
 
-    // CollisionDetector::sphereAndHalfSpace(m_sphere, m_plane,
-    // &m_collisionData);
+        // Movable bodies outside the world may touch several islands
+        for (const RigidBody *body : contacts[i].body)
+        {
+            if (body != nullptr && body->hasFiniteMass() &&
+                m_rigidBodies.getIndex(body) < 0)
+            {
+                index = -1;
+            }
+        }
+
+        m_contactIslands[i] = index < 0 ? looseIsland : m_bodyIslands[index];
+        ++m_islands[m_contactIslands[i]].contactCount;
+    }
 
-    return m_collisionData.contactCount;
+    start = 0;
+    for (Island &island : m_islands)
+    {
+        island.contactStart = start;
+        start += island.contactCount;
+        island.contactCount = 0;
+    }
+    m_islandContacts.resize(contactCount);
+    m_islandContactSources.resize(contactCount);
+    for (unsigned int i = 0; i < contactCount; ++i)
+    {
+        Island &island = m_islands[m_contactIslands[i]];
+        unsigned int index = island.contactStart + island.contactCount++;
+        m_islandContacts[index] = contacts[i];
+        m_islandContactSources[index] = i;
+    }
+
+    if (m_islands.back().contactCount == 0)
+    {
+        m_islands.pop_back();
+    }
+}
+
+RigidBodyHandle PhysicsWorld::addRigidBody(RigidBody *rigidBody)
+{
+    // Add the body to the pool first so that setting up its state doesn't
+    // give it a copy of its own
+    RigidBodyHandle handle = m_rigidBodies.add(rigidBody);
+
+    //@todo Remove when propper loading is done.
+
+    // rigidBody->setRotation(ds_math::Vector3(0, 0, 0));
+    // rigidBody->setLinearDamping(0.95f);
+    // rigidBody->setAngularDamping(0.80f);
+    rigidBody->clearAccumulators();
+    // rigidBody->setAcceleration(0.0f, -10.0f, 0.0f);
+    rigidBody->setCanSleep(true);
+
+    rigidBody->setAwake();
+
+    rigidBody->calculateDerivedData();
+
+    m_sleepGroups.push_back(-1);
+    return handle;
+}
+
+void PhysicsWorld::removeRigidBody(RigidBody *rigidBody)
+{
+    removeRigidBody(rigidBody, true);
+}
+
+void PhysicsWorld::removeRigidBody(RigidBody *rigidBody, bool keepState)
+{
+    while (rigidBody->getCollisionPrimitiveCount() > 0)
+    {
+        removeCollisionPrimitive(rigidBody->getCollisionPrimitive(0));
+        rigidBody->removeCollisionPrimitive(0);
+    }
+
+    int index = m_rigidBodies.getIndex(rigidBody);
+    if (index >= 0)
+    {
+        // The rest of the body's island may have been resting on it
+        int group = m_sleepGroups[index];
+        if (group >= 0)
+        {
+            for (unsigned int i = 0; i < m_sleepGroups.size(); ++i)
+            {
+                if (m_sleepGroups[i] == group)
+                {
+                    m_rigidBodies.getBody(i)->setAwake();
+                    m_sleepGroups[i] = -1;
+                }
+            }
+        }
+
+        removeManifolds(rigidBody, -1);
+
+        // The last body is moved into the gap left, follow it
+        int last = (int)m_rigidBodies.size() - 1;
+        m_rigidBodies.remove(m_rigidBodies.getHandle(rigidBody), keepState);
+
+        m_sleepGroups[index] = m_sleepGroups[last];
+        m_sleepGroups.pop_back();
+        for (int &other : m_sleepGroups)
+        {
+            if (other == last)
+            {
+                other = index;
+            }
+        }
+    }
+}
+
+RigidBody *PhysicsWorld::createRigidBody()
+{
+    RigidBody *rigidBody = m_bodyPool.create();
+    addRigidBody(rigidBody);
+
+    return rigidBody;
+}
+
+void PhysicsWorld::destroyRigidBody(RigidBody *rigidBody)
+{
+    assert(m_bodyPool.owns(rigidBody) &&
+           "Tried to destroy a rigid body not created by this world.");
+
+    removeRigidBody(rigidBody, false);
+    m_forceRegistry.remove(rigidBody);
+    m_bodyPool.destroy(rigidBody);
+}
+
+void PhysicsWorld::removeRigidBody(RigidBodyHandle handle)
+{
+    RigidBody *rigidBody = m_rigidBodies.get(handle);
+    if (rigidBody != nullptr)
+    {
+        removeRigidBody(rigidBody);
+    }
+}
+
+RigidBody *PhysicsWorld::getRigidBody(RigidBodyHandle handle) const
+{
+    return m_rigidBodies.get(handle);
+}
+
+const RigidBodyPool &PhysicsWorld::getRigidBodies() const
+{
+    return m_rigidBodies;
+}
+
+void PhysicsWorld::addForceGenerator(
+    RigidBody *rigidBody, std::shared_ptr<IForceGenerator> forceGenerator)
+{
+    m_forceRegistry.add(rigidBody, forceGenerator);
+}
+
+void PhysicsWorld::removeForceGenerator(
+    RigidBody *rigidBody, std::shared_ptr<IForceGenerator> forceGenerator)
+{
+    m_forceRegistry.remove(rigidBody, forceGenerator);
+}
+
+ForceFieldID PhysicsWorld::addForceField(const ForceField &field)
+{
+    ForceFieldID id = ++m_currentForceFieldID;
+    m_forceFields.push_back(field);
+    m_forceFieldIDs.push_back(id);
+
+    return id;
+}
+
+void PhysicsWorld::setForceField(ForceFieldID id, const ForceField &field)
+{
+    auto it = std::find(m_forceFieldIDs.begin(), m_forceFieldIDs.end(), id);
+    if (it != m_forceFieldIDs.end())
+    {
+        m_forceFields[it - m_forceFieldIDs.begin()] = field;
+    }
+}
+
+const ForceField *PhysicsWorld::getForceField(ForceFieldID id) const
+{
+    auto it = std::find(m_forceFieldIDs.begin(), m_forceFieldIDs.end(), id);
+    if (it != m_forceFieldIDs.end())
+    {
+        return &m_forceFields[it - m_forceFieldIDs.begin()];
+    }
+
+    return nullptr;
+}
+
+void PhysicsWorld::removeForceField(ForceFieldID id)
+{
+    auto it = std::find(m_forceFieldIDs.begin(), m_forceFieldIDs.end(), id);
+    if (it != m_forceFieldIDs.end())
+    {
+        size_t index = it - m_forceFieldIDs.begin();
+        m_forceFields.erase(m_forceFields.begin() + index);
+        m_forceFieldIDs.erase(it);
+    }
+}
+
+CollisionPrimitiveID PhysicsWorld::addCollisionPrimitive(
+    std::unique_ptr<CollisionPrimitive> &&primitive)
+{
+    return addPrimitive(primitive.release(), false);
+}
+
+CollisionBox *PhysicsWorld::createBox(CollisionPrimitiveID *id)
+{
+    CollisionBox *box = m_boxPool.create();
+    CollisionPrimitiveID added = addPrimitive(box, true);
+    if (id != nullptr)
+    {
+        *id = added;
+    }
+    return box;
+}
+
+CollisionSphere *PhysicsWorld::createSphere(CollisionPrimitiveID *id)
+{
+    CollisionSphere *sphere = m_spherePool.create();
+    CollisionPrimitiveID added = addPrimitive(sphere, true);
+    if (id != nullptr)
+    {
+        *id = added;
+    }
+    return sphere;
+}
+
+CollisionPlane *PhysicsWorld::createPlane(CollisionPrimitiveID *id)
+{
+    CollisionPlane *plane = m_planePool.create();
+    CollisionPrimitiveID added = addPrimitive(plane, true);
+    if (id != nullptr)
+    {
+        *id = added;
+    }
+    return plane;
+}
+
+CollisionCapsule *PhysicsWorld::createCapsule(CollisionPrimitiveID *id)
+{
+    CollisionCapsule *capsule = m_capsulePool.create();
+    CollisionPrimitiveID added = addPrimitive(capsule, true);
+    if (id != nullptr)
+    {
+        *id = added;
+    }
+    return capsule;
+}
+
+CollisionHeightfield *PhysicsWorld::createHeightfield(CollisionPrimitiveID *id)
+{
+    CollisionHeightfield *heightfield = m_heightfieldPool.create();
+    CollisionPrimitiveID added = addPrimitive(heightfield, true);
+    if (id != nullptr)
+    {
+        *id = added;
+    }
+    return heightfield;
+}
+
+CollisionConvexHull *PhysicsWorld::createConvexHull(CollisionPrimitiveID *id)
+{
+    CollisionConvexHull *hull = m_convexHullPool.create();
+    CollisionPrimitiveID added = addPrimitive(hull, true);
+    if (id != nullptr)
+    {
+        *id = added;
+    }
+    return hull;
+}
+
+CollisionCompound *PhysicsWorld::createCompound(CollisionPrimitiveID *id)
+{
+    CollisionCompound *compound = m_compoundPool.create();
+    CollisionPrimitiveID added = addPrimitive(compound, true);
+    if (id != nullptr)
+    {
+        *id = added;
+    }
+    return compound;
+}
+
+CollisionPrimitiveID PhysicsWorld::addPrimitive(CollisionPrimitive *primitive,
+                                                bool pooled)
+{
+    PrimitiveArray &array = m_primitiveArrays[(int)primitive->getType()];
+
+    // Re-use a free slot if there is one, its generation was moved on when
+    // it was freed
+    uint32_t slot;
+    if (!m_freePrimitiveSlots.empty())
+    {
+        slot = m_freePrimitiveSlots.back();
+        m_freePrimitiveSlots.pop_back();
+    }
+    else
+    {
+        slot = (uint32_t)m_primitiveSlots.size();
+        assert(slot <= PRIMITIVE_SLOT_MASK);
+        m_primitiveSlots.push_back({CollisionPrimitiveType::Count, -1, 0});
+    }
+
+    m_primitiveSlots[slot].type = primitive->getType();
+    m_primitiveSlots[slot].index = (int)array.ids.size();
+    CollisionPrimitiveID id = (CollisionPrimitiveID)(
+        ((uint32_t)m_primitiveSlots[slot].generation << PRIMITIVE_SLOT_BITS) |
+        slot);
+
+    array.primitives.push_back(primitive);
+    array.pooled.push_back(pooled ? 1 : 0);
+    array.ids.push_back(id);
+    array.proxies.push_back(AabbTree::NULL_NODE);
+
+    return id;
+}
+
+CollisionPrimitive *
+PhysicsWorld::getCollisionPrimitive(CollisionPrimitiveID id) const
+{
+    if (id <= 0)
+    {
+        return nullptr;
+    }
+
+    uint32_t index = (uint32_t)id & PRIMITIVE_SLOT_MASK;
+    if (index < m_primitiveSlots.size())
+    {
+        const PrimitiveSlot &slot = m_primitiveSlots[index];
+        if (slot.index >= 0 &&
+            slot.generation == (uint32_t)id >> PRIMITIVE_SLOT_BITS)
+        {
+            return m_primitiveArrays[(int)slot.type].primitives[slot.index];
+        }
+    }
+    return nullptr;
+}
+
+CollisionPrimitiveID
+PhysicsWorld::getCollisionPrimitiveID(CollisionPrimitive *primitive)
+{
+    if (primitive != nullptr)
+    {
+        const PrimitiveArray &array =
+            m_primitiveArrays[(int)primitive->getType()];
+        for (unsigned int i = 0; i < array.primitives.size(); ++i)
+        {
+            if (primitive == array.primitives[i])
+            {
+                return array.ids[i];
+            }
+        }
+    }
+    return 0;
+}
+
+std::unique_ptr<CollisionPrimitive>
+PhysicsWorld::removeCollisionPrimitive(CollisionPrimitiveID id)
+{
+    if (getCollisionPrimitive(id) == nullptr)
+    {
+        return std::unique_ptr<CollisionPrimitive>();
+    }
+
+    uint32_t slotIndex = (uint32_t)id & PRIMITIVE_SLOT_MASK;
+    PrimitiveSlot &slot = m_primitiveSlots[slotIndex];
+    PrimitiveArray &array = m_primitiveArrays[(int)slot.type];
+    int index = slot.index;
+
+    if (array.proxies[index] != AabbTree::NULL_NODE)
+    {
+        m_broadphase.destroyProxy(array.proxies[index]);
+    }
+
+    removeManifolds(nullptr, id);
+
+    // The primitive's pairs end, reported when the events are next collected
+    for (auto &entry : m_collisionPairs)
+    {
+        CollisionPair &pair = entry.second;
+        CollisionPrimitiveID ids[2] = {
+            (CollisionPrimitiveID)(entry.first >> 32),
+            (CollisionPrimitiveID)(uint32_t)entry.first};
+        for (unsigned int i = 0; i < 2; ++i)
+        {
+            if (ids[i] == id)
+            {
+                pair.primitive[i] = nullptr;
+                pair.touching = false;
+            }
+        }
+    }
+
+    CollisionPrimitive *primitive = array.primitives[index];
+    bool pooled = array.pooled[index] != 0;
+
+    // Fill the gap with the last primitive of the same type
+    int last = (int)array.ids.size() - 1;
+    if (index != last)
+    {
+        array.primitives[index] = array.primitives[last];
+        array.pooled[index] = array.pooled[last];
+        array.ids[index] = array.ids[last];
+        array.proxies[index] = array.proxies[last];
+        m_primitiveSlots[(uint32_t)array.ids[index] & PRIMITIVE_SLOT_MASK]
+            .index = index;
+    }
+    array.primitives.pop_back();
+    array.pooled.pop_back();
+    array.ids.pop_back();
+    array.proxies.pop_back();
+
+    // Move the generation on so that the removed primitive's id no longer
+    // finds the slot
+    slot.index = -1;
+    slot.generation = (uint8_t)(slot.generation + 1);
+    m_freePrimitiveSlots.push_back(slotIndex);
+
+    if (pooled)
+    {
+        destroyPooledPrimitive(primitive);
+        return std::unique_ptr<CollisionPrimitive>();
+    }
+
+    return std::unique_ptr<CollisionPrimitive>(primitive);
+}
+
+void PhysicsWorld::destroyPooledPrimitive(CollisionPrimitive *primitive)
+{
+    switch (primitive->getType())
+    {
+    case CollisionPrimitiveType::Box:
+        m_boxPool.destroy(static_cast<CollisionBox *>(primitive));
+        break;
+    case CollisionPrimitiveType::Sphere:
+        m_spherePool.destroy(static_cast<CollisionSphere *>(primitive));
+        break;
+    case CollisionPrimitiveType::Plane:
+        m_planePool.destroy(static_cast<CollisionPlane *>(primitive));
+        break;
+    case CollisionPrimitiveType::Capsule:
+        m_capsulePool.destroy(static_cast<CollisionCapsule *>(primitive));
+        break;
+    case CollisionPrimitiveType::Heightfield:
+        m_heightfieldPool.destroy(
+            static_cast<CollisionHeightfield *>(primitive));
+        break;
+    case CollisionPrimitiveType::ConvexHull:
+        m_convexHullPool.destroy(static_cast<CollisionConvexHull *>(primitive));
+        break;
+    case CollisionPrimitiveType::Compound:
+        m_compoundPool.destroy(static_cast<CollisionCompound *>(primitive));
+        break;
+    default:
+        assert(false && "Unknown collision primitive type.");
+        break;
+    }
+}
+
+std::unique_ptr<CollisionPrimitive>
+PhysicsWorld::removeCollisionPrimitive(CollisionPrimitive *primitive)
+{
+    CollisionPrimitiveID id = getCollisionPrimitiveID(primitive);
+    if (id != 0)
+    {
+        return removeCollisionPrimitive(id);
+    }
+    return std::unique_ptr<CollisionPrimitive>();
+}
+
+bool PhysicsWorld::raycast(const ds_math::Vector3 &origin,
+                           const ds_math::Vector3 &direction,
+                           ds_math::scalar maxDistance,
+                           QueryHit *hit,
+                           const RigidBody *ignore) const
+{
+    return sweepSphere(origin, 0, direction, maxDistance, hit, ignore);
+}
+
+bool PhysicsWorld::sweepSphere(const ds_math::Vector3 &origin,
+                               ds_math::scalar radius,
+                               const ds_math::Vector3 &direction,
+                               ds_math::scalar maxDistance,
+                               QueryHit *hit,
+                               const RigidBody *ignore) const
+{
+    ds_math::scalar length = ds_math::Vector3::Magnitude(direction);
+    if (length <= 0 || maxDistance < 0)
+    {
+        return false;
+    }
+
+    return castSphere(origin, direction * (1.0f / length), maxDistance,
+                      std::max(radius, 0.0f), hit, ignore);
+}
+
+unsigned int PhysicsWorld::raycastBatch(const RaycastQuery *queries,
+                                        unsigned int queryCount,
+                                        QueryHit *hits)
+{
+    // Enough rays per task to be worth handing to a worker
+    const unsigned int chunkSize = 64;
+
+    std::vector<unsigned int> chunkHits((queryCount + chunkSize - 1) /
+                                        chunkSize);
+
+    auto castChunk = [&](unsigned int chunk, unsigned int) {
+        unsigned int end = std::min((chunk + 1) * chunkSize, queryCount);
+        for (unsigned int i = chunk * chunkSize; i < end; ++i)
+        {
+            const RaycastQuery &query = queries[i];
+            if (sweepSphere(query.origin, query.radius, query.direction,
+                            query.maxDistance, &hits[i]))
+            {
+                ++chunkHits[chunk];
+            }
+            else
+            {
+                hits[i].id = 0;
+                hits[i].primitive = nullptr;
+                hits[i].body = nullptr;
+            }
+        }
+    };
+
+    if (chunkHits.size() > 1)
+    {
+        m_workerPool.run((unsigned int)chunkHits.size(), castChunk);
+    }
+    else if (!chunkHits.empty())
+    {
+        castChunk(0, 0);
+    }
+
+    unsigned int hitCount = 0;
+    for (unsigned int count : chunkHits)
+    {
+        hitCount += count;
+    }
+    return hitCount;
+}
+
+unsigned int
+PhysicsWorld::overlapSphere(const ds_math::Vector3 &centre,
+                            ds_math::scalar radius,
+                            std::vector<CollisionPrimitive *> *results,
+                            const RigidBody *ignore) const
+{
+    RigidBody body;
+    body.setMass(1);
+    body.setPosition(centre);
+    body.calculateDerivedData();
+
+    CollisionSphere sphere;
+    sphere.body = &body;
+    sphere.radius = radius;
+    sphere.calculateInternals();
+
+    BoundingBox bounds;
+    sphere.calculateBoundingBox(&bounds);
+    return overlapPrimitive(sphere, bounds, results, ignore);
+}
+
+unsigned int
+PhysicsWorld::overlapBox(const ds_math::Vector3 &centre,
+                         const ds_math::Vector3 &halfSize,
+                         const ds_math::Quaternion &orientation,
+                         std::vector<CollisionPrimitive *> *results,
+                         const RigidBody *ignore) const
+{
+    RigidBody body;
+    body.setMass(1);
+    body.setPosition(centre);
+    body.setOrientation(orientation);
+    body.calculateDerivedData();
+
+    CollisionBox box;
+    box.body = &body;
+    box.halfSize = halfSize;
+    box.calculateInternals();
+
+    BoundingBox bounds;
+    box.calculateBoundingBox(&bounds);
+    return overlapPrimitive(box, bounds, results, ignore);
+}
+
+/**
+ * Get the radius of the largest sphere about the centre of a primitive that
+ * fits inside it, 0 for primitives that don't move.
+ */
+static ds_math::scalar getInnerRadius(const CollisionPrimitive &primitive)
+{
+    switch (primitive.getType())
+    {
+    case CollisionPrimitiveType::Box:
+    {
+        const ds_math::Vector3 &halfSize =
+            static_cast<const CollisionBox &>(primitive).halfSize;
+        return std::min(halfSize.x, std::min(halfSize.y, halfSize.z));
+    }
+    case CollisionPrimitiveType::Sphere:
+        return static_cast<const CollisionSphere &>(primitive).radius;
+    case CollisionPrimitiveType::Capsule:
+        return static_cast<const CollisionCapsule &>(primitive).radius;
+    default:
+        return 0;
+    }
+}
+
+void PhysicsWorld::advanceContinuousBodies()
+{
+    // Depth swept bodies are left at, so the contact is generated
+    const ds_math::scalar skin = 0.01f;
+
+    for (const ContinuousStart &start : m_continuousStarts)
+    {
+        RigidBody *body = start.body;
+        ds_math::Vector3 motion = body->getPosition() - start.position;
+        ds_math::scalar travel = ds_math::Vector3::Magnitude(motion);
+        if (travel <= 0)
+        {
+            continue;
+        }
+        ds_math::Vector3 direction = motion * (1.0f / travel);
+
+        ds_math::scalar allowed = travel;
+        for (unsigned int i = 0; i < body->getCollisionPrimitiveCount(); ++i)
+        {
+            const CollisionPrimitive &primitive =
+                *body->getCollisionPrimitive(i);
+
+            // Moving less than its own size the primitive can't skip past
+            // anything the discrete detector would miss
+            ds_math::scalar radius = getInnerRadius(primitive);
+            if (radius <= 0 || travel <= radius)
+            {
+                continue;
+            }
+
+            // Sweep half the inner sphere, so that surfaces the primitive
+            // already rests on aren't hit at the start
+            ds_math::Vector3 end = ds_math::Matrix4::Transform(
+                body->getTransform() * primitive.offset,
+                ds_math::Vector3(0, 0, 0));
+            ds_math::scalar sweepRadius = radius * 0.5f;
+
+            QueryHit hit;
+            if (castSphere(end - motion, direction, allowed, sweepRadius, &hit,
+                           body, &primitive))
+            {
+                // Back off to where the whole inner sphere touches, limited
+                // for glancing hits where that would be most of the path
+                ds_math::scalar approach = std::max(
+                    -ds_math::Vector3::Dot(direction, hit.normal), 0.5f);
+                ds_math::scalar backOff = (radius - sweepRadius) / approach;
+                allowed = std::min(
+                    allowed, std::max(hit.distance - backOff + skin, 0.0f));
+            }
+        }
+
+        if (allowed < travel)
+        {
+            body->setPosition(start.position + direction * allowed);
+            body->calculateDerivedData();
+        }
+    }
+}
+
+bool PhysicsWorld::castSphere(const ds_math::Vector3 &origin,
+                              const ds_math::Vector3 &direction,
+                              ds_math::scalar maxDistance,
+                              ds_math::scalar radius,
+                              QueryHit *hit,
+                              const RigidBody *ignore,
+                              const CollisionPrimitive *filter) const
+{
+    bool found = false;
+    ds_math::scalar nearest = maxDistance;
+
+    auto test = [&](CollisionPrimitiveID id) {
+        CollisionPrimitive *primitive = getCollisionPrimitive(id);
+        if (primitive == nullptr ||
+            (ignore != nullptr && primitive->body == ignore) ||
+            (filter != nullptr && !filter->canCollideWith(*primitive)))
+        {
+            return;
+        }
+
+        RayIntersection intersection;
+        if (IntersectionTests::rayAndPrimitive(origin, direction, nearest,
+                                               *primitive, radius,
+                                               &intersection))
+        {
+            nearest = intersection.distance;
+            found = true;
+
+            hit->id = id;
+            hit->primitive = primitive;
+            hit->body = primitive->body;
+            hit->normal = intersection.normal;
+            hit->distance = intersection.distance;
+            hit->point = origin + direction * intersection.distance -
+                         intersection.normal * radius;
+        }
+    };
+
+    // Growing the fat boxes by the radius turns the sweep into a ray cast
+    auto callback = [&](int proxyId, ds_math::scalar) {
+        test((CollisionPrimitiveID)(intptr_t)m_broadphase.getUserData(
+            proxyId));
+        return nearest;
+    };
+    m_broadphase.rayCast(origin, direction, maxDistance,
+                         ds_math::Vector3(radius, radius, radius), callback);
+
+    for (CollisionPrimitiveID id : m_unboundedPrimitives)
+    {
+        test(id);
+    }
+
+    return found;
+}
+
+unsigned int
+PhysicsWorld::overlapPrimitive(const CollisionPrimitive &shape,
+                               const BoundingBox &bounds,
+                               std::vector<CollisionPrimitive *> *results,
+                               const RigidBody *ignore) const
+{
+    // Contacts are only used to tell whether the shapes touch
+    Contact contacts[16];
+    CollisionData data;
+    data.contactArray = contacts;
+    data.friction = 0;
+    data.restitution = 0;
+    data.tolerance = 0;
+
+    unsigned int found = 0;
+    auto test = [&](CollisionPrimitiveID id) {
+        CollisionPrimitive *primitive = getCollisionPrimitive(id);
+        if (primitive == nullptr ||
+            (ignore != nullptr && primitive->body == ignore))
+        {
+            return;
+        }
+
+        data.reset(sizeof(contacts) / sizeof(contacts[0]));
+        if (CollisionDetector::primitiveAndPrimitive(shape, *primitive,
+                                                     &data) > 0)
+        {
+            results->push_back(primitive);
+            ++found;
+        }
+    };
+
+    auto callback = [&](int proxyId) {
+        test((CollisionPrimitiveID)(intptr_t)m_broadphase.getUserData(
+            proxyId));
+        return true;
+    };
+    m_broadphase.query(bounds, callback);
+
+    for (CollisionPrimitiveID id : m_unboundedPrimitives)
+    {
+        test(id);
+    }
+
+    return found;
+}
+
+static unsigned generateCollisions(CollisionPrimitive* b0, CollisionPrimitive* b1, CollisionData& data) {
+	if (!data.hasMoreContacts()) return 0;
+	if (!b0) return 0;
+	if (!b1) return 0;
+	if (b0->body) {
+		if (b1->body) {
+			if ((!b0->body->hasFiniteMass()) && (!b1->body->hasFiniteMass())) return 0;
+		} else {
+			if (!b0->body->hasFiniteMass()) return 0;
+		}
+	} else {
+		if (b1->body) {
+			if (!b1->body->hasFiniteMass()) return 0;
+		}
+	}
+	if ((b0->body == b1->body) && (b0->body != nullptr)) return 0;
+
+    return CollisionDetector::primitiveAndPrimitive(*b0, *b1, &data);
+}
+
+void PhysicsWorld::addPotentialContact(CollisionPrimitiveID a,
+                                       CollisionPrimitiveID b)
+{
+    if (b < a)
+    {
+        std::swap(a, b);
+    }
+
+    PotentialContact pair = {{a, b},
+                             {getCollisionPrimitive(a),
+                              getCollisionPrimitive(b)}};
+    if (pair.primitive[0]->canCollideWith(*pair.primitive[1]))
+    {
+        m_potentialContacts.push_back(pair);
+    }
+}
+
+bool PhysicsWorld::isPrimitiveAsleep(const CollisionPrimitive *primitive)
+{
+    return primitive->body != nullptr && !primitive->body->getAwake();
+}
+
+void PhysicsWorld::findPotentialContacts()
+{
+    m_primitiveBounds.clear();
+    m_unboundedPrimitives.clear();
+    m_potentialContacts.clear();
+
+    // Calculate internals for all collision primitives and refit the
+    // broadphase
+    for (PrimitiveArray &array : m_primitiveArrays)
+    {
+        for (unsigned int i = 0; i < array.primitives.size(); ++i)
+        {
+            CollisionPrimitive *primitive = array.primitives[i];
+            CollisionPrimitiveID id = array.ids[i];
+
+            // Sleeping primitives haven't moved, leave them where they are
+            // in the broadphase
+            if (isPrimitiveAsleep(primitive) &&
+                array.proxies[i] != AabbTree::NULL_NODE)
+            {
+                continue;
+            }
+
+            primitive->calculateInternals();
+
+            PrimitiveBounds bounds;
+            bounds.id = id;
+            if (primitive->calculateBoundingBox(&bounds.box))
+            {
+                if (array.proxies[i] == AabbTree::NULL_NODE)
+                {
+                    array.proxies[i] = m_broadphase.createProxy(
+                        bounds.box,
+                        reinterpret_cast<void *>((intptr_t)id));
+                }
+                else
+                {
+                    m_broadphase.moveProxy(array.proxies[i], bounds.box);
+                }
+
+                m_primitiveBounds.push_back(bounds);
+            }
+            else
+            {
+                m_unboundedPrimitives.push_back(id);
+            }
+        }
+    }
+
+    // Pair each bounded primitive with every other primitive whose fat box
+    // it overlaps, each pair is reported once by the primitive with the
+    // lower id. Sleeping primitives don't query, so pairs with them are
+    // reported by the other primitive.
+    for (const PrimitiveBounds &bounds : m_primitiveBounds)
+    {
+        CollisionPrimitiveID id = bounds.id;
+        auto callback = [&](int proxyId) {
+            CollisionPrimitiveID other = (CollisionPrimitiveID)(
+                intptr_t)m_broadphase.getUserData(proxyId);
+            if (other > id ||
+                (other != id &&
+                 isPrimitiveAsleep(getCollisionPrimitive(other))))
+            {
+                addPotentialContact(id, other);
+            }
+            return true;
+        };
+        m_broadphase.query(bounds.box, callback);
+    }
+
+    // Unbounded primitives may touch anything
+    for (unsigned int i = 0; i < m_unboundedPrimitives.size(); ++i)
+    {
+        CollisionPrimitiveID id = m_unboundedPrimitives[i];
+
+        for (const PrimitiveBounds &bounds : m_primitiveBounds)
+        {
+            addPotentialContact(id, bounds.id);
+        }
+
+        for (unsigned int j = i + 1; j < m_unboundedPrimitives.size(); ++j)
+        {
+            addPotentialContact(id, m_unboundedPrimitives[j]);
+        }
+    }
+
+    // Keep the same order as testing every pair of primitives in id order
+    std::sort(m_potentialContacts.begin(), m_potentialContacts.end());
+}
+
+unsigned int PhysicsWorld::generateContacts()
+{
+    m_collisionData.contactArray = m_contacts.data();
+    m_collisionData.reset((unsigned int)m_contacts.size());
+    m_collisionData.friction = (ds_math::scalar)0.9;
+    m_collisionData.restitution = (ds_math::scalar)0.6;
+    m_collisionData.tolerance = (ds_math::scalar)0.1;
+
+    if (!m_collisionData.hasMoreContacts())
+    {
+        return m_collisionData.contactCount;
+    }
+
+    m_contactPairs.clear();
+
+    findPotentialContacts();
+
+    // Run the fine collision detector on each pair the broadphase found,
+    // skipping pairs where nothing is awake.
+    for (const PotentialContact &pair : m_potentialContacts)
+    {
+        const RigidBody *body0 = pair.primitive[0]->body;
+        const RigidBody *body1 = pair.primitive[1]->body;
+        if (!(body0 != nullptr && body0->getAwake()) &&
+            !(body1 != nullptr && body1->getAwake()))
+        {
+            continue;
+        }
+
+        // A full buffer cuts the pair short, grow it and generate the pair
+        // again
+        unsigned int start = m_collisionData.contactCount;
+        for (;;)
+        {
+            if (m_collisionData.hasMoreContacts())
+            {
+                generateCollisions(pair.primitive[0], pair.primitive[1],
+                                   m_collisionData);
+                if (m_collisionData.hasMoreContacts())
+                {
+                    break;
+                }
+            }
+            growContacts(start);
+        }
+
+        // Remember which pair each contact came from
+        m_contactPairs.resize(m_collisionData.contactCount,
+                              getContactPairKey(pair.id[0], pair.id[1]));
+    }
+
+    // CollisionDetector::boxAndHalfSpace(m_box, m_plane, &m_collisionData);
+    // CollisionDetector::boxAndHalfSpace(m_box2, m_plane, &m_collisionData);
+    // CollisionDetector::boxAndBox(m_box, m_box2, &m_collisionData);
+
+    // CollisionDetector::sphereAndHalfSpace(m_sphere, m_plane,
+    // &m_collisionData);
+
+    unsigned int contactCount = m_collisionData.contactCount;
+
+    m_contactStats.contactCount = contactCount;
+    m_contactStats.highWaterMark =
+        std::max(m_contactStats.highWaterMark, contactCount);
+    m_contactStats.droppedContacts = 0;
+
+    if (m_contactBudget > 0 && contactCount > m_contactBudget)
+    {
+        // Start from the first pair dropped last time, so that the same
+        // pairs aren't dropped every step
+        unsigned int pairCount = 0;
+        for (unsigned int i = 0; i < contactCount; ++i)
+        {
+            if (i == 0 || m_contactPairs[i] != m_contactPairs[i - 1])
+            {
+                ++pairCount;
+            }
+        }
+
+        unsigned int firstPair = m_contactBudgetPair % pairCount;
+        unsigned int first = 0;
+        for (unsigned int pair = 0; pair < firstPair; ++first)
+        {
+            if (m_contactPairs[first + 1] != m_contactPairs[first])
+            {
+                ++pair;
+            }
+        }
+        std::rotate(m_contacts.begin(), m_contacts.begin() + first,
+                    m_contacts.begin() + contactCount);
+        std::rotate(m_contactPairs.begin(), m_contactPairs.begin() + first,
+                    m_contactPairs.end());
+
+        // Keep whole pairs while they fit, a pair resolved with only some
+        // of its contacts can tip over
+        unsigned int kept = 0;
+        unsigned int keptPairs = 0;
+        for (unsigned int end = 1; end <= contactCount; ++end)
+        {
+            if (end == contactCount ||
+                m_contactPairs[end] != m_contactPairs[end - 1])
+            {
+                if (end > m_contactBudget)
+                {
+                    break;
+                }
+                kept = end;
+                ++keptPairs;
+            }
+        }
+
+        m_contactBudgetPair = firstPair + keptPairs;
+        m_contactStats.droppedContacts = contactCount - kept;
+        ++m_contactStats.overBudgetSteps;
+
+        contactCount = kept;
+        m_contactPairs.resize(contactCount);
+    }
+
+    return contactCount;
+}
+
+void PhysicsWorld::growContacts(unsigned int keep)
+{
+    m_contacts.resize(m_contacts.size() * 2);
+    m_contactStats.capacity = (unsigned int)m_contacts.size();
+
+    m_collisionData.contactArray = m_contacts.data();
+    m_collisionData.reset((unsigned int)m_contacts.size());
+    m_collisionData.contactsLeft -= keep;
+    m_collisionData.contactCount = keep;
+    m_collisionData.contacts += keep;
+}
+
+void PhysicsWorld::setContactBudget(unsigned int budget)
+{
+    m_contactBudget = budget;
+}
+
+unsigned int PhysicsWorld::getContactBudget() const
+{
+    return m_contactBudget;
+}
+
+const ContactStats &PhysicsWorld::getContactStats() const
+{
+    return m_contactStats;
+}
+
+void PhysicsWorld::resetContactStats()
+{
+    m_contactStats.highWaterMark = 0;
+    m_contactStats.overBudgetSteps = 0;
+}
+
+const SolverStats &PhysicsWorld::getSolverStats() const
+{
+    return m_solverStats;
 }
 }
@@ -29,20 +29,171 @@
  */
 #pragma once
 
+#include "engine/system/physics/CollisionCoarse.h"
 #include "engine/system/physics/CollisionFine.h"
+#include "engine/system/physics/ContactManifold.h"
 #include "engine/system/physics/ContactResolver.h"
 #include "engine/system/physics/Contacts.h"
 #include "engine/system/physics/ForceGenerator.h"
+#include "engine/system/physics/ObjectPool.h"
 #include "engine/system/physics/RigidBody.h"
+#include "engine/system/physics/RigidBodyPool.h"
+#include "engine/system/physics/SequentialImpulseSolver.h"
+#include "engine/system/physics/WorkerPool.h"
 #include "math/Precision.h"
-#include <map>
+#include <cstdint>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 namespace ds_phys
 {
 typedef int CollisionPrimitiveID;
 
+/**
+ * How the physics world resolves contacts.
+ */
+enum class SolverMode
+{
+    /**
+     * ContactResolver, repeatedly resolves the most severe contact. New
+     * contacts are generated every step.
+     */
+    MostSevereFirst,
+    /**
+     * SequentialImpulseSolver, iterates over every contact. Contacts are
+     * kept in a manifold per pair of collision primitives and warm start
+     * from the impulse they received the step before.
+     */
+    SequentialImpulse
+};
+
+/**
+ * Statistics on the contacts generated by the physics world.
+ */
+struct ContactStats
+{
+    /** Contacts generated in the last step, including any dropped. */
+    unsigned int contactCount;
+
+    /** Most contacts generated in a step since the statistics were reset. */
+    unsigned int highWaterMark;
+
+    /** Number of contacts the contact buffer has room for. */
+    unsigned int capacity;
+
+    /** Contacts over the budget dropped in the last step. */
+    unsigned int droppedContacts;
+
+    /** Steps since the statistics were reset in which contacts were dropped. */
+    unsigned int overBudgetSteps;
+};
+
+/**
+ * Statistics on the work done resolving contacts in the last step.
+ */
+struct SolverStats
+{
+    /** Islands whose contacts were resolved. */
+    unsigned int islandCount;
+
+    /** Contacts resolved, once contact manifolds have added their points. */
+    unsigned int contactCount;
+
+    /** Passes made resolving velocity, summed over the islands. */
+    unsigned int velocityIterations;
+
+    /** Passes made resolving penetration, summed over the islands. */
+    unsigned int positionIterations;
+};
+
+/**
+ * Result of a ray cast or sweep against the physics world.
+ */
+struct QueryHit
+{
+    /** Id of the collision primitive hit, 0 if nothing was hit. */
+    CollisionPrimitiveID id;
+
+    /** Collision primitive hit, nullptr if nothing was hit. */
+    CollisionPrimitive *primitive;
+
+    /** Rigid body of the primitive hit, nullptr for static primitives. */
+    RigidBody *body;
+
+    /** Point where the ray, or the swept shape, touches the primitive. */
+    ds_math::Vector3 point;
+
+    /** Surface normal of the primitive at the point, facing the query. */
+    ds_math::Vector3 normal;
+
+    /** Distance along the query direction. */
+    ds_math::scalar distance;
+};
+
+/**
+ * A ray cast or sphere sweep, for casting many at once.
+ */
+struct RaycastQuery
+{
+    /** Start of the ray. */
+    ds_math::Vector3 origin;
+
+    /** Direction of the ray, needn't be normalized. */
+    ds_math::Vector3 direction;
+
+    /** Length of the ray. */
+    ds_math::scalar maxDistance;
+
+    /** Radius of the sphere swept along the ray, 0 for a plain ray. */
+    ds_math::scalar radius;
+};
+
+/**
+ * How the contact between a pair of collision primitives changed.
+ */
+enum class CollisionEventType
+{
+    /** The pair started touching. */
+    Begin,
+    /** The pair was touching before and still is. */
+    Stay,
+    /** The pair stopped touching. */
+    End
+};
+
+/**
+ * Change in the contact between a pair of collision primitives over a frame.
+ */
+struct CollisionEvent
+{
+    /** How the contact changed. */
+    CollisionEventType type;
+
+    /**
+     * Collision primitives of the pair, the one with the lower id first.
+     * nullptr for a primitive removed from the world since the pair was
+     * last reported, the pair then ends.
+     */
+    CollisionPrimitive *primitive[2];
+
+    /**
+     * Rigid body of each primitive, nullptr for static primitives. The body
+     * of a removed primitive is the one it had when removed and may since
+     * have been destroyed, so only use it to look up what it was.
+     */
+    RigidBody *body[2];
+
+    /** Deepest contact point when the pair was last touching. */
+    ds_math::Vector3 point;
+
+    /** Contact normal at the point, from the second primitive to the first. */
+    ds_math::Vector3 normal;
+
+    /** Penetration at the point. */
+    ds_math::scalar penetration;
+};
+
 /**
  * Physics world class.
  */
@@ -52,8 +203,8 @@ public:
     /**
      * Physics world constructor.
      *
-     * @param   maxContacts   unsigned int, maximum number of contacts to
-     * process.
+     * @param   maxContacts   unsigned int, number of contacts to make room
+     * for up front, or 0 for the default. The buffer grows as needed.
      * @param   iterations    unsigned int, maximum number of iterations to
      * perform.
      */
@@ -66,6 +217,9 @@ public:
     /**
      * Generate contacts for this frame.
      *
+     * Candidate pairs are found with the broadphase and then passed, in order
+     * of collision primitive id, to the fine collision detector.
+     *
      * @return   unsigned int, number of contacts generated.
      */
     unsigned int generateContacts();
@@ -78,17 +232,34 @@ public:
     /**
      * Step the simulation forward one timestep.
      *
+     * Bodies are grouped into islands, sets of bodies connected by contacts,
+     * and each island's contacts are resolved separately. An island is put
+     * to sleep once all of its bodies are at rest and woken as a whole when
+     * an awake body touches any of its bodies. Pairs of primitives whose
+     * bodies are all asleep are skipped by the fine collision detector.
+     *
+     * Islands share no movable bodies, so when there are enough contacts
+     * they are resolved in parallel across the world's workers. Each island
+     * is resolved on its own with a copy of m_contactResolver, so the
+     * results are the same whatever the number of workers.
+     *
+     * Bodies using continuous collision detection are moved back along the
+     * path they were integrated over to where they first touch anything,
+     * see RigidBody::setContinuousCollision.
+     *
      * @param   duration   ds_math::scalar, duration of the timestep to
      * integrate the simulation over.
      */
     void stepSimulation(ds_math::scalar duration);
 
     /**
-     * Add a rigid body to the simulation.
+     * Add a rigid body to the simulation. The body's state is kept in the
+     * world's body pool until it is removed.
      *
      * @param   rigidBody   RigidBody *, rigid body to add to the simulation.
+     * @return              RigidBodyHandle, handle to the body.
      */
-    void addRigidBody(RigidBody *rigidBody);
+    RigidBodyHandle addRigidBody(RigidBody *rigidBody);
 
     /**
      * Remove a rigid body to the simulation.
@@ -97,6 +268,46 @@ public:
      */
     void removeRigidBody(RigidBody *rigidBody);
 
+    /**
+     * Create a rigid body in the world's body pool and add it to the
+     * simulation. Its address stays the same until it is destroyed.
+     *
+     * @return   RigidBody *, body created.
+     */
+    RigidBody *createRigidBody();
+
+    /**
+     * Remove a rigid body created by createRigidBody() from the simulation,
+     * along with its collision primitives and force generators, and return
+     * it to the pool.
+     *
+     * @param   rigidBody   RigidBody *, body to destroy.
+     */
+    void destroyRigidBody(RigidBody *rigidBody);
+
+    /**
+     * Remove a rigid body from the simulation by its handle.
+     *
+     * @param   handle   RigidBodyHandle, handle to the body, nothing is done
+     * if the body has already been removed.
+     */
+    void removeRigidBody(RigidBodyHandle handle);
+
+    /**
+     * Get a rigid body in the simulation by its handle.
+     *
+     * @param   handle   RigidBodyHandle, handle to the body.
+     * @return           RigidBody *, body or nullptr if it has been removed.
+     */
+    RigidBody *getRigidBody(RigidBodyHandle handle) const;
+
+    /**
+     * Get the rigid bodies in the simulation.
+     *
+     * @return   const RigidBodyPool &, bodies in the simulation.
+     */
+    const RigidBodyPool &getRigidBodies() const;
+
     /**
      * Add a force generator to the given rigid body.
      *
@@ -119,6 +330,41 @@ public:
     void removeForceGenerator(RigidBody *rigidBody,
                               std::shared_ptr<IForceGenerator> forceGenerator);
 
+    /**
+     * Add a force field, applied to every awake body with finite mass each
+     * step. Prefer a force field to registering the same force generator
+     * with every body.
+     *
+     * @param   field   const ForceField &, field to add.
+     * @return          ForceFieldID, id of the field added.
+     */
+    ForceFieldID addForceField(const ForceField &field);
+
+    /**
+     * Replace a force field, for example to change the direction of gravity
+     * or move an attractor.
+     *
+     * @param   id      ForceFieldID, id of the field.
+     * @param   field   const ForceField &, field to replace it with.
+     */
+    void setForceField(ForceFieldID id, const ForceField &field);
+
+    /**
+     * Get a force field.
+     *
+     * @param   id   ForceFieldID, id of the field.
+     * @return       const ForceField *, field or nullptr if there is no
+     * field with that id.
+     */
+    const ForceField *getForceField(ForceFieldID id) const;
+
+    /**
+     * Remove a force field.
+     *
+     * @param   id   ForceFieldID, id of the field.
+     */
+    void removeForceField(ForceFieldID id);
+
     /**
      * Add a collision primitive to the physics world.
      *
@@ -129,6 +375,29 @@ public:
      */
     CollisionPrimitiveID
     addCollisionPrimitive(std::unique_ptr<CollisionPrimitive> &&primitive);
+
+    /**
+     * @name Pooled collision primitives
+     *
+     * Create a collision primitive in the world's pool for its type and add
+     * it to the world. The primitive is returned to the pool when it is
+     * removed, rather than handed back. Its address stays the same until
+     * then.
+     *
+     * @param   id   CollisionPrimitiveID *, set to the id of the primitive
+     * added, may be nullptr.
+     * @return       primitive created.
+     */
+    /*@{*/
+    CollisionBox *createBox(CollisionPrimitiveID *id = nullptr);
+    CollisionSphere *createSphere(CollisionPrimitiveID *id = nullptr);
+    CollisionPlane *createPlane(CollisionPrimitiveID *id = nullptr);
+    CollisionCapsule *createCapsule(CollisionPrimitiveID *id = nullptr);
+    CollisionHeightfield *createHeightfield(CollisionPrimitiveID *id = nullptr);
+    CollisionConvexHull *createConvexHull(CollisionPrimitiveID *id = nullptr);
+    CollisionCompound *createCompound(CollisionPrimitiveID *id = nullptr);
+    /*@}*/
+
     /**
      * Get the collision primitive associated with the given primitive id.
      *
@@ -136,7 +405,7 @@ public:
      * @return       CollisionPrimitive *, pointer to collision primitive with
      * the given id or nullptr if no collision primitive with that id.
      */
-    CollisionPrimitive *getCollisionPrimitive(CollisionPrimitiveID id);
+    CollisionPrimitive *getCollisionPrimitive(CollisionPrimitiveID id) const;
     /**
      * Get the collision primitive id of the given collision primitive.
      *
@@ -152,7 +421,8 @@ public:
      * @param   id   CollisionPrimitiveID, id of the collision primitive to
      * remove from the physics world.
      * @return       std::unique_ptr<CollisionPrimitive>, collision primitive
-     * that was removed.
+     * that was removed, nullptr if it was created by the world and has been
+     * returned to its pool.
      */
     std::unique_ptr<CollisionPrimitive>
     removeCollisionPrimitive(CollisionPrimitiveID id);
@@ -162,17 +432,249 @@ public:
      * @param   primitive   CollisionPrimitive *, pointer to collision primitive
      * to remove from the physics world.
      * @return              std::unique_ptr<CollisionPrimitive>, collision
-     * primitive that was removed.
+     * primitive that was removed, nullptr if it was created by the world.
      */
     std::unique_ptr<CollisionPrimitive>
     removeCollisionPrimitive(CollisionPrimitive *primitive);
 
-    // TODO Not public
-    std::vector<RigidBody *> m_rigidBodies;
+    /**
+     * @name Queries
+     *
+     * Queries see the collision primitives as they were at the end of the
+     * last step, primitives added since then aren't found. Queries don't
+     * change the world, so several may run at once between steps.
+     */
+    /*@{*/
 
-    CollisionPrimitiveID m_currentCPID;
-    std::map<CollisionPrimitiveID, std::unique_ptr<CollisionPrimitive>>
-        m_collisionPrimitives;
+    /**
+     * Find the first collision primitive along a ray.
+     *
+     * @param   origin        const ds_math::Vector3 &, start of the ray.
+     * @param   direction     const ds_math::Vector3 &, direction of the ray,
+     * needn't be normalized.
+     * @param   maxDistance   ds_math::scalar, length of the ray.
+     * @param   hit           QueryHit *, filled in with the first hit, only
+     * written if there is one.
+     * @param   ignore        const RigidBody *, body whose primitives are
+     * skipped, or nullptr.
+     * @return                bool, true if the ray hit a primitive.
+     */
+    bool raycast(const ds_math::Vector3 &origin,
+                 const ds_math::Vector3 &direction,
+                 ds_math::scalar maxDistance,
+                 QueryHit *hit,
+                 const RigidBody *ignore = nullptr) const;
+
+    /**
+     * Find the first collision primitive a sphere touches when swept along
+     * a ray.
+     *
+     * @param   origin        const ds_math::Vector3 &, starting centre of
+     * the sphere.
+     * @param   radius        ds_math::scalar, radius of the sphere.
+     * @param   direction     const ds_math::Vector3 &, direction of the
+     * sweep, needn't be normalized.
+     * @param   maxDistance   ds_math::scalar, length of the sweep.
+     * @param   hit           QueryHit *, filled in with the first hit, only
+     * written if there is one.
+     * @param   ignore        const RigidBody *, body whose primitives are
+     * skipped, or nullptr.
+     * @return                bool, true if the sphere hit a primitive.
+     */
+    bool sweepSphere(const ds_math::Vector3 &origin,
+                     ds_math::scalar radius,
+                     const ds_math::Vector3 &direction,
+                     ds_math::scalar maxDistance,
+                     QueryHit *hit,
+                     const RigidBody *ignore = nullptr) const;
+
+    /**
+     * Cast many rays or sphere sweeps, spread across the workers when
+     * there are enough of them.
+     *
+     * @param   queries      const RaycastQuery *, queries to cast.
+     * @param   queryCount   unsigned int, number of queries.
+     * @param   hits         QueryHit *, filled in with the first hit of each
+     * query. Queries that miss have a hit with a nullptr primitive.
+     * @return               unsigned int, number of queries that hit.
+     */
+    unsigned int raycastBatch(const RaycastQuery *queries,
+                              unsigned int queryCount,
+                              QueryHit *hits);
+
+    /**
+     * Find every collision primitive that overlaps a sphere.
+     *
+     * @param   centre    const ds_math::Vector3 &, centre of the sphere.
+     * @param   radius    ds_math::scalar, radius of the sphere.
+     * @param   results   std::vector<CollisionPrimitive *> *, primitives
+     * found are appended.
+     * @param   ignore    const RigidBody *, body whose primitives are
+     * skipped, or nullptr.
+     * @return            unsigned int, number of primitives found.
+     */
+    unsigned int overlapSphere(const ds_math::Vector3 &centre,
+                               ds_math::scalar radius,
+                               std::vector<CollisionPrimitive *> *results,
+                               const RigidBody *ignore = nullptr) const;
+
+    /**
+     * Find every collision primitive that overlaps a box.
+     *
+     * @param   centre        const ds_math::Vector3 &, centre of the box.
+     * @param   halfSize      const ds_math::Vector3 &, half the size of the
+     * box along each of its axes.
+     * @param   orientation   const ds_math::Quaternion &, orientation of the
+     * box.
+     * @param   results       std::vector<CollisionPrimitive *> *,
+     * primitives found are appended.
+     * @param   ignore        const RigidBody *, body whose primitives are
+     * skipped, or nullptr.
+     * @return                unsigned int, number of primitives found.
+     */
+    unsigned int overlapBox(const ds_math::Vector3 &centre,
+                            const ds_math::Vector3 &halfSize,
+                            const ds_math::Quaternion &orientation,
+                            std::vector<CollisionPrimitive *> *results,
+                            const RigidBody *ignore = nullptr) const;
+    /*@}*/
+
+    /**
+     * Get the number of islands found in the last step.
+     *
+     * @return   unsigned int, number of islands.
+     */
+    unsigned int getIslandCount() const
+    {
+        return (unsigned int)m_islands.size();
+    }
+
+    /**
+     * Get the number of islands that were awake in the last step.
+     *
+     * @return   unsigned int, number of awake islands.
+     */
+    unsigned int getAwakeIslandCount() const;
+
+    /**
+     * Get the number of workers used to resolve islands, including the
+     * thread that steps the simulation.
+     *
+     * @return   unsigned int, number of workers.
+     */
+    unsigned int getWorkerCount() const;
+
+    /**
+     * Set the number of workers used to resolve islands, including the
+     * thread that steps the simulation. Defaults to the number of hardware
+     * threads.
+     *
+     * @param   workerCount   unsigned int, number of workers, 1 to resolve
+     * every island on the calling thread.
+     */
+    void setWorkerCount(unsigned int workerCount);
+
+    /**
+     * Set how contacts are resolved, defaults to
+     * SolverMode::MostSevereFirst.
+     *
+     * @param   mode   SolverMode, solver to use.
+     */
+    void setSolverMode(SolverMode mode);
+
+    /**
+     * Get how contacts are resolved.
+     *
+     * @return   SolverMode, solver in use.
+     */
+    SolverMode getSolverMode() const;
+
+    /**
+     * Get the solver used in SolverMode::SequentialImpulse, to configure
+     * it.
+     *
+     * @return   SequentialImpulseSolver &, solver.
+     */
+    SequentialImpulseSolver &getImpulseSolver();
+
+    /**
+     * Get the number of contact manifolds kept, only used in
+     * SolverMode::SequentialImpulse.
+     *
+     * @return   unsigned int, number of manifolds.
+     */
+    unsigned int getManifoldCount() const;
+
+    /**
+     * Set the most contacts resolved in a step. Contacts past the budget
+     * are dropped and counted in the contact statistics.
+     *
+     * Contacts are kept or dropped a whole pair of primitives at a time, so
+     * no pair is resolved with only some of its contacts and fewer than
+     * the budget may be kept. Each step over budget starts from the first
+     * pair dropped in the last one, so the same pairs aren't always
+     * dropped.
+     *
+     * @param   budget   unsigned int, most contacts per step, or 0 for no
+     * limit (the default).
+     */
+    void setContactBudget(unsigned int budget);
+
+    /**
+     * Get the most contacts resolved in a step.
+     *
+     * @return   unsigned int, most contacts per step, 0 if there is no limit.
+     */
+    unsigned int getContactBudget() const;
+
+    /**
+     * Get statistics on the contacts generated.
+     *
+     * @return   const ContactStats &, statistics.
+     */
+    const ContactStats &getContactStats() const;
+
+    /**
+     * Reset the high-water mark and the count of steps over budget.
+     */
+    void resetContactStats();
+
+    /**
+     * Get statistics on the contacts resolved in the last step.
+     *
+     * @return   const SolverStats &, statistics.
+     */
+    const SolverStats &getSolverStats() const;
+
+    /**
+     * Set the collision layers collision events are reported for, a pair
+     * is reported if either of its primitives is in one of them.
+     *
+     * @param   layers   uint32_t, layer bits, 0 to report nothing.
+     */
+    void setCollisionEventLayers(uint32_t layers);
+
+    /**
+     * Get the collision layers collision events are reported for.
+     *
+     * @return   uint32_t, layer bits.
+     */
+    uint32_t getCollisionEventLayers() const;
+
+    /**
+     * Gather one event per pair of collision primitives whose contact
+     * changed, or carried on, since the events were last collected. Call
+     * once per frame, however many steps were taken.
+     *
+     * A pair that touched during the frame but not at its end gets both a
+     * begin and an end event. Sleeping pairs keep touching. A pair whose
+     * primitive is removed ends, reported with that primitive as nullptr,
+     * or is dropped if its begin event was never reported.
+     *
+     * @param   events   std::vector<CollisionEvent> *, events are appended,
+     * ordered by pair.
+     */
+    void collectCollisionEvents(std::vector<CollisionEvent> *events);
 
     ContactResolver m_contactResolver;
 
@@ -184,11 +686,446 @@ private:
     // btBroadphasInterface *m_broadPhase;
     // std::vector<CollisionPrimitive *> m_collisionBodies;
 
-    /** Holds the maximum number of contacts. */
-    const static unsigned MAX_CONTACTS = 256;
+    /**
+     * Collision primitives of a single type, stored densely so that each
+     * type can be iterated without chasing map nodes. Removing a primitive
+     * moves the last primitive of the same type into its place.
+     */
+    struct PrimitiveArray
+    {
+        std::vector<CollisionPrimitive *> primitives;
+        /** Whether each primitive came from the world's pools. */
+        std::vector<uint8_t> pooled;
+        std::vector<CollisionPrimitiveID> ids;
+        /** Broadphase proxy of each primitive, NULL_NODE if it has none. */
+        std::vector<int> proxies;
+    };
 
-    /** Holds the array of contacts. */
-    Contact m_contacts[MAX_CONTACTS];
+    /**
+     * Location of a collision primitive within the per-type arrays.
+     *
+     * Slots are re-used once a primitive is removed. A primitive's id is its
+     * slot with the slot's generation above it, as RigidBodyHandle does, so
+     * ids of removed primitives don't find the slot's next primitive.
+     */
+    struct PrimitiveSlot
+    {
+        CollisionPrimitiveType type;
+        /** Index into the type's array, -1 once the primitive is removed. */
+        int index;
+        /** Incremented each time the slot's primitive is removed. */
+        uint8_t generation;
+    };
+
+    /** Number of bits of a collision primitive id making up the slot. */
+    static const unsigned int PRIMITIVE_SLOT_BITS = 22;
+    /** Slot mask of a collision primitive id. */
+    static const uint32_t PRIMITIVE_SLOT_MASK = (1 << PRIMITIVE_SLOT_BITS) - 1;
+
+    /**
+     * Add a collision primitive, owned by the world either way.
+     *
+     * @param   primitive   CollisionPrimitive *, primitive to add.
+     * @param   pooled      bool, true if it came from the world's pools,
+     * false if it was allocated with new.
+     * @return              CollisionPrimitiveID, id of the primitive.
+     */
+    CollisionPrimitiveID addPrimitive(CollisionPrimitive *primitive,
+                                      bool pooled);
+
+    /**
+     * Return a collision primitive created by the world to its pool.
+     *
+     * @param   primitive   CollisionPrimitive *, primitive to destroy.
+     */
+    void destroyPooledPrimitive(CollisionPrimitive *primitive);
+
+    /**
+     * Remove a rigid body from the simulation.
+     *
+     * @param   rigidBody   RigidBody *, rigid body to remove.
+     * @param   keepState   bool, FALSE if the body is about to be destroyed
+     * and doesn't need its state handed back.
+     */
+    void removeRigidBody(RigidBody *rigidBody, bool keepState);
+
+    /** Primitive bounds, gathered each frame. */
+    struct PrimitiveBounds
+    {
+        CollisionPrimitiveID id;
+        BoundingBox box;
+    };
+
+    /**
+     * Sweep a sphere, of radius 0 for a ray, through the broadphase and the
+     * unbounded primitives.
+     *
+     * @param   origin        const ds_math::Vector3 &, start of the sweep.
+     * @param   direction     const ds_math::Vector3 &, unit direction.
+     * @param   maxDistance   ds_math::scalar, length of the sweep.
+     * @param   radius        ds_math::scalar, radius of the sphere.
+     * @param   hit           QueryHit *, first hit, only written if there
+     * is one.
+     * @param   ignore        const RigidBody *, body skipped, or nullptr.
+     * @param   filter        const CollisionPrimitive *, primitives it can't
+     * collide with are skipped, or nullptr to hit everything.
+     * @return                bool, true if anything was hit.
+     */
+    bool castSphere(const ds_math::Vector3 &origin,
+                    const ds_math::Vector3 &direction,
+                    ds_math::scalar maxDistance,
+                    ds_math::scalar radius,
+                    QueryHit *hit,
+                    const RigidBody *ignore,
+                    const CollisionPrimitive *filter = nullptr) const;
+
+    /**
+     * Find every collision primitive that overlaps a primitive not in the
+     * world, using the fine collision detector.
+     *
+     * @param   shape     const CollisionPrimitive &, primitive to test, with
+     * its internals calculated.
+     * @param   bounds    const BoundingBox &, bounds of the primitive.
+     * @param   results   std::vector<CollisionPrimitive *> *, primitives
+     * found are appended.
+     * @param   ignore    const RigidBody *, body skipped, or nullptr.
+     * @return            unsigned int, number of primitives found.
+     */
+    unsigned int overlapPrimitive(const CollisionPrimitive &shape,
+                                  const BoundingBox &bounds,
+                                  std::vector<CollisionPrimitive *> *results,
+                                  const RigidBody *ignore) const;
+
+    /**
+     * Position of a body using continuous collision detection before it was
+     * integrated this step.
+     */
+    struct ContinuousStart
+    {
+        RigidBody *body;
+        ds_math::Vector3 position;
+    };
+
+    /**
+     * Sweep each body using continuous collision detection along the path
+     * it was integrated over this step, and move it back to where it first
+     * touches anything so that it can't pass through thin primitives.
+     *
+     * Other primitives are swept against where they were last step.
+     */
+    void advanceContinuousBodies();
+
+    /** Bodies using continuous collision detection and their positions. */
+    std::vector<ContinuousStart> m_continuousStarts;
+
+    /**
+     * Pair of collision primitives whose bounding boxes overlap and so may
+     * be in contact.
+     */
+    struct PotentialContact
+    {
+        CollisionPrimitiveID id[2];
+        CollisionPrimitive *primitive[2];
+
+        bool operator<(const PotentialContact &other) const
+        {
+            return id[0] < other.id[0] ||
+                   (id[0] == other.id[0] && id[1] < other.id[1]);
+        }
+    };
+
+    /**
+     * Update the broadphase with the current bounds of every collision
+     * primitive and gather the potentially colliding pairs into
+     * m_potentialContacts, sorted by primitive id.
+     */
+    void findPotentialContacts();
+
+    /**
+     * Record a potentially colliding pair, ordered by primitive id, unless
+     * their collision layers keep them apart.
+     *
+     * @param   a   CollisionPrimitiveID, first collision primitive.
+     * @param   b   CollisionPrimitiveID, second collision primitive.
+     */
+    void addPotentialContact(CollisionPrimitiveID a, CollisionPrimitiveID b);
+
+    /**
+     * Whether a collision primitive is attached to a sleeping rigid body.
+     *
+     * @param   primitive   const CollisionPrimitive *, primitive to check.
+     * @return              bool, true if the primitive's body is asleep.
+     */
+    static bool isPrimitiveAsleep(const CollisionPrimitive *primitive);
+
+    /**
+     * Set of rigid bodies connected by contacts, along with the contacts
+     * between them.
+     */
+    struct Island
+    {
+        /** Range of the island's bodies in m_islandBodies. */
+        unsigned int bodyStart;
+        unsigned int bodyCount;
+        /** Range of the island's contacts in m_islandContacts. */
+        unsigned int contactStart;
+        unsigned int contactCount;
+        /** Whether the island is simulated this step. */
+        bool awake;
+        /**
+         * Whether the island holds the contacts on bodies that aren't in
+         * the world, which are resolved after the other islands.
+         */
+        bool loose;
+    };
+
+    /**
+     * Resolve the contacts of each awake island, in parallel when there
+     * are enough of them.
+     *
+     * @param   duration   ds_math::scalar, duration of the timestep.
+     */
+    void resolveIslands(ds_math::scalar duration);
+
+    /**
+     * Group the rigid bodies into islands using this step's contacts, wake
+     * islands touched by awake bodies, put resting islands to sleep and
+     * gather each island's contacts into m_islandContacts.
+     *
+     * @param   contacts       const Contact *, contacts to resolve this step.
+     * @param   contactCount   unsigned int, number of contacts.
+     */
+    void buildIslands(const Contact *contacts, unsigned int contactCount);
+
+    /**
+     * Identifies a pair of collision primitives, lower id first.
+     */
+    typedef uint64_t ContactPairKey;
+
+    /**
+     * Get the key of a pair of collision primitives.
+     *
+     * @param   a   CollisionPrimitiveID, lower id.
+     * @param   b   CollisionPrimitiveID, higher id.
+     * @return      ContactPairKey, key of the pair.
+     */
+    static ContactPairKey getContactPairKey(CollisionPrimitiveID a,
+                                            CollisionPrimitiveID b);
+
+    /**
+     * Contact between a pair of collision primitives, tracked for the
+     * collision events.
+     */
+    struct CollisionPair
+    {
+        /** Primitives of the pair, nullptr once removed from the world. */
+        CollisionPrimitive *primitive[2];
+
+        /** Rigid body of each primitive when the pair last touched. */
+        RigidBody *body[2];
+
+        /** Deepest contact when the pair was last touching. */
+        ds_math::Vector3 point;
+        ds_math::Vector3 normal;
+        ds_math::scalar penetration;
+
+        /** Step in which the pair last had contacts. */
+        unsigned int lastStep;
+
+        /** Whether the pair is touching. */
+        bool touching;
+
+        /** Whether the pair was touching when events were last collected. */
+        bool wasTouching;
+    };
+
+    /**
+     * Track which pairs of collision primitives are touching from the
+     * contacts generated this step.
+     *
+     * @param   contactCount   unsigned int, number of contacts generated.
+     */
+    void updateCollisionPairs(unsigned int contactCount);
+
+    /**
+     * Add the contacts generated this step to the manifold of their pair,
+     * drop the manifolds whose points have all separated and gather the
+     * points of every manifold into m_manifoldContacts.
+     *
+     * @param   contactCount   unsigned int, number of contacts generated
+     * this step.
+     */
+    void updateManifolds(unsigned int contactCount);
+
+    /**
+     * Copy the impulse of each resolved contact back to its manifold.
+     */
+    void storeManifoldImpulses();
+
+    /**
+     * Remove the manifolds involving a rigid body or collision primitive.
+     *
+     * @param   body   const RigidBody *, body, may be nullptr.
+     * @param   id     CollisionPrimitiveID, id of the primitive, may be -1.
+     */
+    void removeManifolds(const RigidBody *body, CollisionPrimitiveID id);
+
+    /**
+     * Get the index in m_rigidBodies of a body that takes part in islands,
+     * that is a body in the world with finite mass.
+     *
+     * @param   body   const RigidBody *, body to find.
+     * @return         int, index of the body or -1 if it doesn't take part
+     * in islands.
+     */
+    int getIslandBodyIndex(const RigidBody *body) const;
+
+    /**
+     * Find the representative body of the island a body belongs to.
+     *
+     * @param   body   unsigned int, index of the body.
+     * @return         unsigned int, index of the representative body.
+     */
+    unsigned int findIslandRoot(unsigned int body);
+
+    /**
+     * Join the islands of two bodies.
+     *
+     * @param   a   const RigidBody *, first body, may be nullptr.
+     * @param   b   const RigidBody *, second body, may be nullptr.
+     */
+    void linkIslandBodies(const RigidBody *a, const RigidBody *b);
+
+    /**
+     * Rigid bodies in the simulation, packed so that their state is
+     * integrated in one pass.
+     */
+    RigidBodyPool m_rigidBodies;
+
+    /** Union-find parent of each rigid body, by index. */
+    std::vector<unsigned int> m_islandParents;
+
+    /** Island of each rigid body, by index. */
+    std::vector<unsigned int> m_bodyIslands;
+
+    /** Island of each contact generated this step. */
+    std::vector<unsigned int> m_contactIslands;
+
+    /** Islands found in the last step. */
+    std::vector<Island> m_islands;
+
+    /** Indices of the bodies of each island, contiguous per island. */
+    std::vector<unsigned int> m_islandBodies;
+
+    /**
+     * Sleeping island of each rigid body, by index, given as the index of
+     * the island's first body or -1 if the body isn't asleep in an island.
+     */
+    std::vector<int> m_sleepGroups;
+
+    /** Contacts of each island, stored contiguously per island. */
+    std::vector<Contact> m_islandContacts;
+
+    /** Index of each island contact in the contacts given to buildIslands. */
+    std::vector<unsigned int> m_islandContactSources;
+
+    /** Awake islands to resolve in parallel, largest first. */
+    std::vector<unsigned int> m_solverIslands;
+
+    /** Contact resolver of each worker. */
+    std::vector<ContactResolver> m_islandResolvers;
+
+    /** Statistics on the islands each worker resolved this step. */
+    std::vector<SolverStats> m_workerSolverStats;
+
+    /** Statistics on the contacts resolved in the last step. */
+    SolverStats m_solverStats;
+
+    /** Workers that resolve islands in parallel. */
+    WorkerPool m_workerPool;
+
+    /**
+     * Minimum number of contacts in the parallel islands for the workers
+     * to be used, smaller steps are resolved on the calling thread.
+     */
+    const static unsigned int MIN_PARALLEL_CONTACTS = 64;
+
+    /** How contacts are resolved. */
+    SolverMode m_solverMode;
+
+    /** Solver used in SolverMode::SequentialImpulse. */
+    SequentialImpulseSolver m_impulseSolver;
+
+    /** Number of steps taken, used to spot stale manifolds. */
+    unsigned int m_stepCount;
+
+    /** Contact manifold of each pair of collision primitives in contact. */
+    std::unordered_map<ContactPairKey, ContactManifold> m_manifolds;
+
+    /** Pairs of collision primitives tracked for the collision events. */
+    std::unordered_map<ContactPairKey, CollisionPair> m_collisionPairs;
+
+    /** Layers collision events are reported for. */
+    uint32_t m_collisionEventLayers;
+
+    /** Pair of collision primitives of each contact generated this step. */
+    std::vector<ContactPairKey> m_contactPairs;
+
+    /** Contacts of every manifold point, resolved this step. */
+    std::vector<Contact> m_manifoldContacts;
+
+    /** Manifold point of each contact in m_manifoldContacts. */
+    std::vector<ContactManifoldPoint *> m_manifoldPoints;
+
+    /** Collision primitives, one array per primitive type. */
+    PrimitiveArray m_primitiveArrays[(int)CollisionPrimitiveType::Count];
+
+    /**
+     * Location of every collision primitive, indexed by the slot part of its
+     * id. Slot 0 is never used so that no primitive has id 0.
+     */
+    std::vector<PrimitiveSlot> m_primitiveSlots;
+
+    /** Primitive slots free to be re-used. */
+    std::vector<uint32_t> m_freePrimitiveSlots;
+
+    /** Bounding volume hierarchy of all bounded collision primitives. */
+    AabbTree m_broadphase;
+
+    /** Current bounds of each bounded collision primitive, per frame. */
+    std::vector<PrimitiveBounds> m_primitiveBounds;
+
+    /** Collision primitives with no bounds (planes), per frame. */
+    std::vector<CollisionPrimitiveID> m_unboundedPrimitives;
+
+    /** Pairs found by the broadphase this frame. */
+    std::vector<PotentialContact> m_potentialContacts;
+
+    /**
+     * Double the size of the contact buffer, keeping the contacts generated
+     * before the pair being generated.
+     *
+     * @param   keep   unsigned int, number of contacts to keep.
+     */
+    void growContacts(unsigned int keep);
+
+    /** Number of contacts the contact buffer starts with by default. */
+    const static unsigned int DEFAULT_CONTACT_CAPACITY = 256;
+
+    /** Contacts generated this step, kept from step to step. */
+    std::vector<Contact> m_contacts;
+
+    /** Most contacts resolved in a step, 0 for no limit. */
+    unsigned int m_contactBudget;
+
+    /**
+     * Pair the contacts kept under the budget start from, the first pair
+     * dropped in the last step over budget.
+     */
+    unsigned int m_contactBudgetPair;
+
+    /** Statistics on the contacts generated. */
+    ContactStats m_contactStats;
 
     /** Collision generation structure */
     CollisionData m_collisionData;
@@ -197,5 +1134,28 @@ private:
     // ContactResolver m_contactResolver;
 
     ForceRegistry m_forceRegistry;
+
+    /** Force fields applied to every body, packed. */
+    std::vector<ForceField> m_forceFields;
+
+    /** Id of each force field. */
+    std::vector<ForceFieldID> m_forceFieldIDs;
+
+    /** Id of the last force field added. */
+    ForceFieldID m_currentForceFieldID;
+
+    /**
+     * Pools of the bodies and primitives created by the world. Declared
+     * last, so that pooled bodies are destroyed while m_rigidBodies is still
+     * there for them to leave.
+     */
+    ObjectPool<RigidBody> m_bodyPool;
+    ObjectPool<CollisionBox> m_boxPool;
+    ObjectPool<CollisionSphere> m_spherePool;
+    ObjectPool<CollisionPlane> m_planePool;
+    ObjectPool<CollisionCapsule> m_capsulePool;
+    ObjectPool<CollisionHeightfield> m_heightfieldPool;
+    ObjectPool<CollisionConvexHull> m_convexHullPool;
+    ObjectPool<CollisionCompound> m_compoundPool;
 };
 }
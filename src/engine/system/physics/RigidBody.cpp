@@ -136,47 +136,67 @@ calculateTransformMatrix(ds_math::Matrix4 &transformMatrix,
 
 /// Functions declared in header.
 
+RigidBodyState::RigidBodyState()
+    : centerOfMassOffset(ds_math::Vector3(0.0f, 0.0f, 0.0f)),
+      inverseMass((ds_math::scalar)0.0),
+      linearDamping((ds_math::scalar)0.95),
+      angularDamping((ds_math::scalar)0.8),
+      isAwake(true)
+{
+}
+
 RigidBody::RigidBody()
-    : m_inverseMass((ds_math::scalar)0.0),
-      m_linearDamping((ds_math::scalar)0.95),
-      m_angularDamping((ds_math::scalar)0.8),
-      m_motion((ds_math::scalar)0.0),
-      m_isAwake(true),
+    : m_motion((ds_math::scalar)0.0),
       m_canSleep(true),
-      m_centerOfMassOffset(ds_math::Vector3(0.0f, 0.0f, 0.0f))
+      m_continuousCollision(false),
+      m_pool(nullptr), m_poolIndex(0)
 {
 }
 
-void RigidBody::integrate(ds_math::scalar duration)
+RigidBody::~RigidBody()
 {
-    if (!m_isAwake)
+    if (m_pool != nullptr)
+    {
+        m_pool->remove(m_pool->getHandle(this), false);
+    }
+}
+
+const RigidBodyState &RigidBody::getDefaultState()
+{
+    static const RigidBodyState defaultState;
+    return defaultState;
+}
+
+void RigidBody::integrate(ds_math::scalar duration, bool allowSleep)
+{
+    if (!isAwakeRef())
     {
         return;
     }
 
     // Calculate linear acceleration from force inputs.
-    m_lastFrameAcceleration = m_acceleration;
-    m_lastFrameAcceleration += m_forceAccum * m_inverseMass;
+    lastFrameAccelerationRef() = accelerationRef();
+    lastFrameAccelerationRef() += forceAccumRef() * inverseMassRef();
 
     // Calculate angular acceleration from torque inputs.
-    ds_math::Vector3 angularAcceleration =
-        ds_math::Matrix3::Transform(m_inverseInertiaTensorWorld, m_torqueAccum);
+    ds_math::Vector3 angularAcceleration = ds_math::Matrix3::Transform(
+        inverseInertiaTensorWorldRef(), torqueAccumRef());
 
     /// Update linear velocity from acceleration and impulse.
-    m_velocity += m_lastFrameAcceleration * duration;
+    velocityRef() += lastFrameAccelerationRef() * duration;
 
     // Update angular velocity from acceleration and impulse.
-    m_rotation += angularAcceleration * duration;
+    rotationRef() += angularAcceleration * duration;
 
     // Impose drag.
-    m_velocity *= SCALAR_POW(m_linearDamping, duration);
-    m_rotation *= SCALAR_POW(m_angularDamping, duration);
+    velocityRef() *= SCALAR_POW(linearDampingRef(), duration);
+    rotationRef() *= SCALAR_POW(angularDampingRef(), duration);
 
     // Update linear position.
-    m_position += m_velocity * duration;
+    positionRef() += velocityRef() * duration;
 
     // Update angular position.
-    m_orientation.AddScaledVector(m_rotation, duration);
+    orientationRef().AddScaledVector(rotationRef(), duration);
 
     // Normalize the orientation, and update the matrices with the new
     // position and orientation
@@ -186,23 +206,34 @@ void RigidBody::integrate(ds_math::scalar duration)
     clearAccumulators();
 
     // Update kinetic energy store, and possibly put the body to sleep.
-    if (m_canSleep)
+    if (allowSleep)
     {
-        ds_math::scalar currentMotion =
-            ds_math::Vector3::Dot(m_velocity, m_velocity) +
-            ds_math::Vector3::Dot(m_rotation, m_rotation);
-
-        ds_math::scalar bias = SCALAR_POW(0.5, duration);
-        m_motion = bias * m_motion + (1 - bias) * currentMotion;
+        updateMotion(duration);
 
-        if (m_motion < sleepEpsilon)
+        if (isResting())
         {
             setAwake(false);
         }
-        else if (m_motion > 10 * sleepEpsilon)
-        {
-            m_motion = 10 * sleepEpsilon;
-        }
+    }
+}
+
+void RigidBody::updateMotion(ds_math::scalar duration)
+{
+    if (!m_canSleep)
+    {
+        return;
+    }
+
+    ds_math::scalar currentMotion =
+        ds_math::Vector3::Dot(velocityRef(), velocityRef()) +
+        ds_math::Vector3::Dot(rotationRef(), rotationRef());
+
+    ds_math::scalar bias = SCALAR_POW(0.5, duration);
+    m_motion = bias * m_motion + (1 - bias) * currentMotion;
+
+    if (m_motion > 10 * sleepEpsilon)
+    {
+        m_motion = 10 * sleepEpsilon;
     }
 }
 
@@ -213,22 +244,23 @@ void RigidBody::integrate(ds_math::scalar duration)
 
 void RigidBody::calculateDerivedData()
 {
-    m_orientation.Normalize();
+    orientationRef().Normalize();
 
     // Calculate the transform matrix for the body.
-    calculateTransformMatrix(m_transformMatrix, m_position, m_orientation);
+    calculateTransformMatrix(m_transformMatrix, positionRef(),
+                             orientationRef());
 
     // Calculate the transform matrix for the center of mass of the body
     calculateTransformMatrix(m_centerOfMassTransformMatrix,
-                             (m_position + m_centerOfMassOffset),
-                             m_orientation);
+                             (positionRef() + centerOfMassOffsetRef()),
+                             orientationRef());
 
     // Calculate the inertiaTensor in world space.
     // transformInertiaTensor(m_inverseInertiaTensorWorld, m_orientation,
     //                        m_inverseInertiaTensor,
     //                        m_transformMatrix);
-    transformInertiaTensor(m_inverseInertiaTensorWorld, m_orientation,
-                           m_inverseInertiaTensor,
+    transformInertiaTensor(inverseInertiaTensorWorldRef(), orientationRef(),
+                           inverseInertiaTensorRef(),
                            m_centerOfMassTransformMatrix);
 }
 
@@ -236,45 +268,45 @@ void RigidBody::setMass(const ds_math::scalar mass)
 {
     if (mass == 0)
     {
-        m_inverseMass = 0;
+        inverseMassRef() = 0;
     }
     else
     {
-        m_inverseMass = ((ds_math::scalar)1.0) / mass;
+        inverseMassRef() = ((ds_math::scalar)1.0) / mass;
     }
 }
 
 ds_math::scalar RigidBody::getMass() const
 {
-    if (m_inverseMass == 0)
+    if (inverseMassRef() == 0)
     {
         return 0;
     }
     else
     {
-        return ((ds_math::scalar)1.0) / m_inverseMass;
+        return ((ds_math::scalar)1.0) / inverseMassRef();
     }
 }
 
 void RigidBody::setInverseMass(const ds_math::scalar inverseMass)
 {
-    m_inverseMass = inverseMass;
+    inverseMassRef() = inverseMass;
 }
 
 ds_math::scalar RigidBody::getInverseMass() const
 {
-    return m_inverseMass;
+    return inverseMassRef();
 }
 
 bool RigidBody::hasFiniteMass() const
 {
-    return m_inverseMass > 0.0f;
+    return inverseMassRef() > 0.0f;
 }
 
 void RigidBody::setInertiaTensor(const ds_math::Matrix3 &inertiaTensor)
 {
-    m_inverseInertiaTensor = ds_math::Matrix3::Inverse(inertiaTensor);
-    checkInverseInertiaTensor(m_inverseInertiaTensor);
+    inverseInertiaTensorRef() = ds_math::Matrix3::Inverse(inertiaTensor);
+    checkInverseInertiaTensor(inverseInertiaTensorRef());
 }
 
 void RigidBody::setInertiaTensor(const ds_math::Vector3 &inertiaTensor)
@@ -285,8 +317,8 @@ void RigidBody::setInertiaTensor(const ds_math::Vector3 &inertiaTensor)
     inertiaTensorMat[1][1] = inertiaTensor.y;
     inertiaTensorMat[2][2] = inertiaTensor.z;
 
-    m_inverseInertiaTensor = ds_math::Matrix3::Inverse(inertiaTensorMat);
-    checkInverseInertiaTensor(m_inverseInertiaTensor);
+    inverseInertiaTensorRef() = ds_math::Matrix3::Inverse(inertiaTensorMat);
+    checkInverseInertiaTensor(inverseInertiaTensorRef());
 }
 
 void RigidBody::setInverseInertiaTensor(
@@ -298,14 +330,14 @@ void RigidBody::setInverseInertiaTensor(
     invInertiaTensorMat[1][1] = invInertiaTensor.y;
     invInertiaTensorMat[2][2] = invInertiaTensor.z;
 
-    m_inverseInertiaTensor = invInertiaTensorMat;
-    checkInverseInertiaTensor(m_inverseInertiaTensor);
+    inverseInertiaTensorRef() = invInertiaTensorMat;
+    checkInverseInertiaTensor(inverseInertiaTensorRef());
 }
 
 ds_math::Vector3 RigidBody::getInertiaTensorProducts() const
 {
     ds_math::Matrix3 inertiaTensor =
-        ds_math::Matrix3::Inverse(m_inverseInertiaTensor);
+        ds_math::Matrix3::Inverse(inverseInertiaTensorRef());
 
     return ds_math::Vector3(inertiaTensor[0][0], inertiaTensor[1][1],
                             inertiaTensor[2][2]);
@@ -315,7 +347,7 @@ void RigidBody::getInertiaTensor(ds_math::Matrix3 *inertiaTensor) const
 {
     assert(inertiaTensor != nullptr);
 
-    *inertiaTensor = ds_math::Matrix3::Inverse(m_inverseInertiaTensor);
+    *inertiaTensor = ds_math::Matrix3::Inverse(inverseInertiaTensorRef());
 }
 
 ds_math::Matrix3 RigidBody::getInertiaTensor() const
@@ -331,7 +363,7 @@ void RigidBody::getInertiaTensorWorld(ds_math::Matrix3 *inertiaTensor) const
 {
     assert(inertiaTensor != nullptr);
 
-    *inertiaTensor = ds_math::Matrix3::Inverse(m_inverseInertiaTensorWorld);
+    *inertiaTensor = ds_math::Matrix3::Inverse(inverseInertiaTensorWorldRef());
 }
 
 ds_math::Matrix3 RigidBody::getInertiaTensorWorld() const
@@ -345,7 +377,7 @@ void RigidBody::setInverseInertiaTensor(
     const ds_math::Matrix3 &inverseInertiaTensor)
 {
     checkInverseInertiaTensor(inverseInertiaTensor);
-    m_inverseInertiaTensor = inverseInertiaTensor;
+    inverseInertiaTensorRef() = inverseInertiaTensor;
 }
 
 void RigidBody::getInverseInertiaTensor(
@@ -353,12 +385,12 @@ void RigidBody::getInverseInertiaTensor(
 {
     assert(inverseInertiaTensor != nullptr);
 
-    *inverseInertiaTensor = m_inverseInertiaTensor;
+    *inverseInertiaTensor = inverseInertiaTensorRef();
 }
 
 ds_math::Matrix3 RigidBody::getInverseInertiaTensor() const
 {
-    return m_inverseInertiaTensor;
+    return inverseInertiaTensorRef();
 }
 
 void RigidBody::getInverseInertiaTensorWorld(
@@ -366,71 +398,71 @@ void RigidBody::getInverseInertiaTensorWorld(
 {
     assert(inverseInertiaTensor != nullptr);
 
-    *inverseInertiaTensor = m_inverseInertiaTensorWorld;
+    *inverseInertiaTensor = inverseInertiaTensorWorldRef();
 }
 
 ds_math::Matrix3 RigidBody::getInverseInertiaTensorWorld() const
 {
-    return m_inverseInertiaTensorWorld;
+    return inverseInertiaTensorWorldRef();
 }
 
 void RigidBody::setDamping(const ds_math::scalar linearDamping,
                            const ds_math::scalar angularDamping)
 {
-    m_linearDamping = linearDamping;
-    m_angularDamping = angularDamping;
+    linearDampingRef() = linearDamping;
+    angularDampingRef() = angularDamping;
 }
 
 void RigidBody::setLinearDamping(const ds_math::scalar linearDamping)
 {
-    m_linearDamping = linearDamping;
+    linearDampingRef() = linearDamping;
 }
 
 ds_math::scalar RigidBody::getLinearDamping() const
 {
-    return m_linearDamping;
+    return linearDampingRef();
 }
 
 void RigidBody::setAngularDamping(const ds_math::scalar angularDamping)
 {
-    m_angularDamping = angularDamping;
+    angularDampingRef() = angularDamping;
 }
 
 ds_math::scalar RigidBody::getAngularDamping() const
 {
-    return m_angularDamping;
+    return angularDampingRef();
 }
 
 void RigidBody::setPosition(const ds_math::Vector3 &position)
 {
-    m_position = position;
+    positionRef() = position;
 }
 
 void RigidBody::setPosition(const ds_math::scalar x,
                             const ds_math::scalar y,
                             const ds_math::scalar z)
 {
-    m_position.x = x;
-    m_position.y = y;
-    m_position.z = z;
+    positionRef().x = x;
+    positionRef().y = y;
+    positionRef().z = z;
 }
 
 void RigidBody::getPosition(ds_math::Vector3 *position) const
 {
     assert(position != nullptr);
 
-    *position = m_position;
+    *position = positionRef();
 }
 
 ds_math::Vector3 RigidBody::getPosition() const
 {
-    return m_position;
+    return positionRef();
 }
 
 void RigidBody::setOrientation(const ds_math::Quaternion &orientation)
 {
-    m_orientation = orientation;
-    m_orientation.Normalize();
+    orientationRef() = orientation;
+    orientationRef().Normalize();
 }
 
 void RigidBody::setOrientation(const ds_math::scalar r,
@@ -438,23 +470,23 @@ void RigidBody::setOrientation(const ds_math::scalar r,
                                const ds_math::scalar j,
                                const ds_math::scalar k)
 {
-    m_orientation.w = r;
-    m_orientation.x = i;
-    m_orientation.y = j;
-    m_orientation.z = k;
-    m_orientation.Normalize();
+    orientationRef().w = r;
+    orientationRef().x = i;
+    orientationRef().y = j;
+    orientationRef().z = k;
+    orientationRef().Normalize();
 }
 
 void RigidBody::getOrientation(ds_math::Quaternion *orientation) const
 {
     assert(orientation != nullptr);
 
-    *orientation = m_orientation;
+    *orientation = orientationRef();
 }
 
 ds_math::Quaternion RigidBody::getOrientation() const
 {
-    return m_orientation;
+    return orientationRef();
 }
 
 void RigidBody::getOrientation(ds_math::Matrix3 *matrix) const
@@ -525,7 +557,8 @@ ds_math::Matrix4 RigidBody::getTransform() const
 ds_math::Vector3
 RigidBody::getPointInLocalSpace(const ds_math::Vector3 &point) const
 {
-    return ds_math::Matrix4::TransformInverse(m_transformMatrix, point);
+    return ds_math::Matrix4::Transform(
+        ds_math::Matrix4::RigidInverse(m_transformMatrix), point);
 }
 
 ds_math::Vector3
@@ -549,80 +582,80 @@ RigidBody::getDirectionInWorldSpace(const ds_math::Vector3 &direction) const
 
 void RigidBody::setVelocity(const ds_math::Vector3 &velocity)
 {
-    m_velocity = velocity;
+    velocityRef() = velocity;
 }
 
 void RigidBody::setVelocity(const ds_math::scalar x,
                             const ds_math::scalar y,
                             const ds_math::scalar z)
 {
-    m_velocity.x = x;
-    m_velocity.y = y;
-    m_velocity.z = z;
+    velocityRef().x = x;
+    velocityRef().y = y;
+    velocityRef().z = z;
 }
 
 void RigidBody::getVelocity(ds_math::Vector3 *velocity) const
 {
     assert(velocity != nullptr);
 
-    *velocity = m_velocity;
+    *velocity = velocityRef();
 }
 
 ds_math::Vector3 RigidBody::getVelocity() const
 {
-    return m_velocity;
+    return velocityRef();
 }
 
 void RigidBody::addVelocity(const ds_math::Vector3 &deltaVelocity)
 {
-    m_velocity += deltaVelocity;
+    velocityRef() += deltaVelocity;
 }
 
 void RigidBody::setRotation(const ds_math::Vector3 &rotation)
 {
-    m_rotation = rotation;
+    rotationRef() = rotation;
 }
 
 void RigidBody::setRotation(const ds_math::scalar x,
                             const ds_math::scalar y,
                             const ds_math::scalar z)
 {
-    m_rotation.x = x;
-    m_rotation.y = y;
-    m_rotation.z = z;
+    rotationRef().x = x;
+    rotationRef().y = y;
+    rotationRef().z = z;
 }
 
 void RigidBody::getRotation(ds_math::Vector3 *rotation) const
 {
     assert(rotation != nullptr);
 
-    *rotation = m_rotation;
+    *rotation = rotationRef();
 }
 
 ds_math::Vector3 RigidBody::getRotation() const
 {
-    return m_rotation;
+    return rotationRef();
 }
 
 void RigidBody::addRotation(const ds_math::Vector3 &deltaRotation)
 {
-    m_rotation += deltaRotation;
+    rotationRef() += deltaRotation;
 }
 
 void RigidBody::setAwake(const bool awake)
 {
     if (awake)
     {
-        m_isAwake = true;
+        isAwakeRef() = true;
 
         // Add a bit of motion to avoid it falling asleep immediately.
         m_motion = sleepEpsilon * 2.0f;
     }
     else
     {
-        m_isAwake = false;
-        m_velocity.Clear();
-        m_rotation.Clear();
+        isAwakeRef() = false;
+        velocityRef().Clear();
+        rotationRef().Clear();
     }
 }
 
@@ -630,33 +663,41 @@ void RigidBody::setCanSleep(const bool canSleep)
 {
     m_canSleep = canSleep;
 
-    if (!m_canSleep && !m_isAwake)
+    if (!m_canSleep && !isAwakeRef())
         setAwake();
 }
 
+bool RigidBody::isResting() const
+{
+    return m_canSleep && m_motion < sleepEpsilon;
+}
+
 
 void RigidBody::getLastFrameAcceleration(ds_math::Vector3 *acceleration) const
 {
     assert(acceleration != nullptr);
 
-    *acceleration = m_lastFrameAcceleration;
+    *acceleration = lastFrameAccelerationRef();
 }
 
 ds_math::Vector3 RigidBody::getLastFrameAcceleration() const
 {
-    return m_lastFrameAcceleration;
+    return lastFrameAccelerationRef();
 }
 
 void RigidBody::clearAccumulators()
 {
-    m_forceAccum.Clear();
-    m_torqueAccum.Clear();
+    forceAccumRef().Clear();
+    torqueAccumRef().Clear();
 }
 
 void RigidBody::addForce(const ds_math::Vector3 &force)
 {
-    m_forceAccum += force;
-    m_isAwake = true;
+    forceAccumRef() += force;
+    if (!isAwakeRef())
+    {
+        setAwake();
+    }
 }
 
 void RigidBody::addForceAtBodyPoint(const ds_math::Vector3 &force,
@@ -673,42 +714,48 @@ void RigidBody::addForceAtPoint(const ds_math::Vector3 &force,
     // Convert to coordinates relative to center of mass.
     ds_math::Vector3 pt = point;
     // pt -= (m_position);
-    pt -= (m_position + m_centerOfMassOffset);
+    pt -= (positionRef() + centerOfMassOffsetRef());
 
-    m_forceAccum += force;
-    m_torqueAccum += ds_math::Vector3::Cross(pt, force);
+    forceAccumRef() += force;
+    torqueAccumRef() += ds_math::Vector3::Cross(pt, force);
 
-    m_isAwake = true;
+    if (!isAwakeRef())
+    {
+        setAwake();
+    }
 }
 
 void RigidBody::addTorque(const ds_math::Vector3 &torque)
 {
-    m_torqueAccum += torque;
-    m_isAwake = true;
+    torqueAccumRef() += torque;
+    if (!isAwakeRef())
+    {
+        setAwake();
+    }
 }
 
 void RigidBody::setAcceleration(const ds_math::Vector3 &acceleration)
 {
-    m_acceleration = acceleration;
+    accelerationRef() = acceleration;
 }
 
 void RigidBody::setAcceleration(const ds_math::scalar x,
                                 const ds_math::scalar y,
                                 const ds_math::scalar z)
 {
-    m_acceleration.x = x;
-    m_acceleration.y = y;
-    m_acceleration.z = z;
+    accelerationRef().x = x;
+    accelerationRef().y = y;
+    accelerationRef().z = z;
 }
 
 void RigidBody::getAcceleration(ds_math::Vector3 *acceleration) const
 {
-    *acceleration = m_acceleration;
+    *acceleration = accelerationRef();
 }
 
 ds_math::Vector3 RigidBody::getAcceleration() const
 {
-    return m_acceleration;
+    return accelerationRef();
 }
 
 
@@ -762,21 +809,21 @@ unsigned RigidBody::getCollisionPrimitiveCount()
 
 ds_math::Vector3 RigidBody::getCenterOfMassWorldSpace() const
 {
-    return (m_position + m_centerOfMassOffset);
+    return (positionRef() + centerOfMassOffsetRef());
 }
 
 ds_math::Vector3 RigidBody::getCenterOfMassLocalSpace() const
 {
-    return m_centerOfMassOffset;
+    return centerOfMassOffsetRef();
 }
 
 void RigidBody::setCenterOfMassWorldSpace(const ds_math::Vector3 &centerOfMass)
 {
-    m_centerOfMassOffset = centerOfMass - m_position;
+    centerOfMassOffsetRef() = centerOfMass - positionRef();
 }
 
 void RigidBody::setCenterOfMassLocalSpace(const ds_math::Vector3 &centerOfMass)
 {
-    m_centerOfMassOffset = centerOfMass;
+    centerOfMassOffsetRef() = centerOfMass;
 }
 }
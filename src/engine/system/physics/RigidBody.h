@@ -34,12 +34,113 @@
 #include "math/Precision.h"
 #include "math/Quaternion.h"
 #include "math/Vector3.h"
+#include "engine/system/physics/RigidBodyPool.h"
+#include <memory>
 #include <vector>
 
 namespace ds_phys
 {
 class CollisionPrimitive;
 
+/**
+ * State of a rigid body read and written every step. A RigidBodyPool keeps
+ * one array per field for the bodies in it, a body outside a pool holds its
+ * own.
+ *
+ * @see RigidBody
+ */
+struct RigidBodyState
+{
+    /**
+     * RigidBodyState constructor, the state of a new rigid body.
+     */
+    RigidBodyState();
+
+    ///
+    /// Holds the linear position of the rigid body in world space
+    ///
+    ds_math::Vector3 position;
+
+    ///
+    /// Holds the angular orientation of the rigid body in world space
+    ///
+    ds_math::Quaternion orientation;
+
+    ///
+    /// Holds the linear velocity of the rigid body in world space
+    ///
+    ds_math::Vector3 velocity;
+
+    ///
+    /// Holds the angular velocity (rotation) of the rigid body in world space
+    ///
+    ds_math::Vector3 rotation;
+
+    ///
+    /// Holds accumulated force to be applied at the next integration step
+    ///
+    ds_math::Vector3 forceAccum;
+
+    ///
+    /// Holds the accumulated torque to be applied at the next integration step
+    ///
+    ds_math::Vector3 torqueAccum;
+
+    ///
+    /// Holds acceleration of the rigid body
+    /// This value can be used to set acceleration due to gravity (primary use)
+    /// or other acceleration
+    ///
+    ds_math::Vector3 acceleration;
+
+    ///
+    /// Holds the linear acceleration of the rigid body for previous frame
+    ///
+    ds_math::Vector3 lastFrameAcceleration;
+
+    ///
+    /// Holds the inverse intertia tensor of the rigid body in world space
+    ///
+    ds_math::Matrix3 inverseInertiaTensorWorld;
+
+    ///
+    /// Holds inverse of rigid body inertia tensor
+    /// Must not degenerate (have zero inertia along one axis)
+    /// Is given in body space (unlike other rigid body variables)
+    ///
+    ds_math::Matrix3 inverseInertiaTensor;
+
+    ///
+    /// Centre of mass of the rigid body relative to the position of the object.
+    ///
+    ds_math::Vector3 centerOfMassOffset;
+
+    ///
+    /// Holds inverse mass of rigid body
+    /// Inverse is one over mass, makes intergration simpler
+    /// More useful to have infinite mass than zero mass
+    ///
+    ds_math::scalar inverseMass;
+
+    ///
+    /// Holds amount of damping applied to linear motion
+    /// Required to remove energy added through numerical instability to the
+    /// integrator
+    ///
+    ds_math::scalar linearDamping;
+
+    ///
+    /// Holds amount of damping applied to angular motion
+    ///
+    ds_math::scalar angularDamping;
+
+    ///
+    /// Can be put to sleep to avoid being updated by integration functions
+    /// or effected by collisions with the world
+    ///
+    uint8_t isAwake;
+};
+
 /**
  * Rigid body class.
  */
@@ -48,6 +149,16 @@ class RigidBody
 public:
     RigidBody();
 
+    /**
+     * RigidBody destructor, takes the body out of any pool it is still in.
+     * A body in a world should be removed from the world first.
+     */
+    ~RigidBody();
+
+    // A body in a pool shares its state with it, so can't be copied
+    RigidBody(const RigidBody &) = delete;
+    RigidBody &operator=(const RigidBody &) = delete;
+
     /**
      * @name Integration and Simulation Functions
      *
@@ -75,7 +186,21 @@ public:
     /// Uses a Newton-Euler integration method - linear approximation.
     /// May be innacurate in some cases.
     ///
-    void integrate(ds_math::scalar duration);
+    /// @param duration The time to integrate over.
+    /// @param allowSleep If false the body's motion is not updated and the
+    /// body is not put to sleep, the caller is expected to call updateMotion
+    /// itself (the physics world does so once contacts are resolved, then
+    /// puts whole islands to sleep at once).
+    ///
+    void integrate(ds_math::scalar duration, bool allowSleep = true);
+
+    ///
+    /// Updates the recency-weighted average of the body's kinetic energy
+    /// used to decide when it may sleep.
+    ///
+    /// @param duration The time since the motion was last updated.
+    ///
+    void updateMotion(ds_math::scalar duration);
 
     /*@}*/
 
@@ -615,7 +740,7 @@ public:
     ///
     bool getAwake() const
     {
-        return m_isAwake;
+        return isAwakeRef() != 0;
     }
 
     ///
@@ -647,6 +772,33 @@ public:
     ///
     void setCanSleep(const bool canSleep = true);
 
+    ///
+    /// Returns true if the body is swept along its path each step so that
+    /// it can't pass through thin objects.
+    ///
+    bool getContinuousCollision() const
+    {
+        return m_continuousCollision;
+    }
+
+    ///
+    /// Sets whether the body is swept along its path each step. Only fast
+    /// bodies, such as projectiles, need to be, as bodies moving less than
+    /// their own size in a step are always caught.
+    ///
+    /// @param continuousCollision Whether the body is swept.
+    ///
+    void setContinuousCollision(const bool continuousCollision = true)
+    {
+        m_continuousCollision = continuousCollision;
+    }
+
+    ///
+    /// Returns true if the body can sleep and its recent motion has
+    /// dropped below the sleep threshold.
+    ///
+    bool isResting() const;
+
     /*@}*/
 
 
@@ -860,71 +1012,13 @@ protected:
          */
     /*@{*/
 
-
-    ///
-    /// Holds inverse mass of rigid body
-    /// Inverse is one over mass, makes intergration simpler
-    /// More useful to have infinite mass than zero mass
-    ///
-    ds_math::scalar m_inverseMass;
-
-    ///
-    /// Holds inverse of rigid body inertia tensor
-    /// Must not degenerate (have zero inertia along one axis)
-    /// Used for similar reasons than inverse mass
-    /// Is given in body space (unlike other rigid body variables)
-    ///
-    ds_math::Matrix3 m_inverseInertiaTensor;
-
-    ///
-    /// Holds amount of damping applied to linear motion
-    /// Required to remove energy added through numerical instability to the
-    /// integrator
-    ///
-    ///
-    ///
-    ds_math::scalar m_linearDamping;
-
-    ///
-    /// Holds amount of damping applied to angular motion
-    /// Required to remove energy added through numerical instability to the
-    /// integrator
     ///
+    /// State of the body while it isn't in a pool, see RigidBodyState.
+    /// nullptr while the body is in a pool, and until the state of a body
+    /// outside one is first changed, when it has the default state. Bodies
+    /// in a pool don't carry a copy of their state.
     ///
-    ///
-    ds_math::scalar m_angularDamping;
-
-    ///
-    /// Holds the linear position of the rigid body in world space
-    ///
-    ///
-    ///
-    ///
-    ds_math::Vector3 m_position;
-
-    ///
-    /// Holds the angular orientation of the rigid body in world space
-    ///
-    ///
-    ///
-    ///
-    ds_math::Quaternion m_orientation;
-
-    ///
-    /// Holds the linear velocity of the rigid body in world space
-    ///
-    ///
-    ///
-    ///
-    ds_math::Vector3 m_velocity;
-
-    ///
-    /// Holds the angular velocity (rotation) of the rigid body in world space
-    ///
-    ///
-    ///
-    ///
-    ds_math::Vector3 m_rotation;
+    std::unique_ptr<RigidBodyState> m_state;
 
     /*@}*/
 
@@ -937,14 +1031,6 @@ protected:
         */
     /*@{*/
 
-    ///
-    /// Holds the inverse intertia tensor of the rigid body in world space
-    /// Inverse intertia tensor is specified in rigid body's local space
-    ///
-    ///
-    ///
-    ds_math::Matrix3 m_inverseInertiaTensorWorld;
-
     ///
     /// Holds the amount  of motion of the body
     /// Recency weighted mean that can be used to put the body to sleep
@@ -953,14 +1039,6 @@ protected:
     ///
     ds_math::scalar m_motion;
 
-    ///
-    /// Can be put to sleep to avoid being updated by integration functions
-    /// or effected by collisions with the world
-    ///
-    ///
-    ///
-    bool m_isAwake;
-
     ///
     /// Some rigid bodies may never be asleep
     /// @Example - User controlled bodies should always be awake
@@ -969,6 +1047,11 @@ protected:
     ///
     bool m_canSleep;
 
+    ///
+    /// Whether the body is swept along its path each step
+    ///
+    bool m_continuousCollision;
+
     ///
     /// Holds transform matrix for converting body space into world space (and
     /// vice versa)
@@ -983,58 +1066,220 @@ protected:
     /*@}*/
 
 
-    /**
-        * @name Force and Torque Accumulators
-        *
-        * These data members store the current force, torque and
-        * acceleration of the rigid body. Forces can be added to the
-        * rigid body in any order, and the class decomposes them into
-        * their constituents, accumulating them for the next
-        * simulation step. At the simulation step, the accelerations
-        * are calculated and stored to be applied to the rigid body.
-        */
-    /*@{*/
+    ds_math::Matrix4 m_centerOfMassTransformMatrix;
 
     ///
-    /// Holds accumulated force to be applied at the next integration step
+    /// Pool holding the body's state while it is in one, nullptr
+    /// otherwise.
     ///
+    /// @see RigidBodyPool
     ///
-    ///
-    ///
-    ds_math::Vector3 m_forceAccum;
+    RigidBodyPool *m_pool;
 
     ///
-    /// Holds the accumulated torque to be applied at the next integration step
-    ///
+    /// Index of the body in m_pool.
     ///
-    ///
-    ///
-    ds_math::Vector3 m_torqueAccum;
+    unsigned int m_poolIndex;
 
-    ///
-    /// Holds acceleration of the rigid body
-    /// This value can be used to set acceleration due to gravity (primary use)
-    /// or other acceleration
-    ///
-    ///
-    ds_math::Vector3 m_acceleration;
+private:
+    friend class RigidBodyPool;
 
     ///
-    /// Holds the linear acceleration of the rigid body for previous frame
-    ///
+    /// Get the state a body has until it is changed.
     ///
+    static const RigidBodyState &getDefaultState();
+
     ///
+    /// Get a field of the body's state, from its pool if it is in one.
+    /// Outside a pool, the body is given its own state the first time it is
+    /// changed.
     ///
-    ds_math::Vector3 m_lastFrameAcceleration;
-    /*@}*/
+    template <typename T>
+    T &stateRef(std::vector<T> RigidBodyPool::*column,
+                T RigidBodyState::*field)
+    {
+        if (m_pool != nullptr)
+        {
+            return (m_pool->*column)[m_poolIndex];
+        }
+        if (m_state == nullptr)
+        {
+            m_state.reset(new RigidBodyState(getDefaultState()));
+        }
+        return (*m_state).*field;
+    }
+
+    template <typename T>
+    const T &stateRef(std::vector<T> RigidBodyPool::*column,
+                      T RigidBodyState::*field) const
+    {
+        if (m_pool != nullptr)
+        {
+            return (m_pool->*column)[m_poolIndex];
+        }
+        return (m_state != nullptr ? *m_state : getDefaultState()).*field;
+    }
 
     ///
-    /// Centre of mass of the rigid body relative to the position of the object.
+    /// Fields of the body's state, wherever they are held.
     ///
-    ds_math::Vector3 m_centerOfMassOffset;
+    ds_math::Vector3 &positionRef()
+    {
+        return stateRef(&RigidBodyPool::m_positions, &RigidBodyState::position);
+    }
+    const ds_math::Vector3 &positionRef() const
+    {
+        return stateRef(&RigidBodyPool::m_positions, &RigidBodyState::position);
+    }
 
-    ds_math::Matrix4 m_centerOfMassTransformMatrix;
+    ds_math::Quaternion &orientationRef()
+    {
+        return stateRef(&RigidBodyPool::m_orientations,
+                        &RigidBodyState::orientation);
+    }
+    const ds_math::Quaternion &orientationRef() const
+    {
+        return stateRef(&RigidBodyPool::m_orientations,
+                        &RigidBodyState::orientation);
+    }
 
-private:
+    ds_math::Vector3 &velocityRef()
+    {
+        return stateRef(&RigidBodyPool::m_velocities,
+                        &RigidBodyState::velocity);
+    }
+    const ds_math::Vector3 &velocityRef() const
+    {
+        return stateRef(&RigidBodyPool::m_velocities,
+                        &RigidBodyState::velocity);
+    }
+
+    ds_math::Vector3 &rotationRef()
+    {
+        return stateRef(&RigidBodyPool::m_rotations, &RigidBodyState::rotation);
+    }
+    const ds_math::Vector3 &rotationRef() const
+    {
+        return stateRef(&RigidBodyPool::m_rotations, &RigidBodyState::rotation);
+    }
+
+    ds_math::Vector3 &forceAccumRef()
+    {
+        return stateRef(&RigidBodyPool::m_forceAccums,
+                        &RigidBodyState::forceAccum);
+    }
+    const ds_math::Vector3 &forceAccumRef() const
+    {
+        return stateRef(&RigidBodyPool::m_forceAccums,
+                        &RigidBodyState::forceAccum);
+    }
+
+    ds_math::Vector3 &torqueAccumRef()
+    {
+        return stateRef(&RigidBodyPool::m_torqueAccums,
+                        &RigidBodyState::torqueAccum);
+    }
+    const ds_math::Vector3 &torqueAccumRef() const
+    {
+        return stateRef(&RigidBodyPool::m_torqueAccums,
+                        &RigidBodyState::torqueAccum);
+    }
+
+    ds_math::Vector3 &accelerationRef()
+    {
+        return stateRef(&RigidBodyPool::m_accelerations,
+                        &RigidBodyState::acceleration);
+    }
+    const ds_math::Vector3 &accelerationRef() const
+    {
+        return stateRef(&RigidBodyPool::m_accelerations,
+                        &RigidBodyState::acceleration);
+    }
+
+    ds_math::Vector3 &lastFrameAccelerationRef()
+    {
+        return stateRef(&RigidBodyPool::m_lastFrameAccelerations,
+                        &RigidBodyState::lastFrameAcceleration);
+    }
+    const ds_math::Vector3 &lastFrameAccelerationRef() const
+    {
+        return stateRef(&RigidBodyPool::m_lastFrameAccelerations,
+                        &RigidBodyState::lastFrameAcceleration);
+    }
+
+    ds_math::Matrix3 &inverseInertiaTensorRef()
+    {
+        return stateRef(&RigidBodyPool::m_inverseInertiaTensors,
+                        &RigidBodyState::inverseInertiaTensor);
+    }
+    const ds_math::Matrix3 &inverseInertiaTensorRef() const
+    {
+        return stateRef(&RigidBodyPool::m_inverseInertiaTensors,
+                        &RigidBodyState::inverseInertiaTensor);
+    }
+
+    ds_math::Matrix3 &inverseInertiaTensorWorldRef()
+    {
+        return stateRef(&RigidBodyPool::m_inverseInertiaTensorsWorld,
+                        &RigidBodyState::inverseInertiaTensorWorld);
+    }
+    const ds_math::Matrix3 &inverseInertiaTensorWorldRef() const
+    {
+        return stateRef(&RigidBodyPool::m_inverseInertiaTensorsWorld,
+                        &RigidBodyState::inverseInertiaTensorWorld);
+    }
+
+    ds_math::scalar &inverseMassRef()
+    {
+        return stateRef(&RigidBodyPool::m_inverseMasses,
+                        &RigidBodyState::inverseMass);
+    }
+    const ds_math::scalar &inverseMassRef() const
+    {
+        return stateRef(&RigidBodyPool::m_inverseMasses,
+                        &RigidBodyState::inverseMass);
+    }
+
+    ds_math::scalar &linearDampingRef()
+    {
+        return stateRef(&RigidBodyPool::m_linearDampings,
+                        &RigidBodyState::linearDamping);
+    }
+    const ds_math::scalar &linearDampingRef() const
+    {
+        return stateRef(&RigidBodyPool::m_linearDampings,
+                        &RigidBodyState::linearDamping);
+    }
+
+    ds_math::scalar &angularDampingRef()
+    {
+        return stateRef(&RigidBodyPool::m_angularDampings,
+                        &RigidBodyState::angularDamping);
+    }
+    const ds_math::scalar &angularDampingRef() const
+    {
+        return stateRef(&RigidBodyPool::m_angularDampings,
+                        &RigidBodyState::angularDamping);
+    }
+
+    ds_math::Vector3 &centerOfMassOffsetRef()
+    {
+        return stateRef(&RigidBodyPool::m_centerOfMassOffsets,
+                        &RigidBodyState::centerOfMassOffset);
+    }
+    const ds_math::Vector3 &centerOfMassOffsetRef() const
+    {
+        return stateRef(&RigidBodyPool::m_centerOfMassOffsets,
+                        &RigidBodyState::centerOfMassOffset);
+    }
+
+    uint8_t &isAwakeRef()
+    {
+        return stateRef(&RigidBodyPool::m_awake, &RigidBodyState::isAwake);
+    }
+    const uint8_t &isAwakeRef() const
+    {
+        return stateRef(&RigidBodyPool::m_awake, &RigidBodyState::isAwake);
+    }
 };
 }
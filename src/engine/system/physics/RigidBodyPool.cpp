@@ -0,0 +1,769 @@
+#include <cassert>
+
+#include "engine/system/physics/ForceGenerator.h"
+#include "engine/system/physics/RigidBody.h"
+#include "engine/system/physics/RigidBodyPool.h"
+#include "math/Simd.h"
+
+namespace ds_phys
+{
+RigidBodyPool::~RigidBodyPool()
+{
+    while (!m_bodies.empty())
+    {
+        remove(m_handles.back());
+    }
+}
+
+RigidBodyHandle RigidBodyPool::add(RigidBody *body)
+{
+    assert(body != nullptr && body->m_pool == nullptr);
+
+    // Re-use a free slot if there is one, its generation was moved on when
+    // it was freed
+    uint32_t slot;
+    if (!m_freeSlots.empty())
+    {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    }
+    else
+    {
+        slot = (uint32_t)m_slotIndices.size();
+        assert(slot <= RigidBodyHandle::INDEX_MASK);
+        m_slotIndices.push_back(0);
+        m_slotGenerations.push_back(0);
+    }
+
+    uint32_t index = (uint32_t)m_bodies.size();
+    m_slotIndices[slot] = index;
+
+    RigidBodyHandle handle;
+    handle.id = ((uint32_t)m_slotGenerations[slot]
+                 << RigidBodyHandle::INDEX_BITS) |
+                slot;
+
+    m_bodies.push_back(body);
+    m_handles.push_back(handle);
+
+    const RigidBodyState &state = body->m_state != nullptr
+                                      ? *body->m_state
+                                      : RigidBody::getDefaultState();
+    m_positions.push_back(state.position);
+    m_orientations.push_back(state.orientation);
+    m_velocities.push_back(state.velocity);
+    m_rotations.push_back(state.rotation);
+    m_forceAccums.push_back(state.forceAccum);
+    m_torqueAccums.push_back(state.torqueAccum);
+    m_accelerations.push_back(state.acceleration);
+    m_lastFrameAccelerations.push_back(state.lastFrameAcceleration);
+    m_inverseInertiaTensorsWorld.push_back(state.inverseInertiaTensorWorld);
+    m_inverseInertiaTensors.push_back(state.inverseInertiaTensor);
+    m_centerOfMassOffsets.push_back(state.centerOfMassOffset);
+    m_inverseMasses.push_back(state.inverseMass);
+    m_linearDampings.push_back(state.linearDamping);
+    m_angularDampings.push_back(state.angularDamping);
+    m_awake.push_back(state.isAwake);
+
+    // The pool holds the body's state from now on
+    body->m_state.reset();
+    body->m_pool = this;
+    body->m_poolIndex = index;
+
+    return handle;
+}
+
+// Move the element at one index of a column to another and drop the last
+template <typename T>
+static void moveAndPop(std::vector<T> &column, unsigned int to,
+                       unsigned int from)
+{
+    column[to] = column[from];
+    column.pop_back();
+}
+
+RigidBody *RigidBodyPool::remove(RigidBodyHandle handle, bool keepState)
+{
+    RigidBody *body = get(handle);
+    if (body == nullptr)
+    {
+        return nullptr;
+    }
+
+    unsigned int index = body->m_poolIndex;
+
+    // Hand the body its state back
+    if (keepState)
+    {
+        RigidBodyState *state = new RigidBodyState();
+        state->position = m_positions[index];
+        state->orientation = m_orientations[index];
+        state->velocity = m_velocities[index];
+        state->rotation = m_rotations[index];
+        state->forceAccum = m_forceAccums[index];
+        state->torqueAccum = m_torqueAccums[index];
+        state->acceleration = m_accelerations[index];
+        state->lastFrameAcceleration = m_lastFrameAccelerations[index];
+        state->inverseInertiaTensorWorld = m_inverseInertiaTensorsWorld[index];
+        state->inverseInertiaTensor = m_inverseInertiaTensors[index];
+        state->centerOfMassOffset = m_centerOfMassOffsets[index];
+        state->inverseMass = m_inverseMasses[index];
+        state->linearDamping = m_linearDampings[index];
+        state->angularDamping = m_angularDampings[index];
+        state->isAwake = m_awake[index];
+        body->m_state.reset(state);
+    }
+    body->m_pool = nullptr;
+    body->m_poolIndex = 0;
+
+    // Free the slot, moving its generation on so that old handles to it are
+    // no longer valid
+    uint32_t slot = handle.getIndex();
+    m_slotGenerations[slot] = (uint8_t)((m_slotGenerations[slot] + 1) &
+                                        RigidBodyHandle::GENERATION_MASK);
+    m_freeSlots.push_back(slot);
+
+    // Fill the gap with the last body
+    unsigned int last = (unsigned int)m_bodies.size() - 1;
+    if (index != last)
+    {
+        m_bodies[last]->m_poolIndex = index;
+        m_slotIndices[m_handles[last].getIndex()] = index;
+    }
+
+    moveAndPop(m_bodies, index, last);
+    moveAndPop(m_handles, index, last);
+    moveAndPop(m_positions, index, last);
+    moveAndPop(m_orientations, index, last);
+    moveAndPop(m_velocities, index, last);
+    moveAndPop(m_rotations, index, last);
+    moveAndPop(m_forceAccums, index, last);
+    moveAndPop(m_torqueAccums, index, last);
+    moveAndPop(m_accelerations, index, last);
+    moveAndPop(m_lastFrameAccelerations, index, last);
+    moveAndPop(m_inverseInertiaTensorsWorld, index, last);
+    moveAndPop(m_inverseInertiaTensors, index, last);
+    moveAndPop(m_centerOfMassOffsets, index, last);
+    moveAndPop(m_inverseMasses, index, last);
+    moveAndPop(m_linearDampings, index, last);
+    moveAndPop(m_angularDampings, index, last);
+    moveAndPop(m_awake, index, last);
+
+    return body;
+}
+
+RigidBody *RigidBodyPool::get(RigidBodyHandle handle) const
+{
+    uint32_t slot = handle.getIndex();
+    if (handle.id == RigidBodyHandle::INVALID_ID ||
+        slot >= m_slotGenerations.size() ||
+        m_slotGenerations[slot] != handle.getGeneration())
+    {
+        return nullptr;
+    }
+
+    return m_bodies[m_slotIndices[slot]];
+}
+
+RigidBodyHandle RigidBodyPool::getHandle(const RigidBody *body) const
+{
+    int index = getIndex(body);
+    if (index < 0)
+    {
+        RigidBodyHandle invalid = {RigidBodyHandle::INVALID_ID};
+        return invalid;
+    }
+
+    return m_handles[index];
+}
+
+int RigidBodyPool::getIndex(const RigidBody *body) const
+{
+    return body != nullptr && body->m_pool == this ? (int)body->m_poolIndex
+                                                   : -1;
+}
+
+void RigidBodyPool::clearAccumulators()
+{
+    for (unsigned int i = 0; i < m_bodies.size(); ++i)
+    {
+        m_forceAccums[i].Clear();
+        m_torqueAccums[i].Clear();
+    }
+}
+
+void RigidBodyPool::integrate(ds_math::scalar duration)
+{
+    unsigned int count = (unsigned int)m_bodies.size();
+    unsigned int i = 0;
+
+#if defined(DS_MATH_SSE2)
+    for (; i + 4 <= count; i += 4)
+    {
+        if (m_awake[i] || m_awake[i + 1] || m_awake[i + 2] || m_awake[i + 3])
+        {
+            integrateLanes(i, duration);
+        }
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        if (m_awake[i])
+        {
+            integrateBody(i, duration);
+        }
+    }
+}
+
+void RigidBodyPool::integrateBody(unsigned int i, ds_math::scalar duration)
+{
+    // Calculate linear acceleration from force inputs.
+    m_lastFrameAccelerations[i] =
+        m_accelerations[i] + m_forceAccums[i] * m_inverseMasses[i];
+
+    // Calculate angular acceleration from torque inputs.
+    ds_math::Vector3 angularAcceleration = ds_math::Matrix3::Transform(
+        m_inverseInertiaTensorsWorld[i], m_torqueAccums[i]);
+
+    // Update velocities, then impose drag
+    m_velocities[i] += m_lastFrameAccelerations[i] * duration;
+    m_rotations[i] += angularAcceleration * duration;
+
+    m_velocities[i] *= SCALAR_POW(m_linearDampings[i], duration);
+    m_rotations[i] *= SCALAR_POW(m_angularDampings[i], duration);
+
+    // Update position and orientation
+    m_positions[i] += m_velocities[i] * duration;
+    m_orientations[i].AddScaledVector(m_rotations[i], duration);
+
+    m_forceAccums[i].Clear();
+    m_torqueAccums[i].Clear();
+
+    // The transform matrices are kept with the body
+    m_bodies[i]->calculateDerivedData();
+}
+
+void RigidBodyPool::applyForceFields(const ForceField *fields,
+                                     unsigned int count)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    unsigned int size = (unsigned int)m_bodies.size();
+    unsigned int i = 0;
+
+#if defined(DS_MATH_SSE2)
+    for (; i + 4 <= size; i += 4)
+    {
+        if (m_awake[i] || m_awake[i + 1] || m_awake[i + 2] || m_awake[i + 3])
+        {
+            applyForceFieldsLanes(i, fields, count);
+        }
+    }
+#endif
+
+    for (; i < size; ++i)
+    {
+        if (m_awake[i] && m_inverseMasses[i] > 0)
+        {
+            applyForceFieldsBody(i, fields, count);
+        }
+    }
+}
+
+void RigidBodyPool::applyForceFieldsBody(unsigned int i,
+                                         const ForceField *fields,
+                                         unsigned int count)
+{
+    const ds_math::scalar mass = 1.0f / m_inverseMasses[i];
+    const ds_math::Vector3 &position = m_positions[i];
+    ds_math::Vector3 &force = m_forceAccums[i];
+
+    for (unsigned int f = 0; f < count; ++f)
+    {
+        const ForceField &field = fields[f];
+        switch (field.type)
+        {
+        case ForceFieldType::Uniform:
+            force += field.vector * mass;
+            break;
+        case ForceFieldType::Directional:
+            force += field.vector;
+            break;
+        case ForceFieldType::Radial:
+        {
+            ds_math::Vector3 offset = field.centre - position;
+            ds_math::scalar distance =
+                SCALAR_SQRT(offset.x * offset.x + offset.y * offset.y +
+                            offset.z * offset.z);
+            if (distance > 0 && distance < field.radius)
+            {
+                // Direction to the centre and acceleration scaled together
+                ds_math::scalar scale =
+                    field.strength * (1.0f - distance / field.radius) * mass /
+                    distance;
+                force += offset * scale;
+            }
+            break;
+        }
+        }
+    }
+}
+
+#if defined(DS_MATH_SSE2)
+namespace
+{
+// Every step below performs the same operations, in the same order, as
+// the scalar path through RigidBody, so that both give identical results.
+
+/** The same Vector3 field of four bodies, one body per lane. */
+struct Vector3Lanes
+{
+    __m128 x, y, z;
+};
+
+/** The same Quaternion field of four bodies, one body per lane. */
+struct QuaternionLanes
+{
+    __m128 x, y, z, w;
+};
+
+/** The same Matrix3 field of four bodies, column by column. */
+struct Matrix3Lanes
+{
+    Vector3Lanes data[3];
+};
+
+inline Vector3Lanes operator+(const Vector3Lanes &a, const Vector3Lanes &b)
+{
+    Vector3Lanes result = {_mm_add_ps(a.x, b.x), _mm_add_ps(a.y, b.y),
+                           _mm_add_ps(a.z, b.z)};
+    return result;
+}
+
+inline Vector3Lanes operator*(const Vector3Lanes &v, __m128 factor)
+{
+    Vector3Lanes result = {_mm_mul_ps(v.x, factor), _mm_mul_ps(v.y, factor),
+                           _mm_mul_ps(v.z, factor)};
+    return result;
+}
+
+inline Vector3Lanes loadLanes(const ds_math::Vector3 *v)
+{
+    Vector3Lanes lanes = {_mm_setr_ps(v[0].x, v[1].x, v[2].x, v[3].x),
+                          _mm_setr_ps(v[0].y, v[1].y, v[2].y, v[3].y),
+                          _mm_setr_ps(v[0].z, v[1].z, v[2].z, v[3].z)};
+    return lanes;
+}
+
+inline QuaternionLanes loadLanes(const ds_math::Quaternion *q)
+{
+    QuaternionLanes lanes = {_mm_setr_ps(q[0].x, q[1].x, q[2].x, q[3].x),
+                             _mm_setr_ps(q[0].y, q[1].y, q[2].y, q[3].y),
+                             _mm_setr_ps(q[0].z, q[1].z, q[2].z, q[3].z),
+                             _mm_setr_ps(q[0].w, q[1].w, q[2].w, q[3].w)};
+    return lanes;
+}
+
+inline Matrix3Lanes loadLanes(const ds_math::Matrix3 *m)
+{
+    Matrix3Lanes lanes;
+    for (unsigned int c = 0; c < 3; ++c)
+    {
+        const ds_math::Vector3 column[4] = {m[0].data[c], m[1].data[c],
+                                            m[2].data[c], m[3].data[c]};
+        lanes.data[c] = loadLanes(column);
+    }
+    return lanes;
+}
+
+/** Lanes unpacked to memory so that each body's values can be read. */
+struct Vector3Values
+{
+    explicit Vector3Values(const Vector3Lanes &lanes)
+    {
+        _mm_store_ps(x, lanes.x);
+        _mm_store_ps(y, lanes.y);
+        _mm_store_ps(z, lanes.z);
+    }
+
+    ds_math::Vector3 operator[](unsigned int lane) const
+    {
+        return ds_math::Vector3(x[lane], y[lane], z[lane]);
+    }
+
+    alignas(16) ds_math::scalar x[4];
+    alignas(16) ds_math::scalar y[4];
+    alignas(16) ds_math::scalar z[4];
+};
+
+/** Store lanes to the bodies whose bit is set in the mask. */
+inline void storeLanes(ds_math::Vector3 *v,
+                       const Vector3Lanes &lanes,
+                       unsigned int mask)
+{
+    Vector3Values values(lanes);
+    for (unsigned int lane = 0; lane < 4; ++lane)
+    {
+        if (mask & (1u << lane))
+        {
+            v[lane] = values[lane];
+        }
+    }
+}
+
+inline void storeLanes(ds_math::Quaternion *q,
+                       const QuaternionLanes &lanes,
+                       unsigned int mask)
+{
+    alignas(16) ds_math::scalar x[4], y[4], z[4], w[4];
+    _mm_store_ps(x, lanes.x);
+    _mm_store_ps(y, lanes.y);
+    _mm_store_ps(z, lanes.z);
+    _mm_store_ps(w, lanes.w);
+    for (unsigned int lane = 0; lane < 4; ++lane)
+    {
+        if (mask & (1u << lane))
+        {
+            q[lane] = ds_math::Quaternion(x[lane], y[lane], z[lane], w[lane]);
+        }
+    }
+}
+
+inline void storeLanes(ds_math::Matrix3 *m,
+                       const Matrix3Lanes &lanes,
+                       unsigned int mask)
+{
+    for (unsigned int c = 0; c < 3; ++c)
+    {
+        Vector3Values column(lanes.data[c]);
+        for (unsigned int lane = 0; lane < 4; ++lane)
+        {
+            if (mask & (1u << lane))
+            {
+                m[lane].data[c] = column[lane];
+            }
+        }
+    }
+}
+
+/** Matrix3::Transform, each row dotted with the vector. */
+inline Vector3Lanes transform(const Matrix3Lanes &m, const Vector3Lanes &v)
+{
+    Vector3Lanes result;
+    result.x = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m.data[0].x, v.x),
+                                     _mm_mul_ps(m.data[1].x, v.y)),
+                          _mm_mul_ps(m.data[2].x, v.z));
+    result.y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m.data[0].y, v.x),
+                                     _mm_mul_ps(m.data[1].y, v.y)),
+                          _mm_mul_ps(m.data[2].y, v.z));
+    result.z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m.data[0].z, v.x),
+                                     _mm_mul_ps(m.data[1].z, v.y)),
+                          _mm_mul_ps(m.data[2].z, v.z));
+    return result;
+}
+
+/** Quaternion::AddScaledVector followed by Quaternion::Normalize. */
+inline void addScaledVectorAndNormalize(QuaternionLanes &q,
+                                        const Vector3Lanes &vector,
+                                        __m128 scale)
+{
+    // The product (v * scale, 0) * q, with the zero kept so that signed
+    // zeros match
+    __m128 x = _mm_mul_ps(vector.x, scale);
+    __m128 y = _mm_mul_ps(vector.y, scale);
+    __m128 z = _mm_mul_ps(vector.z, scale);
+    __m128 w = _mm_setzero_ps();
+
+    __m128 px = _mm_sub_ps(
+        _mm_add_ps(_mm_add_ps(_mm_mul_ps(w, q.x), _mm_mul_ps(x, q.w)),
+                   _mm_mul_ps(y, q.z)),
+        _mm_mul_ps(z, q.y));
+    __m128 py = _mm_sub_ps(
+        _mm_add_ps(_mm_add_ps(_mm_mul_ps(w, q.y), _mm_mul_ps(y, q.w)),
+                   _mm_mul_ps(z, q.x)),
+        _mm_mul_ps(x, q.z));
+    __m128 pz = _mm_sub_ps(
+        _mm_add_ps(_mm_add_ps(_mm_mul_ps(w, q.z), _mm_mul_ps(z, q.w)),
+                   _mm_mul_ps(x, q.y)),
+        _mm_mul_ps(y, q.x));
+    __m128 pw = _mm_sub_ps(
+        _mm_sub_ps(_mm_sub_ps(_mm_mul_ps(w, q.w), _mm_mul_ps(x, q.x)),
+                   _mm_mul_ps(y, q.y)),
+        _mm_mul_ps(z, q.z));
+
+    const __m128 half = _mm_set1_ps(0.5f);
+    q.x = _mm_add_ps(q.x, _mm_mul_ps(px, half));
+    q.y = _mm_add_ps(q.y, _mm_mul_ps(py, half));
+    q.z = _mm_add_ps(q.z, _mm_mul_ps(pz, half));
+    q.w = _mm_add_ps(q.w, _mm_mul_ps(pw, half));
+
+    __m128 dot = _mm_add_ps(
+        _mm_add_ps(_mm_add_ps(_mm_mul_ps(q.x, q.x), _mm_mul_ps(q.y, q.y)),
+                   _mm_mul_ps(q.z, q.z)),
+        _mm_mul_ps(q.w, q.w));
+    __m128 factor = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(dot));
+
+    q.x = _mm_mul_ps(q.x, factor);
+    q.y = _mm_mul_ps(q.y, factor);
+    q.z = _mm_mul_ps(q.z, factor);
+    q.w = _mm_mul_ps(q.w, factor);
+}
+
+/**
+ * Rotation part of the matrix built by calculateTransformMatrix in
+ * RigidBody.cpp, by column.
+ */
+inline Matrix3Lanes rotationMatrix(const QuaternionLanes &q)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+
+    __m128 x2 = _mm_mul_ps(two, q.x);
+    __m128 y2 = _mm_mul_ps(two, q.y);
+    __m128 z2 = _mm_mul_ps(two, q.z);
+    __m128 w2 = _mm_mul_ps(two, q.w);
+
+    __m128 xx = _mm_mul_ps(x2, q.x);
+    __m128 xy = _mm_mul_ps(x2, q.y);
+    __m128 xz = _mm_mul_ps(x2, q.z);
+    __m128 yy = _mm_mul_ps(y2, q.y);
+    __m128 yz = _mm_mul_ps(y2, q.z);
+    __m128 zz = _mm_mul_ps(z2, q.z);
+    __m128 wx = _mm_mul_ps(w2, q.x);
+    __m128 wy = _mm_mul_ps(w2, q.y);
+    __m128 wz = _mm_mul_ps(w2, q.z);
+
+    Matrix3Lanes m;
+    m.data[0].x = _mm_sub_ps(_mm_sub_ps(one, yy), zz);
+    m.data[0].y = _mm_add_ps(xy, wz);
+    m.data[0].z = _mm_sub_ps(xz, wy);
+    m.data[1].x = _mm_sub_ps(xy, wz);
+    m.data[1].y = _mm_sub_ps(_mm_sub_ps(one, xx), zz);
+    m.data[1].z = _mm_add_ps(yz, wx);
+    m.data[2].x = _mm_add_ps(xz, wy);
+    m.data[2].y = _mm_sub_ps(yz, wx);
+    m.data[2].z = _mm_sub_ps(_mm_sub_ps(one, xx), yy);
+    return m;
+}
+
+/** a0 * b0 + a1 * b1 + a2 * b2, added left to right. */
+inline __m128 dot3(__m128 a0, __m128 b0, __m128 a1, __m128 b1, __m128 a2,
+                   __m128 b2)
+{
+    return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a0, b0), _mm_mul_ps(a1, b1)),
+                      _mm_mul_ps(a2, b2));
+}
+
+/**
+ * transformInertiaTensor in RigidBody.cpp, taking the inverse inertia
+ * tensor from body space to world space.
+ */
+inline Matrix3Lanes transformInertiaTensor(const Matrix3Lanes &iitBody,
+                                           const Matrix3Lanes &rotation)
+{
+    const Vector3Lanes *r = rotation.data;
+    const Vector3Lanes *i = iitBody.data;
+
+    // Row j of the rotation times each column of the body tensor
+    Vector3Lanes t[3];
+    t[0].x = dot3(r[0].x, i[0].x, r[1].x, i[0].y, r[2].x, i[0].z);
+    t[0].y = dot3(r[0].x, i[1].x, r[1].x, i[1].y, r[2].x, i[1].z);
+    t[0].z = dot3(r[0].x, i[2].x, r[1].x, i[2].y, r[2].x, i[2].z);
+    t[1].x = dot3(r[0].y, i[0].x, r[1].y, i[0].y, r[2].y, i[0].z);
+    t[1].y = dot3(r[0].y, i[1].x, r[1].y, i[1].y, r[2].y, i[1].z);
+    t[1].z = dot3(r[0].y, i[2].x, r[1].y, i[2].y, r[2].y, i[2].z);
+    t[2].x = dot3(r[0].z, i[0].x, r[1].z, i[0].y, r[2].z, i[0].z);
+    t[2].y = dot3(r[0].z, i[1].x, r[1].z, i[1].y, r[2].z, i[1].z);
+    t[2].z = dot3(r[0].z, i[2].x, r[1].z, i[2].y, r[2].z, i[2].z);
+
+    Matrix3Lanes world;
+    for (unsigned int c = 0; c < 3; ++c)
+    {
+        world.data[c].x =
+            dot3(t[c].x, r[0].x, t[c].y, r[1].x, t[c].z, r[2].x);
+        world.data[c].y =
+            dot3(t[c].x, r[0].y, t[c].y, r[1].y, t[c].z, r[2].y);
+        world.data[c].z =
+            dot3(t[c].x, r[0].z, t[c].y, r[1].z, t[c].z, r[2].z);
+    }
+    return world;
+}
+
+/** Write the rotation and translation of a transform matrix. */
+inline void setTransform(ds_math::Matrix4 &transform,
+                         const Vector3Values *rotation,
+                         const ds_math::Vector3 &position,
+                         unsigned int lane)
+{
+    for (unsigned int c = 0; c < 3; ++c)
+    {
+        transform.data[c].x = rotation[c].x[lane];
+        transform.data[c].y = rotation[c].y[lane];
+        transform.data[c].z = rotation[c].z[lane];
+    }
+    transform.data[3].x = position.x;
+    transform.data[3].y = position.y;
+    transform.data[3].z = position.z;
+}
+}
+
+void RigidBodyPool::integrateLanes(unsigned int first,
+                                   ds_math::scalar duration)
+{
+    unsigned int mask = 0;
+    for (unsigned int lane = 0; lane < 4; ++lane)
+    {
+        mask |= (m_awake[first + lane] ? 1u : 0u) << lane;
+    }
+
+    const __m128 step = _mm_set1_ps(duration);
+    const __m128 inverseMass = ds_math::simd::Load(&m_inverseMasses[first]);
+
+    // Calculate linear and angular acceleration from force inputs.
+    Vector3Lanes lastFrameAcceleration =
+        loadLanes(&m_accelerations[first]) +
+        loadLanes(&m_forceAccums[first]) * inverseMass;
+    Vector3Lanes angularAcceleration =
+        transform(loadLanes(&m_inverseInertiaTensorsWorld[first]),
+                  loadLanes(&m_torqueAccums[first]));
+
+    // Update velocities, then impose drag
+    Vector3Lanes velocity =
+        loadLanes(&m_velocities[first]) + lastFrameAcceleration * step;
+    Vector3Lanes rotation =
+        loadLanes(&m_rotations[first]) + angularAcceleration * step;
+
+    ds_math::scalar linearDrag[4], angularDrag[4];
+    for (unsigned int lane = 0; lane < 4; ++lane)
+    {
+        linearDrag[lane] = SCALAR_POW(m_linearDampings[first + lane], duration);
+        angularDrag[lane] =
+            SCALAR_POW(m_angularDampings[first + lane], duration);
+    }
+    velocity = velocity * ds_math::simd::Load(linearDrag);
+    rotation = rotation * ds_math::simd::Load(angularDrag);
+
+    // Update position and orientation
+    Vector3Lanes position = loadLanes(&m_positions[first]) + velocity * step;
+    QuaternionLanes orientation = loadLanes(&m_orientations[first]);
+    addScaledVectorAndNormalize(orientation, rotation, step);
+
+    // Derived data, as RigidBody::calculateDerivedData
+    Matrix3Lanes rotationLanes = rotationMatrix(orientation);
+    Matrix3Lanes inverseInertiaTensorWorld = transformInertiaTensor(
+        loadLanes(&m_inverseInertiaTensors[first]), rotationLanes);
+
+    storeLanes(&m_lastFrameAccelerations[first], lastFrameAcceleration, mask);
+    storeLanes(&m_velocities[first], velocity, mask);
+    storeLanes(&m_rotations[first], rotation, mask);
+    storeLanes(&m_positions[first], position, mask);
+    storeLanes(&m_orientations[first], orientation, mask);
+    storeLanes(&m_inverseInertiaTensorsWorld[first], inverseInertiaTensorWorld,
+               mask);
+
+    const Vector3Values rotationColumns[3] = {
+        Vector3Values(rotationLanes.data[0]),
+        Vector3Values(rotationLanes.data[1]),
+        Vector3Values(rotationLanes.data[2])};
+    for (unsigned int lane = 0; lane < 4; ++lane)
+    {
+        if (mask & (1u << lane))
+        {
+            unsigned int i = first + lane;
+            RigidBody *body = m_bodies[i];
+
+            setTransform(body->m_transformMatrix, rotationColumns,
+                         m_positions[i], lane);
+            setTransform(body->m_centerOfMassTransformMatrix,
+                         rotationColumns,
+                         m_positions[i] + m_centerOfMassOffsets[i], lane);
+
+            m_forceAccums[i].Clear();
+            m_torqueAccums[i].Clear();
+        }
+    }
+}
+
+void RigidBodyPool::applyForceFieldsLanes(unsigned int first,
+                                          const ForceField *fields,
+                                          unsigned int count)
+{
+    unsigned int mask = 0;
+    for (unsigned int lane = 0; lane < 4; ++lane)
+    {
+        unsigned int i = first + lane;
+        mask |= (m_awake[i] && m_inverseMasses[i] > 0 ? 1u : 0u) << lane;
+    }
+    if (mask == 0)
+    {
+        return;
+    }
+
+    // Lanes with infinite mass give nonsense here, but are never stored
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 mass = _mm_div_ps(
+        _mm_set1_ps(1.0f), ds_math::simd::Load(&m_inverseMasses[first]));
+    const Vector3Lanes position = loadLanes(&m_positions[first]);
+    Vector3Lanes force = loadLanes(&m_forceAccums[first]);
+
+    for (unsigned int f = 0; f < count; ++f)
+    {
+        const ForceField &field = fields[f];
+        switch (field.type)
+        {
+        case ForceFieldType::Uniform:
+        {
+            Vector3Lanes acceleration = {_mm_set1_ps(field.vector.x),
+                                         _mm_set1_ps(field.vector.y),
+                                         _mm_set1_ps(field.vector.z)};
+            force = force + acceleration * mass;
+            break;
+        }
+        case ForceFieldType::Directional:
+        {
+            Vector3Lanes fieldForce = {_mm_set1_ps(field.vector.x),
+                                       _mm_set1_ps(field.vector.y),
+                                       _mm_set1_ps(field.vector.z)};
+            force = force + fieldForce;
+            break;
+        }
+        case ForceFieldType::Radial:
+        {
+            Vector3Lanes offset = {
+                _mm_sub_ps(_mm_set1_ps(field.centre.x), position.x),
+                _mm_sub_ps(_mm_set1_ps(field.centre.y), position.y),
+                _mm_sub_ps(_mm_set1_ps(field.centre.z), position.z)};
+            __m128 distance = _mm_sqrt_ps(_mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(offset.x, offset.x),
+                           _mm_mul_ps(offset.y, offset.y)),
+                _mm_mul_ps(offset.z, offset.z)));
+            __m128 radius = _mm_set1_ps(field.radius);
+            __m128 inside = _mm_and_ps(_mm_cmpgt_ps(distance, zero),
+                                       _mm_cmplt_ps(distance, radius));
+            if (_mm_movemask_ps(inside) == 0)
+            {
+                break;
+            }
+
+            __m128 falloff =
+                _mm_sub_ps(_mm_set1_ps(1.0f), _mm_div_ps(distance, radius));
+            __m128 scale = _mm_div_ps(
+                _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(field.strength), falloff),
+                           mass),
+                distance);
+
+            // Lanes outside the field add nothing, as the scalar path
+            force = force + offset * _mm_and_ps(inside, scale);
+            break;
+        }
+        }
+    }
+
+    storeLanes(&m_forceAccums[first], force, mask);
+}
+#endif
+}
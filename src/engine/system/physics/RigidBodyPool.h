@@ -0,0 +1,293 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "math/Matrix3.h"
+#include "math/Precision.h"
+#include "math/Quaternion.h"
+#include "math/Vector3.h"
+
+namespace ds_phys
+{
+class RigidBody;
+struct ForceField;
+
+/**
+ * Handle to a rigid body in a RigidBodyPool.
+ *
+ * Slots are re-used once a body is removed, the generation part of the
+ * handle tells whether the body it refers to is still in the pool.
+ */
+class RigidBodyHandle
+{
+public:
+    /**
+     * Get the index part of the handle id.
+     *
+     * @return   unsigned int, index part of the handle id.
+     */
+    unsigned int getIndex() const
+    {
+        return id & INDEX_MASK;
+    }
+
+    /**
+     * Get the generation part of the handle id.
+     *
+     * @return   unsigned int, generation part of the handle id.
+     */
+    unsigned int getGeneration() const
+    {
+        return (id >> INDEX_BITS) & GENERATION_MASK;
+    }
+
+    bool operator==(const RigidBodyHandle &other) const
+    {
+        return id == other.id;
+    }
+
+    bool operator!=(const RigidBodyHandle &other) const
+    {
+        return id != other.id;
+    }
+
+    /** Number of bits making up the index. */
+    static const unsigned int INDEX_BITS = 22;
+    /** Index mask. */
+    static const uint32_t INDEX_MASK = (1 << INDEX_BITS) - 1;
+
+    /** Number of bits making up the generation. */
+    static const unsigned int GENERATION_BITS = 8;
+    /** Generation mask. */
+    static const uint32_t GENERATION_MASK = (1 << GENERATION_BITS) - 1;
+
+    /** Id of a handle that never refers to a body. */
+    static const uint32_t INVALID_ID = 0xffffffff;
+
+    /** Unique identifier. */
+    uint32_t id;
+};
+
+/**
+ * Packed storage for the rigid bodies of a physics world.
+ *
+ * The state integrated every step is kept in one array per field, with the
+ * bodies packed at the front so that integrate() streams through memory.
+ * Removing a body moves the last body into its place, so the index of a
+ * body may change; handles stay valid until their body is removed.
+ *
+ * A body reads and writes its state in the pool while it is added, and
+ * keeps its own copy otherwise.
+ */
+class RigidBodyPool
+{
+public:
+    /**
+     * RigidBodyPool destructor, hands every body its state back.
+     */
+    ~RigidBodyPool();
+
+    /**
+     * Add a rigid body, moving its state into the pool.
+     *
+     * @pre   The body is not in a pool.
+     *
+     * @param   body   RigidBody *, body to add.
+     * @return         RigidBodyHandle, handle to the body.
+     */
+    RigidBodyHandle add(RigidBody *body);
+
+    /**
+     * Remove a rigid body, handing its state back to it. The last body in
+     * the pool takes its index.
+     *
+     * @param   handle      RigidBodyHandle, handle to the body.
+     * @param   keepState   bool, FALSE to drop the body's state rather than
+     * hand it back, such as when the body is being destroyed.
+     * @return              RigidBody *, body removed, nullptr if the handle
+     * is no longer valid.
+     */
+    RigidBody *remove(RigidBodyHandle handle, bool keepState = true);
+
+    /**
+     * Get the rigid body a handle refers to.
+     *
+     * @param   handle   RigidBodyHandle, handle to the body.
+     * @return           RigidBody *, body, nullptr if it has been removed.
+     */
+    RigidBody *get(RigidBodyHandle handle) const;
+
+    /**
+     * Get the handle of a rigid body in the pool.
+     *
+     * @param   body   const RigidBody *, body.
+     * @return         RigidBodyHandle, handle to the body, with
+     * RigidBodyHandle::INVALID_ID if the body isn't in this pool.
+     */
+    RigidBodyHandle getHandle(const RigidBody *body) const;
+
+    /**
+     * Get the index of a rigid body in the pool.
+     *
+     * @param   body   const RigidBody *, body.
+     * @return         int, index of the body, -1 if it isn't in this pool.
+     */
+    int getIndex(const RigidBody *body) const;
+
+    /**
+     * Get the number of rigid bodies in the pool.
+     *
+     * @return   unsigned int, number of bodies.
+     */
+    unsigned int size() const
+    {
+        return (unsigned int)m_bodies.size();
+    }
+
+    /**
+     * Get a rigid body by its index.
+     *
+     * @param   index   unsigned int, index of the body.
+     * @return          RigidBody *, body.
+     */
+    RigidBody *getBody(unsigned int index) const
+    {
+        return m_bodies[index];
+    }
+
+    /**
+     * Clear the force and torque accumulated by every body.
+     */
+    void clearAccumulators();
+
+    /**
+     * Integrate every awake body forward in time and clear their
+     * accumulators, as RigidBody::integrate does without putting bodies to
+     * sleep. Derived data is recalculated for the bodies integrated.
+     *
+     * When SIMD is available bodies are integrated four at a time, with
+     * results identical to integrating each body on its own.
+     *
+     * @param   duration   ds_math::scalar, duration to integrate over.
+     */
+    void integrate(ds_math::scalar duration);
+
+    /**
+     * Add the forces of a set of force fields to every awake body with
+     * finite mass.
+     *
+     * When SIMD is available bodies are visited four at a time, with
+     * results identical to visiting each body on its own.
+     *
+     * @param   fields   const ForceField *, fields to apply.
+     * @param   count    unsigned int, number of fields.
+     */
+    void applyForceFields(const ForceField *fields, unsigned int count);
+
+private:
+    friend class RigidBody;
+
+    /**
+     * Integrate one awake body, see integrate().
+     *
+     * @param   index      unsigned int, index of the body.
+     * @param   duration   ds_math::scalar, duration to integrate over.
+     */
+    void integrateBody(unsigned int index, ds_math::scalar duration);
+
+    /**
+     * Integrate the awake bodies among four consecutive bodies, one body
+     * per SIMD lane. Only defined when DS_MATH_SSE2 is.
+     *
+     * @param   first      unsigned int, index of the first body.
+     * @param   duration   ds_math::scalar, duration to integrate over.
+     */
+    void integrateLanes(unsigned int first, ds_math::scalar duration);
+
+    /**
+     * Add the forces of a set of force fields to one awake body with finite
+     * mass, see applyForceFields().
+     *
+     * @param   index    unsigned int, index of the body.
+     * @param   fields   const ForceField *, fields to apply.
+     * @param   count    unsigned int, number of fields.
+     */
+    void applyForceFieldsBody(unsigned int index,
+                              const ForceField *fields,
+                              unsigned int count);
+
+    /**
+     * Add the forces of a set of force fields to the awake bodies with
+     * finite mass among four consecutive bodies, one body per SIMD lane.
+     * Only defined when DS_MATH_SSE2 is.
+     *
+     * @param   first    unsigned int, index of the first body.
+     * @param   fields   const ForceField *, fields to apply.
+     * @param   count    unsigned int, number of fields.
+     */
+    void applyForceFieldsLanes(unsigned int first,
+                               const ForceField *fields,
+                               unsigned int count);
+
+    /** Bodies in the pool, packed. */
+    std::vector<RigidBody *> m_bodies;
+
+    /** Handle of each body. */
+    std::vector<RigidBodyHandle> m_handles;
+
+    /** Index of the body each handle slot refers to. */
+    std::vector<uint32_t> m_slotIndices;
+
+    /** Current generation of each handle slot. */
+    std::vector<uint8_t> m_slotGenerations;
+
+    /** Handle slots free to be re-used. */
+    std::vector<uint32_t> m_freeSlots;
+
+    /** @see RigidBodyState::position */
+    std::vector<ds_math::Vector3> m_positions;
+
+    /** @see RigidBodyState::orientation */
+    std::vector<ds_math::Quaternion> m_orientations;
+
+    /** @see RigidBodyState::velocity */
+    std::vector<ds_math::Vector3> m_velocities;
+
+    /** @see RigidBodyState::rotation */
+    std::vector<ds_math::Vector3> m_rotations;
+
+    /** @see RigidBodyState::forceAccum */
+    std::vector<ds_math::Vector3> m_forceAccums;
+
+    /** @see RigidBodyState::torqueAccum */
+    std::vector<ds_math::Vector3> m_torqueAccums;
+
+    /** @see RigidBodyState::acceleration */
+    std::vector<ds_math::Vector3> m_accelerations;
+
+    /** @see RigidBodyState::lastFrameAcceleration */
+    std::vector<ds_math::Vector3> m_lastFrameAccelerations;
+
+    /** @see RigidBodyState::inverseInertiaTensorWorld */
+    std::vector<ds_math::Matrix3> m_inverseInertiaTensorsWorld;
+
+    /** @see RigidBodyState::inverseInertiaTensor */
+    std::vector<ds_math::Matrix3> m_inverseInertiaTensors;
+
+    /** @see RigidBodyState::centerOfMassOffset */
+    std::vector<ds_math::Vector3> m_centerOfMassOffsets;
+
+    /** @see RigidBodyState::inverseMass */
+    std::vector<ds_math::scalar> m_inverseMasses;
+
+    /** @see RigidBodyState::linearDamping */
+    std::vector<ds_math::scalar> m_linearDampings;
+
+    /** @see RigidBodyState::angularDamping */
+    std::vector<ds_math::scalar> m_angularDampings;
+
+    /** @see RigidBodyState::isAwake */
+    std::vector<uint8_t> m_awake;
+};
+}
@@ -0,0 +1,359 @@
+#include <algorithm>
+#include <cmath>
+
+#include "engine/system/physics/SequentialImpulseSolver.h"
+
+namespace ds_phys
+{
+// Closing velocities below this don't bounce, matches the limit used by the
+// contact resolver.
+static const ds_math::scalar RESTITUTION_VELOCITY_LIMIT = 0.25f;
+
+// Largest distance a position pass moves a contact apart, keeps deep
+// contacts from being thrown apart in one step.
+static const ds_math::scalar MAX_CORRECTION = 0.2f;
+
+SequentialImpulseSolver::SequentialImpulseSolver(
+    unsigned int velocityIterations,
+    unsigned int positionIterations,
+    ds_math::scalar correction,
+    ds_math::scalar slop)
+    : m_velocityIterations(velocityIterations),
+      m_positionIterations(positionIterations), m_correction(correction),
+      m_slop(slop)
+{
+}
+
+void SequentialImpulseSolver::setIterations(unsigned int velocityIterations,
+                                            unsigned int positionIterations)
+{
+    m_velocityIterations = velocityIterations;
+    m_positionIterations = positionIterations;
+}
+
+void SequentialImpulseSolver::setIterations(unsigned int iterations)
+{
+    setIterations(iterations, iterations);
+}
+
+unsigned int SequentialImpulseSolver::getVelocityIterations() const
+{
+    return m_velocityIterations;
+}
+
+unsigned int SequentialImpulseSolver::getPositionIterations() const
+{
+    return m_positionIterations;
+}
+
+void SequentialImpulseSolver::setPositionCorrection(ds_math::scalar correction,
+                                                    ds_math::scalar slop)
+{
+    m_correction = correction;
+    m_slop = slop;
+}
+
+void SequentialImpulseSolver::resolveContacts(Contact *contacts,
+                                              unsigned int numContacts,
+                                              ds_math::scalar duration) const
+{
+    if (numContacts == 0 || duration <= 0)
+    {
+        return;
+    }
+
+    // Every contact's bounce is found from the velocities before any
+    // impulse is applied
+    for (unsigned int i = 0; i < numContacts; ++i)
+    {
+        prepareContact(contacts[i], duration);
+    }
+
+    for (unsigned int i = 0; i < numContacts; ++i)
+    {
+        warmStartContact(contacts[i]);
+    }
+
+    for (unsigned int iteration = 0; iteration < m_velocityIterations;
+         ++iteration)
+    {
+        for (unsigned int i = 0; i < numContacts; ++i)
+        {
+            solveContact(contacts[i]);
+        }
+    }
+
+    for (unsigned int iteration = 0; iteration < m_positionIterations;
+         ++iteration)
+    {
+        for (unsigned int i = 0; i < numContacts; ++i)
+        {
+            correctPenetration(contacts[i]);
+        }
+    }
+
+    // Keep the total impulse to warm start the contact next step
+    for (unsigned int i = 0; i < numContacts; ++i)
+    {
+        Contact &contact = contacts[i];
+        contact.impulse = contact.m_axes[0] * contact.m_accumulatedImpulse.x +
+                          contact.m_axes[1] * contact.m_accumulatedImpulse.y +
+                          contact.m_axes[2] * contact.m_accumulatedImpulse.z;
+    }
+}
+
+void SequentialImpulseSolver::prepareContact(Contact &contact,
+                                             ds_math::scalar duration) const
+{
+    if (!contact.body[0])
+    {
+        contact.swapBodies();
+    }
+
+    // Orthonormal contact basis, normal first
+    const ds_math::Vector3 &normal = contact.contactNormal;
+    ds_math::Vector3 tangent;
+    if (fabs(normal.x) > 0.57735f)
+    {
+        tangent = ds_math::Vector3(normal.y, -normal.x, 0.0f);
+    }
+    else
+    {
+        tangent = ds_math::Vector3(0.0f, normal.z, -normal.y);
+    }
+    contact.m_axes[0] = normal;
+    contact.m_axes[1] = ds_math::Vector3::Normalize(tangent);
+    contact.m_axes[2] = ds_math::Vector3::Cross(normal, contact.m_axes[1]);
+
+    ds_math::Matrix3 inverseInertiaTensor[2];
+    for (unsigned int i = 0; i < 2; ++i)
+    {
+        if (contact.body[i])
+        {
+            contact.m_relativeContactPosition[i] =
+                contact.contactPoint - contact.body[i]->getPosition();
+            contact.m_localContactPoint[i] =
+                contact.body[i]->getPointInLocalSpace(contact.contactPoint);
+            Contact::getInverseInertiaTensorWorld(contact.body[i],
+                                                  &inverseInertiaTensor[i]);
+        }
+        else
+        {
+            contact.m_localContactPoint[i] = contact.contactPoint;
+        }
+    }
+
+    // Inverse of the change in relative velocity per unit impulse, along
+    // each axis
+    for (unsigned int axis = 0; axis < 3; ++axis)
+    {
+        const ds_math::Vector3 &direction = contact.m_axes[axis];
+
+        ds_math::scalar inverseMass = 0;
+        for (unsigned int i = 0; i < 2; ++i)
+        {
+            if (contact.body[i])
+            {
+                const ds_math::Vector3 &position =
+                    contact.m_relativeContactPosition[i];
+                ds_math::Vector3 angular = ds_math::Vector3::Cross(
+                    inverseInertiaTensor[i] *
+                        ds_math::Vector3::Cross(position, direction),
+                    position);
+
+                inverseMass += contact.body[i]->getInverseMass() +
+                               ds_math::Vector3::Dot(angular, direction);
+            }
+        }
+
+        contact.m_effectiveMass[axis] =
+            inverseMass > 0 ? 1.0f / inverseMass : 0.0f;
+    }
+
+    // Bounce fast collisions, penetration is left to the position passes.
+    // Bodies that have yet to touch may close the gap this step.
+    ds_math::scalar normalVelocity =
+        ds_math::Vector3::Dot(getRelativeVelocity(contact), normal);
+
+    contact.m_velocityBias = 0;
+    if (contact.penetration < 0)
+    {
+        contact.m_velocityBias = contact.penetration / duration;
+    }
+    else if (normalVelocity < -RESTITUTION_VELOCITY_LIMIT)
+    {
+        // Only bounce the velocity the bodies had before this step, as the
+        // contact resolver does, so resting contacts don't gain energy
+        ds_math::scalar accelerationVelocity = 0;
+        for (unsigned int i = 0; i < 2; ++i)
+        {
+            if (contact.body[i] && contact.body[i]->getAwake())
+            {
+                ds_math::scalar velocity = ds_math::Vector3::Dot(
+                    contact.body[i]->getLastFrameAcceleration() * duration,
+                    normal);
+                accelerationVelocity += i == 0 ? velocity : -velocity;
+            }
+        }
+
+        contact.m_velocityBias =
+            std::max(-contact.restitution *
+                         (normalVelocity - accelerationVelocity),
+                     0.0f);
+    }
+}
+
+void SequentialImpulseSolver::warmStartContact(Contact &contact) const
+{
+    // Start from the given impulse, clamped to this step's limits
+    ds_math::Vector3 &accumulated = contact.m_accumulatedImpulse;
+    accumulated.x =
+        std::max(ds_math::Vector3::Dot(contact.impulse, contact.m_axes[0]),
+                 0.0f);
+
+    ds_math::scalar maxFriction = contact.friction * accumulated.x;
+    accumulated.y =
+        std::min(std::max(ds_math::Vector3::Dot(contact.impulse,
+                                                contact.m_axes[1]),
+                          -maxFriction),
+                 maxFriction);
+    accumulated.z =
+        std::min(std::max(ds_math::Vector3::Dot(contact.impulse,
+                                                contact.m_axes[2]),
+                          -maxFriction),
+                 maxFriction);
+
+    applyImpulse(contact, contact.m_axes[0] * accumulated.x +
+                              contact.m_axes[1] * accumulated.y +
+                              contact.m_axes[2] * accumulated.z);
+}
+
+void SequentialImpulseSolver::solveContact(Contact &contact) const
+{
+    ds_math::Vector3 &accumulated = contact.m_accumulatedImpulse;
+
+    // Friction, limited by the current normal impulse
+    ds_math::scalar maxFriction = contact.friction * accumulated.x;
+    for (unsigned int axis = 1; axis < 3; ++axis)
+    {
+        ds_math::scalar velocity = ds_math::Vector3::Dot(
+            getRelativeVelocity(contact), contact.m_axes[axis]);
+        ds_math::scalar lambda = -velocity * contact.m_effectiveMass[axis];
+
+        ds_math::scalar previous = accumulated[axis];
+        accumulated[axis] =
+            std::min(std::max(previous + lambda, -maxFriction), maxFriction);
+
+        applyImpulse(contact,
+                     contact.m_axes[axis] * (accumulated[axis] - previous));
+    }
+
+    // Normal, the contact may only push
+    ds_math::scalar velocity = ds_math::Vector3::Dot(
+        getRelativeVelocity(contact), contact.m_axes[0]);
+    ds_math::scalar lambda =
+        (contact.m_velocityBias - velocity) * contact.m_effectiveMass[0];
+
+    ds_math::scalar previous = accumulated.x;
+    accumulated.x = std::max(previous + lambda, 0.0f);
+
+    applyImpulse(contact, contact.m_axes[0] * (accumulated.x - previous));
+}
+
+void SequentialImpulseSolver::correctPenetration(Contact &contact) const
+{
+    // Both points started at the contact point, so how far they have moved
+    // apart along the normal is how much of the penetration is left
+    ds_math::Vector3 point[2];
+    for (unsigned int i = 0; i < 2; ++i)
+    {
+        point[i] = contact.body[i] ? contact.body[i]->getPointInWorldSpace(
+                                         contact.m_localContactPoint[i])
+                                   : contact.m_localContactPoint[i];
+    }
+
+    ds_math::scalar penetration =
+        contact.penetration +
+        ds_math::Vector3::Dot(point[1] - point[0], contact.m_axes[0]);
+
+    ds_math::scalar move =
+        std::min(m_correction * (penetration - m_slop), MAX_CORRECTION);
+    if (move <= 0)
+    {
+        return;
+    }
+
+    // The velocity effective mass is reused, the bodies have barely turned
+    // since it was found
+    ds_math::Vector3 impulse =
+        contact.m_axes[0] * (move * contact.m_effectiveMass[0]);
+    for (unsigned int i = 0; i < 2; ++i)
+    {
+        RigidBody *body = contact.body[i];
+        if (body && body->hasFiniteMass())
+        {
+            ds_math::Vector3 bodyImpulse = i == 0 ? impulse : -impulse;
+            ds_math::Vector3 relativePosition = point[i] - body->getPosition();
+
+            ds_math::Matrix3 inverseInertiaTensor;
+            body->getInverseInertiaTensorWorld(&inverseInertiaTensor);
+
+            body->setPosition(body->getPosition() +
+                              bodyImpulse * body->getInverseMass());
+
+            ds_math::Quaternion orientation;
+            body->getOrientation(&orientation);
+            orientation.AddScaledVector(
+                inverseInertiaTensor *
+                    ds_math::Vector3::Cross(relativePosition, bodyImpulse),
+                1.0f);
+            body->setOrientation(orientation);
+
+            body->calculateDerivedData();
+        }
+    }
+}
+
+ds_math::Vector3
+SequentialImpulseSolver::getRelativeVelocity(const Contact &contact)
+{
+    ds_math::Vector3 velocity;
+    for (unsigned int i = 0; i < 2; ++i)
+    {
+        const RigidBody *body = contact.body[i];
+        if (body)
+        {
+            ds_math::Vector3 bodyVelocity =
+                body->getVelocity() +
+                ds_math::Vector3::Cross(body->getRotation(),
+                                        contact.m_relativeContactPosition[i]);
+            velocity += i == 0 ? bodyVelocity : -bodyVelocity;
+        }
+    }
+    return velocity;
+}
+
+void SequentialImpulseSolver::applyImpulse(Contact &contact,
+                                           const ds_math::Vector3 &impulse)
+{
+    for (unsigned int i = 0; i < 2; ++i)
+    {
+        RigidBody *body = contact.body[i];
+
+        // Immovable bodies are only read, see Contact::matchAwakeState
+        if (body && body->hasFiniteMass())
+        {
+            ds_math::Vector3 bodyImpulse = i == 0 ? impulse : -impulse;
+
+            ds_math::Matrix3 inverseInertiaTensor;
+            body->getInverseInertiaTensorWorld(&inverseInertiaTensor);
+
+            body->addVelocity(bodyImpulse * body->getInverseMass());
+            body->addRotation(inverseInertiaTensor *
+                              ds_math::Vector3::Cross(
+                                  contact.m_relativeContactPosition[i],
+                                  bodyImpulse));
+        }
+    }
+}
+}
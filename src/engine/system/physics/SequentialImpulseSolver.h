@@ -0,0 +1,164 @@
+#pragma once
+
+#include "engine/system/physics/Contacts.h"
+#include "math/Precision.h"
+
+namespace ds_phys
+{
+/**
+ * Contact solver using sequential impulses, that is projected Gauss-Seidel
+ * iterations over every contact.
+ *
+ * Each contact keeps the total impulse it has received, clamped so that the
+ * contact only ever pushes and friction stays within its cone. Contacts
+ * start from the impulse given in Contact::impulse, so passing the impulse a
+ * contact received last step (warm starting) lets stacks settle in a handful
+ * of iterations. Penetration is then corrected by moving the bodies
+ * directly in a separate pass, so that it doesn't add any velocity and
+ * resting bodies are still able to sleep.
+ */
+class SequentialImpulseSolver
+{
+public:
+    /**
+     * SequentialImpulseSolver constructor.
+     *
+     * @param   velocityIterations   unsigned int, number of passes over the
+     * contacts resolving velocity.
+     * @param   positionIterations   unsigned int, number of passes over the
+     * contacts resolving penetration.
+     * @param   correction           ds_math::scalar, fraction of the
+     * penetration corrected by each position pass.
+     * @param   slop                 ds_math::scalar, penetration allowed
+     * without any correction, keeps resting contacts from jittering.
+     */
+    explicit SequentialImpulseSolver(unsigned int velocityIterations = 8,
+                                     unsigned int positionIterations = 3,
+                                     ds_math::scalar correction = 0.2f,
+                                     ds_math::scalar slop = 0.005f);
+
+    /**
+     * Set the number of passes made over the contacts.
+     *
+     * @param   velocityIterations   unsigned int, number of passes resolving
+     * velocity.
+     * @param   positionIterations   unsigned int, number of passes resolving
+     * penetration.
+     */
+    void setIterations(unsigned int velocityIterations,
+                       unsigned int positionIterations);
+
+    /**
+     * Set the number of passes made over the contacts, both for velocity and
+     * penetration.
+     *
+     * @param   iterations   unsigned int, number of passes.
+     */
+    void setIterations(unsigned int iterations);
+
+    /**
+     * Get the number of passes made over the contacts resolving velocity.
+     *
+     * @return   unsigned int, number of passes.
+     */
+    unsigned int getVelocityIterations() const;
+
+    /**
+     * Get the number of passes made over the contacts resolving
+     * penetration.
+     *
+     * @return   unsigned int, number of passes.
+     */
+    unsigned int getPositionIterations() const;
+
+    /**
+     * Set how penetration is corrected.
+     *
+     * @param   correction   ds_math::scalar, fraction of the penetration
+     * corrected by each position pass.
+     * @param   slop         ds_math::scalar, penetration allowed without any
+     * correction.
+     */
+    void setPositionCorrection(ds_math::scalar correction,
+                               ds_math::scalar slop);
+
+    /**
+     * Resolve a set of contacts, updating the velocities and positions of
+     * the bodies involved and the impulse of each contact.
+     *
+     * Bodies with infinite mass are only read, so sets of contacts that
+     * don't share any other bodies may be resolved at the same time.
+     *
+     * @param   contacts      Contact *, contacts to resolve.
+     * @param   numContacts   unsigned int, number of contacts.
+     * @param   duration      ds_math::scalar, duration of the step.
+     */
+    void resolveContacts(Contact *contacts,
+                         unsigned int numContacts,
+                         ds_math::scalar duration) const;
+
+private:
+    /**
+     * Calculate the contact basis, effective masses and velocity bias of a
+     * contact.
+     *
+     * @param   contact    Contact &, contact to prepare.
+     * @param   duration   ds_math::scalar, duration of the step.
+     */
+    void prepareContact(Contact &contact, ds_math::scalar duration) const;
+
+    /**
+     * Apply the starting impulse of a prepared contact.
+     *
+     * @param   contact   Contact &, contact to warm start.
+     */
+    void warmStartContact(Contact &contact) const;
+
+    /**
+     * Make one pass over a contact, updating its friction and then its
+     * normal impulse.
+     *
+     * @param   contact   Contact &, contact to solve.
+     */
+    void solveContact(Contact &contact) const;
+
+    /**
+     * Move the bodies of a contact apart to correct part of its current
+     * penetration.
+     *
+     * @param   contact   Contact &, contact to correct.
+     */
+    void correctPenetration(Contact &contact) const;
+
+    /**
+     * Get the velocity of the first body relative to the second at the
+     * contact point.
+     *
+     * @param   contact   const Contact &, contact.
+     * @return            ds_math::Vector3, relative velocity in world-space.
+     */
+    static ds_math::Vector3 getRelativeVelocity(const Contact &contact);
+
+    /**
+     * Apply an impulse to the first body of a contact and the opposite
+     * impulse to the second.
+     *
+     * @param   contact   Contact &, contact.
+     * @param   impulse   const ds_math::Vector3 &, impulse in world-space.
+     */
+    static void applyImpulse(Contact &contact,
+                             const ds_math::Vector3 &impulse);
+
+    /** Number of passes over the contacts resolving velocity. */
+    unsigned int m_velocityIterations;
+
+    /** Number of passes over the contacts resolving penetration. */
+    unsigned int m_positionIterations;
+
+    /** Fraction of the penetration corrected by each position pass. */
+    ds_math::scalar m_correction;
+
+    /** Penetration allowed without any correction. */
+    ds_math::scalar m_slop;
+};
+}
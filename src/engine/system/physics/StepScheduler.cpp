@@ -0,0 +1,159 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "engine/system/physics/StepScheduler.h"
+
+namespace ds_phys
+{
+// Weight of the newest measurement in the average step cost
+static const double STEP_COST_SMOOTHING = 0.25;
+
+// Fraction of a step that rounding in the accumulator is allowed to lose
+static const ds_math::scalar STEP_TOLERANCE = 1e-4f;
+
+StepScheduler::StepScheduler(ds_math::scalar stepSize,
+                             double budget,
+                             unsigned int maxSteps)
+    : m_stepSize(stepSize),
+      m_budget(budget),
+      m_maxSteps(maxSteps),
+      m_accumulator(0),
+      m_frameTime(0),
+      m_frameOpen(false)
+{
+    assert(stepSize > 0 && "Step size must be greater than 0.");
+
+    reset();
+}
+
+ds_math::scalar StepScheduler::getStepSize() const
+{
+    return m_stepSize;
+}
+
+void StepScheduler::setStepSize(ds_math::scalar stepSize)
+{
+    assert(stepSize > 0 && "Step size must be greater than 0.");
+
+    m_stepSize = stepSize;
+}
+
+double StepScheduler::getBudget() const
+{
+    return m_budget;
+}
+
+void StepScheduler::setBudget(double budget)
+{
+    m_budget = budget;
+}
+
+unsigned int StepScheduler::getMaxSteps() const
+{
+    return m_maxSteps;
+}
+
+void StepScheduler::setMaxSteps(unsigned int maxSteps)
+{
+    m_maxSteps = maxSteps;
+}
+
+void StepScheduler::beginFrame(ds_math::scalar deltaTime)
+{
+    // A frame that wasn't stepped to the end owes no more steps
+    if (m_frameOpen)
+    {
+        finishFrame();
+    }
+
+    m_accumulator += deltaTime;
+    m_frameTime = deltaTime;
+    m_frameOpen = true;
+
+    m_stats.steps = 0;
+    m_stats.simulatedTime = 0;
+    m_stats.droppedTime = 0;
+    m_stats.timeScale = 1;
+    m_stats.frameCost = 0;
+}
+
+bool StepScheduler::nextStep()
+{
+    if (!m_frameOpen)
+    {
+        return false;
+    }
+
+    bool owed = m_accumulator >= m_stepSize * (1 - STEP_TOLERANCE);
+
+    // The first step owed is always taken, so the simulation keeps moving
+    bool allowed = owed;
+    if (owed && m_stats.steps > 0)
+    {
+        if (m_maxSteps > 0 && m_stats.steps >= m_maxSteps)
+        {
+            allowed = false;
+        }
+        else if (m_budget > 0 &&
+                 m_stats.frameCost + m_stats.stepCost > m_budget)
+        {
+            allowed = false;
+        }
+    }
+
+    if (!allowed)
+    {
+        finishFrame();
+        return false;
+    }
+
+    m_accumulator = std::max(m_accumulator - m_stepSize, ds_math::scalar(0));
+    m_stats.simulatedTime += m_stepSize;
+    ++m_stats.steps;
+    return true;
+}
+
+void StepScheduler::recordStep(double cost)
+{
+    m_stats.frameCost += cost;
+    m_stats.stepCost =
+        m_stats.stepCost > 0
+            ? m_stats.stepCost + (cost - m_stats.stepCost) * STEP_COST_SMOOTHING
+            : cost;
+}
+
+const StepSchedulerStats &StepScheduler::getStats() const
+{
+    return m_stats;
+}
+
+void StepScheduler::reset()
+{
+    m_accumulator = 0;
+    m_frameTime = 0;
+    m_frameOpen = false;
+
+    m_stats.steps = 0;
+    m_stats.simulatedTime = 0;
+    m_stats.droppedTime = 0;
+    m_stats.totalDroppedTime = 0;
+    m_stats.timeScale = 1;
+    m_stats.frameCost = 0;
+    m_stats.stepCost = 0;
+}
+
+void StepScheduler::finishFrame()
+{
+    // Drop the whole steps still owed, keeping the part of a step left over
+    ds_math::scalar dropped =
+        std::floor(m_accumulator / m_stepSize + STEP_TOLERANCE) * m_stepSize;
+    m_accumulator = std::max(m_accumulator - dropped, ds_math::scalar(0));
+
+    m_stats.droppedTime = dropped;
+    m_stats.totalDroppedTime += dropped;
+    m_stats.timeScale =
+        m_frameTime > 0 ? m_stats.simulatedTime / m_frameTime : 1;
+    m_frameOpen = false;
+}
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+#include "math/Precision.h"
+
+namespace ds_phys
+{
+/**
+ * What a step scheduler did over the last frame.
+ */
+struct StepSchedulerStats
+{
+    /** Number of steps taken. */
+    unsigned int steps;
+
+    /** Simulation time stepped over, in seconds. */
+    ds_math::scalar simulatedTime;
+
+    /**
+     * Time owed to the simulation that was dropped to stay in budget, in
+     * seconds.
+     */
+    ds_math::scalar droppedTime;
+
+    /** Time dropped since the scheduler was created or reset, in seconds. */
+    double totalDroppedTime;
+
+    /** Simulation time stepped over per second of frame time. */
+    ds_math::scalar timeScale;
+
+    /** CPU time spent stepping, in milliseconds. */
+    double frameCost;
+
+    /** Expected CPU time of one step, in milliseconds. */
+    double stepCost;
+};
+
+/**
+ * Splits frame time into fixed steps, taking as many each frame as a CPU
+ * time budget allows.
+ *
+ * Each step's cost is measured by the caller and averaged. A frame only
+ * takes another step if the average says it will fit in what's left of the
+ * budget, so a slow frame doesn't make the next one slower still. Whole
+ * steps left over are dropped and reported, so the simulation runs slower
+ * than real time until it's back under budget. At least one step is taken
+ * whenever one is owed.
+ *
+ * Usage:
+ *
+ *     scheduler.beginFrame(deltaTime);
+ *     while (scheduler.nextStep())
+ *     {
+ *         // time world.stepSimulation(scheduler.getStepSize())
+ *         scheduler.recordStep(milliseconds);
+ *     }
+ */
+class StepScheduler
+{
+public:
+    /**
+     * StepScheduler constructor.
+     *
+     * @param   stepSize   ds_math::scalar, simulation time of each step, in
+     * seconds.
+     * @param   budget     double, CPU time allowed for stepping each frame,
+     * in milliseconds, 0 for no limit.
+     * @param   maxSteps   unsigned int, most steps taken in one frame, 0 for
+     * no limit.
+     */
+    explicit StepScheduler(ds_math::scalar stepSize = 1.0f / 60.0f,
+                           double budget = 8.0,
+                           unsigned int maxSteps = 4);
+
+    /**
+     * Get the simulation time of each step.
+     *
+     * @return   ds_math::scalar, step size, in seconds.
+     */
+    ds_math::scalar getStepSize() const;
+
+    /**
+     * Set the simulation time of each step.
+     *
+     * @param   stepSize   ds_math::scalar, step size, in seconds, greater
+     * than 0.
+     */
+    void setStepSize(ds_math::scalar stepSize);
+
+    /**
+     * Get the CPU time allowed for stepping each frame.
+     *
+     * @return   double, budget, in milliseconds, 0 for no limit.
+     */
+    double getBudget() const;
+
+    /**
+     * Set the CPU time allowed for stepping each frame.
+     *
+     * @param   budget   double, budget, in milliseconds, 0 for no limit.
+     */
+    void setBudget(double budget);
+
+    /**
+     * Get the most steps taken in one frame.
+     *
+     * @return   unsigned int, number of steps, 0 for no limit.
+     */
+    unsigned int getMaxSteps() const;
+
+    /**
+     * Set the most steps taken in one frame.
+     *
+     * @param   maxSteps   unsigned int, number of steps, 0 for no limit.
+     * @remarks With no budget, this should not be 0, otherwise the
+     * simulation may never catch up.
+     */
+    void setMaxSteps(unsigned int maxSteps);
+
+    /**
+     * Start a frame, adding its time to what the simulation is owed.
+     *
+     * @param   deltaTime   ds_math::scalar, frame time, in seconds.
+     */
+    void beginFrame(ds_math::scalar deltaTime);
+
+    /**
+     * Get whether to take another step this frame. Once this returns false,
+     * any whole steps still owed are dropped and the frame's stats are
+     * final.
+     *
+     * @return   bool, true if a step should be taken.
+     */
+    bool nextStep();
+
+    /**
+     * Record the CPU time a step took.
+     *
+     * @param   cost   double, CPU time, in milliseconds.
+     */
+    void recordStep(double cost);
+
+    /**
+     * Get what was done over the last frame.
+     *
+     * @return   const StepSchedulerStats &, stats.
+     */
+    const StepSchedulerStats &getStats() const;
+
+    /**
+     * Forget the time owed, the measured step cost and the time dropped.
+     */
+    void reset();
+
+private:
+    /**
+     * End the current frame, dropping the whole steps still owed.
+     */
+    void finishFrame();
+
+    /** Simulation time of each step, in seconds. */
+    ds_math::scalar m_stepSize;
+
+    /** CPU time allowed each frame, in milliseconds. */
+    double m_budget;
+
+    /** Most steps in one frame. */
+    unsigned int m_maxSteps;
+
+    /** Simulation time owed, in seconds. */
+    ds_math::scalar m_accumulator;
+
+    /** Length of the current frame, in seconds. */
+    ds_math::scalar m_frameTime;
+
+    /** Whether the current frame still takes steps. */
+    bool m_frameOpen;
+
+    /** Stats of the current or last frame. */
+    StepSchedulerStats m_stats;
+};
+}
@@ -0,0 +1,136 @@
+#include <algorithm>
+
+#include "engine/system/physics/WorkerPool.h"
+
+namespace ds_phys
+{
+WorkerPool::WorkerPool(unsigned int workerCount)
+    : m_workerCount(std::max(workerCount, 1u)), m_batch(0), m_busyThreads(0),
+      m_stopping(false), m_task(nullptr), m_taskCount(0), m_nextTask(0)
+{
+}
+
+WorkerPool::~WorkerPool()
+{
+    stop();
+}
+
+unsigned int WorkerPool::getWorkerCount() const
+{
+    return m_workerCount;
+}
+
+void WorkerPool::setWorkerCount(unsigned int workerCount)
+{
+    stop();
+    m_workerCount = std::max(workerCount, 1u);
+}
+
+void WorkerPool::run(unsigned int taskCount, const Task &task)
+{
+    if (m_workerCount == 1 || taskCount <= 1)
+    {
+        for (unsigned int i = 0; i < taskCount; ++i)
+        {
+            task(i, 0);
+        }
+        return;
+    }
+
+    start();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_task = &task;
+        m_taskCount = taskCount;
+        m_nextTask = 0;
+        m_busyThreads = (unsigned int)m_threads.size();
+        ++m_batch;
+    }
+    m_batchStarted.notify_all();
+
+    runTasks(0);
+
+    // Wait for the other workers so that the task may be released
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_batchFinished.wait(lock, [this]() { return m_busyThreads == 0; });
+    m_task = nullptr;
+}
+
+void WorkerPool::start()
+{
+    if (!m_threads.empty())
+    {
+        return;
+    }
+
+    // Threads started after a restart must wait for the next batch rather
+    // than the one the last threads ran
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopping = false;
+    for (unsigned int i = 1; i < m_workerCount; ++i)
+    {
+        m_threads.push_back(
+            std::thread(&WorkerPool::workerMain, this, i, m_batch));
+    }
+}
+
+void WorkerPool::stop()
+{
+    if (m_threads.empty())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_batchStarted.notify_all();
+
+    for (std::thread &thread : m_threads)
+    {
+        thread.join();
+    }
+    m_threads.clear();
+}
+
+void WorkerPool::workerMain(unsigned int worker, unsigned int batch)
+{
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_batchStarted.wait(
+                lock, [&]() { return m_stopping || m_batch != batch; });
+            if (m_stopping)
+            {
+                return;
+            }
+            batch = m_batch;
+        }
+
+        runTasks(worker);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            --m_busyThreads;
+        }
+        m_batchFinished.notify_one();
+    }
+}
+
+void WorkerPool::runTasks(unsigned int worker)
+{
+    for (;;)
+    {
+        unsigned int task = m_nextTask++;
+        if (task >= m_taskCount)
+        {
+            return;
+        }
+
+        (*m_task)(task, worker);
+    }
+}
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ds_phys
+{
+/**
+ * Small pool of persistent worker threads used to run independent physics
+ * tasks, such as resolving the contacts of separate islands, in parallel.
+ *
+ * The calling thread takes part in each run as worker 0 and the pool's
+ * threads are only started the first time they are needed.
+ */
+class WorkerPool
+{
+public:
+    /**
+     * Task callback, given the index of the task to run and the index of
+     * the worker running it.
+     */
+    typedef std::function<void(unsigned int task, unsigned int worker)> Task;
+
+    /**
+     * WorkerPool constructor.
+     *
+     * @param   workerCount   unsigned int, number of workers including the
+     * calling thread, at least 1.
+     */
+    explicit WorkerPool(unsigned int workerCount = 1);
+
+    /**
+     * WorkerPool destructor, stops and joins the worker threads.
+     */
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    /**
+     * Get the number of workers, including the calling thread.
+     *
+     * @return   unsigned int, number of workers.
+     */
+    unsigned int getWorkerCount() const;
+
+    /**
+     * Set the number of workers, including the calling thread. Any running
+     * worker threads are stopped.
+     *
+     * @param   workerCount   unsigned int, number of workers, at least 1.
+     */
+    void setWorkerCount(unsigned int workerCount);
+
+    /**
+     * Run tasks [0, taskCount) across the workers, returning once all of
+     * them are complete. Tasks are handed out in index order, but may
+     * complete in any order.
+     *
+     * @param   taskCount   unsigned int, number of tasks to run.
+     * @param   task        const Task &, function run for each task.
+     */
+    void run(unsigned int taskCount, const Task &task);
+
+private:
+    /**
+     * Start the worker threads if they aren't running.
+     */
+    void start();
+
+    /**
+     * Stop and join the worker threads.
+     */
+    void stop();
+
+    /**
+     * Worker thread entry point.
+     *
+     * @param   worker   unsigned int, index of the worker.
+     * @param   batch    unsigned int, batch current when the thread was
+     * started, the thread waits for the one after it.
+     */
+    void workerMain(unsigned int worker, unsigned int batch);
+
+    /**
+     * Run tasks from the current batch until none are left.
+     *
+     * @param   worker   unsigned int, index of the worker.
+     */
+    void runTasks(unsigned int worker);
+
+    /** Number of workers, including the calling thread. */
+    unsigned int m_workerCount;
+
+    /** Worker threads, one fewer than the number of workers. */
+    std::vector<std::thread> m_threads;
+
+    /** Guards the batch state below. */
+    std::mutex m_mutex;
+
+    /** Signalled when a new batch starts or the pool stops. */
+    std::condition_variable m_batchStarted;
+
+    /** Signalled when a worker thread finishes its part of a batch. */
+    std::condition_variable m_batchFinished;
+
+    /** Incremented for each batch so that workers can spot new ones. */
+    unsigned int m_batch;
+
+    /** Worker threads that haven't finished the current batch. */
+    unsigned int m_busyThreads;
+
+    /** Whether the worker threads should exit. */
+    bool m_stopping;
+
+    /** Task of the current batch. */
+    const Task *m_task;
+
+    /** Number of tasks in the current batch. */
+    unsigned int m_taskCount;
+
+    /** Next task of the current batch to hand out. */
+    std::atomic<unsigned int> m_nextTask;
+};
+}
@@ -0,0 +1,127 @@
+#include <algorithm>
+#include <cmath>
+
+#include "engine/system/render/BoundingVolume.h"
+
+namespace ds_render
+{
+BoundingVolume::BoundingVolume()
+    : valid(false), min(), max(), centre(), radius(0.0f)
+{
+}
+
+BoundingVolume
+BoundingVolume::FromPoints(const std::vector<ds_math::Vector3> &points)
+{
+    BoundingVolume volume;
+
+    if (!points.empty())
+    {
+        volume.valid = true;
+        volume.min = points[0];
+        volume.max = points[0];
+        for (const auto &point : points)
+        {
+            for (unsigned int i = 0; i < 3; ++i)
+            {
+                volume.min[i] = std::min(volume.min[i], point[i]);
+                volume.max[i] = std::max(volume.max[i], point[i]);
+            }
+        }
+
+        // Centre the sphere on the box, it's only as big as the furthest
+        // point rather than the box's corners
+        volume.centre = (volume.min + volume.max) * 0.5f;
+        for (const auto &point : points)
+        {
+            volume.radius = std::max(
+                volume.radius,
+                ds_math::Vector3::Magnitude(point - volume.centre));
+        }
+    }
+
+    return volume;
+}
+
+BoundingVolume BoundingVolume::Merge(const BoundingVolume &first,
+                                     const BoundingVolume &second)
+{
+    if (!first.valid)
+    {
+        return second;
+    }
+    else if (!second.valid)
+    {
+        return first;
+    }
+
+    BoundingVolume volume;
+    volume.valid = true;
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        volume.min[i] = std::min(first.min[i], second.min[i]);
+        volume.max[i] = std::max(first.max[i], second.max[i]);
+    }
+
+    // Sphere around both spheres
+    ds_math::Vector3 offset = second.centre - first.centre;
+    ds_math::scalar distance = ds_math::Vector3::Magnitude(offset);
+    if (distance + second.radius <= first.radius)
+    {
+        volume.centre = first.centre;
+        volume.radius = first.radius;
+    }
+    else if (distance + first.radius <= second.radius)
+    {
+        volume.centre = second.centre;
+        volume.radius = second.radius;
+    }
+    else
+    {
+        volume.radius = (distance + first.radius + second.radius) * 0.5f;
+        volume.centre =
+            first.centre + offset * ((volume.radius - first.radius) / distance);
+    }
+
+    return volume;
+}
+
+BoundingVolume BoundingVolume::Transform(const ds_math::Matrix4 &mat,
+                                         const BoundingVolume &volume)
+{
+    if (!volume.valid)
+    {
+        return volume;
+    }
+
+    BoundingVolume transformed;
+    transformed.valid = true;
+
+    // Move the box's centre, and grow its half extents by how much each
+    // axis of the matrix spreads them (Arvo's method)
+    ds_math::Vector3 boxCentre = (volume.min + volume.max) * 0.5f;
+    ds_math::Vector3 extents = (volume.max - volume.min) * 0.5f;
+    ds_math::Vector3 newCentre = ds_math::Matrix4::Transform(mat, boxCentre);
+    ds_math::Vector3 newExtents;
+    for (unsigned int row = 0; row < 3; ++row)
+    {
+        for (unsigned int column = 0; column < 3; ++column)
+        {
+            newExtents[row] += std::fabs(mat[column][row]) * extents[column];
+        }
+    }
+    transformed.min = newCentre - newExtents;
+    transformed.max = newCentre + newExtents;
+
+    ds_math::scalar scale = 0.0f;
+    for (unsigned int column = 0; column < 3; ++column)
+    {
+        scale = std::max(scale, ds_math::Vector3::Magnitude(
+                                    ds_math::Vector3(mat[column])));
+    }
+    transformed.centre = ds_math::Matrix4::Transform(mat, volume.centre);
+    transformed.radius = volume.radius * scale;
+
+    return transformed;
+}
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <vector>
+
+#include "math/Matrix4.h"
+#include "math/Vector3.h"
+
+namespace ds_render
+{
+/**
+ * Bounding sphere and axis-aligned bounding box around a set of points, such
+ * as the vertices of a mesh.
+ *
+ * A default constructed bounding volume is empty and bounds nothing, it's
+ * taken to mean the bounds aren't known.
+ */
+struct BoundingVolume
+{
+    /**
+     * Default constructor, create an empty bounding volume.
+     */
+    BoundingVolume();
+
+    /**
+     * Create the bounding volume of the given points.
+     *
+     * @param   points   const std::vector<ds_math::Vector3> &, points to
+     * bound.
+     * @return           BoundingVolume, bounds of the points, empty if there
+     * are none.
+     */
+    static BoundingVolume
+    FromPoints(const std::vector<ds_math::Vector3> &points);
+
+    /**
+     * Create a bounding volume that bounds both of the given ones.
+     *
+     * @param   first    const BoundingVolume &, first bounding volume.
+     * @param   second   const BoundingVolume &, second bounding volume.
+     * @return           BoundingVolume, bounds of both, empty if both are
+     * empty.
+     */
+    static BoundingVolume Merge(const BoundingVolume &first,
+                                const BoundingVolume &second);
+
+    /**
+     * Transform the given bounding volume, such as into world space.
+     *
+     * The box is grown to stay axis-aligned and the sphere is scaled by the
+     * largest scale of the matrix, so both still bound what they did.
+     *
+     * @param   mat      const ds_math::Matrix4 &, affine transform.
+     * @param   volume   const BoundingVolume &, bounding volume to transform.
+     * @return           BoundingVolume, transformed bounds, empty if the
+     * given bounds are empty.
+     */
+    static BoundingVolume Transform(const ds_math::Matrix4 &mat,
+                                    const BoundingVolume &volume);
+
+    /** Whether the volume bounds anything. */
+    bool valid;
+    /** Minimum corner of the box. */
+    ds_math::Vector3 min;
+    /** Maximum corner of the box. */
+    ds_math::Vector3 max;
+    /** Centre of the sphere. */
+    ds_math::Vector3 centre;
+    /** Radius of the sphere. */
+    ds_math::scalar radius;
+};
+}
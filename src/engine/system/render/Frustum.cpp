@@ -0,0 +1,80 @@
+#include <cmath>
+
+#include "engine/system/render/Frustum.h"
+
+namespace ds_render
+{
+Frustum::Frustum()
+{
+    // Planes of all zeros have every point on them, so nothing is outside
+    for (unsigned int i = 0; i < NUM_PLANES; ++i)
+    {
+        m_planes[i] = ds_math::Vector4(0.0f, 0.0f, 0.0f, 0.0f);
+    }
+}
+
+Frustum::Frustum(const ds_math::Matrix4 &viewProjection)
+{
+    // Matrix is column major, get its rows
+    ds_math::Vector4 rows[4];
+    for (unsigned int row = 0; row < 4; ++row)
+    {
+        rows[row] = ds_math::Vector4(
+            viewProjection[0][row], viewProjection[1][row],
+            viewProjection[2][row], viewProjection[3][row]);
+    }
+
+    // A point is in clip space when -w <= x, y, z <= w
+    m_planes[0] = rows[3] + rows[0]; // Left
+    m_planes[1] = rows[3] - rows[0]; // Right
+    m_planes[2] = rows[3] + rows[1]; // Bottom
+    m_planes[3] = rows[3] - rows[1]; // Top
+    m_planes[4] = rows[3] + rows[2]; // Near
+    m_planes[5] = rows[3] - rows[2]; // Far
+
+    for (unsigned int i = 0; i < NUM_PLANES; ++i)
+    {
+        ds_math::scalar length =
+            ds_math::Vector3::Magnitude(ds_math::Vector3(m_planes[i]));
+        if (length > 0.0f)
+        {
+            m_planes[i] *= 1.0f / length;
+        }
+    }
+}
+
+bool Frustum::Intersects(const BoundingVolume &volume) const
+{
+    if (!volume.valid)
+    {
+        return true;
+    }
+
+    ds_math::Vector3 boxCentre = (volume.min + volume.max) * 0.5f;
+    ds_math::Vector3 extents = (volume.max - volume.min) * 0.5f;
+
+    for (unsigned int i = 0; i < NUM_PLANES; ++i)
+    {
+        ds_math::Vector3 normal(m_planes[i]);
+
+        // Sphere wholly behind the plane
+        if (ds_math::Vector3::Dot(normal, volume.centre) + m_planes[i].w <
+            -volume.radius)
+        {
+            return false;
+        }
+
+        // Box wholly behind the plane, its half extents projected on the
+        // normal give how far it reaches towards the plane
+        ds_math::scalar reach = std::fabs(normal.x) * extents.x +
+                                std::fabs(normal.y) * extents.y +
+                                std::fabs(normal.z) * extents.z;
+        if (ds_math::Vector3::Dot(normal, boxCentre) + m_planes[i].w < -reach)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+}
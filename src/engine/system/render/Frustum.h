@@ -0,0 +1,59 @@
+#pragma once
+
+#include "engine/system/render/BoundingVolume.h"
+#include "math/Matrix4.h"
+#include "math/Vector4.h"
+
+namespace ds_render
+{
+/**
+ * The volume a camera can see, bounded by six planes.
+ *
+ * Used to cull objects whose bounds are wholly outside the view before any
+ * work is done to draw them.
+ */
+class Frustum
+{
+public:
+    /**
+     * Default constructor, create a frustum that contains everything.
+     */
+    Frustum();
+
+    /**
+     * Create the frustum of the given view projection matrix.
+     *
+     * The planes are taken from the rows of the matrix (Gribb and Hartmann),
+     * so the frustum is in the space the matrix transforms from, world space
+     * for projection * view.
+     *
+     * @param   viewProjection   const ds_math::Matrix4 &, projection matrix
+     * times view matrix, mapping to OpenGL clip space.
+     */
+    explicit Frustum(const ds_math::Matrix4 &viewProjection);
+
+    /**
+     * Get whether a bounding volume is at least partly inside the frustum.
+     *
+     * The sphere is tested first as it's cheaper, then the box. Empty bounds
+     * are taken to be unknown and are always inside.
+     *
+     * @param   volume   const BoundingVolume &, bounds, in the same space as
+     * the frustum.
+     * @return           bool, FALSE if the bounds are wholly outside the
+     * frustum, TRUE otherwise.
+     */
+    bool Intersects(const BoundingVolume &volume) const;
+
+private:
+    /** Number of planes bounding the frustum. */
+    static const unsigned int NUM_PLANES = 6;
+
+    /**
+     * Planes of the frustum, (normal, distance) with normals of unit length
+     * facing in, so a point p is inside a plane if dot(normal, p) + distance
+     * >= 0.
+     */
+    ds_math::Vector4 m_planes[NUM_PLANES];
+};
+}
@@ -9,6 +9,7 @@ Mesh::Mesh()
     m_vertexBuffer = VertexBufferHandle();
     m_indexBuffer = IndexBufferHandle();
     m_meshResourceHandle = MeshResourceHandle();
+    m_bounds = BoundingVolume();
 }
 
 Mesh::Mesh(VertexBufferHandle vertexBuffer,
@@ -18,6 +19,7 @@ Mesh::Mesh(VertexBufferHandle vertexBuffer,
     m_vertexBuffer = vertexBuffer;
     m_indexBuffer = indexBuffer;
     m_meshResourceHandle = meshResource;
+    m_bounds = BoundingVolume();
 }
 
 VertexBufferHandle Mesh::GetVertexBuffer() const
@@ -95,4 +97,14 @@ void Mesh::SetMeshResourceHandle(MeshResourceHandle meshResourceHandle)
 {
     m_meshResourceHandle = meshResourceHandle;
 }
+
+const BoundingVolume &Mesh::GetBounds() const
+{
+    return m_bounds;
+}
+
+void Mesh::SetBounds(const BoundingVolume &bounds)
+{
+    m_bounds = bounds;
+}
 }
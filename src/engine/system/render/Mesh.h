@@ -3,6 +3,7 @@
 #include <cstddef>
 #include <vector>
 
+#include "engine/system/render/BoundingVolume.h"
 #include "engine/system/render/RenderCommon.h"
 #include "engine/system/render/SubMesh.h"
 
@@ -150,6 +151,22 @@ public:
      */
     void SetMeshResourceHandle(MeshResourceHandle meshResourceHandle);
 
+    /**
+     * Get the bounds of the whole mesh in model space.
+     *
+     * @return  const BoundingVolume &, bounds of the mesh, empty if not known,
+     *          in which case the mesh is never culled.
+     */
+    const BoundingVolume &GetBounds() const;
+
+    /**
+     * Set the bounds of the whole mesh in model space.
+     *
+     * @param  bounds  const BoundingVolume &, bounds of the mesh, empty if not
+     *                 known.
+     */
+    void SetBounds(const BoundingVolume &bounds);
+
 private:
     /** Vertex buffer of mesh */
     VertexBufferHandle m_vertexBuffer;
@@ -159,6 +176,8 @@ private:
     std::vector<SubMesh> m_subMeshes;
     /** Handle to MeshResource used to create this Mesh */
     MeshResourceHandle m_meshResourceHandle;
+    /** Bounds of the mesh in model space */
+    BoundingVolume m_bounds;
     // size_t m_startingIndex;
     // size_t m_numIndices;
 };
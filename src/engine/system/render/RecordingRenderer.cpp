@@ -0,0 +1,535 @@
+#include "engine/system/render/RecordingRenderer.h"
+
+namespace ds_render
+{
+// Name of each command, in the order of RecordedCommandType
+static const char *const s_commandNames[] = {
+    "Init",
+    "SetClearColour",
+    "ClearBuffers",
+    "SetDepthWriting",
+    "SetBlending",
+    "ResizeViewport",
+    "CreateVertexBuffer",
+    "CreateIndexBuffer",
+    "CreateShaderObject",
+    "CreateProgram",
+    "SetProgram",
+    "Create2DTexture",
+    "CreateCubemapTexture",
+    "BindTextureToSampler",
+    "UnbindTextureFromSampler",
+    "GetConstantBufferDescription",
+    "CreateConstantBuffer",
+    "BindConstantBuffer",
+    "UpdateConstantBufferData",
+    "DrawVertices",
+    "DrawVerticesIndexed",
+    "UpdateProgramParameter"};
+
+static size_t GetImageBytes(ImageFormat format,
+                            RenderDataType imageDataType,
+                            unsigned int width,
+                            unsigned int height)
+{
+    size_t components = 0;
+    switch (format)
+    {
+    case ImageFormat::R:
+        components = 1;
+        break;
+    case ImageFormat::RG:
+        components = 2;
+        break;
+    case ImageFormat::RGB:
+        components = 3;
+        break;
+    case ImageFormat::RGBA:
+        components = 4;
+        break;
+    }
+
+    size_t componentSize = 0;
+    switch (imageDataType)
+    {
+    case RenderDataType::Int:
+        componentSize = sizeof(int);
+        break;
+    case RenderDataType::Float:
+        componentSize = sizeof(float);
+        break;
+    case RenderDataType::UnsignedByte:
+        componentSize = sizeof(unsigned char);
+        break;
+    }
+
+    return components * componentSize * width * height;
+}
+
+static size_t
+GetParameterBytes(ShaderParameter::ShaderParameterType parameterType)
+{
+    switch (parameterType)
+    {
+    case ShaderParameter::ShaderParameterType::Float:
+        return sizeof(float);
+    case ShaderParameter::ShaderParameterType::Int:
+        return sizeof(int);
+    case ShaderParameter::ShaderParameterType::Matrix4:
+        return 16 * sizeof(float);
+    case ShaderParameter::ShaderParameterType::Vector3:
+        return 3 * sizeof(float);
+    case ShaderParameter::ShaderParameterType::Vector4:
+        return 4 * sizeof(float);
+    default:
+        return 0;
+    }
+}
+
+RecordingRenderer::RecordingRenderer(bool record)
+    : m_record(record),
+      m_depthWriting(true),
+      m_blending(false),
+      m_viewportWidth(0),
+      m_viewportHeight(0)
+{
+    // Match the defaults of a new OpenGL context
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        m_clearColour[i] = 0.0f;
+    }
+
+    ResetStats();
+}
+
+const RenderStats &RecordingRenderer::GetStats() const
+{
+    return m_stats;
+}
+
+void RecordingRenderer::ResetStats()
+{
+    m_stats.drawCalls = 0;
+    m_stats.verticesDrawn = 0;
+    m_stats.stateChanges = 0;
+    m_stats.redundantStateChanges = 0;
+    m_stats.bytesUploaded = 0;
+    m_stats.objectsCreated = 0;
+    m_stats.invalidHandles = 0;
+}
+
+void RecordingRenderer::SetRecording(bool record)
+{
+    m_record = record;
+}
+
+const std::vector<RecordedCommand> &RecordingRenderer::GetCommands() const
+{
+    return m_commands;
+}
+
+void RecordingRenderer::ClearCommands()
+{
+    m_commands.clear();
+}
+
+void RecordingRenderer::WriteCommands(std::ostream &out) const
+{
+    for (const RecordedCommand &command : m_commands)
+    {
+        out << s_commandNames[(int)command.type];
+        if (command.handle != 0)
+        {
+            out << " handle=" << command.handle;
+        }
+        if (command.secondHandle != 0)
+        {
+            out << " second=" << command.secondHandle;
+        }
+        if (command.count != 0)
+        {
+            out << " count=" << command.count;
+        }
+        if (command.bytes != 0)
+        {
+            out << " bytes=" << command.bytes;
+        }
+        if (!command.name.empty())
+        {
+            out << " name=" << command.name;
+        }
+        out << "\n";
+    }
+}
+
+bool RecordingRenderer::Init(unsigned int viewportWidth,
+                             unsigned int viewportHeight)
+{
+    m_viewportWidth = viewportWidth;
+    m_viewportHeight = viewportHeight;
+
+    Record(RecordedCommandType::Init);
+
+    return true;
+}
+
+void RecordingRenderer::SetClearColour(float r, float g, float b, float a)
+{
+    const float colour[4] = {r, g, b, a};
+    bool redundant = true;
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        redundant &= m_clearColour[i] == colour[i];
+        m_clearColour[i] = colour[i];
+    }
+
+    CountStateChange(redundant);
+    Record(RecordedCommandType::SetClearColour);
+}
+
+void RecordingRenderer::ClearBuffers(bool colour, bool depth, bool stencil)
+{
+    // Buffers cleared as bits, colour first
+    Record(RecordedCommandType::ClearBuffers, ds::Handle(), ds::Handle(),
+           (colour ? 1 : 0) | (depth ? 2 : 0) | (stencil ? 4 : 0));
+}
+
+void RecordingRenderer::SetDepthWriting(bool enableDisableDepthWriting)
+{
+    CountStateChange(m_depthWriting == enableDisableDepthWriting);
+    m_depthWriting = enableDisableDepthWriting;
+
+    Record(RecordedCommandType::SetDepthWriting, ds::Handle(), ds::Handle(),
+           enableDisableDepthWriting ? 1 : 0);
+}
+
+void RecordingRenderer::SetBlending(bool enableBlending)
+{
+    CountStateChange(m_blending == enableBlending);
+    m_blending = enableBlending;
+
+    Record(RecordedCommandType::SetBlending, ds::Handle(), ds::Handle(),
+           enableBlending ? 1 : 0);
+}
+
+void RecordingRenderer::ResizeViewport(unsigned int newViewportWidth,
+                                       unsigned int newViewportHeight)
+{
+    CountStateChange(m_viewportWidth == newViewportWidth &&
+                     m_viewportHeight == newViewportHeight);
+    m_viewportWidth = newViewportWidth;
+    m_viewportHeight = newViewportHeight;
+
+    Record(RecordedCommandType::ResizeViewport);
+}
+
+VertexBufferHandle RecordingRenderer::CreateVertexBuffer(
+    BufferUsageType usage,
+    const VertexBufferDescription &description,
+    size_t numBytes,
+    const void *data)
+{
+    VertexBufferHandle handle =
+        CreateObject(ObjectType::VertexBuffer, numBytes);
+    Record(RecordedCommandType::CreateVertexBuffer, handle, ds::Handle(), 0,
+           numBytes);
+
+    return handle;
+}
+
+IndexBufferHandle RecordingRenderer::CreateIndexBuffer(BufferUsageType usage,
+                                                       size_t numBytes,
+                                                       const void *data)
+{
+    IndexBufferHandle handle = CreateObject(ObjectType::IndexBuffer, numBytes);
+    Record(RecordedCommandType::CreateIndexBuffer, handle, ds::Handle(), 0,
+           numBytes);
+
+    return handle;
+}
+
+ShaderHandle RecordingRenderer::CreateShaderObject(ShaderType shaderType,
+                                                   size_t shaderSourceSize,
+                                                   const char *shaderSource)
+{
+    ShaderHandle handle = CreateObject(ObjectType::Shader, shaderSourceSize);
+    Record(RecordedCommandType::CreateShaderObject, handle, ds::Handle(), 0,
+           shaderSourceSize);
+
+    return handle;
+}
+
+ProgramHandle
+RecordingRenderer::CreateProgram(const std::vector<ShaderHandle> &shaders)
+{
+    for (ShaderHandle shader : shaders)
+    {
+        CheckHandle(shader, ObjectType::Shader);
+    }
+
+    ProgramHandle handle = CreateObject(ObjectType::Program, 0);
+    Record(RecordedCommandType::CreateProgram, handle, ds::Handle(),
+           shaders.size());
+
+    return handle;
+}
+
+void RecordingRenderer::SetProgram(ProgramHandle programHandle)
+{
+    CheckHandle(programHandle, ObjectType::Program);
+
+    CountStateChange((uint32_t)m_program == (uint32_t)programHandle);
+    m_program = programHandle;
+
+    Record(RecordedCommandType::SetProgram, programHandle);
+}
+
+RenderTextureHandle
+RecordingRenderer::Create2DTexture(ImageFormat format,
+                                   RenderDataType imageDataType,
+                                   InternalImageFormat internalFormat,
+                                   bool generateMipMaps,
+                                   unsigned int width,
+                                   unsigned int height,
+                                   const void *data)
+{
+    size_t bytes = GetImageBytes(format, imageDataType, width, height);
+    RenderTextureHandle handle = CreateObject(ObjectType::Texture, bytes);
+    Record(RecordedCommandType::Create2DTexture, handle, ds::Handle(), 0,
+           bytes);
+
+    return handle;
+}
+
+RenderTextureHandle
+RecordingRenderer::CreateCubemapTexture(ImageFormat format,
+                                        RenderDataType imageDataType,
+                                        InternalImageFormat internalFormat,
+                                        unsigned int width,
+                                        unsigned int height,
+                                        const void *dataFrontImage,
+                                        const void *dataBackImage,
+                                        const void *dataLeftImage,
+                                        const void *dataRightImage,
+                                        const void *dataTopImage,
+                                        const void *dataBottomImage)
+{
+    size_t bytes = 6 * GetImageBytes(format, imageDataType, width, height);
+    RenderTextureHandle handle = CreateObject(ObjectType::Texture, bytes);
+    Record(RecordedCommandType::CreateCubemapTexture, handle, ds::Handle(), 0,
+           bytes);
+
+    return handle;
+}
+
+void RecordingRenderer::BindTextureToSampler(ProgramHandle programHandle,
+                                             const std::string &samplerName,
+                                             const TextureType &samplerType,
+                                             RenderTextureHandle textureHandle)
+{
+    CheckHandle(programHandle, ObjectType::Program);
+    CheckHandle(textureHandle, ObjectType::Texture);
+
+    auto key = std::make_pair((uint32_t)programHandle, samplerName);
+    auto it = m_samplerTextures.find(key);
+    CountStateChange(it != m_samplerTextures.end() &&
+                     it->second == (uint32_t)textureHandle);
+    m_samplerTextures[key] = (uint32_t)textureHandle;
+
+    Record(RecordedCommandType::BindTextureToSampler, programHandle,
+           textureHandle, 0, 0, samplerName);
+}
+
+void RecordingRenderer::UnbindTextureFromSampler(
+    const TextureType &samplerType, RenderTextureHandle textureHandle)
+{
+    CheckHandle(textureHandle, ObjectType::Texture);
+
+    // Unbinding a texture unbinds it from every sampler it was bound to
+    bool bound = false;
+    for (auto it = m_samplerTextures.begin(); it != m_samplerTextures.end();)
+    {
+        if (it->second == (uint32_t)textureHandle)
+        {
+            it = m_samplerTextures.erase(it);
+            bound = true;
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    CountStateChange(!bound);
+    Record(RecordedCommandType::UnbindTextureFromSampler, textureHandle);
+}
+
+void RecordingRenderer::GetConstantBufferDescription(
+    ProgramHandle programHandle,
+    const std::string &constantBufferName,
+    ConstantBufferDescription *constantBufferDescription)
+{
+    CheckHandle(programHandle, ObjectType::Program);
+
+    if (constantBufferDescription != nullptr)
+    {
+        std::vector<std::string> memberNames =
+            constantBufferDescription->GetMemberNames();
+        for (const std::string &memberName : memberNames)
+        {
+            constantBufferDescription->SetMemberOffset(memberName, 0);
+        }
+    }
+
+    Record(RecordedCommandType::GetConstantBufferDescription, programHandle,
+           ds::Handle(), 0, 0, constantBufferName);
+}
+
+ConstantBufferHandle RecordingRenderer::CreateConstantBuffer(
+    const ConstantBufferDescription &constantBufferDescription)
+{
+    size_t bytes = constantBufferDescription.GetBufferSize();
+    ConstantBufferHandle handle =
+        CreateObject(ObjectType::ConstantBuffer, bytes);
+    Record(RecordedCommandType::CreateConstantBuffer, handle, ds::Handle(), 0,
+           bytes);
+
+    return handle;
+}
+
+void RecordingRenderer::BindConstantBuffer(
+    ProgramHandle programHandle,
+    const std::string &constantBufferName,
+    ConstantBufferHandle constantBufferHandle)
+{
+    CheckHandle(programHandle, ObjectType::Program);
+    CheckHandle(constantBufferHandle, ObjectType::ConstantBuffer);
+
+    auto key = std::make_pair((uint32_t)programHandle, constantBufferName);
+    auto it = m_constantBuffers.find(key);
+    CountStateChange(it != m_constantBuffers.end() &&
+                     it->second == (uint32_t)constantBufferHandle);
+    m_constantBuffers[key] = (uint32_t)constantBufferHandle;
+
+    Record(RecordedCommandType::BindConstantBuffer, programHandle,
+           constantBufferHandle, 0, 0, constantBufferName);
+}
+
+void RecordingRenderer::UpdateConstantBufferData(
+    ConstantBufferHandle constantBufferHandle,
+    const ConstantBufferDescription &constantBufferDescription)
+{
+    CheckHandle(constantBufferHandle, ObjectType::ConstantBuffer);
+
+    size_t bytes = constantBufferDescription.GetBufferSize();
+    m_stats.bytesUploaded += bytes;
+
+    Record(RecordedCommandType::UpdateConstantBufferData, constantBufferHandle,
+           ds::Handle(), 0, bytes);
+}
+
+void RecordingRenderer::DrawVertices(VertexBufferHandle buffer,
+                                     PrimitiveType primitiveType,
+                                     size_t startingVertex,
+                                     size_t numVertices)
+{
+    if (CheckHandle(buffer, ObjectType::VertexBuffer))
+    {
+        ++m_stats.drawCalls;
+        m_stats.verticesDrawn += numVertices;
+    }
+
+    Record(RecordedCommandType::DrawVertices, buffer, ds::Handle(),
+           numVertices);
+}
+
+void RecordingRenderer::DrawVerticesIndexed(VertexBufferHandle buffer,
+                                            IndexBufferHandle indexBuffer,
+                                            PrimitiveType primitiveType,
+                                            size_t startingIndex,
+                                            size_t numIndices)
+{
+    bool valid = CheckHandle(buffer, ObjectType::VertexBuffer);
+    valid &= CheckHandle(indexBuffer, ObjectType::IndexBuffer);
+    if (valid)
+    {
+        ++m_stats.drawCalls;
+        m_stats.verticesDrawn += numIndices;
+    }
+
+    Record(RecordedCommandType::DrawVerticesIndexed, buffer, indexBuffer,
+           numIndices);
+}
+
+void RecordingRenderer::UpdateProgramParameter(
+    ProgramHandle programHandle,
+    const std::string &parameterName,
+    ShaderParameter::ShaderParameterType parameterType,
+    const void *parameterData)
+{
+    CheckHandle(programHandle, ObjectType::Program);
+
+    size_t bytes =
+        parameterData != nullptr ? GetParameterBytes(parameterType) : 0;
+    m_stats.bytesUploaded += bytes;
+
+    Record(RecordedCommandType::UpdateProgramParameter, programHandle,
+           ds::Handle(), 0, bytes, parameterName);
+}
+
+ds::Handle RecordingRenderer::CreateObject(ObjectType type, size_t bytes)
+{
+    RecordedObject object;
+    object.type = type;
+    object.bytes = bytes;
+    m_objects.push_back(object);
+
+    ++m_stats.objectsCreated;
+    m_stats.bytesUploaded += bytes;
+
+    return m_handleManager.Add(&m_objects.back(), (uint32_t)type);
+}
+
+bool RecordingRenderer::CheckHandle(ds::Handle handle, ObjectType type)
+{
+    const RecordedObject *object =
+        static_cast<const RecordedObject *>(m_handleManager.Get(handle));
+
+    bool valid = object != nullptr && object->type == type;
+    if (!valid)
+    {
+        ++m_stats.invalidHandles;
+    }
+
+    return valid;
+}
+
+void RecordingRenderer::CountStateChange(bool redundant)
+{
+    ++m_stats.stateChanges;
+    if (redundant)
+    {
+        ++m_stats.redundantStateChanges;
+    }
+}
+
+void RecordingRenderer::Record(RecordedCommandType type,
+                               ds::Handle handle,
+                               ds::Handle secondHandle,
+                               size_t count,
+                               size_t bytes,
+                               const std::string &name)
+{
+    if (m_record)
+    {
+        RecordedCommand command;
+        command.type = type;
+        command.handle = handle;
+        command.secondHandle = secondHandle;
+        command.count = count;
+        command.bytes = bytes;
+        command.name = name;
+        m_commands.push_back(command);
+    }
+}
+}
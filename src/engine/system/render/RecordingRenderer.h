@@ -0,0 +1,376 @@
+#pragma once
+
+#include <deque>
+#include <map>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "engine/common/HandleManager.h"
+#include "engine/system/render/IRenderer.h"
+
+namespace ds_render
+{
+/**
+ * Counts of the work given to a renderer.
+ */
+struct RenderStats
+{
+    /** Number of draw calls. */
+    unsigned int drawCalls;
+
+    /** Number of vertices or indices drawn. */
+    size_t verticesDrawn;
+
+    /**
+     * Number of calls that change render state, such as the program,
+     * blending or bound textures.
+     */
+    unsigned int stateChanges;
+
+    /** Number of state changes that set the state it already had. */
+    unsigned int redundantStateChanges;
+
+    /**
+     * Number of bytes given to the renderer, in buffers, textures, shader
+     * sources and program parameters.
+     */
+    size_t bytesUploaded;
+
+    /** Number of objects created, such as buffers, shaders and textures. */
+    unsigned int objectsCreated;
+
+    /** Number of calls given a handle of the wrong type or no object. */
+    unsigned int invalidHandles;
+};
+
+/**
+ * Type of a command given to a recording renderer, one for each IRenderer
+ * method.
+ */
+enum class RecordedCommandType
+{
+    Init,
+    SetClearColour,
+    ClearBuffers,
+    SetDepthWriting,
+    SetBlending,
+    ResizeViewport,
+    CreateVertexBuffer,
+    CreateIndexBuffer,
+    CreateShaderObject,
+    CreateProgram,
+    SetProgram,
+    Create2DTexture,
+    CreateCubemapTexture,
+    BindTextureToSampler,
+    UnbindTextureFromSampler,
+    GetConstantBufferDescription,
+    CreateConstantBuffer,
+    BindConstantBuffer,
+    UpdateConstantBufferData,
+    DrawVertices,
+    DrawVerticesIndexed,
+    UpdateProgramParameter
+};
+
+/**
+ * A command given to a recording renderer.
+ */
+struct RecordedCommand
+{
+    /** Method called. */
+    RecordedCommandType type;
+
+    /** Object the command created or acts on, if any. */
+    uint32_t handle;
+
+    /** Second object the command uses, such as an index buffer, if any. */
+    uint32_t secondHandle;
+
+    /**
+     * Number the command was given, such as a vertex count or a flag, 0 if
+     * it has none.
+     */
+    size_t count;
+
+    /** Number of bytes the command uploaded. */
+    size_t bytes;
+
+    /** Name the command was given, such as a sampler name, if any. */
+    std::string name;
+};
+
+/**
+ * Renderer that draws nothing, for running the render system without a GPU.
+ *
+ * Handles are allocated as they would be by a real renderer, and the work
+ * given to the renderer is counted in its stats. The commands can also be
+ * recorded and written out, so that a frame's command stream can be compared
+ * against a known one.
+ *
+ * There are no shaders to lay out constant buffers, so every member is given
+ * an offset of 0. Writes the caller sized the buffer for stay in bounds.
+ */
+class RecordingRenderer : public IRenderer
+{
+public:
+    /**
+     * RecordingRenderer constructor.
+     *
+     * @param   record   bool, TRUE to record the commands given, FALSE to only
+     * count them.
+     */
+    explicit RecordingRenderer(bool record = false);
+
+    /**
+     * Get the counts of the work given to the renderer since it was created or
+     * its stats were reset.
+     *
+     * @return   const RenderStats &, stats.
+     */
+    const RenderStats &GetStats() const;
+
+    /**
+     * Reset the stats to zero, such as at the start of a frame.
+     */
+    void ResetStats();
+
+    /**
+     * Set whether the commands given are recorded.
+     *
+     * @param   record   bool, TRUE to record the commands given, FALSE to only
+     * count them.
+     */
+    void SetRecording(bool record);
+
+    /**
+     * Get the commands recorded since recording began or the commands were
+     * cleared.
+     *
+     * @return   const std::vector<RecordedCommand> &, commands, oldest first.
+     */
+    const std::vector<RecordedCommand> &GetCommands() const;
+
+    /**
+     * Forget the commands recorded.
+     */
+    void ClearCommands();
+
+    /**
+     * Write the commands recorded as text, one command per line.
+     *
+     * @param   out   std::ostream &, stream to write to.
+     */
+    void WriteCommands(std::ostream &out) const;
+
+    /// @copydoc IRenderer::Init
+    virtual bool Init(unsigned int viewportWidth, unsigned int viewportHeight);
+
+    /// @copydoc IRenderer::SetClearColour
+    virtual void SetClearColour(float r, float g, float b, float a);
+
+    /// @copydoc IRenderer::ClearBuffers
+    virtual void
+    ClearBuffers(bool colour = true, bool depth = true, bool stencil = true);
+
+    /// @copydoc IRenderer::SetDepthWriting
+    virtual void SetDepthWriting(bool enableDisableDepthWriting);
+
+    /// @copydoc IRenderer::SetBlending
+    virtual void SetBlending(bool enableBlending);
+
+    /// @copydoc IRenderer::ResizeViewport
+    virtual void ResizeViewport(unsigned int newViewportWidth,
+                                unsigned int newViewportHeight);
+
+    /// @copydoc IRenderer::CreateVertexBuffer
+    virtual VertexBufferHandle
+    CreateVertexBuffer(BufferUsageType usage,
+                       const VertexBufferDescription &description,
+                       size_t numBytes,
+                       const void *data);
+
+    /// @copydoc IRenderer::CreateIndexBuffer
+    virtual IndexBufferHandle CreateIndexBuffer(BufferUsageType usage,
+                                                size_t numBytes,
+                                                const void *data);
+
+    /// @copydoc IRenderer::CreateShaderObject
+    virtual ShaderHandle CreateShaderObject(ShaderType shaderType,
+                                            size_t shaderSourceSize,
+                                            const char *shaderSource);
+
+    /// @copydoc IRenderer::CreateProgram
+    virtual ProgramHandle
+    CreateProgram(const std::vector<ShaderHandle> &shaders);
+
+    /// @copydoc IRenderer::SetProgram
+    virtual void SetProgram(ProgramHandle programHandle);
+
+    /// @copydoc IRenderer::Create2DTexture
+    virtual RenderTextureHandle
+    Create2DTexture(ImageFormat format,
+                    RenderDataType imageDataType,
+                    InternalImageFormat internalFormat,
+                    bool generateMipMaps,
+                    unsigned int width,
+                    unsigned int height,
+                    const void *data);
+
+    /// @copydoc IRenderer::CreateCubemapTexture
+    virtual RenderTextureHandle
+    CreateCubemapTexture(ImageFormat format,
+                         RenderDataType imageDataType,
+                         InternalImageFormat internalFormat,
+                         unsigned int width,
+                         unsigned int height,
+                         const void *dataFrontImage,
+                         const void *dataBackImage,
+                         const void *dataLeftImage,
+                         const void *dataRightImage,
+                         const void *dataTopImage,
+                         const void *dataBottomImage);
+
+    /// @copydoc IRenderer::BindTextureToSampler
+    virtual void BindTextureToSampler(ProgramHandle programHandle,
+                                      const std::string &samplerName,
+                                      const TextureType &samplerType,
+                                      RenderTextureHandle textureHandle);
+
+    /// @copydoc IRenderer::UnbindTextureFromSampler
+    virtual void UnbindTextureFromSampler(const TextureType &samplerType,
+                                          RenderTextureHandle textureHandle);
+
+    /// @copydoc IRenderer::GetConstantBufferDescription
+    virtual void GetConstantBufferDescription(
+        ProgramHandle programHandle,
+        const std::string &constantBufferName,
+        ConstantBufferDescription *constantBufferDescription);
+
+    /// @copydoc IRenderer::CreateConstantBuffer
+    virtual ConstantBufferHandle CreateConstantBuffer(
+        const ConstantBufferDescription &constantBufferDescription);
+
+    /// @copydoc IRenderer::BindConstantBuffer
+    virtual void BindConstantBuffer(ProgramHandle programHandle,
+                                    const std::string &constantBufferName,
+                                    ConstantBufferHandle constantBufferHandle);
+
+    /// @copydoc IRenderer::UpdateConstantBufferData
+    virtual void UpdateConstantBufferData(
+        ConstantBufferHandle constantBufferHandle,
+        const ConstantBufferDescription &constantBufferDescription);
+
+    /// @copydoc IRenderer::DrawVertices
+    virtual void DrawVertices(VertexBufferHandle buffer,
+                              PrimitiveType primitiveType,
+                              size_t startingVertex,
+                              size_t numVertices);
+
+    /// @copydoc IRenderer::DrawVerticesIndexed
+    virtual void DrawVerticesIndexed(VertexBufferHandle buffer,
+                                     IndexBufferHandle indexBuffer,
+                                     PrimitiveType primitiveType,
+                                     size_t startingIndex,
+                                     size_t numIndices);
+
+    /// @copydoc IRenderer::UpdateProgramParameter
+    virtual void
+    UpdateProgramParameter(ProgramHandle programHandle,
+                           const std::string &parameterName,
+                           ShaderParameter::ShaderParameterType parameterType,
+                           const void *parameterData);
+
+private:
+    /**
+     * Type of an object the renderer has handed out a handle to.
+     */
+    enum class ObjectType
+    {
+        VertexBuffer,
+        IndexBuffer,
+        Shader,
+        Program,
+        Texture,
+        ConstantBuffer
+    };
+
+    /**
+     * Create an object and hand out a handle to it.
+     *
+     * @param   type    ObjectType, type of the object.
+     * @param   bytes   size_t, number of bytes uploaded to create it.
+     * @return          ds::Handle, handle to the object.
+     */
+    ds::Handle CreateObject(ObjectType type, size_t bytes);
+
+    /**
+     * Get whether a handle is to an object of the given type, counting it as
+     * invalid if it isn't.
+     *
+     * @param   handle   ds::Handle, handle to check.
+     * @param   type     ObjectType, type the object should have.
+     * @return           bool, TRUE if the handle is to an object of the type,
+     * FALSE otherwise.
+     */
+    bool CheckHandle(ds::Handle handle, ObjectType type);
+
+    /**
+     * Count a state change, and whether it changed nothing.
+     *
+     * @param   redundant   bool, TRUE if the state already had the value set.
+     */
+    void CountStateChange(bool redundant);
+
+    /**
+     * Record a command, if recording.
+     *
+     * @param   type           RecordedCommandType, method called.
+     * @param   handle         ds::Handle, object the command acts on.
+     * @param   secondHandle   ds::Handle, second object the command uses.
+     * @param   count          size_t, number the command was given.
+     * @param   bytes          size_t, number of bytes uploaded.
+     * @param   name           const std::string &, name the command was
+     * given.
+     */
+    void Record(RecordedCommandType type,
+                ds::Handle handle = ds::Handle(),
+                ds::Handle secondHandle = ds::Handle(),
+                size_t count = 0,
+                size_t bytes = 0,
+                const std::string &name = std::string());
+
+    /** Object a handle refers to. */
+    struct RecordedObject
+    {
+        ObjectType type;
+        size_t bytes;
+    };
+
+    /** Objects created, a deque so their addresses never change. */
+    std::deque<RecordedObject> m_objects;
+    /** Hands out handles to the objects. */
+    ds::HandleManager m_handleManager;
+
+    /** Work given so far. */
+    RenderStats m_stats;
+
+    /** Whether commands are recorded. */
+    bool m_record;
+    /** Commands recorded. */
+    std::vector<RecordedCommand> m_commands;
+
+    /** Current state, used to spot state changes that change nothing. */
+    float m_clearColour[4];
+    bool m_depthWriting;
+    bool m_blending;
+    unsigned int m_viewportWidth, m_viewportHeight;
+    ProgramHandle m_program;
+    /** Texture bound to each sampler of each program. */
+    std::map<std::pair<uint32_t, std::string>, uint32_t> m_samplerTextures;
+    /** Constant buffer bound to each block of each program. */
+    std::map<std::pair<uint32_t, std::string>, uint32_t> m_constantBuffers;
+};
+}
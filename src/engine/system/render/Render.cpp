@@ -8,6 +8,7 @@
 #include "engine/resource/ShaderResource.h"
 #include "engine/resource/TerrainResource.h"
 #include "engine/resource/TextureResource.h"
+#include "engine/system/render/Frustum.h"
 #include "engine/system/render/GLRenderer.h"
 #include "engine/system/render/Render.h"
 #include "math/MathHelper.h"
@@ -489,6 +490,93 @@ void Render::SetAnimationIndex(Entity entity, int animationIndex)
     }
 }
 
+bool Render::InitRenderer(std::unique_ptr<ds_render::IRenderer> renderer)
+{
+    if (m_renderer != nullptr || renderer == nullptr)
+    {
+        return false;
+    }
+
+    m_renderer = std::move(renderer);
+
+    m_renderer->Init(m_windowWidth, m_windowHeight);
+
+    m_renderer->SetBlending(true);
+
+    // Need a program to get information about Scene and Object constant
+    // buffers, so create a "fake" one.
+    // Create shader program
+    std::unique_ptr<ShaderResource> shaderResource =
+        m_factory.CreateResource<ShaderResource>(
+            "../assets/constantBuffer.shader");
+
+    // Load each shader
+    std::vector<ds_render::ShaderHandle> shaders;
+    std::vector<ds_render::ShaderType> shaderTypes =
+        shaderResource->GetShaderTypes();
+    for (auto shaderType : shaderTypes)
+    {
+        const std::string &shaderSource =
+            shaderResource->GetShaderSource(shaderType);
+
+        // Append shader to list
+        shaders.push_back(m_renderer->CreateShaderObject(
+            shaderType, shaderSource.size(), shaderSource.c_str()));
+    }
+    // Compile shaders into shader program
+    ds_render::ProgramHandle fakeShader = m_renderer->CreateProgram(shaders);
+
+    // Set shader data descriptions
+    // Allocate space for view and projection matrices
+    m_sceneBufferDescrip =
+        ds_render::ConstantBufferDescription(2 * sizeof(ds_math::Matrix4));
+    m_sceneBufferDescrip.AddMember("Scene.viewMatrix");
+    m_sceneBufferDescrip.AddMember("Scene.projectionMatrix");
+    m_renderer->GetConstantBufferDescription(fakeShader, "Scene",
+                                             &m_sceneBufferDescrip);
+
+    // Allocate space for model matrix and bone transforms
+    m_objectBufferDescrip = ds_render::ConstantBufferDescription(
+        1 * sizeof(ds_math::Matrix4) +
+        MeshResource::MAX_BONES * sizeof(ds_math::Matrix4));
+    // Add model matrix description
+    m_objectBufferDescrip.AddMember("Object.modelMatrix");
+    // Add bone transform descriptions
+    m_objectBufferDescrip.AddMember("Object.boneTransforms");
+    // Ask renderer to construct constant buffer
+    m_renderer->GetConstantBufferDescription(fakeShader, "Object",
+                                             &m_objectBufferDescrip);
+
+    // Create shader data
+    // Insert default data for view and projection matrix
+    m_viewMatrix = ds_math::Matrix4(1.0f);
+    m_projectionMatrix = ds_math::Matrix4::CreatePerspectiveFieldOfView(
+        ds_math::MathHelper::PI / 3.0f,
+        (float)m_windowWidth / (float)m_windowHeight, 0.1f, 100.0f);
+    m_sceneBufferDescrip.InsertMemberData(
+        "Scene.viewMatrix", sizeof(ds_math::Matrix4), &m_viewMatrix);
+    m_sceneBufferDescrip.InsertMemberData("Scene.projectionMatrix",
+                                          sizeof(ds_math::Matrix4),
+                                          &m_projectionMatrix);
+
+    // Insert default data for model matrix and bone transforms
+    ds_math::Matrix4 modelMatrix = ds_math::Matrix4(1.0f);
+    m_objectBufferDescrip.InsertMemberData(
+        "Object.modelMatrix", sizeof(ds_math::Matrix4), &modelMatrix);
+
+    std::vector<ds_math::Matrix4> identityMatrices(
+        MeshResource::MAX_BONES, ds_math::Matrix4(1.0f));
+    m_objectBufferDescrip.InsertMemberData(
+        "Object.boneTransforms",
+        MeshResource::MAX_BONES * sizeof(ds_math::Matrix4),
+        &identityMatrices[0]);
+
+    m_sceneMatrices = m_renderer->CreateConstantBuffer(m_sceneBufferDescrip);
+    m_objectMatrices = m_renderer->CreateConstantBuffer(m_objectBufferDescrip);
+
+    return true;
+}
+
 void Render::ProcessEvents(ds_msg::MessageStream *messages)
 {
     while (messages->AvailableBytes() != 0)
@@ -511,97 +599,9 @@ void Render::ProcessEvents(ds_msg::MessageStream *messages)
                 switch (gfxContext.contextInfo.type)
                 {
                 case ds_platform::GraphicsContext::ContextType::OpenGL:
-                {
-                    m_renderer = std::unique_ptr<ds_render::IRenderer>(
-                        new ds_render::GLRenderer());
-
-                    m_renderer->Init(m_windowWidth, m_windowHeight);
-
-                    m_renderer->SetBlending(true);
-
-                    // Need a program to get information about Scene and Object
-                    // constant
-                    // buffers, so create a "fake" one.
-                    // Create shader program
-                    std::unique_ptr<ShaderResource> shaderResource =
-                        m_factory.CreateResource<ShaderResource>(
-                            "../assets/constantBuffer.shader");
-
-                    // Load each shader
-                    std::vector<ds_render::ShaderHandle> shaders;
-                    std::vector<ds_render::ShaderType> shaderTypes =
-                        shaderResource->GetShaderTypes();
-                    for (auto shaderType : shaderTypes)
-                    {
-                        const std::string &shaderSource =
-                            shaderResource->GetShaderSource(shaderType);
-
-                        // Append shader to list
-                        shaders.push_back(m_renderer->CreateShaderObject(
-                            shaderType, shaderSource.size(),
-                            shaderSource.c_str()));
-                    }
-                    // Compile shaders into shader program
-                    ds_render::ProgramHandle fakeShader =
-                        m_renderer->CreateProgram(shaders);
-
-                    // Set shader data descriptions
-                    // Allocate space for view and projection matrices
-                    m_sceneBufferDescrip = ds_render::ConstantBufferDescription(
-                        2 * sizeof(ds_math::Matrix4));
-                    m_sceneBufferDescrip.AddMember("Scene.viewMatrix");
-                    m_sceneBufferDescrip.AddMember("Scene.projectionMatrix");
-                    m_renderer->GetConstantBufferDescription(
-                        fakeShader, "Scene", &m_sceneBufferDescrip);
-
-                    // Allocate space for model matrix and bone transforms
-                    m_objectBufferDescrip =
-                        ds_render::ConstantBufferDescription(
-                            1 * sizeof(ds_math::Matrix4) +
-                            MeshResource::MAX_BONES * sizeof(ds_math::Matrix4));
-                    // Add model matrix description
-                    m_objectBufferDescrip.AddMember("Object.modelMatrix");
-                    // Add bone transform descriptions
-                    m_objectBufferDescrip.AddMember("Object.boneTransforms");
-                    // Ask renderer to construct constant buffer
-                    m_renderer->GetConstantBufferDescription(
-                        fakeShader, "Object", &m_objectBufferDescrip);
-
-                    // Create shader data
-                    // Insert default data for view and projection matrix
-                    m_viewMatrix = ds_math::Matrix4(1.0f);
-                    m_projectionMatrix =
-                        ds_math::Matrix4::CreatePerspectiveFieldOfView(
-                            ds_math::MathHelper::PI / 3.0f,
-                            (float)m_windowWidth / (float)m_windowHeight, 0.1f,
-                            100.0f);
-                    m_sceneBufferDescrip.InsertMemberData(
-                        "Scene.viewMatrix", sizeof(ds_math::Matrix4),
-                        &m_viewMatrix);
-                    m_sceneBufferDescrip.InsertMemberData(
-                        "Scene.projectionMatrix", sizeof(ds_math::Matrix4),
-                        &m_projectionMatrix);
-
-                    // Insert default data for model matrix and bone transforms
-                    ds_math::Matrix4 modelMatrix = ds_math::Matrix4(1.0f);
-                    m_objectBufferDescrip.InsertMemberData(
-                        "Object.modelMatrix", sizeof(ds_math::Matrix4),
-                        &modelMatrix);
-
-                    std::vector<ds_math::Matrix4> identityMatrices(
-                        MeshResource::MAX_BONES, ds_math::Matrix4(1.0f));
-                    m_objectBufferDescrip.InsertMemberData(
-                        "Object.boneTransforms",
-                        MeshResource::MAX_BONES * sizeof(ds_math::Matrix4),
-                        &identityMatrices[0]);
-
-                    m_sceneMatrices =
-                        m_renderer->CreateConstantBuffer(m_sceneBufferDescrip);
-                    m_objectMatrices =
-                        m_renderer->CreateConstantBuffer(m_objectBufferDescrip);
-
+                    InitRenderer(std::unique_ptr<ds_render::IRenderer>(
+                        new ds_render::GLRenderer()));
                     break;
-                }
                 default:
                     break;
                 }
@@ -1669,15 +1669,31 @@ ds_render::Mesh Render::CreateMeshFromMeshResource(const std::string &filePath)
         mesh = ds_render::Mesh(vb, ib, meshResourceHandle);
         // Create Mesh
 
+        // Animated meshes move their vertices away from where they were
+        // loaded, so only bound meshes without bones, the rest are never
+        // culled
+        bool bounded = meshResource->GetNumBones() == 0;
+
         // For 0 to meshCount - 1, add submesh..
+        ds_render::BoundingVolume meshBounds;
         for (unsigned int iSubMesh = 0; iSubMesh < meshResource->GetMeshCount();
              ++iSubMesh)
         {
+            ds_render::BoundingVolume subMeshBounds;
+            if (bounded)
+            {
+                subMeshBounds = ds_render::BoundingVolume::FromPoints(
+                    meshResource->GetVerts(iSubMesh));
+                meshBounds =
+                    ds_render::BoundingVolume::Merge(meshBounds, subMeshBounds);
+            }
+
             mesh.AddSubMesh(
                 ds_render::SubMesh(meshResource->GetBaseIndex(iSubMesh),
                                    meshResource->GetNumIndices(iSubMesh),
-                                   ds_render::MaterialHandle()));
+                                   ds_render::MaterialHandle(), subMeshBounds));
         }
+        mesh.SetBounds(meshBounds);
     }
     else
     {
@@ -1783,7 +1799,7 @@ void Render::RenderScene(float deltaTime)
         const ds_math::Matrix4 &worldTransform =
             m_transformComponentManager->GetWorldTransform(cameraTransform);
         const ds_math::Matrix4 &viewMatrix =
-            ds_math::Matrix4::Inverse(worldTransform);
+            ds_math::Matrix4::AffineInverse(worldTransform);
 
         // Get projection matrix of camera
         const ds_math::Matrix4 &projectionMatrix =
@@ -1798,6 +1814,9 @@ void Render::RenderScene(float deltaTime)
         m_renderer->UpdateConstantBufferData(m_sceneMatrices,
                                              m_sceneBufferDescrip);
 
+        // Objects outside what the camera can see are skipped
+        const ds_render::Frustum frustum(projectionMatrix * viewMatrix);
+
         if (m_hasSkybox)
         {
             // Render skybox
@@ -1866,6 +1885,15 @@ void Render::RenderScene(float deltaTime)
             m_renderer->SetDepthWriting(true);
         }
 
+        // Queue the draws of each render component, so they can be sorted
+        // to share render state
+        m_renderQueue.Clear();
+        m_renderObjects.clear();
+        // Objects without a mesh resource use the first, default, bone
+        // transforms
+        m_renderBoneTransforms.assign(MeshResource::MAX_BONES,
+                                      ds_math::Matrix4());
+
         // For each render component
         for (unsigned int i = 0;
              i < m_renderComponentManager->GetNumInstances(); ++i)
@@ -1881,43 +1909,72 @@ void Render::RenderScene(float deltaTime)
             ds_render::Mesh mesh =
                 m_renderComponentManager->GetMesh(renderInstance);
 
+            // First, get mesh resource that holds skeleton/animation data
+            MeshResource *meshResource =
+                (MeshResource *)m_handleManager.Get(
+                    mesh.GetMeshResourceHandle());
+
+            // Objects without a transform aren't culled and don't update the
+            // object constant buffer
+            RenderObject object;
+            object.hasTransform = transformInstance.IsValid();
+            object.boneTransforms = 0;
+            float depth = 0.0f;
+
             // If has transform instance
             if (transformInstance.IsValid())
             {
-                ds_math::Matrix4 worldTransform =
+                object.worldTransform =
                     m_transformComponentManager->GetWorldTransform(
                         transformInstance);
-                // Update object constant buffer with world transform of this
-                // transform instance
-                m_objectBufferDescrip.InsertMemberData("Object.modelMatrix",
-                                                       sizeof(ds_math::Matrix4),
-                                                       &worldTransform[0][0]);
-
-                // First, get mesh resource that holds skeleton/animation data
-                MeshResource *meshResource =
-                    (MeshResource *)m_handleManager.Get(
-                        mesh.GetMeshResourceHandle());
-                // Get bone transform data to bind to shader
-                std::vector<ds_math::Matrix4> boneTransforms(
-                    MeshResource::MAX_BONES, ds_math::Matrix4());
+
+                // Skip the object if it's wholly outside the frustum
+                if (!frustum.Intersects(ds_render::BoundingVolume::Transform(
+                        object.worldTransform, mesh.GetBounds())))
+                {
+                    continue;
+                }
+
+                // Distance in front of the camera, to draw near objects first
+                depth = -ds_math::Matrix4::Transform(
+                             viewMatrix,
+                             ds_math::Vector3(object.worldTransform[3]))
+                             .z;
 
                 // If we have mesh resource (terrain components don't)
                 if (meshResource != nullptr)
                 {
-                    // Then query mesh resource for data
+                    // Then query mesh resource for bone transform data, once
+                    // per frame as it moves the animation on
+                    std::vector<ds_math::Matrix4> boneTransforms(
+                        MeshResource::MAX_BONES, ds_math::Matrix4());
                     meshResource->BoneTransform(deltaTime, &boneTransforms);
+
+                    object.boneTransforms = m_renderBoneTransforms.size();
+                    m_renderBoneTransforms.insert(m_renderBoneTransforms.end(),
+                                                  boneTransforms.begin(),
+                                                  boneTransforms.end());
                 }
-                m_objectBufferDescrip.InsertMemberData(
-                    "Object.boneTransforms",
-                    MeshResource::MAX_BONES * sizeof(ds_math::Matrix4),
-                    &boneTransforms[0]);
-                m_renderer->UpdateConstantBufferData(m_objectMatrices,
-                                                     m_objectBufferDescrip);
             }
 
+            // Meshes without a mesh resource, such as GUI panels, are drawn
+            // in order after the rest
+            ds_render::RenderPass pass = meshResource != nullptr
+                                             ? ds_render::RenderPass::Opaque
+                                             : ds_render::RenderPass::Ordered;
+
             for (unsigned int iSubMesh = 0; iSubMesh < mesh.GetNumSubMeshes();
                  ++iSubMesh)
             {
+                // With one submesh its bounds are the mesh's, already tested
+                if (transformInstance.IsValid() && mesh.GetNumSubMeshes() > 1 &&
+                    !frustum.Intersects(ds_render::BoundingVolume::Transform(
+                        object.worldTransform,
+                        mesh.GetSubMesh(iSubMesh).bounds)))
+                {
+                    continue;
+                }
+
                 // Get material handle
                 ds_render::MaterialHandle materialHandle =
                     mesh.GetSubMesh(iSubMesh).materialHandle;
@@ -1928,59 +1985,75 @@ void Render::RenderScene(float deltaTime)
 
                 if (material != nullptr)
                 {
-                    // Set shader program
-                    m_renderer->SetProgram(material->GetProgram());
-
-                    // For each texture in material, bind it to shader
-                    for (const auto &shaderTexture : material->GetTextures())
+                    // Add the material's state to the queue the first time
+                    // it's drawn with this frame
+                    unsigned int queueMaterial;
+                    if (!m_renderQueue.GetMaterial(materialHandle,
+                                                   &queueMaterial))
                     {
-                        ds_render::Texture *texture =
-                            m_textureManager.GetTexture(
-                                shaderTexture.textureHandle);
+                        ds_render::RenderQueueMaterial state;
+                        state.program = material->GetProgram();
+                        state.parameters = &material->GetMaterialParameters();
 
-                        if (texture != nullptr)
+                        // Get the renderer texture of each material texture
+                        for (const auto &shaderTexture :
+                             material->GetTextures())
                         {
-                            m_renderer->BindTextureToSampler(
-                                material->GetProgram(),
-                                shaderTexture.samplerName, texture->textureType,
-                                texture->renderTextureHandle);
+                            ds_render::Texture *texture =
+                                m_textureManager.GetTexture(
+                                    shaderTexture.textureHandle);
+
+                            if (texture != nullptr)
+                            {
+                                ds_render::RenderQueueTexture queueTexture;
+                                queueTexture.samplerName =
+                                    shaderTexture.samplerName;
+                                queueTexture.textureType = texture->textureType;
+                                queueTexture.textureHandle =
+                                    texture->renderTextureHandle;
+                                state.textures.push_back(queueTexture);
+                            }
                         }
-                    }
 
-                    // Bind each material parameter to shader program
-                    for (const auto &materialParameter :
-                         material->GetMaterialParameters())
-                    {
-                        m_renderer->UpdateProgramParameter(
-                            material->GetProgram(), materialParameter.GetName(),
-                            materialParameter.GetDataType(),
-                            materialParameter.GetData());
+                        queueMaterial =
+                            m_renderQueue.AddMaterial(materialHandle, state);
                     }
 
-                    // Draw the mesh
-                    m_renderer->DrawVerticesIndexed(
-                        mesh.GetVertexBuffer(), mesh.GetIndexBuffer(),
-                        ds_render::PrimitiveType::Triangles,
-                        mesh.GetSubMesh(iSubMesh).startingIndex,
-                        mesh.GetSubMesh(iSubMesh).numIndices);
-
-                    // For each texture in material, unbind
-                    for (auto shaderTexture : material->GetTextures())
-                    {
-                        ds_render::Texture *texture =
-                            m_textureManager.GetTexture(
-                                shaderTexture.textureHandle);
-
-                        if (texture != nullptr)
-                        {
-                            m_renderer->UnbindTextureFromSampler(
-                                texture->textureType,
-                                texture->renderTextureHandle);
-                        }
-                    }
+                    // Queue the mesh to be drawn
+                    m_renderQueue.Add(pass, queueMaterial,
+                                      mesh.GetVertexBuffer(),
+                                      mesh.GetIndexBuffer(),
+                                      mesh.GetSubMesh(iSubMesh).startingIndex,
+                                      mesh.GetSubMesh(iSubMesh).numIndices,
+                                      m_renderObjects.size(), depth);
                 }
             }
+
+            m_renderObjects.push_back(object);
         }
+
+        // Update the object constant buffer with the world and bone
+        // transforms of each object as its draws are reached
+        auto setObject = [&](unsigned int iObject)
+        {
+            const RenderObject &renderObject = m_renderObjects[iObject];
+
+            if (renderObject.hasTransform)
+            {
+                m_objectBufferDescrip.InsertMemberData(
+                    "Object.modelMatrix", sizeof(ds_math::Matrix4),
+                    &renderObject.worldTransform[0][0]);
+                m_objectBufferDescrip.InsertMemberData(
+                    "Object.boneTransforms",
+                    MeshResource::MAX_BONES * sizeof(ds_math::Matrix4),
+                    &m_renderBoneTransforms[renderObject.boneTransforms]);
+                m_renderer->UpdateConstantBufferData(m_objectMatrices,
+                                                     m_objectBufferDescrip);
+            }
+        };
+
+        // Draw the queue
+        m_renderQueue.Submit(m_renderer.get(), setObject);
     }
 }
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include "engine/common/HandleManager.h"
 #include "engine/resource/MeshResource.h"
@@ -14,6 +15,7 @@
 #include "engine/system/render/Material.h"
 #include "engine/system/render/Mesh.h"
 #include "engine/system/render/RenderComponentManager.h"
+#include "engine/system/render/RenderQueue.h"
 #include "engine/system/render/Skybox.h"
 #include "engine/system/render/Texture.h"
 #include "engine/system/scene/TransformComponentManager.h"
@@ -248,6 +250,20 @@ public:
     void SetCameraOrientation(Entity entity,
                               const ds_math::Quaternion &orientation);
 
+    /**
+     * Start rendering with the given renderer.
+     *
+     * The render system creates a renderer itself once a graphics context is
+     * created. Call this before then to use another renderer, such as a
+     * ds_render::RecordingRenderer on a machine without a GPU.
+     *
+     * @param   renderer  std::unique_ptr<ds_render::IRenderer>, renderer to
+     * use.
+     * @return            bool, TRUE if the renderer is used, FALSE if there
+     * already is one.
+     */
+    bool InitRenderer(std::unique_ptr<ds_render::IRenderer> renderer);
+
 private:
     /**
      * Process messages in the given message stream.
@@ -366,6 +382,26 @@ private:
     ds_render::ConstantBufferDescription m_sceneBufferDescrip;
     ds_render::ConstantBufferDescription m_objectBufferDescrip;
 
+    /**
+     * Object drawn this frame.
+     */
+    struct RenderObject
+    {
+        /** Whether the object has a transform */
+        bool hasTransform;
+        /** World transform of the object */
+        ds_math::Matrix4 worldTransform;
+        /** Index of the object's first bone transform */
+        size_t boneTransforms;
+    };
+
+    /** Draws of this frame, sorted to share render state */
+    ds_render::RenderQueue m_renderQueue;
+    /** Objects drawn this frame */
+    std::vector<RenderObject> m_renderObjects;
+    /** Bone transforms of the objects drawn this frame */
+    std::vector<ds_math::Matrix4> m_renderBoneTransforms;
+
     ds_math::Matrix4 m_viewMatrix;
     ds_math::Matrix4 m_projectionMatrix;
 
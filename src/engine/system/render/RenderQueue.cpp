@@ -0,0 +1,250 @@
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include "engine/system/render/RenderQueue.h"
+
+namespace
+{
+// Sort key fields, from most significant
+const unsigned int PASS_SHIFT = 62;
+const unsigned int PROGRAM_BITS = 10;
+const unsigned int PROGRAM_SHIFT = 52;
+const unsigned int TEXTURE_SET_BITS = 10;
+const unsigned int TEXTURE_SET_SHIFT = 42;
+const unsigned int MATERIAL_BITS = 12;
+const unsigned int MATERIAL_SHIFT = 30;
+const unsigned int MESH_BITS = 14;
+const unsigned int MESH_SHIFT = 16;
+
+/**
+ * Fit a number in a key field, numbers too big for it share its largest
+ * value.
+ */
+uint64_t KeyField(unsigned int value, unsigned int bits, unsigned int shift)
+{
+    const uint64_t max = (1ull << bits) - 1;
+    return std::min((uint64_t)value, max) << shift;
+}
+
+/**
+ * Quantise a depth to 16 bits that sort in the same order. The bits of a
+ * positive float sort as the float does, so keep the top 16.
+ */
+uint64_t DepthField(float depth)
+{
+    if (!(depth > 0.0f))
+    {
+        return 0;
+    }
+
+    uint32_t bits;
+    std::memcpy(&bits, &depth, sizeof(bits));
+    return bits >> 16;
+}
+}
+
+namespace ds_render
+{
+template <typename Key>
+unsigned int RenderQueue::Number(std::map<Key, unsigned int> *numbers,
+                                 const Key &value)
+{
+    typename std::map<Key, unsigned int>::iterator it = numbers->find(value);
+
+    if (it == numbers->end())
+    {
+        unsigned int number = numbers->size();
+        it = numbers->insert(std::make_pair(value, number)).first;
+    }
+
+    return it->second;
+}
+
+void RenderQueue::Clear()
+{
+    m_materials.clear();
+    m_materialIndices.clear();
+    m_programNumbers.clear();
+    m_textureSetNumbers.clear();
+    m_meshNumbers.clear();
+    m_draws.clear();
+    m_keys.clear();
+}
+
+bool RenderQueue::GetMaterial(MaterialHandle handle,
+                              unsigned int *material) const
+{
+    std::map<uint32_t, unsigned int>::const_iterator it =
+        m_materialIndices.find((uint32_t)handle);
+
+    if (it != m_materialIndices.end())
+    {
+        *material = it->second;
+        return true;
+    }
+
+    return false;
+}
+
+unsigned int RenderQueue::AddMaterial(MaterialHandle handle,
+                                      const RenderQueueMaterial &material)
+{
+    // Materials binding the same textures to the same samplers share a
+    // texture set
+    std::vector<std::pair<std::string, uint32_t>> textureSet;
+    for (const auto &texture : material.textures)
+    {
+        textureSet.push_back(std::make_pair(texture.samplerName,
+                                            (uint32_t)texture.textureHandle));
+    }
+
+    Material added;
+    added.state = material;
+    added.program = Number(&m_programNumbers, (uint32_t)material.program);
+    added.textureSet = Number(&m_textureSetNumbers, textureSet);
+
+    unsigned int index = m_materials.size();
+    m_materials.push_back(added);
+    m_materialIndices[(uint32_t)handle] = index;
+
+    return index;
+}
+
+void RenderQueue::Add(RenderPass pass,
+                      unsigned int material,
+                      VertexBufferHandle vertexBuffer,
+                      IndexBufferHandle indexBuffer,
+                      size_t startingIndex,
+                      size_t numIndices,
+                      unsigned int object,
+                      float depth)
+{
+    assert(material < m_materials.size() &&
+           "RenderQueue::Add: material not added this frame.");
+
+    uint64_t key = (uint64_t)pass << PASS_SHIFT;
+    if (pass == RenderPass::Opaque)
+    {
+        key |= KeyField(m_materials[material].program, PROGRAM_BITS,
+                        PROGRAM_SHIFT);
+        key |= KeyField(m_materials[material].textureSet, TEXTURE_SET_BITS,
+                        TEXTURE_SET_SHIFT);
+        key |= KeyField(material, MATERIAL_BITS, MATERIAL_SHIFT);
+        key |= KeyField(Number(&m_meshNumbers, (uint32_t)vertexBuffer),
+                        MESH_BITS, MESH_SHIFT);
+        key |= DepthField(depth);
+    }
+    else
+    {
+        // Keep the order draws were added in
+        key |= m_draws.size();
+    }
+
+    Draw draw;
+    draw.material = material;
+    draw.vertexBuffer = vertexBuffer;
+    draw.indexBuffer = indexBuffer;
+    draw.startingIndex = startingIndex;
+    draw.numIndices = numIndices;
+    draw.object = object;
+
+    m_keys.push_back(std::make_pair(key, (unsigned int)m_draws.size()));
+    m_draws.push_back(draw);
+}
+
+size_t RenderQueue::GetNumDraws() const
+{
+    return m_draws.size();
+}
+
+void RenderQueue::Submit(
+    IRenderer *renderer,
+    const std::function<void(unsigned int object)> &setObject)
+{
+    // Equal keys keep the order they were added in
+    std::sort(m_keys.begin(), m_keys.end());
+
+    // State set by the last draw
+    const Material *current = nullptr;
+    const Material *bound = nullptr;
+    unsigned int object = 0;
+    // Material whose parameters each program was last given
+    std::map<uint32_t, unsigned int> programParameters;
+
+    for (const auto &key : m_keys)
+    {
+        const Draw &draw = m_draws[key.second];
+        const Material &material = m_materials[draw.material];
+
+        bool programChanged =
+            current == nullptr || material.program != current->program;
+        if (programChanged)
+        {
+            renderer->SetProgram(material.state.program);
+        }
+
+        // Samplers are set per program, so textures are bound again for a
+        // new program even if they're the same
+        if (programChanged || bound == nullptr ||
+            material.textureSet != bound->textureSet)
+        {
+            if (bound != nullptr)
+            {
+                UnbindTextures(renderer, *bound);
+            }
+            for (const auto &texture : material.state.textures)
+            {
+                renderer->BindTextureToSampler(
+                    material.state.program, texture.samplerName,
+                    texture.textureType, texture.textureHandle);
+            }
+            bound = &material;
+        }
+
+        // Parameters stay set on a program until changed
+        std::map<uint32_t, unsigned int>::iterator parameters =
+            programParameters.find((uint32_t)material.state.program);
+        if (parameters == programParameters.end() ||
+            parameters->second != draw.material)
+        {
+            if (material.state.parameters != nullptr)
+            {
+                for (const auto &parameter : *material.state.parameters)
+                {
+                    renderer->UpdateProgramParameter(
+                        material.state.program, parameter.GetName(),
+                        parameter.GetDataType(), parameter.GetData());
+                }
+            }
+            programParameters[(uint32_t)material.state.program] =
+                draw.material;
+        }
+
+        if (current == nullptr || draw.object != object)
+        {
+            setObject(draw.object);
+            object = draw.object;
+        }
+        current = &material;
+
+        renderer->DrawVerticesIndexed(
+            draw.vertexBuffer, draw.indexBuffer, PrimitiveType::Triangles,
+            draw.startingIndex, draw.numIndices);
+    }
+
+    if (bound != nullptr)
+    {
+        UnbindTextures(renderer, *bound);
+    }
+}
+
+void RenderQueue::UnbindTextures(IRenderer *renderer, const Material &material)
+{
+    for (const auto &texture : material.state.textures)
+    {
+        renderer->UnbindTextureFromSampler(texture.textureType,
+                                           texture.textureHandle);
+    }
+}
+}
@@ -0,0 +1,212 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "engine/system/render/IRenderer.h"
+#include "engine/system/render/RenderCommon.h"
+#include "engine/system/render/ShaderParameter.h"
+
+namespace ds_render
+{
+/**
+ * Pass a draw is made in, passes are drawn in this order.
+ */
+enum class RenderPass
+{
+    /** Sorted by render state then front to back. */
+    Opaque,
+    /** Drawn in the order added, after the opaque pass, such as GUI panels. */
+    Ordered
+};
+
+/**
+ * A texture bound to a sampler for a draw.
+ */
+struct RenderQueueTexture
+{
+    /** Name of sampler to bind texture to */
+    std::string samplerName;
+    /** Type of sampler that samples the texture */
+    TextureType textureType;
+    /** Handle to renderer texture */
+    RenderTextureHandle textureHandle;
+};
+
+/**
+ * Render state set for a draw, taken from a material.
+ */
+struct RenderQueueMaterial
+{
+    /** Program to draw with */
+    ProgramHandle program;
+    /** Textures to bind */
+    std::vector<RenderQueueTexture> textures;
+    /** Parameters to give the program, must outlive the queue's frame */
+    const std::vector<ShaderParameter> *parameters;
+};
+
+/**
+ * Queue of a frame's draws, sorted to group draws sharing render state and
+ * submitted without setting state that hasn't changed.
+ *
+ * Each draw is given a 64-bit sort key made up of, from most significant:
+ * pass, program, texture set, material, mesh and depth. Draws in the same
+ * pass with the same program and textures end up next to each other, so the
+ * program is set and the textures are bound once for the lot. Material
+ * parameters are only given to a program when the material differs from the
+ * last one given to it this frame. Programs, texture sets, materials and
+ * meshes are numbered in the order they're first seen each frame. The number
+ * only groups draws, so running out of bits costs grouping, not correctness.
+ *
+ * Usage, each frame:
+ *
+ *     queue.Clear();
+ *     unsigned int material;
+ *     if (!queue.GetMaterial(materialHandle, &material))
+ *     {
+ *         material = queue.AddMaterial(materialHandle, renderQueueMaterial);
+ *     }
+ *     queue.Add(RenderPass::Opaque, material, ...);
+ *     queue.Submit(renderer, setObject);
+ */
+class RenderQueue
+{
+public:
+    /**
+     * Forget the draws and materials added, such as at the start of a frame.
+     */
+    void Clear();
+
+    /**
+     * Get the index of a material added this frame.
+     *
+     * @param   handle     MaterialHandle, handle of material.
+     * @param   material   unsigned int *, index of material out.
+     * @return             bool, TRUE if the material has been added, FALSE
+     * otherwise.
+     */
+    bool GetMaterial(MaterialHandle handle, unsigned int *material) const;
+
+    /**
+     * Add a material draws can be made with this frame.
+     *
+     * @param   handle     MaterialHandle, handle of material.
+     * @param   material   const RenderQueueMaterial &, render state of the
+     * material.
+     * @return             unsigned int, index of material.
+     */
+    unsigned int AddMaterial(MaterialHandle handle,
+                             const RenderQueueMaterial &material);
+
+    /**
+     * Add an indexed draw.
+     *
+     * @param   pass            RenderPass, pass to draw in.
+     * @param   material        unsigned int, index of material to draw with.
+     * @param   vertexBuffer    VertexBufferHandle, vertex buffer to draw.
+     * @param   indexBuffer     IndexBufferHandle, index buffer to draw.
+     * @param   startingIndex   size_t, index to begin drawing from.
+     * @param   numIndices      size_t, number of indices to draw.
+     * @param   object          unsigned int, object drawn, passed back when
+     * its draws are submitted.
+     * @param   depth           float, distance from the camera, draws in the
+     * opaque pass are drawn nearest first where state allows.
+     */
+    void Add(RenderPass pass,
+             unsigned int material,
+             VertexBufferHandle vertexBuffer,
+             IndexBufferHandle indexBuffer,
+             size_t startingIndex,
+             size_t numIndices,
+             unsigned int object,
+             float depth);
+
+    /**
+     * Get the number of draws added this frame.
+     *
+     * @return   size_t, number of draws.
+     */
+    size_t GetNumDraws() const;
+
+    /**
+     * Sort the draws and give them to the renderer.
+     *
+     * Textures bound are unbound once all draws are made.
+     *
+     * @param   renderer    IRenderer *, renderer to draw with.
+     * @param   setObject   const std::function<void(unsigned int)> &, called
+     * before the draws of an object when it differs from the last object
+     * drawn, to set per-object state such as its constant buffer.
+     */
+    void Submit(IRenderer *renderer,
+                const std::function<void(unsigned int object)> &setObject);
+
+private:
+    /**
+     * Material added this frame.
+     */
+    struct Material
+    {
+        /** Render state */
+        RenderQueueMaterial state;
+        /** Number of the material's program this frame */
+        unsigned int program;
+        /** Number of the material's texture set this frame */
+        unsigned int textureSet;
+    };
+
+    /**
+     * Draw added this frame.
+     */
+    struct Draw
+    {
+        unsigned int material;
+        VertexBufferHandle vertexBuffer;
+        IndexBufferHandle indexBuffer;
+        size_t startingIndex;
+        size_t numIndices;
+        unsigned int object;
+    };
+
+    /**
+     * Get the number of a value, numbering it if it hasn't been seen.
+     *
+     * @param   numbers   std::map<Key, unsigned int> *, numbers given so far.
+     * @param   value     const Key &, value to number.
+     * @return            unsigned int, number of value.
+     */
+    template <typename Key>
+    static unsigned int Number(std::map<Key, unsigned int> *numbers,
+                               const Key &value);
+
+    /**
+     * Unbind the textures of a material.
+     *
+     * @param   renderer   IRenderer *, renderer to unbind with.
+     * @param   material   const Material &, material whose textures to
+     * unbind.
+     */
+    static void UnbindTextures(IRenderer *renderer, const Material &material);
+
+    /** Materials added this frame */
+    std::vector<Material> m_materials;
+    /** Index of each material added, by handle */
+    std::map<uint32_t, unsigned int> m_materialIndices;
+
+    /** Numbers given to programs, texture sets and meshes this frame */
+    std::map<uint32_t, unsigned int> m_programNumbers;
+    std::map<std::vector<std::pair<std::string, uint32_t>>, unsigned int>
+        m_textureSetNumbers;
+    std::map<uint32_t, unsigned int> m_meshNumbers;
+
+    /** Draws added this frame */
+    std::vector<Draw> m_draws;
+    /** Sort key and index of each draw */
+    std::vector<std::pair<uint64_t, unsigned int>> m_keys;
+};
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "engine/system/render/BoundingVolume.h"
 #include "engine/system/render/Material.h"
 
 namespace ds_render
@@ -16,7 +17,10 @@ struct SubMesh
      * Default constructor, create empty submesh with an empty material.
      */
     SubMesh()
-        : startingIndex(0), numIndices(0), materialHandle(MaterialHandle())
+        : startingIndex(0),
+          numIndices(0),
+          materialHandle(MaterialHandle()),
+          bounds(BoundingVolume())
     {
     }
 
@@ -27,18 +31,24 @@ struct SubMesh
      * @param  startingIndex   size_t, starting index to begin drawing from.
      * @param  numIndices      size_t, number of indices to use to draw.
      * @param  materialHandle  MaterialHandle, handle to material to draw with.
+     * @param  bounds          const BoundingVolume &, bounds of the vertices
+     *                         drawn, in model space, empty if not known.
      */
     SubMesh(size_t startingIndex,
             size_t numIndices,
-            MaterialHandle materialHandle)
+            MaterialHandle materialHandle,
+            const BoundingVolume &bounds = BoundingVolume())
     {
         this->startingIndex = startingIndex;
         this->numIndices = numIndices;
         this->materialHandle = materialHandle;
+        this->bounds = bounds;
     }
 
     size_t startingIndex;
     size_t numIndices;
     MaterialHandle materialHandle;
+    /** Bounds of the submesh in model space, empty if not known */
+    BoundingVolume bounds;
 };
 }
@@ -223,6 +223,20 @@ static int l_GetNextMessage(lua_State *L)
                 lua_pushliteral(L, "physics_collision");
                 lua_setfield(L, -2, "type"); // table.type = physics_collision
 
+                switch (collisionMsg.phase)
+                {
+                case ds_msg::PhysicsCollisionPhase::Begin:
+                    lua_pushliteral(L, "begin");
+                    break;
+                case ds_msg::PhysicsCollisionPhase::Stay:
+                    lua_pushliteral(L, "stay");
+                    break;
+                case ds_msg::PhysicsCollisionPhase::End:
+                    lua_pushliteral(L, "end");
+                    break;
+                }
+                lua_setfield(L, -2, "phase"); // table.phase = begin/stay/end
+
                 // Create entityA and push to stack
                 ds::Entity *entityA =
                     (ds::Entity *)lua_newuserdata(L, sizeof(ds::Entity));
@@ -236,18 +250,23 @@ static int l_GetNextMessage(lua_State *L)
                 // Set entityA field
                 lua_setfield(L, -2, "entityA"); // table.entityA = entityA
 
-                // Create entityB and push to stack
-                ds::Entity *entityB =
-                    (ds::Entity *)lua_newuserdata(L, sizeof(ds::Entity));
-                *entityB = collisionMsg.entityB;
-
-                // Get Entity metatable
-                luaL_getmetatable(L, "Entity");
-                // Set it as metatable of new user data
-                lua_setmetatable(L, -2);
-
-                // Set entityB field
-                lua_setfield(L, -2, "entityB"); // table.entityB = entityB
+                // Static geometry without an entity leaves entityB nil
+                if (collisionMsg.entityB.id !=
+                    ds_msg::PHYSICS_COLLISION_NO_ENTITY)
+                {
+                    // Create entityB and push to stack
+                    ds::Entity *entityB =
+                        (ds::Entity *)lua_newuserdata(L, sizeof(ds::Entity));
+                    *entityB = collisionMsg.entityB;
+
+                    // Get Entity metatable
+                    luaL_getmetatable(L, "Entity");
+                    // Set it as metatable of new user data
+                    lua_setmetatable(L, -2);
+
+                    // Set entityB field
+                    lua_setfield(L, -2, "entityB"); // table.entityB = entityB
+                }
 
                 // Create Vector3 and push to stack
                 ds_math::Vector3 *pointA = (ds_math::Vector3 *)lua_newuserdata(
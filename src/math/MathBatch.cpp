@@ -0,0 +1,357 @@
+#include <cassert>
+#include <cmath>
+
+#include "MathBatch.h"
+#include "Simd.h"
+
+namespace ds_math
+{
+static_assert(sizeof(Vector3) == 3 * sizeof(scalar),
+              "Vector3 components must be tightly packed.");
+
+/**
+ * Write the columns of the matrix composed from the given translation,
+ * orientation and scale.
+ *
+ * The rotation part is calculated in the same way as
+ * Matrix4::CreateFromQuaternion, each rotation column is then scaled by the
+ * corresponding scale component.
+ */
+static void ComposeTransform(const Vector3 &translation,
+                             const Quaternion &orientation,
+                             const Vector3 &scale,
+                             Matrix4 &out)
+{
+    const Quaternion &q = orientation;
+
+    out[0] = Vector4((1 - 2 * q.y * q.y - 2 * q.z * q.z) * scale.x,
+                     (2 * q.x * q.y + 2 * q.w * q.z) * scale.x,
+                     (2 * q.x * q.z - 2 * q.w * q.y) * scale.x, 0.0f);
+    out[1] = Vector4((2 * q.x * q.y - 2 * q.w * q.z) * scale.y,
+                     (1 - 2 * q.x * q.x - 2 * q.z * q.z) * scale.y,
+                     (2 * q.y * q.z + 2 * q.w * q.x) * scale.y, 0.0f);
+    out[2] = Vector4((2 * q.x * q.z + 2 * q.w * q.y) * scale.z,
+                     (2 * q.y * q.z - 2 * q.w * q.x) * scale.z,
+                     (1 - 2 * q.x * q.x - 2 * q.y * q.y) * scale.z, 0.0f);
+    out[3] = Vector4(translation, 1.0f);
+}
+
+#if defined(DS_MATH_SSE2)
+/**
+ * Convert four consecutive Vector3s (twelve scalars) into separate x, y and z
+ * vectors.
+ */
+static inline void
+LoadVector3x4(const Vector3 *v, __m128 &x, __m128 &y, __m128 &z)
+{
+    const scalar *p = &v[0].x;
+    // {x0, y0, z0, x1}, {y1, z1, x2, y2}, {z2, x3, y3, z3}
+    __m128 a = simd::Load(p);
+    __m128 b = simd::Load(p + 4);
+    __m128 c = simd::Load(p + 8);
+
+    __m128 t = _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2));
+    x = _mm_shuffle_ps(a, t, _MM_SHUFFLE(2, 0, 3, 0));
+
+    y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)),
+                       _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)),
+                       _MM_SHUFFLE(2, 0, 2, 0));
+
+    z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)),
+                       _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)),
+                       _MM_SHUFFLE(2, 0, 2, 0));
+}
+
+/**
+ * Inverse of LoadVector3x4, interleave x, y and z vectors into four
+ * consecutive Vector3s.
+ */
+static inline void StoreVector3x4(Vector3 *v, __m128 x, __m128 y, __m128 z)
+{
+    scalar *p = &v[0].x;
+
+    simd::Store(p,
+                _mm_shuffle_ps(_mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 0, 0, 0)),
+                               _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0)),
+                               _MM_SHUFFLE(2, 0, 2, 0)));
+    simd::Store(p + 4,
+                _mm_shuffle_ps(_mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1)),
+                               _mm_shuffle_ps(x, y, _MM_SHUFFLE(2, 2, 2, 2)),
+                               _MM_SHUFFLE(2, 0, 2, 0)));
+    simd::Store(p + 8,
+                _mm_shuffle_ps(_mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2)),
+                               _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3)),
+                               _MM_SHUFFLE(2, 0, 2, 0)));
+}
+
+/**
+ * Transform four points, given as separate x, y and z vectors, by a matrix.
+ * Performs the same operations in the same order as Matrix4::Transform.
+ */
+static inline void
+TransformPoints4(const Matrix4 &mat, __m128 &x, __m128 &y, __m128 &z)
+{
+    __m128 rx = _mm_mul_ps(_mm_set1_ps(mat[0].x), x);
+    rx = _mm_add_ps(rx, _mm_mul_ps(_mm_set1_ps(mat[1].x), y));
+    rx = _mm_add_ps(rx, _mm_mul_ps(_mm_set1_ps(mat[2].x), z));
+    rx = _mm_add_ps(rx, _mm_set1_ps(mat[3].x));
+
+    __m128 ry = _mm_mul_ps(_mm_set1_ps(mat[0].y), x);
+    ry = _mm_add_ps(ry, _mm_mul_ps(_mm_set1_ps(mat[1].y), y));
+    ry = _mm_add_ps(ry, _mm_mul_ps(_mm_set1_ps(mat[2].y), z));
+    ry = _mm_add_ps(ry, _mm_set1_ps(mat[3].y));
+
+    __m128 rz = _mm_mul_ps(_mm_set1_ps(mat[0].z), x);
+    rz = _mm_add_ps(rz, _mm_mul_ps(_mm_set1_ps(mat[1].z), y));
+    rz = _mm_add_ps(rz, _mm_mul_ps(_mm_set1_ps(mat[2].z), z));
+    rz = _mm_add_ps(rz, _mm_set1_ps(mat[3].z));
+
+    x = rx;
+    y = ry;
+    z = rz;
+}
+
+/**
+ * Normalize four quaternions, given as separate x, y, z and w vectors.
+ * Performs the same operations in the same order as Quaternion::Normalize.
+ */
+static inline void
+NormalizeQuaternions4(__m128 &x, __m128 &y, __m128 &z, __m128 &w)
+{
+    __m128 dot = _mm_mul_ps(x, x);
+    dot = _mm_add_ps(dot, _mm_mul_ps(y, y));
+    dot = _mm_add_ps(dot, _mm_mul_ps(z, z));
+    dot = _mm_add_ps(dot, _mm_mul_ps(w, w));
+
+    __m128 mag = _mm_sqrt_ps(dot);
+    assert(_mm_movemask_ps(_mm_cmpeq_ps(mag, _mm_setzero_ps())) == 0 &&
+           "Attempted to normalize a vector with zero magnitude.");
+
+    __m128 factor = _mm_div_ps(_mm_set1_ps(1.0f), mag);
+
+    x = _mm_mul_ps(x, factor);
+    y = _mm_mul_ps(y, factor);
+    z = _mm_mul_ps(z, factor);
+    w = _mm_mul_ps(w, factor);
+}
+#endif
+
+void MathBatch::TransformPoints(const Matrix4 &mat,
+                                const Vector3 *points,
+                                Vector3 *out,
+                                unsigned int count)
+{
+    unsigned int i = 0;
+
+#if defined(DS_MATH_SSE2)
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 x, y, z;
+        LoadVector3x4(&points[i], x, y, z);
+        TransformPoints4(mat, x, y, z);
+        StoreVector3x4(&out[i], x, y, z);
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        out[i] = Matrix4::Transform(mat, points[i]);
+    }
+}
+
+void MathBatch::TransformPoints(const Matrix4 &mat,
+                                const ConstVector3SoA &points,
+                                const Vector3SoA &out,
+                                unsigned int count)
+{
+    unsigned int i = 0;
+
+#if defined(DS_MATH_SSE2)
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 x = simd::Load(&points.x[i]);
+        __m128 y = simd::Load(&points.y[i]);
+        __m128 z = simd::Load(&points.z[i]);
+
+        TransformPoints4(mat, x, y, z);
+
+        simd::Store(&out.x[i], x);
+        simd::Store(&out.y[i], y);
+        simd::Store(&out.z[i], z);
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        Vector3 result = Matrix4::Transform(
+            mat, Vector3(points.x[i], points.y[i], points.z[i]));
+
+        out.x[i] = result.x;
+        out.y[i] = result.y;
+        out.z[i] = result.z;
+    }
+}
+
+void MathBatch::Multiply(const Matrix4 *lhs,
+                         const Matrix4 *rhs,
+                         Matrix4 *out,
+                         unsigned int count)
+{
+    // Matrix4 multiplication is already vectorised across the columns of the
+    // result, so there is nothing to gain from interleaving matrices.
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        out[i] = lhs[i] * rhs[i];
+    }
+}
+
+void MathBatch::NormalizeQuaternions(const Quaternion *quaternions,
+                                     Quaternion *out,
+                                     unsigned int count)
+{
+    unsigned int i = 0;
+
+#if defined(DS_MATH_SSE2)
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 x = simd::Load(&quaternions[i].x);
+        __m128 y = simd::Load(&quaternions[i + 1].x);
+        __m128 z = simd::Load(&quaternions[i + 2].x);
+        __m128 w = simd::Load(&quaternions[i + 3].x);
+
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+        NormalizeQuaternions4(x, y, z, w);
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+
+        simd::Store(&out[i].x, x);
+        simd::Store(&out[i + 1].x, y);
+        simd::Store(&out[i + 2].x, z);
+        simd::Store(&out[i + 3].x, w);
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        out[i] = Quaternion::Normalize(quaternions[i]);
+    }
+}
+
+void MathBatch::NormalizeQuaternions(const QuaternionSoA &quaternions,
+                                     unsigned int count)
+{
+    unsigned int i = 0;
+
+#if defined(DS_MATH_SSE2)
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 x = simd::Load(&quaternions.x[i]);
+        __m128 y = simd::Load(&quaternions.y[i]);
+        __m128 z = simd::Load(&quaternions.z[i]);
+        __m128 w = simd::Load(&quaternions.w[i]);
+
+        NormalizeQuaternions4(x, y, z, w);
+
+        simd::Store(&quaternions.x[i], x);
+        simd::Store(&quaternions.y[i], y);
+        simd::Store(&quaternions.z[i], z);
+        simd::Store(&quaternions.w[i], w);
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        Quaternion q = Quaternion::Normalize(
+            Quaternion(quaternions.x[i], quaternions.y[i], quaternions.z[i],
+                       quaternions.w[i]));
+
+        quaternions.x[i] = q.x;
+        quaternions.y[i] = q.y;
+        quaternions.z[i] = q.z;
+        quaternions.w[i] = q.w;
+    }
+}
+
+void MathBatch::ComposeTransforms(const Vector3 *translations,
+                                  const Quaternion *orientations,
+                                  const Vector3 *scales,
+                                  Matrix4 *out,
+                                  unsigned int count)
+{
+    unsigned int i = 0;
+
+#if defined(DS_MATH_SSE2)
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 zero = _mm_setzero_ps();
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 qx = simd::Load(&orientations[i].x);
+        __m128 qy = simd::Load(&orientations[i + 1].x);
+        __m128 qz = simd::Load(&orientations[i + 2].x);
+        __m128 qw = simd::Load(&orientations[i + 3].x);
+        _MM_TRANSPOSE4_PS(qx, qy, qz, qw);
+
+        __m128 sx, sy, sz;
+        LoadVector3x4(&scales[i], sx, sy, sz);
+        __m128 tx, ty, tz;
+        LoadVector3x4(&translations[i], tx, ty, tz);
+
+        // Same expressions as ComposeTransform, for four transforms at once
+        __m128 x2 = _mm_add_ps(qx, qx);
+        __m128 y2 = _mm_add_ps(qy, qy);
+        __m128 z2 = _mm_add_ps(qz, qz);
+        __m128 w2 = _mm_add_ps(qw, qw);
+
+        __m128 xx = _mm_mul_ps(x2, qx);
+        __m128 yy = _mm_mul_ps(y2, qy);
+        __m128 zz = _mm_mul_ps(z2, qz);
+        __m128 xy = _mm_mul_ps(x2, qy);
+        __m128 xz = _mm_mul_ps(x2, qz);
+        __m128 yz = _mm_mul_ps(y2, qz);
+        __m128 wx = _mm_mul_ps(w2, qx);
+        __m128 wy = _mm_mul_ps(w2, qy);
+        __m128 wz = _mm_mul_ps(w2, qz);
+
+        __m128 c0x = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(one, yy), zz), sx);
+        __m128 c0y = _mm_mul_ps(_mm_add_ps(xy, wz), sx);
+        __m128 c0z = _mm_mul_ps(_mm_sub_ps(xz, wy), sx);
+        __m128 c0w = zero;
+        _MM_TRANSPOSE4_PS(c0x, c0y, c0z, c0w);
+
+        __m128 c1x = _mm_mul_ps(_mm_sub_ps(xy, wz), sy);
+        __m128 c1y = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(one, xx), zz), sy);
+        __m128 c1z = _mm_mul_ps(_mm_add_ps(yz, wx), sy);
+        __m128 c1w = zero;
+        _MM_TRANSPOSE4_PS(c1x, c1y, c1z, c1w);
+
+        __m128 c2x = _mm_mul_ps(_mm_add_ps(xz, wy), sz);
+        __m128 c2y = _mm_mul_ps(_mm_sub_ps(yz, wx), sz);
+        __m128 c2z = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(one, xx), yy), sz);
+        __m128 c2w = zero;
+        _MM_TRANSPOSE4_PS(c2x, c2y, c2z, c2w);
+
+        __m128 tw = one;
+        _MM_TRANSPOSE4_PS(tx, ty, tz, tw);
+
+        // After transposing, register k of each group holds column j of
+        // transform i + k.
+        const __m128 columns[4][4] = {{c0x, c1x, c2x, tx},
+                                      {c0y, c1y, c2y, ty},
+                                      {c0z, c1z, c2z, tz},
+                                      {c0w, c1w, c2w, tw}};
+        for (unsigned int k = 0; k < 4; ++k)
+        {
+            for (unsigned int j = 0; j < 4; ++j)
+            {
+                simd::Store(&out[i + k][j].x, columns[k][j]);
+            }
+        }
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        ComposeTransform(translations[i], orientations[i], scales[i], out[i]);
+    }
+}
+}
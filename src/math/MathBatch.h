@@ -0,0 +1,147 @@
+#pragma once
+
+#include "Matrix4.h"
+#include "Precision.h"
+#include "Quaternion.h"
+#include "Vector3.h"
+
+namespace ds_math
+{
+/**
+ * Structure-of-arrays view of a set of three component vectors, each pointer
+ * refers to an array of at least as many scalars as the kernel is given.
+ */
+struct Vector3SoA
+{
+    scalar *x;
+    scalar *y;
+    scalar *z;
+};
+
+/**
+ * Read-only structure-of-arrays view of a set of three component vectors.
+ */
+struct ConstVector3SoA
+{
+    const scalar *x;
+    const scalar *y;
+    const scalar *z;
+};
+
+/**
+ * Structure-of-arrays view of a set of quaternions.
+ */
+struct QuaternionSoA
+{
+    scalar *x;
+    scalar *y;
+    scalar *z;
+    scalar *w;
+};
+
+/**
+ * Kernels that operate on whole arrays of math objects at once.
+ *
+ * Each kernel accepts either array-of-structures input (plain arrays of
+ * Vector3, Quaternion or Matrix4) or structure-of-arrays input and processes
+ * four elements at a time when SIMD is available. Results are identical to
+ * calling the equivalent single-object function in a loop.
+ *
+ * Input and output arrays may be the same array but must not otherwise
+ * overlap.
+ *
+ * @author Samuel Evans-Powell
+ */
+class MathBatch
+{
+public:
+    /**
+     * Transform an array of points by a matrix, equivalent to calling
+     * Matrix4::Transform for each point.
+     *
+     * @param  mat     const Matrix4 &, matrix to transform points by.
+     * @param  points  const Vector3 *, array of points to transform.
+     * @param  out     Vector3 *, array to store transformed points in.
+     * @param  count   unsigned int, number of points.
+     */
+    static void TransformPoints(const Matrix4 &mat,
+                                const Vector3 *points,
+                                Vector3 *out,
+                                unsigned int count);
+
+    /**
+     * Transform an array of points, stored as separate x, y and z arrays, by
+     * a matrix.
+     *
+     * @param  mat     const Matrix4 &, matrix to transform points by.
+     * @param  points  const ConstVector3SoA &, arrays of points to transform.
+     * @param  out     const Vector3SoA &, arrays to store transformed points
+     *                 in.
+     * @param  count   unsigned int, number of points.
+     */
+    static void TransformPoints(const Matrix4 &mat,
+                                const ConstVector3SoA &points,
+                                const Vector3SoA &out,
+                                unsigned int count);
+
+    /**
+     * Multiply pairs of matrices, out[i] = lhs[i] * rhs[i].
+     *
+     * @param  lhs    const Matrix4 *, array of left-hand side matrices.
+     * @param  rhs    const Matrix4 *, array of right-hand side matrices.
+     * @param  out    Matrix4 *, array to store the products in.
+     * @param  count  unsigned int, number of matrix pairs.
+     */
+    static void Multiply(const Matrix4 *lhs,
+                         const Matrix4 *rhs,
+                         Matrix4 *out,
+                         unsigned int count);
+
+    /**
+     * Normalize an array of quaternions, equivalent to calling
+     * Quaternion::Normalize for each quaternion.
+     *
+     * All quaternions must have a non-zero magnitude.
+     *
+     * @param  quaternions  const Quaternion *, array of quaternions to
+     *                      normalize.
+     * @param  out          Quaternion *, array to store normalized
+     *                      quaternions in.
+     * @param  count        unsigned int, number of quaternions.
+     */
+    static void NormalizeQuaternions(const Quaternion *quaternions,
+                                     Quaternion *out,
+                                     unsigned int count);
+
+    /**
+     * Normalize, in place, an array of quaternions stored as separate x, y, z
+     * and w arrays.
+     *
+     * All quaternions must have a non-zero magnitude.
+     *
+     * @param  quaternions  const QuaternionSoA &, arrays of quaternions to
+     *                      normalize.
+     * @param  count        unsigned int, number of quaternions.
+     */
+    static void NormalizeQuaternions(const QuaternionSoA &quaternions,
+                                     unsigned int count);
+
+    /**
+     * Compose translation, rotation and scale triples into transformation
+     * matrices, equivalent to CreateTranslationMatrix(translations[i]) *
+     * CreateFromQuaternion(orientations[i]) * CreateScaleMatrix(scales[i]).
+     *
+     * @param  translations  const Vector3 *, array of translations.
+     * @param  orientations  const Quaternion *, array of orientations.
+     * @param  scales        const Vector3 *, array of scales.
+     * @param  out           Matrix4 *, array to store transformation matrices
+     *                       in.
+     * @param  count         unsigned int, number of transformations.
+     */
+    static void ComposeTransforms(const Vector3 *translations,
+                                  const Quaternion *orientations,
+                                  const Vector3 *scales,
+                                  Matrix4 *out,
+                                  unsigned int count);
+};
+}
@@ -3,9 +3,80 @@
 
 #include "MathHelper.h"
 #include "Matrix4.h"
+#include "Simd.h"
 
 namespace ds_math
 {
+#if defined(DS_MATH_SSE2)
+/**
+ * Multiply the matrix with the given columns by a column vector.
+ *
+ * Lane i of the result is ((c0[i] * v.x + c1[i] * v.y) + c2[i] * v.z) +
+ * c3[i] * v.w, the same sum the scalar row-column dot product performs.
+ */
+static inline __m128 MultiplyColumns(__m128 c0,
+                                     __m128 c1,
+                                     __m128 c2,
+                                     __m128 c3,
+                                     __m128 column)
+{
+    __m128 result = _mm_mul_ps(c0, simd::Splat<0>(column));
+    result = _mm_add_ps(result, _mm_mul_ps(c1, simd::Splat<1>(column)));
+    result = _mm_add_ps(result, _mm_mul_ps(c2, simd::Splat<2>(column)));
+    result = _mm_add_ps(result, _mm_mul_ps(c3, simd::Splat<3>(column)));
+
+    return result;
+}
+
+/**
+ * Gather lane L of the columns of a matrix in the patterns used by the
+ * cofactor expansion in Matrix4::Inverse.
+ */
+template <int L>
+struct InverseLanes
+{
+    /** {c2[L], c2[L], c1[L], c1[L]} */
+    static __m128 From21(__m128 c1, __m128 c2)
+    {
+        return _mm_shuffle_ps(c2, c1, _MM_SHUFFLE(L, L, L, L));
+    }
+
+    /** {c3[L], c3[L], c3[L], c2[L]} */
+    static __m128 From332(__m128 c2, __m128 c3)
+    {
+        __m128 t = _mm_shuffle_ps(c3, c2, _MM_SHUFFLE(L, L, L, L));
+        return _mm_shuffle_ps(t, t, _MM_SHUFFLE(2, 0, 0, 0));
+    }
+
+    /** {c1[L], c0[L], c0[L], c0[L]} */
+    static __m128 From100(__m128 c0, __m128 c1)
+    {
+        __m128 t = _mm_shuffle_ps(c1, c0, _MM_SHUFFLE(L, L, L, L));
+        return _mm_shuffle_ps(t, t, _MM_SHUFFLE(2, 2, 2, 0));
+    }
+};
+
+/**
+ * One column of the (transposed) co-factor matrix.
+ *
+ * Evaluates ((a1000 * sa - a2211 * sb) + a3332 * sc) per lane and negates
+ * the lanes selected by sign, mirroring the scalar co-factor expressions.
+ */
+static inline __m128 CofactorColumn(__m128 a1000,
+                                    __m128 a2211,
+                                    __m128 a3332,
+                                    __m128 sa,
+                                    __m128 sb,
+                                    __m128 sc,
+                                    __m128 sign)
+{
+    __m128 result = _mm_sub_ps(_mm_mul_ps(a1000, sa), _mm_mul_ps(a2211, sb));
+    result = _mm_add_ps(result, _mm_mul_ps(a3332, sc));
+
+    return _mm_xor_ps(result, sign);
+}
+#endif
+
 Matrix4::Matrix4()
 {
     data[0] = Vector4(1.0f, 0.0f, 0.0f, 0.0f);
@@ -125,6 +196,8 @@ const Vector4 &Matrix4::operator[](unsigned int index) const
 
 const Matrix4 &Matrix4::operator*=(scalar factor)
 {
+    // Vector4 operations are vectorised, so these each compile to a single
+    // SIMD operation when available.
     data[0] *= factor;
     data[1] *= factor;
     data[2] *= factor;
@@ -166,13 +239,96 @@ bool Matrix4::operator!=(const Matrix4 &other) const
 
 Matrix4 Matrix4::Transpose(const Matrix4 &mat)
 {
+#if defined(DS_MATH_SSE2)
+    __m128 c0 = simd::Load(&mat.data[0].x);
+    __m128 c1 = simd::Load(&mat.data[1].x);
+    __m128 c2 = simd::Load(&mat.data[2].x);
+    __m128 c3 = simd::Load(&mat.data[3].x);
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+    Matrix4 result;
+    simd::Store(&result.data[0].x, c0);
+    simd::Store(&result.data[1].x, c1);
+    simd::Store(&result.data[2].x, c2);
+    simd::Store(&result.data[3].x, c3);
+
+    return result;
+#else
     return (Matrix4(mat[0].x, mat[0].y, mat[0].z, mat[0].w, mat[1].x, mat[1].y,
                     mat[1].z, mat[1].w, mat[2].x, mat[2].y, mat[2].z, mat[2].w,
                     mat[3].x, mat[3].y, mat[3].z, mat[3].w));
+#endif
 }
 
 Matrix4 Matrix4::Inverse(const Matrix4 &mat)
 {
+#if defined(DS_MATH_SSE2)
+    // Vectorised form of the Laplace expansion below. Each lane evaluates
+    // exactly the same sub-factor and co-factor expressions as the scalar
+    // code, four at a time.
+    __m128 c0 = simd::Load(&mat.data[0].x);
+    __m128 c1 = simd::Load(&mat.data[1].x);
+    __m128 c2 = simd::Load(&mat.data[2].x);
+    __m128 c3 = simd::Load(&mat.data[3].x);
+
+    __m128 x21 = InverseLanes<0>::From21(c1, c2);
+    __m128 x332 = InverseLanes<0>::From332(c2, c3);
+    __m128 x100 = InverseLanes<0>::From100(c0, c1);
+    __m128 y21 = InverseLanes<1>::From21(c1, c2);
+    __m128 y332 = InverseLanes<1>::From332(c2, c3);
+    __m128 y100 = InverseLanes<1>::From100(c0, c1);
+    __m128 z21 = InverseLanes<2>::From21(c1, c2);
+    __m128 z332 = InverseLanes<2>::From332(c2, c3);
+    __m128 z100 = InverseLanes<2>::From100(c0, c1);
+    __m128 w21 = InverseLanes<3>::From21(c1, c2);
+    __m128 w332 = InverseLanes<3>::From332(c2, c3);
+    __m128 w100 = InverseLanes<3>::From100(c0, c1);
+
+    // {sub00, sub00, sub01, sub02}, {sub01, sub03, sub03, sub04},
+    // {sub02, sub04, sub05, sub05}
+    __m128 subZW0 = _mm_sub_ps(_mm_mul_ps(z21, w332), _mm_mul_ps(z332, w21));
+    __m128 subZW1 = _mm_sub_ps(_mm_mul_ps(z100, w332), _mm_mul_ps(z332, w100));
+    __m128 subZW2 = _mm_sub_ps(_mm_mul_ps(z100, w21), _mm_mul_ps(z21, w100));
+    // {sub12, sub12, sub13, sub06}, {sub13, sub07, sub07, sub15},
+    // {sub14, sub15, sub08, sub08}
+    __m128 subYW0 = _mm_sub_ps(_mm_mul_ps(y21, w332), _mm_mul_ps(y332, w21));
+    __m128 subYW1 = _mm_sub_ps(_mm_mul_ps(y100, w332), _mm_mul_ps(y332, w100));
+    __m128 subYW2 = _mm_sub_ps(_mm_mul_ps(y100, w21), _mm_mul_ps(y21, w100));
+    // {sub16, sub16, sub17, sub18}, {sub17, sub19, sub19, sub11},
+    // {sub18, sub11, sub10, sub10}
+    __m128 subYZ0 = _mm_sub_ps(_mm_mul_ps(y21, z332), _mm_mul_ps(y332, z21));
+    __m128 subYZ1 = _mm_sub_ps(_mm_mul_ps(y100, z332), _mm_mul_ps(y332, z100));
+    __m128 subYZ2 = _mm_sub_ps(_mm_mul_ps(y100, z21), _mm_mul_ps(y21, z100));
+
+    __m128 signEven = simd::SignMask(false, true, false, true);
+    __m128 signOdd = simd::SignMask(true, false, true, false);
+
+    // Columns of the adjoint matrix
+    __m128 adj0 = CofactorColumn(y100, y21, y332, subZW0, subZW1, subZW2,
+                                 signEven);
+    __m128 adj1 = CofactorColumn(x100, x21, x332, subZW0, subZW1, subZW2,
+                                 signOdd);
+    __m128 adj2 = CofactorColumn(x100, x21, x332, subYW0, subYW1, subYW2,
+                                 signEven);
+    __m128 adj3 = CofactorColumn(x100, x21, x332, subYZ0, subYZ1, subYZ2,
+                                 signOdd);
+
+    // Determinant from the first row of the matrix and first column of the
+    // adjoint.
+    __m128 row0 = _mm_shuffle_ps(_mm_unpacklo_ps(c0, c1),
+                                 _mm_unpacklo_ps(c2, c3),
+                                 _MM_SHUFFLE(1, 0, 1, 0));
+    scalar invDet = 1 / simd::SumLanes(_mm_mul_ps(row0, adj0));
+    __m128 factor = _mm_set1_ps(invDet);
+
+    Matrix4 inv;
+    simd::Store(&inv.data[0].x, _mm_mul_ps(adj0, factor));
+    simd::Store(&inv.data[1].x, _mm_mul_ps(adj1, factor));
+    simd::Store(&inv.data[2].x, _mm_mul_ps(adj2, factor));
+    simd::Store(&inv.data[3].x, _mm_mul_ps(adj3, factor));
+
+    return (inv);
+#else
     // Uses Laplace expansion to find determinant and inverse of matrix
     // Find sub-factors (col, row).
     /* Sub-factor is determinant of 2x2 matrix left when:
@@ -234,6 +390,43 @@ Matrix4 Matrix4::Inverse(const Matrix4 &mat)
     Matrix4 inv = adj * invDet;
 
     return (inv);
+#endif
+}
+
+Matrix4 Matrix4::AffineInverse(const Matrix4 &mat)
+{
+    Vector3 a = Vector3(mat[0]);
+    Vector3 b = Vector3(mat[1]);
+    Vector3 c = Vector3(mat[2]);
+    Vector3 t = Vector3(mat[3]);
+
+    // Rows of the inverse of the upper 3x3 matrix are the cross products of
+    // its columns divided by the determinant
+    Vector3 row0 = Vector3::Cross(b, c);
+    Vector3 row1 = Vector3::Cross(c, a);
+    Vector3 row2 = Vector3::Cross(a, b);
+
+    scalar invDet = 1 / Vector3::Dot(a, row0);
+    row0 *= invDet;
+    row1 *= invDet;
+    row2 *= invDet;
+
+    return Matrix4(row0.x, row0.y, row0.z, -Vector3::Dot(row0, t), row1.x,
+                   row1.y, row1.z, -Vector3::Dot(row1, t), row2.x, row2.y,
+                   row2.z, -Vector3::Dot(row2, t), 0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+Matrix4 Matrix4::RigidInverse(const Matrix4 &mat)
+{
+    Vector3 a = Vector3(mat[0]);
+    Vector3 b = Vector3(mat[1]);
+    Vector3 c = Vector3(mat[2]);
+    Vector3 t = Vector3(mat[3]);
+
+    // Inverse of a rotation is its transpose
+    return Matrix4(a.x, a.y, a.z, -Vector3::Dot(a, t), b.x, b.y, b.z,
+                   -Vector3::Dot(b, t), c.x, c.y, c.z, -Vector3::Dot(c, t),
+                   0.0f, 0.0f, 0.0f, 1.0f);
 }
 
 Vector3 Matrix4::Transform(const Matrix4 &mat, const Vector3 &vec)
@@ -248,12 +441,12 @@ Vector4 Matrix4::Transform(const Matrix4 &mat, const Vector4 &vec)
 
 Vector3 Matrix4::TransformInverse(const Matrix4 &mat, const Vector3 &vec)
 {
-    return Vector3(Matrix4::Inverse(mat) * Vector4(vec, 1.0f));
+    return Vector3(Matrix4::AffineInverse(mat) * Vector4(vec, 1.0f));
 }
 
 Vector4 Matrix4::TransformInverse(const Matrix4 &mat, const Vector4 &vec)
 {
-    return Matrix4::Inverse(mat) * vec;
+    return Matrix4::AffineInverse(mat) * vec;
 }
 
 Vector3 Matrix4::TransformDirection(const Matrix4 &mat, const Vector3 &vec)
@@ -378,6 +571,22 @@ Matrix4 operator-(const Matrix4 &m1, const Matrix4 &m2)
 
 Matrix4 operator*(const Matrix4 &m1, const Matrix4 &m2)
 {
+#if defined(DS_MATH_SSE2)
+    __m128 c0 = simd::Load(&m1.data[0].x);
+    __m128 c1 = simd::Load(&m1.data[1].x);
+    __m128 c2 = simd::Load(&m1.data[2].x);
+    __m128 c3 = simd::Load(&m1.data[3].x);
+
+    Matrix4 result;
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        simd::Store(&result.data[i].x,
+                    MultiplyColumns(c0, c1, c2, c3,
+                                    simd::Load(&m2.data[i].x)));
+    }
+
+    return result;
+#else
     Vector4 row0(m1[0].x, m1[1].x, m1[2].x, m1[3].x);
     Vector4 row1(m1[0].y, m1[1].y, m1[2].y, m1[3].y);
     Vector4 row2(m1[0].z, m1[1].z, m1[2].z, m1[3].z);
@@ -394,10 +603,21 @@ Matrix4 operator*(const Matrix4 &m1, const Matrix4 &m2)
 
     return (
         Matrix4(resultColumn0, resultColumn1, resultColumn2, resultColumn3));
+#endif
 }
 
 Vector4 operator*(const Matrix4 &mat, const Vector4 &column)
 {
+#if defined(DS_MATH_SSE2)
+    Vector4 result;
+    simd::Store(&result.x, MultiplyColumns(simd::Load(&mat.data[0].x),
+                                           simd::Load(&mat.data[1].x),
+                                           simd::Load(&mat.data[2].x),
+                                           simd::Load(&mat.data[3].x),
+                                           simd::Load(&column.x)));
+
+    return result;
+#else
     Vector4 row0(mat[0].x, mat[1].x, mat[2].x, mat[3].x);
     Vector4 row1(mat[0].y, mat[1].y, mat[2].y, mat[3].y);
     Vector4 row2(mat[0].z, mat[1].z, mat[2].z, mat[3].z);
@@ -405,12 +625,29 @@ Vector4 operator*(const Matrix4 &mat, const Vector4 &column)
 
     return (Vector4(Vector4::Dot(row0, column), Vector4::Dot(row1, column),
                     Vector4::Dot(row2, column), Vector4::Dot(row3, column)));
+#endif
 }
 
 Vector4 operator*(const Vector4 &row, const Matrix4 &mat)
 {
+#if defined(DS_MATH_SSE2)
+    // Multiplying by the transpose turns the four dot products into one
+    // linear combination with the same order of operations.
+    __m128 c0 = simd::Load(&mat.data[0].x);
+    __m128 c1 = simd::Load(&mat.data[1].x);
+    __m128 c2 = simd::Load(&mat.data[2].x);
+    __m128 c3 = simd::Load(&mat.data[3].x);
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+    Vector4 result;
+    simd::Store(&result.x,
+                MultiplyColumns(c0, c1, c2, c3, simd::Load(&row.x)));
+
+    return result;
+#else
     return (Vector4(Vector4::Dot(row, mat[0]), Vector4::Dot(row, mat[1]),
                     Vector4::Dot(row, mat[2]), Vector4::Dot(row, mat[3])));
+#endif
 }
 
 Matrix4 operator*(const Matrix4 &mat, scalar factor)
@@ -193,6 +193,31 @@ public:
      * @return       Matrix4, matrix inverse.
      */
     static Matrix4 Inverse(const Matrix4 &mat);
+    /**
+     * Return the inverse of the given affine matrix.
+     *
+     * Only the upper 3x3 part and the translation of the matrix are used, the
+     * last row is assumed to be (0, 0, 0, 1). Considerably cheaper than
+     * Inverse.
+     *
+     * @param   mat  const Matrix4 &, affine matrix to find the inverse of.
+     * @return       Matrix4, matrix inverse.
+     */
+    static Matrix4 AffineInverse(const Matrix4 &mat);
+    /**
+     * Return the inverse of the given rigid transformation matrix (rotation
+     * and translation only, no scale or shear).
+     *
+     * The inverse is found by transposing the rotation and applying the
+     * negated, rotated translation. If the matrix is not a rigid
+     * transformation this function will not give the correct result, use
+     * AffineInverse instead.
+     *
+     * @param   mat  const Matrix4 &, rigid transformation matrix to find the
+     *  inverse of.
+     * @return       Matrix4, matrix inverse.
+     */
+    static Matrix4 RigidInverse(const Matrix4 &mat);
     /**
      * Transform the given vector by the given matrix.
      *
@@ -212,6 +237,8 @@ public:
     /**
      * Transform the given vector by the inverse of the given matrix.
      *
+     * @note The matrix must be an affine transform, see AffineInverse.
+     *
      * @param  mat  const Matrix4 &, matrix to invert and transform vector by.
      * @param  vec  const Vector3 &, vector to transform.
      * @return      Vector3, transformed vector.
@@ -220,6 +247,8 @@ public:
     /**
      * Transform the given vector by the inverse of the given matrix.
      *
+     * @note The matrix must be an affine transform, see AffineInverse.
+     *
      * @param  mat  const Matrix4 &, matrix to invert and transform vector by.
      * @param  vec  const Vector4 &, vector to transform.
      * @return      Vector4, transformed vector.
@@ -36,3 +36,15 @@ const float SCALAR_MAX = std::numeric_limits<float>::max();
  */
 const float FLOAT_ACCURACY = 10.0e-6f;
 }
+
+/**
+ * Alignment of the four component math types (Vector4, Quaternion and
+ * Matrix4 columns). 16-byte alignment is opt-in via DS_MATH_ALIGNED_STORAGE
+ * as these types are also stored in Lua userdata, which is not guaranteed to
+ * be 16-byte aligned.
+ */
+#if defined(DS_MATH_ALIGNED_STORAGE)
+#define DS_MATH_ALIGN alignas(16)
+#else
+#define DS_MATH_ALIGN
+#endif
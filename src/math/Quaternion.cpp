@@ -2,9 +2,13 @@
 #include <cassert>
 
 #include "Quaternion.h"
+#include "Simd.h"
 
 namespace ds_math
 {
+static_assert(sizeof(Quaternion) == 4 * sizeof(scalar),
+              "Quaternion components must be tightly packed.");
+
 Quaternion::Quaternion(scalar x, scalar y, scalar z, scalar w)
     : x(x), y(y), z(z), w(w)
 {
@@ -32,10 +36,14 @@ const Quaternion &Quaternion::operator=(const Quaternion &other)
 
 const Quaternion &Quaternion::operator*=(scalar factor)
 {
+#if defined(DS_MATH_SSE2)
+    simd::Store(&x, _mm_mul_ps(simd::Load(&x), _mm_set1_ps(factor)));
+#else
     x *= factor;
     y *= factor;
     z *= factor;
     w *= factor;
+#endif
 
     return (*this);
 }
@@ -144,7 +152,11 @@ Quaternion Quaternion::Normalize(const Quaternion &q)
 
 scalar Quaternion::Dot(const Quaternion &q1, const Quaternion &q2)
 {
+#if defined(DS_MATH_SSE2)
+    return simd::SumLanes(_mm_mul_ps(simd::Load(&q1.x), simd::Load(&q2.x)));
+#else
     return ((q1.x * q2.x) + (q1.y * q2.y) + (q1.z * q2.z) + (q1.w * q2.w));
+#endif
 }
 
 Quaternion Quaternion::Invert(const Quaternion &q)
@@ -178,10 +190,40 @@ Quaternion Quaternion::CreateFromAxisAngle(const Vector3 &axis, scalar angleRad)
 
 Quaternion operator*(const Quaternion &q1, const Quaternion &q2)
 {
+#if defined(DS_MATH_SSE2)
+    // Each lane evaluates the same terms, in the same order, as the scalar
+    // product below. Subtractions are performed as additions of negated
+    // terms, which IEEE 754 guarantees to be exact equivalents.
+    __m128 a = simd::Load(&q1.x);
+    __m128 b = simd::Load(&q2.x);
+
+    // {q1.w * q2.x, q1.w * q2.y, q1.w * q2.z, q1.w * q2.w}
+    __m128 product = _mm_mul_ps(simd::Splat<3>(a), b);
+    // {q1.x * q2.w, q1.y * q2.w, q1.z * q2.w, -q1.x * q2.x}
+    __m128 term = _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 2, 1, 0)),
+                             _mm_shuffle_ps(b, b, _MM_SHUFFLE(0, 3, 3, 3)));
+    product = _mm_add_ps(
+        product, _mm_xor_ps(term, simd::SignMask(false, false, false, true)));
+    // {q1.y * q2.z, q1.z * q2.x, q1.x * q2.y, -q1.y * q2.y}
+    term = _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 0, 2, 1)),
+                      _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 1, 0, 2)));
+    product = _mm_add_ps(
+        product, _mm_xor_ps(term, simd::SignMask(false, false, false, true)));
+    // {q1.z * q2.y, q1.x * q2.z, q1.y * q2.x, q1.z * q2.z}
+    term = _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 1, 0, 2)),
+                      _mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 0, 2, 1)));
+    product = _mm_sub_ps(product, term);
+
+    Quaternion result;
+    simd::Store(&result.x, product);
+
+    return result;
+#else
     return (Quaternion(q1.w * q2.x + q1.x * q2.w + q1.y * q2.z - q1.z * q2.y,
                        q1.w * q2.y + q1.y * q2.w + q1.z * q2.x - q1.x * q2.z,
                        q1.w * q2.z + q1.z * q2.w + q1.x * q2.y - q1.y * q2.x,
                        q1.w * q2.w - q1.x * q2.x - q1.y * q2.y - q1.z * q2.z));
+#endif
 }
 
 Quaternion operator*(const Quaternion &q, scalar factor)
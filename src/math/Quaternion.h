@@ -9,7 +9,7 @@ namespace ds_math
 /**
  * @author Samuel Evans-Powell
  */
-class Quaternion
+class DS_MATH_ALIGN Quaternion
 {
 public:
     /**
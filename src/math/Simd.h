@@ -0,0 +1,110 @@
+#pragma once
+
+#include "Precision.h"
+
+/**
+ * Compile-time selection of the SIMD backend used by the math classes.
+ *
+ * DS_MATH_SSE2 is defined whenever the target supports SSE2 (always true for
+ * x86-64 and for MSVC builds using /arch:SSE2). Define DS_MATH_NO_SIMD to
+ * force the scalar implementation.
+ *
+ * The SIMD paths perform exactly the same multiplications and additions, in
+ * the same order, as the scalar paths so both backends produce bit-identical
+ * results. For that reason instructions which change rounding behaviour
+ * (dpps, FMA) are intentionally not used.
+ */
+#if !defined(DS_MATH_NO_SIMD)
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DS_MATH_SSE2
+#endif
+#endif
+
+#if defined(DS_MATH_SSE2)
+#include <emmintrin.h>
+
+namespace ds_math
+{
+namespace simd
+{
+static_assert(sizeof(scalar) == sizeof(float),
+              "SIMD backend requires single precision scalars.");
+
+/**
+ * Load four contiguous scalars.
+ *
+ * Storage is not required to be 16-byte aligned (math objects may live in
+ * Lua userdata), an unaligned load of aligned data costs nothing on any
+ * SSE2-capable processor.
+ *
+ * @param   p  const scalar *, pointer to the first of four scalars.
+ * @return     __m128, loaded values.
+ */
+inline __m128 Load(const scalar *p)
+{
+    return _mm_loadu_ps(p);
+}
+
+/**
+ * Store four contiguous scalars.
+ *
+ * @param  p  scalar *, pointer to the first of four scalars.
+ * @param  v  __m128, values to store.
+ */
+inline void Store(scalar *p, __m128 v)
+{
+    _mm_storeu_ps(p, v);
+}
+
+/**
+ * Broadcast one lane of a vector to all four lanes.
+ *
+ * @tparam  L  int, lane to broadcast.
+ * @param   v  __m128, vector to broadcast lane from.
+ * @return     __m128, {v[L], v[L], v[L], v[L]}.
+ */
+template <int L>
+inline __m128 Splat(__m128 v)
+{
+    return _mm_shuffle_ps(v, v, _MM_SHUFFLE(L, L, L, L));
+}
+
+/**
+ * Sum the four lanes of a vector, left to right.
+ *
+ * The order of the additions matches ((v0 + v1) + v2) + v3 so that the
+ * result is identical to the scalar dot product.
+ *
+ * @param   v  __m128, vector to sum.
+ * @return     scalar, sum of all lanes.
+ */
+inline scalar SumLanes(__m128 v)
+{
+    __m128 sum = _mm_add_ss(v, Splat<1>(v));
+    sum = _mm_add_ss(sum, Splat<2>(v));
+    sum = _mm_add_ss(sum, Splat<3>(v));
+
+    return _mm_cvtss_f32(sum);
+}
+
+/**
+ * Build a mask that flips the sign of the selected lanes when XOR-ed with a
+ * vector.
+ *
+ * @param   x  bool, flip sign of the first lane.
+ * @param   y  bool, flip sign of the second lane.
+ * @param   z  bool, flip sign of the third lane.
+ * @param   w  bool, flip sign of the fourth lane.
+ * @return     __m128, sign mask.
+ */
+inline __m128 SignMask(bool x, bool y, bool z, bool w)
+{
+    return _mm_castsi128_ps(_mm_set_epi32(w ? (int)0x80000000 : 0,
+                                          z ? (int)0x80000000 : 0,
+                                          y ? (int)0x80000000 : 0,
+                                          x ? (int)0x80000000 : 0));
+}
+}
+}
+#endif
@@ -3,9 +3,13 @@
 
 #include "Vector4.h"
 #include "Matrix4.h"
+#include "Simd.h"
 
 namespace ds_math
 {
+static_assert(sizeof(Vector4) == 4 * sizeof(scalar),
+              "Vector4 components must be tightly packed.");
+
 Vector4::Vector4(scalar x, scalar y, scalar z, scalar w)
     : x(x), y(y), z(z), w(w)
 {
@@ -81,30 +85,42 @@ const scalar &Vector4::operator[](unsigned int index) const
 
 const Vector4 &Vector4::operator*=(scalar factor)
 {
+#if defined(DS_MATH_SSE2)
+    simd::Store(&x, _mm_mul_ps(simd::Load(&x), _mm_set1_ps(factor)));
+#else
     x *= factor;
     y *= factor;
     z *= factor;
     w *= factor;
+#endif
 
     return (*this);
 }
 
 const Vector4 &Vector4::operator+=(const Vector4 &other)
 {
+#if defined(DS_MATH_SSE2)
+    simd::Store(&x, _mm_add_ps(simd::Load(&x), simd::Load(&other.x)));
+#else
     x += other.x;
     y += other.y;
     z += other.z;
     w += other.w;
+#endif
 
     return (*this);
 }
 
 const Vector4 &Vector4::operator-=(const Vector4 &other)
 {
+#if defined(DS_MATH_SSE2)
+    simd::Store(&x, _mm_sub_ps(simd::Load(&x), simd::Load(&other.x)));
+#else
     x -= other.x;
     y -= other.y;
     z -= other.z;
     w -= other.w;
+#endif
 
     return (*this);
 }
@@ -139,7 +155,11 @@ void Vector4::Invert()
 
 scalar Vector4::Dot(const Vector4 &v1, const Vector4 &v2)
 {
+#if defined(DS_MATH_SSE2)
+    return simd::SumLanes(_mm_mul_ps(simd::Load(&v1.x), simd::Load(&v2.x)));
+#else
     return ((v1.x * v2.x) + (v1.y * v2.y) + (v1.z * v2.z) + (v1.w * v2.w));
+#endif
 }
 
 scalar Vector4::Magnitude(const Vector4 &vec)
@@ -184,12 +204,27 @@ const Vector4 Vector4::UnitW = Vector4(0.0f, 0.0f, 0.0f, 1.0f);
 
 Vector4 operator+(const Vector4 &v1, const Vector4 &v2)
 {
+#if defined(DS_MATH_SSE2)
+    Vector4 sum;
+    simd::Store(&sum.x, _mm_add_ps(simd::Load(&v1.x), simd::Load(&v2.x)));
+
+    return sum;
+#else
     return (Vector4(v1.x + v2.x, v1.y + v2.y, v1.z + v2.z, v1.w + v2.w));
+#endif
 }
 
 Vector4 operator-(const Vector4 &v1, const Vector4 &v2)
 {
+#if defined(DS_MATH_SSE2)
+    Vector4 difference;
+    simd::Store(&difference.x,
+                _mm_sub_ps(simd::Load(&v1.x), simd::Load(&v2.x)));
+
+    return difference;
+#else
     return (Vector4(v1.x - v2.x, v1.y - v2.y, v1.z - v2.z, v1.w - v2.w));
+#endif
 }
 
 Vector4 operator*(scalar factor, const Vector4 &vec)
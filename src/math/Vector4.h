@@ -10,7 +10,7 @@ class Matrix4;
 /**
  * @author Samuel Evans-Powell
  */
-class Vector4
+class DS_MATH_ALIGN Vector4
 {
 public:
     /**
@@ -0,0 +1,195 @@
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "engine/system/physics/CollisionCoarse.h"
+#include "engine/system/physics/PhysicsWorld.h"
+
+// Small deterministic generator so the tests don't depend on the standard
+// library's random number implementation.
+static float CollisionCoarseRandom(unsigned int *state)
+{
+    *state = *state * 1664525u + 1013904223u;
+    return (*state >> 8) / (float)(1 << 24);
+}
+
+static ds_phys::BoundingBox CollisionCoarseRandomBox(unsigned int *state)
+{
+    ds_math::Vector3 centre(CollisionCoarseRandom(state) * 50.0f,
+                            CollisionCoarseRandom(state) * 50.0f,
+                            CollisionCoarseRandom(state) * 50.0f);
+    ds_math::Vector3 extents(0.5f + CollisionCoarseRandom(state) * 2.0f,
+                             0.5f + CollisionCoarseRandom(state) * 2.0f,
+                             0.5f + CollisionCoarseRandom(state) * 2.0f);
+
+    return ds_phys::BoundingBox(centre - extents, centre + extents);
+}
+
+// Check that a tree query returns exactly the proxies whose fat boxes
+// overlap the query box.
+static void CollisionCoarseCheckQuery(const ds_phys::AabbTree &tree,
+                                      const std::vector<int> &proxies,
+                                      const ds_phys::BoundingBox &box)
+{
+    std::vector<int> expected;
+    for (int proxy : proxies)
+    {
+        if (proxy != ds_phys::AabbTree::NULL_NODE &&
+            tree.getFatBox(proxy).overlaps(box))
+        {
+            expected.push_back(proxy);
+        }
+    }
+
+    std::vector<int> found;
+    auto callback = [&](int proxy) {
+        found.push_back(proxy);
+        return true;
+    };
+    tree.query(box, callback);
+
+    std::sort(expected.begin(), expected.end());
+    std::sort(found.begin(), found.end());
+    EXPECT_EQ(expected, found);
+}
+
+TEST(CollisionCoarse, TestBoundingBoxOverlap)
+{
+    ds_phys::BoundingBox a(ds_math::Vector3(0, 0, 0),
+                           ds_math::Vector3(1, 1, 1));
+    ds_phys::BoundingBox b(ds_math::Vector3(1, 0.5f, 0.5f),
+                           ds_math::Vector3(2, 2, 2));
+    ds_phys::BoundingBox c(ds_math::Vector3(1.5f, 0, 0),
+                           ds_math::Vector3(2, 1, 1));
+
+    EXPECT_TRUE(a.overlaps(b));
+    EXPECT_TRUE(b.overlaps(a));
+    EXPECT_FALSE(a.overlaps(c));
+    EXPECT_TRUE(ds_phys::BoundingBox::merge(a, b).contains(c));
+    EXPECT_FALSE(a.contains(b));
+    EXPECT_EQ(6.0f, a.getSurfaceArea());
+}
+
+TEST(CollisionCoarse, TestAabbTreeQuery)
+{
+    unsigned int state = 1;
+    ds_phys::AabbTree tree;
+    std::vector<int> proxies;
+
+    for (int i = 0; i < 200; ++i)
+    {
+        proxies.push_back(
+            tree.createProxy(CollisionCoarseRandomBox(&state), nullptr));
+    }
+    EXPECT_EQ(200u, tree.getProxyCount());
+
+    // A balanced tree of 200 leaves should be far shallower than a list
+    EXPECT_LE(tree.getHeight(), 20);
+
+    for (int i = 0; i < 50; ++i)
+    {
+        CollisionCoarseCheckQuery(tree, proxies,
+                                  CollisionCoarseRandomBox(&state));
+    }
+
+    // Move half of the proxies and destroy a quarter of them
+    for (unsigned int i = 0; i < proxies.size(); i += 2)
+    {
+        tree.moveProxy(proxies[i], CollisionCoarseRandomBox(&state));
+    }
+    for (unsigned int i = 1; i < proxies.size(); i += 4)
+    {
+        tree.destroyProxy(proxies[i]);
+        proxies[i] = ds_phys::AabbTree::NULL_NODE;
+    }
+    EXPECT_EQ(150u, tree.getProxyCount());
+
+    for (int i = 0; i < 50; ++i)
+    {
+        CollisionCoarseCheckQuery(tree, proxies,
+                                  CollisionCoarseRandomBox(&state));
+    }
+}
+
+TEST(CollisionCoarse, TestAabbTreeMoveWithinMargin)
+{
+    ds_phys::AabbTree tree(0.5f);
+    ds_phys::BoundingBox box(ds_math::Vector3(0, 0, 0),
+                             ds_math::Vector3(1, 1, 1));
+    int proxy = tree.createProxy(box, nullptr);
+
+    ds_math::Vector3 small(0.25f, 0.25f, 0.25f);
+    EXPECT_FALSE(tree.moveProxy(
+        proxy, ds_phys::BoundingBox(box.min + small, box.max + small)));
+
+    ds_math::Vector3 large(2, 2, 2);
+    EXPECT_TRUE(tree.moveProxy(
+        proxy, ds_phys::BoundingBox(box.min + large, box.max + large)));
+    EXPECT_TRUE(tree.getFatBox(proxy).contains(
+        ds_phys::BoundingBox(box.min + large, box.max + large)));
+}
+
+TEST(CollisionCoarse, TestGenerateContactsMatchesAllPairs)
+{
+    const unsigned int count = 40;
+    unsigned int state = 7;
+
+    ds_phys::PhysicsWorld world(0);
+    std::vector<std::unique_ptr<ds_phys::RigidBody>> bodies;
+    std::vector<ds_phys::CollisionSphere *> spheres;
+
+    ds_phys::CollisionPlane *plane = new ds_phys::CollisionPlane();
+    plane->direction = ds_math::Vector3(0, 1, 0);
+    plane->offset = 0;
+    world.addCollisionPrimitive(
+        std::unique_ptr<ds_phys::CollisionPrimitive>(plane));
+
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        ds_phys::RigidBody *body = new ds_phys::RigidBody();
+        body->setMass(1.0f);
+        body->setInertiaTensor(ds_math::Vector3(1, 1, 1));
+        body->setOrientation(ds_math::Quaternion(0, 0, 0, 1));
+        body->setPosition(ds_math::Vector3(CollisionCoarseRandom(&state) * 10,
+                                           CollisionCoarseRandom(&state) * 3,
+                                           CollisionCoarseRandom(&state) * 10));
+
+        ds_phys::CollisionSphere *sphere = new ds_phys::CollisionSphere();
+        sphere->radius = 0.5f + CollisionCoarseRandom(&state);
+        sphere->body = body;
+        body->addCollisionPrimitive(sphere);
+
+        world.addRigidBody(body);
+        world.addCollisionPrimitive(
+            std::unique_ptr<ds_phys::CollisionPrimitive>(sphere));
+
+        bodies.push_back(std::unique_ptr<ds_phys::RigidBody>(body));
+        spheres.push_back(sphere);
+    }
+
+    unsigned int got = world.generateContacts();
+
+    // Reference: test every pair with the fine collision detector
+    std::vector<ds_phys::Contact> contacts(1024);
+    ds_phys::CollisionData data;
+    data.contactArray = &contacts[0];
+    data.reset(1024);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        ds_phys::CollisionDetector::sphereAndHalfSpace(*spheres[i], *plane,
+                                                       &data);
+    }
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        for (unsigned int j = i + 1; j < count; ++j)
+        {
+            ds_phys::CollisionDetector::sphereAndSphere(*spheres[i],
+                                                        *spheres[j], &data);
+        }
+    }
+
+    EXPECT_GT(data.contactCount, 0u);
+    EXPECT_EQ(data.contactCount, got);
+}
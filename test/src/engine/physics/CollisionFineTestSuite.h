@@ -0,0 +1,271 @@
+#include "gtest/gtest.h"
+
+#include "engine/system/physics/CollisionFine.h"
+
+/**
+ * Two overlapping rigid bodies with a primitive of each bounded type
+ * attached to each, and a plane through both.
+ */
+struct CollisionFineTestScene
+{
+    CollisionFineTestScene()
+    {
+        for (unsigned int i = 0; i < 2; ++i)
+        {
+            bodies[i].setMass(1.0f);
+            bodies[i].setInertiaTensor(ds_math::Vector3(1, 1, 1));
+            bodies[i].setOrientation(ds_math::Quaternion::CreateFromAxisAngle(
+                ds_math::Vector3::Normalize(ds_math::Vector3(1, 1, 0)),
+                0.4f * i));
+            bodies[i].setPosition(ds_math::Vector3(0.7f * i, 0.5f, 0.1f * i));
+            bodies[i].calculateDerivedData();
+
+            boxes[i].body = &bodies[i];
+            boxes[i].halfSize = ds_math::Vector3(0.5f, 0.5f, 0.5f);
+            spheres[i].body = &bodies[i];
+            spheres[i].radius = 0.5f;
+            capsules[i].body = &bodies[i];
+            capsules[i].height = 1.0f;
+            capsules[i].radius = 0.4f;
+
+            primitives[i][0] = &boxes[i];
+            primitives[i][1] = &spheres[i];
+            primitives[i][2] = &capsules[i];
+            primitives[i][3] = &plane;
+
+            for (ds_phys::CollisionPrimitive *primitive : primitives[i])
+            {
+                primitive->calculateInternals();
+            }
+        }
+
+        plane.direction = ds_math::Vector3(0, 1, 0);
+        plane.offset = 0.25f;
+
+        data.contactArray = contacts;
+        data.friction = 0.9f;
+        data.restitution = 0.1f;
+        data.tolerance = 0.1f;
+    }
+
+    ds_phys::RigidBody bodies[2];
+    ds_phys::CollisionBox boxes[2];
+    ds_phys::CollisionSphere spheres[2];
+    ds_phys::CollisionCapsule capsules[2];
+    ds_phys::CollisionPlane plane;
+    ds_phys::CollisionPrimitive *primitives[2][4];
+    ds_phys::Contact contacts[64];
+    ds_phys::CollisionData data;
+};
+
+TEST(CollisionFine, TestPrimitiveTypes)
+{
+    CollisionFineTestScene scene;
+
+    EXPECT_EQ(ds_phys::CollisionPrimitiveType::Box, scene.boxes[0].getType());
+    EXPECT_EQ(ds_phys::CollisionPrimitiveType::Sphere,
+              scene.spheres[0].getType());
+    EXPECT_EQ(ds_phys::CollisionPrimitiveType::Capsule,
+              scene.capsules[0].getType());
+    EXPECT_EQ(ds_phys::CollisionPrimitiveType::Plane, scene.plane.getType());
+}
+
+TEST(CollisionFine, TestPrimitiveAndPrimitiveIsSymmetric)
+{
+    CollisionFineTestScene scene;
+
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        for (unsigned int j = 0; j < 4; ++j)
+        {
+            const ds_phys::CollisionPrimitive &one = *scene.primitives[0][i];
+            const ds_phys::CollisionPrimitive &two = *scene.primitives[1][j];
+
+            scene.data.reset(64);
+            unsigned forward = ds_phys::CollisionDetector::primitiveAndPrimitive(
+                one, two, &scene.data);
+            ds_math::Vector3 forwardNormal = scene.contacts[0].contactNormal;
+
+            scene.data.reset(64);
+            unsigned backward =
+                ds_phys::CollisionDetector::primitiveAndPrimitive(
+                    two, one, &scene.data);
+            ds_math::Vector3 backwardNormal = scene.contacts[0].contactNormal;
+
+            EXPECT_EQ(forward, backward) << "types " << i << ", " << j;
+
+            // Mixed pairs run the same routine with the same argument order
+            // whichever way round they are given
+            if (forward > 0 && i != j)
+            {
+                EXPECT_EQ(forwardNormal, backwardNormal);
+            }
+
+            if (i == 3 && j == 3)
+            {
+                // Planes never collide with each other
+                EXPECT_EQ(0u, forward);
+            }
+            else
+            {
+                EXPECT_GT(forward, 0u) << "types " << i << ", " << j;
+            }
+        }
+    }
+}
+
+TEST(CollisionFine, TestAlignedBoxesIntersect)
+{
+    CollisionFineTestScene scene;
+
+    // Boxes with parallel axes, whose edge cross products are all zero
+    for (unsigned int i = 0; i < 2; ++i)
+    {
+        scene.bodies[i].setOrientation(ds_math::Quaternion(0, 0, 0, 1));
+        scene.bodies[i].setPosition(ds_math::Vector3(0.2f * i, 0.99f * i, 0));
+        scene.bodies[i].calculateDerivedData();
+        scene.boxes[i].calculateInternals();
+    }
+
+    EXPECT_TRUE(
+        ds_phys::IntersectionTests::boxAndBox(scene.boxes[0], scene.boxes[1]));
+
+    scene.data.reset(64);
+    ASSERT_EQ(1u, ds_phys::CollisionDetector::boxAndBox(
+                      scene.boxes[0], scene.boxes[1], &scene.data));
+    EXPECT_NEAR(1.0f, fabs(scene.contacts[0].contactNormal.y), 1e-4f);
+    EXPECT_NEAR(0.01f, scene.contacts[0].penetration, 1e-4f);
+}
+
+/**
+ * Convex hull of the corners of a box with the given half size.
+ */
+static void CollisionFineSetBoxHull(ds_phys::CollisionConvexHull *hull,
+                                    const ds_math::Vector3 &halfSize)
+{
+    std::vector<ds_math::Vector3> corners;
+    for (unsigned int i = 0; i < 8; ++i)
+    {
+        corners.push_back(ds_math::Vector3(i & 1 ? halfSize.x : -halfSize.x,
+                                           i & 2 ? halfSize.y : -halfSize.y,
+                                           i & 4 ? halfSize.z : -halfSize.z));
+    }
+    hull->setVertices(corners);
+}
+
+TEST(CollisionFine, TestConvexHullMatchesBox)
+{
+    CollisionFineTestScene scene;
+
+    // Hull of the first box's corners, tested against what the box touches
+    ds_phys::CollisionConvexHull hull;
+    hull.body = &scene.bodies[0];
+    CollisionFineSetBoxHull(&hull, scene.boxes[0].halfSize);
+    hull.calculateInternals();
+
+    ds_phys::BoundingBox hullBounds, boxBounds;
+    ASSERT_TRUE(hull.calculateBoundingBox(&hullBounds));
+    ASSERT_TRUE(scene.boxes[0].calculateBoundingBox(&boxBounds));
+    EXPECT_EQ(boxBounds.min, hullBounds.min);
+    EXPECT_EQ(boxBounds.max, hullBounds.max);
+
+    // Box and sphere, the sphere's centre outside the box
+    scene.data.reset(64);
+    ASSERT_EQ(1u, ds_phys::CollisionDetector::boxAndSphere(
+                      scene.boxes[0], scene.spheres[1], &scene.data));
+    ds_phys::Contact expected = scene.contacts[0];
+    scene.data.reset(64);
+    ASSERT_EQ(1u, ds_phys::CollisionDetector::primitiveAndPrimitive(
+                      hull, scene.spheres[1], &scene.data));
+    EXPECT_NEAR(expected.penetration, scene.contacts[0].penetration, 1e-3f);
+    EXPECT_NEAR(1.0f,
+                ds_math::Vector3::Dot(expected.contactNormal,
+                                      scene.contacts[0].contactNormal),
+                1e-3f);
+
+    // Overlapping boxes, where EPA finds the depth
+    scene.data.reset(64);
+    ASSERT_GT(ds_phys::CollisionDetector::boxAndBox(
+                  scene.boxes[0], scene.boxes[1], &scene.data),
+              0u);
+    expected = scene.contacts[0];
+    scene.data.reset(64);
+    ASSERT_EQ(1u, ds_phys::CollisionDetector::primitiveAndPrimitive(
+                      hull, scene.boxes[1], &scene.data));
+    EXPECT_NEAR(expected.penetration, scene.contacts[0].penetration, 1e-3f);
+    EXPECT_NEAR(1.0f,
+                fabs(ds_math::Vector3::Dot(expected.contactNormal,
+                                           scene.contacts[0].contactNormal)),
+                1e-3f);
+
+    // Corners behind the plane
+    scene.data.reset(64);
+    unsigned boxContacts = ds_phys::CollisionDetector::boxAndHalfSpace(
+        scene.boxes[0], scene.plane, &scene.data);
+    scene.data.reset(64);
+    EXPECT_EQ(boxContacts, ds_phys::CollisionDetector::primitiveAndPrimitive(
+                               scene.plane, hull, &scene.data));
+    EXPECT_NEAR(0.25f, scene.contacts[0].penetration, 1e-4f);
+    EXPECT_NEAR(1.0f, scene.contacts[0].contactNormal.y, 1e-4f);
+
+    // Rays meet the hull where they meet the box
+    ds_phys::RayIntersection boxHit, hullHit;
+    ds_math::Vector3 origin(-5, 0.6f, 0.1f);
+    ASSERT_TRUE(ds_phys::IntersectionTests::rayAndBox(
+        origin, ds_math::Vector3(1, 0, 0), 20, scene.boxes[0], 0, &boxHit));
+    ASSERT_TRUE(ds_phys::IntersectionTests::rayAndPrimitive(
+        origin, ds_math::Vector3(1, 0, 0), 20, hull, 0, &hullHit));
+    EXPECT_NEAR(boxHit.distance, hullHit.distance, 1e-3f);
+    EXPECT_NEAR(-1.0f, hullHit.normal.x, 1e-3f);
+    EXPECT_FALSE(ds_phys::IntersectionTests::rayAndPrimitive(
+        origin, ds_math::Vector3(-1, 0, 0), 20, hull, 0, &hullHit));
+}
+
+TEST(CollisionFine, TestCompoundTestsOverlappingChildren)
+{
+    CollisionFineTestScene scene;
+
+    // Spheres either side of the first body, only the second reaches the
+    // sphere of the second body
+    ds_phys::CollisionCompound compound;
+    compound.body = &scene.bodies[0];
+    for (unsigned int i = 0; i < 2; ++i)
+    {
+        std::unique_ptr<ds_phys::CollisionSphere> child(
+            new ds_phys::CollisionSphere());
+        child->radius = 0.25f;
+        child->offset = ds_math::Matrix4::CreateTranslationMatrix(
+            ds_math::Vector3(i == 0 ? -2.0f : 0.5f, 0, 0));
+        compound.addChild(std::move(child));
+    }
+    compound.calculateInternals();
+
+    ASSERT_EQ(2u, compound.getChildCount());
+    EXPECT_EQ(&scene.bodies[0], compound.getChild(1).body);
+    EXPECT_NEAR(-2.25f, compound.getLocalBounds().min.x, 1e-4f);
+    EXPECT_NEAR(0.75f, compound.getLocalBounds().max.x, 1e-4f);
+
+    unsigned int visited = 0;
+    auto count = [&](const ds_phys::CollisionPrimitive &) {
+        ++visited;
+        return true;
+    };
+    ds_phys::BoundingBox bounds;
+    scene.spheres[1].calculateBoundingBox(&bounds);
+    compound.queryChildren(bounds, count);
+    EXPECT_EQ(1u, visited);
+
+    scene.data.reset(64);
+    ASSERT_EQ(1u, ds_phys::CollisionDetector::primitiveAndPrimitive(
+                      scene.spheres[1], compound, &scene.data));
+    EXPECT_EQ(&scene.bodies[0], scene.contacts[0].body[0]);
+    EXPECT_LT(scene.contacts[0].contactNormal.x, 0);
+
+    // A ray along the compound meets the nearest child
+    ds_phys::RayIntersection hit;
+    ASSERT_TRUE(ds_phys::IntersectionTests::rayAndPrimitive(
+        ds_math::Vector3(5, 0.5f, 0), ds_math::Vector3(-1, 0, 0), 20,
+        compound, 0, &hit));
+    EXPECT_NEAR(4.25f, hit.distance, 1e-4f);
+    EXPECT_NEAR(1.0f, hit.normal.x, 1e-4f);
+}
@@ -0,0 +1,1373 @@
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "engine/system/physics/PhysicsWorld.h"
+
+/**
+ * Physics world with a ground plane and gravity, owning the bodies added to
+ * it.
+ */
+struct PhysicsWorldTestScene
+{
+    PhysicsWorldTestScene() : world(0)
+    {
+        gravity = world.addForceField(
+            ds_phys::ForceField::uniform(ds_math::Vector3(0, -9.8f, 0)));
+
+        ds_phys::CollisionPlane *plane = new ds_phys::CollisionPlane();
+        plane->direction = ds_math::Vector3(0, 1, 0);
+        plane->offset = 0;
+        world.addCollisionPrimitive(
+            std::unique_ptr<ds_phys::CollisionPrimitive>(plane));
+    }
+
+    ds_phys::RigidBody *addSphere(const ds_math::Vector3 &position,
+                                  ds_math::scalar radius)
+    {
+        ds_phys::RigidBody *body = new ds_phys::RigidBody();
+        body->setMass(1.0f);
+        body->setInertiaTensor(ds_math::Vector3(0.4f, 0.4f, 0.4f) * radius *
+                               radius);
+        body->setOrientation(ds_math::Quaternion(0, 0, 0, 1));
+        body->setPosition(position);
+
+        ds_phys::CollisionSphere *sphere = new ds_phys::CollisionSphere();
+        sphere->radius = radius;
+        sphere->body = body;
+        body->addCollisionPrimitive(sphere);
+
+        world.addRigidBody(body);
+        world.addCollisionPrimitive(
+            std::unique_ptr<ds_phys::CollisionPrimitive>(sphere));
+
+        bodies.push_back(std::unique_ptr<ds_phys::RigidBody>(body));
+        return body;
+    }
+
+    ds_phys::RigidBody *addBox(const ds_math::Vector3 &position,
+                               const ds_math::Vector3 &halfSize)
+    {
+        ds_phys::RigidBody *body = new ds_phys::RigidBody();
+        body->setMass(1.0f);
+        body->setInertiaTensor(ds_math::Vector3(1, 1, 1) * (1.0f / 6.0f));
+        body->setOrientation(ds_math::Quaternion(0, 0, 0, 1));
+        body->setPosition(position);
+
+        ds_phys::CollisionBox *box = new ds_phys::CollisionBox();
+        box->halfSize = halfSize;
+        box->body = body;
+        body->addCollisionPrimitive(box);
+
+        world.addRigidBody(body);
+        world.addCollisionPrimitive(
+            std::unique_ptr<ds_phys::CollisionPrimitive>(box));
+
+        bodies.push_back(std::unique_ptr<ds_phys::RigidBody>(body));
+        return body;
+    }
+
+    void step(unsigned int frames)
+    {
+        for (unsigned int i = 0; i < frames; ++i)
+        {
+            world.startFrame();
+            world.stepSimulation(1.0f / 60.0f);
+        }
+    }
+
+    ds_phys::PhysicsWorld world;
+    ds_phys::ForceFieldID gravity;
+    std::vector<std::unique_ptr<ds_phys::RigidBody>> bodies;
+};
+
+TEST(PhysicsWorld, TestRestingIslandsSleep)
+{
+    PhysicsWorldTestScene scene;
+
+    // Two separate spheres and a sphere resting on a box
+    ds_phys::RigidBody *a =
+        scene.addSphere(ds_math::Vector3(-5, 0.5f, 0), 0.5f);
+    ds_phys::RigidBody *b = scene.addSphere(ds_math::Vector3(5, 0.5f, 0), 0.5f);
+    ds_phys::RigidBody *c = scene.addBox(ds_math::Vector3(0, 0.5f, 0),
+                                         ds_math::Vector3(0.5f, 0.5f, 0.5f));
+    ds_phys::RigidBody *d = scene.addSphere(ds_math::Vector3(0, 1.5f, 0), 0.5f);
+
+    scene.step(600);
+
+    EXPECT_EQ(3u, scene.world.getIslandCount());
+    EXPECT_EQ(0u, scene.world.getAwakeIslandCount());
+    for (const auto &body : scene.bodies)
+    {
+        EXPECT_FALSE(body->getAwake());
+    }
+    EXPECT_NEAR(0.5f, a->getPosition().y, 0.1f);
+    EXPECT_NEAR(0.5f, b->getPosition().y, 0.1f);
+    EXPECT_NEAR(0.5f, c->getPosition().y, 0.1f);
+    EXPECT_NEAR(1.5f, d->getPosition().y, 0.1f);
+}
+
+TEST(PhysicsWorld, TestIslandWakesAsUnit)
+{
+    PhysicsWorldTestScene scene;
+
+    ds_phys::RigidBody *a = scene.addSphere(ds_math::Vector3(0, 1.5f, 0), 0.5f);
+    ds_phys::RigidBody *b = scene.addBox(ds_math::Vector3(0, 0.5f, 0),
+                                         ds_math::Vector3(0.5f, 0.5f, 0.5f));
+    ds_phys::RigidBody *c = scene.addSphere(ds_math::Vector3(8, 0.5f, 0), 0.5f);
+
+    scene.step(600);
+    ASSERT_FALSE(a->getAwake());
+    ASSERT_FALSE(b->getAwake());
+    ASSERT_FALSE(c->getAwake());
+
+    // Drop a sphere onto the sphere resting on the box, the box wakes with
+    // it as soon as it is touched and the distant body stays asleep
+    ds_phys::RigidBody *d =
+        scene.addSphere(ds_math::Vector3(0, 2.75f, 0), 0.5f);
+    for (unsigned int i = 0; i < 60 && !a->getAwake(); ++i)
+    {
+        EXPECT_FALSE(b->getAwake());
+        scene.step(1);
+    }
+
+    EXPECT_TRUE(a->getAwake());
+    EXPECT_TRUE(b->getAwake());
+    EXPECT_TRUE(d->getAwake());
+    EXPECT_FALSE(c->getAwake());
+    EXPECT_EQ(1u, scene.world.getAwakeIslandCount());
+}
+
+TEST(PhysicsWorld, TestForceWakesBody)
+{
+    PhysicsWorldTestScene scene;
+
+    ds_phys::RigidBody *a = scene.addSphere(ds_math::Vector3(0, 0.5f, 0), 0.5f);
+
+    scene.step(600);
+    ASSERT_FALSE(a->getAwake());
+
+    scene.world.startFrame();
+    a->addForce(ds_math::Vector3(0, 0, 100));
+    scene.world.stepSimulation(1.0f / 60.0f);
+
+    EXPECT_TRUE(a->getAwake());
+    EXPECT_GT(a->getPosition().z, 0.0f);
+}
+
+TEST(PhysicsWorld, TestImpulseGeneratorWakesBody)
+{
+    PhysicsWorldTestScene scene;
+
+    ds_phys::RigidBody *a = scene.addSphere(ds_math::Vector3(0, 0.5f, 0), 0.5f);
+
+    scene.step(600);
+    ASSERT_FALSE(a->getAwake());
+
+    // Registered on a sleeping body, the impulse is applied on the next step
+    std::shared_ptr<ds_phys::ImpulseGenerator> impulse(
+        new ds_phys::ImpulseGenerator());
+    impulse->addImpulse(ds_math::Vector3(0, 0, 100));
+    scene.world.addForceGenerator(a, impulse);
+    scene.step(1);
+
+    EXPECT_TRUE(a->getAwake());
+    EXPECT_GT(a->getPosition().z, 0.0f);
+    EXPECT_TRUE(impulse->isDone());
+}
+
+// Build a scene of separate stacks dropped onto the ground plane and onto a
+// static box shared by several of them, then step it with the given number
+// of workers.
+static std::vector<ds_math::Vector3>
+PhysicsWorldStepStacks(unsigned int workerCount)
+{
+    PhysicsWorldTestScene scene;
+    scene.world.setWorkerCount(workerCount);
+
+    ds_phys::RigidBody *ledge = scene.addBox(
+        ds_math::Vector3(0, 0.5f, 0), ds_math::Vector3(4.0f, 0.5f, 4.0f));
+    ledge->setInverseMass(0.0f);
+
+    for (unsigned int i = 0; i < 64; ++i)
+    {
+        ds_math::scalar x = (ds_math::scalar)(i % 8) * 2.5f - 9.0f;
+        ds_math::scalar z = (ds_math::scalar)(i / 8) * 2.5f - 9.0f;
+        scene.addBox(ds_math::Vector3(x, 2.0f, z),
+                     ds_math::Vector3(0.5f, 0.5f, 0.5f));
+        scene.addSphere(ds_math::Vector3(x + 0.1f, 3.5f, z), 0.5f);
+    }
+
+    scene.step(120);
+    EXPECT_GT(scene.world.getAwakeIslandCount(), 1u);
+
+    std::vector<ds_math::Vector3> positions;
+    for (const auto &body : scene.bodies)
+    {
+        positions.push_back(body->getPosition());
+    }
+    return positions;
+}
+
+TEST(PhysicsWorld, TestIslandsResolveDeterministically)
+{
+    std::vector<ds_math::Vector3> serial = PhysicsWorldStepStacks(1);
+    std::vector<ds_math::Vector3> parallel = PhysicsWorldStepStacks(4);
+
+    ASSERT_EQ(serial.size(), parallel.size());
+    for (unsigned int i = 0; i < serial.size(); ++i)
+    {
+        EXPECT_EQ(serial[i], parallel[i]) << "body " << i;
+    }
+
+    // The static box is shared by several islands but never moved
+    EXPECT_EQ(ds_math::Vector3(0, 0.5f, 0), serial[0]);
+}
+
+TEST(WorkerPool, TestRunAfterSetWorkerCount)
+{
+    ds_phys::WorkerPool pool(4);
+    std::vector<std::atomic<unsigned int>> runs(64);
+    std::atomic<unsigned int> running(0);
+
+    ds_phys::WorkerPool::Task task = [&](unsigned int index, unsigned int)
+    {
+        ++running;
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+        ++runs[index];
+        --running;
+    };
+
+    // Threads started again after each restart only run the batches after
+    // it, and every task is finished by the time run returns
+    for (unsigned int i = 0; i < 100; ++i)
+    {
+        for (auto &count : runs)
+        {
+            count = 0;
+        }
+
+        pool.run((unsigned int)runs.size(), task);
+        ASSERT_EQ(0u, running);
+        pool.setWorkerCount(2 + i % 3);
+        pool.run((unsigned int)runs.size(), task);
+        ASSERT_EQ(0u, running);
+
+        for (unsigned int index = 0; index < runs.size(); ++index)
+        {
+            ASSERT_EQ(2u, runs[index]) << "task " << index;
+        }
+    }
+}
+
+TEST(PhysicsWorld, TestSequentialImpulseStackStands)
+{
+    PhysicsWorldTestScene scene;
+    scene.world.setSolverMode(ds_phys::SolverMode::SequentialImpulse);
+    scene.world.getImpulseSolver().setIterations(8, 3);
+
+    std::vector<ds_phys::RigidBody *> stack;
+    for (unsigned int i = 0; i < 5; ++i)
+    {
+        stack.push_back(
+            scene.addBox(ds_math::Vector3(0, 0.5f + (ds_math::scalar)i, 0),
+                         ds_math::Vector3(0.5f, 0.5f, 0.5f)));
+    }
+
+    scene.step(600);
+
+    // One manifold between each box and the one below it, or the ground.
+    // Each contact is left with a little penetration, which adds up.
+    EXPECT_EQ(5u, scene.world.getManifoldCount());
+    EXPECT_EQ(0u, scene.world.getAwakeIslandCount());
+    for (unsigned int i = 0; i < stack.size(); ++i)
+    {
+        ds_math::Vector3 position = stack[i]->getPosition();
+        EXPECT_NEAR(0.0f, position.x, 0.05f) << "box " << i;
+        EXPECT_NEAR(0.5f + (ds_math::scalar)i, position.y, 0.15f)
+            << "box " << i;
+        EXPECT_NEAR(0.0f, position.z, 0.05f) << "box " << i;
+    }
+}
+
+TEST(PhysicsWorld, TestContactManifoldKeepsPoints)
+{
+    ds_phys::RigidBody body;
+    body.setMass(1.0f);
+    body.setOrientation(ds_math::Quaternion(0, 0, 0, 1));
+    body.setPosition(ds_math::Vector3(0, 0.5f, 0));
+    body.calculateDerivedData();
+
+    ds_phys::Contact contact;
+    contact.body[0] = nullptr;
+    contact.body[1] = &body;
+    contact.contactNormal = ds_math::Vector3(0, -1, 0);
+    contact.penetration = 0.01f;
+    contact.friction = 0.5f;
+    contact.restitution = 0.0f;
+
+    // A shallow point under the centre of a box resting on the ground, then
+    // its corners, generated one per step
+    ds_phys::ContactManifold manifold;
+    const ds_math::scalar points[5][2] = {
+        {0, 0}, {-0.5f, -0.5f}, {0.5f, -0.5f}, {0.5f, 0.5f}, {-0.5f, 0.5f}};
+    for (unsigned int i = 0; i < 5; ++i)
+    {
+        manifold.refresh();
+        contact.contactPoint = ds_math::Vector3(points[i][0], 0, points[i][1]);
+        contact.penetration = i == 0 ? 0.005f : 0.01f;
+        manifold.addContact(contact);
+    }
+
+    // The centre is replaced to cover the largest area, and the body is
+    // always first
+    ASSERT_EQ(4u, manifold.getPointCount());
+    EXPECT_EQ(&body, manifold.getBody(0));
+    EXPECT_EQ(nullptr, manifold.getBody(1));
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        EXPECT_EQ(ds_math::Vector3(0, 1, 0), manifold.getPoint(i).normal);
+        EXPECT_NE(0.0f, manifold.getPoint(i).point.x);
+    }
+
+    // Generating a point again keeps its impulse
+    manifold.getPoint(0).impulse = ds_math::Vector3(0, 2, 0);
+    contact.contactPoint = manifold.getPoint(0).point;
+    manifold.refresh();
+    manifold.addContact(contact);
+    ASSERT_EQ(4u, manifold.getPointCount());
+    EXPECT_EQ(ds_math::Vector3(0, 2, 0), manifold.getPoint(0).impulse);
+
+    // Points follow the body, and are dropped once it has moved apart
+    body.setPosition(ds_math::Vector3(0, 0.505f, 0));
+    body.calculateDerivedData();
+    manifold.refresh();
+    ASSERT_EQ(4u, manifold.getPointCount());
+    EXPECT_NEAR(0.005f, manifold.getPoint(0).penetration, 1e-4f);
+
+    body.setPosition(ds_math::Vector3(0, 0.55f, 0));
+    body.calculateDerivedData();
+    manifold.refresh();
+    EXPECT_EQ(0u, manifold.getPointCount());
+}
+
+TEST(PhysicsWorld, TestContactBufferGrows)
+{
+    PhysicsWorldTestScene scene;
+
+    // More spheres resting on the ground than the buffer starts with
+    const unsigned int count = 600;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        scene.addSphere(ds_math::Vector3((ds_math::scalar)(i % 25) * 2.0f,
+                                         0.45f,
+                                         (ds_math::scalar)(i / 25) * 2.0f),
+                        0.5f);
+    }
+    ASSERT_LT(scene.world.getContactStats().capacity, count);
+
+    scene.world.startFrame();
+    EXPECT_EQ(count, scene.world.generateContacts());
+
+    const ds_phys::ContactStats &stats = scene.world.getContactStats();
+    EXPECT_EQ(count, stats.contactCount);
+    EXPECT_EQ(count, stats.highWaterMark);
+    EXPECT_GE(stats.capacity, count);
+    EXPECT_EQ(0u, stats.droppedContacts);
+
+    // The high-water mark is kept until reset
+    scene.bodies.back()->setPosition(ds_math::Vector3(0, 10, 0));
+    scene.world.startFrame();
+    EXPECT_EQ(count - 1, scene.world.generateContacts());
+    EXPECT_EQ(count, stats.highWaterMark);
+
+    scene.world.resetContactStats();
+    EXPECT_EQ(0u, stats.highWaterMark);
+}
+
+TEST(PhysicsWorld, TestContactBudgetIsReported)
+{
+    PhysicsWorldTestScene scene;
+    scene.world.setContactBudget(10);
+
+    for (unsigned int i = 0; i < 16; ++i)
+    {
+        scene.addSphere(ds_math::Vector3((ds_math::scalar)i * 2.0f, 0.45f, 0),
+                        0.5f);
+    }
+
+    scene.world.startFrame();
+    EXPECT_EQ(10u, scene.world.generateContacts());
+
+    const ds_phys::ContactStats &stats = scene.world.getContactStats();
+    EXPECT_EQ(16u, stats.contactCount);
+    EXPECT_EQ(6u, stats.droppedContacts);
+    EXPECT_EQ(1u, stats.overBudgetSteps);
+
+    // Without a budget every contact is kept
+    scene.world.setContactBudget(0);
+    scene.world.startFrame();
+    EXPECT_EQ(16u, scene.world.generateContacts());
+    EXPECT_EQ(0u, stats.droppedContacts);
+    EXPECT_EQ(1u, stats.overBudgetSteps);
+
+    // Each box touches the ground at its four bottom corners, no box is
+    // left with only some of them
+    PhysicsWorldTestScene boxScene;
+    boxScene.world.setContactBudget(10);
+    std::vector<ds_phys::RigidBody *> boxes;
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        boxes.push_back(boxScene.addBox(
+            ds_math::Vector3((ds_math::scalar)i * 2.0f, 0.45f, 0),
+            ds_math::Vector3(0.5f, 0.5f, 0.5f)));
+    }
+
+    boxScene.world.startFrame();
+    EXPECT_EQ(8u, boxScene.world.generateContacts());
+    const ds_phys::ContactStats &boxStats = boxScene.world.getContactStats();
+    EXPECT_EQ(16u, boxStats.contactCount);
+    EXPECT_EQ(8u, boxStats.droppedContacts);
+
+    // The boxes dropped one step are kept the next, so none of them sinks
+    // through the ground
+    boxScene.step(120);
+    for (ds_phys::RigidBody *box : boxes)
+    {
+        EXPECT_NEAR(0.5f, box->getPosition().y, 0.1f);
+    }
+    EXPECT_GT(boxStats.overBudgetSteps, 1u);
+}
+
+TEST(PhysicsWorld, TestSolverStatsAreReported)
+{
+    PhysicsWorldTestScene scene;
+    scene.world.setSolverMode(ds_phys::SolverMode::SequentialImpulse);
+    scene.world.getImpulseSolver().setIterations(6, 2);
+
+    // Three separate spheres sinking slightly into the ground
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        scene.addSphere(ds_math::Vector3((ds_math::scalar)i * 3.0f, 0.45f, 0),
+                        0.5f);
+    }
+    scene.step(1);
+
+    const ds_phys::SolverStats &stats = scene.world.getSolverStats();
+    EXPECT_EQ(3u, stats.islandCount);
+    EXPECT_GE(stats.contactCount, 3u);
+    EXPECT_EQ(18u, stats.velocityIterations);
+    EXPECT_EQ(6u, stats.positionIterations);
+}
+
+TEST(PhysicsWorld, TestRigidBodyHandlesGoStale)
+{
+    PhysicsWorldTestScene scene;
+
+    ds_phys::RigidBody *a = scene.addSphere(ds_math::Vector3(-5, 5, 0), 0.5f);
+    ds_phys::RigidBody *b = scene.addSphere(ds_math::Vector3(0, 5, 0), 0.5f);
+    ds_phys::RigidBody *c = scene.addSphere(ds_math::Vector3(5, 5, 0), 0.5f);
+
+    const ds_phys::RigidBodyPool &pool = scene.world.getRigidBodies();
+    ds_phys::RigidBodyHandle handleA = pool.getHandle(a);
+    ds_phys::RigidBodyHandle handleB = pool.getHandle(b);
+    ds_phys::RigidBodyHandle handleC = pool.getHandle(c);
+    EXPECT_EQ(b, scene.world.getRigidBody(handleB));
+
+    scene.step(10);
+    ds_math::Vector3 position = b->getPosition();
+
+    // The last body fills the gap and the removed body keeps its state
+    scene.world.removeRigidBody(handleB);
+    EXPECT_EQ(2u, pool.size());
+    EXPECT_EQ(c, pool.getBody(1));
+    EXPECT_EQ(-1, pool.getIndex(b));
+    EXPECT_EQ(position, b->getPosition());
+
+    EXPECT_EQ(nullptr, scene.world.getRigidBody(handleB));
+    EXPECT_EQ(a, scene.world.getRigidBody(handleA));
+    EXPECT_EQ(c, scene.world.getRigidBody(handleC));
+
+    // Removing again does nothing
+    scene.world.removeRigidBody(handleB);
+    EXPECT_EQ(2u, pool.size());
+
+    // The slot is re-used with a handle the old one doesn't match
+    ds_phys::RigidBodyHandle handleD = scene.world.addRigidBody(b);
+    EXPECT_EQ(handleB.getIndex(), handleD.getIndex());
+    EXPECT_NE(handleB, handleD);
+    EXPECT_EQ(nullptr, scene.world.getRigidBody(handleB));
+    EXPECT_EQ(b, scene.world.getRigidBody(handleD));
+    EXPECT_EQ(position, b->getPosition());
+
+    scene.step(10);
+    EXPECT_LT(b->getPosition().y, position.y);
+}
+
+TEST(PhysicsWorld, TestRigidBodyPoolIntegratesAsBody)
+{
+    ds_phys::RigidBody pooled;
+    ds_phys::RigidBody standalone;
+    for (ds_phys::RigidBody *body : {&pooled, &standalone})
+    {
+        body->setMass(2.0f);
+        body->setInertiaTensor(ds_math::Vector3(1, 2, 3));
+        body->setOrientation(ds_math::Quaternion(0, 0, 0, 1));
+        body->setPosition(ds_math::Vector3(1, 2, 3));
+        body->setVelocity(ds_math::Vector3(0, 1, 0));
+        body->setRotation(ds_math::Vector3(0.5f, 0, 0.25f));
+        body->setAcceleration(ds_math::Vector3(0, -9.8f, 0));
+        body->setCanSleep(false);
+        body->calculateDerivedData();
+    }
+
+    ds_phys::RigidBodyPool pool;
+    pool.add(&pooled);
+
+    for (unsigned int i = 0; i < 30; ++i)
+    {
+        for (ds_phys::RigidBody *body : {&pooled, &standalone})
+        {
+            body->addForceAtBodyPoint(ds_math::Vector3(1, 0, 0),
+                                      ds_math::Vector3(0, 1, 0));
+        }
+
+        pool.integrate(1.0f / 60.0f);
+        standalone.integrate(1.0f / 60.0f);
+    }
+
+    EXPECT_EQ(standalone.getPosition(), pooled.getPosition());
+    EXPECT_EQ(standalone.getVelocity(), pooled.getVelocity());
+    EXPECT_EQ(standalone.getRotation(), pooled.getRotation());
+}
+
+TEST(PhysicsWorld, TestObjectPoolReusesSlots)
+{
+    ds_phys::ObjectPool<ds_phys::CollisionSphere> pool(4);
+
+    std::vector<ds_phys::CollisionSphere *> spheres;
+    for (unsigned int i = 0; i < 6; ++i)
+    {
+        spheres.push_back(pool.create());
+    }
+    EXPECT_EQ(6u, pool.size());
+    EXPECT_EQ(8u, pool.capacity());
+    EXPECT_TRUE(pool.owns(spheres[5]));
+
+    // Freed slots are handed out again before any slab is added
+    ds_phys::CollisionSphere *freed = spheres[1];
+    pool.destroy(freed);
+    EXPECT_FALSE(pool.owns(freed));
+    EXPECT_EQ(freed, pool.create());
+
+    ds_phys::CollisionSphere outside;
+    EXPECT_FALSE(pool.owns(&outside));
+    EXPECT_EQ(8u, pool.capacity());
+}
+
+TEST(PhysicsWorld, TestPooledBodiesAreRecycled)
+{
+    PhysicsWorldTestScene scene;
+
+    // Spawn and despawn a projectile several times over
+    ds_phys::RigidBody *first = nullptr;
+    ds_phys::CollisionSphere *firstSphere = nullptr;
+    ds_phys::CollisionPrimitiveID firstId = 0;
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        ds_phys::RigidBody *body = scene.world.createRigidBody();
+        body->setMass(1.0f);
+        body->setInertiaTensor(ds_math::Vector3(0.1f, 0.1f, 0.1f));
+        body->setPosition(ds_math::Vector3(0, 0.45f, 0));
+
+        ds_phys::CollisionPrimitiveID id;
+        ds_phys::CollisionSphere *sphere = scene.world.createSphere(&id);
+        sphere->radius = 0.5f;
+        sphere->body = body;
+        body->addCollisionPrimitive(sphere);
+        EXPECT_EQ(sphere, scene.world.getCollisionPrimitive(id));
+
+        scene.world.addForceGenerator(
+            body, std::make_shared<ds_phys::Gravity>(ds_math::Vector3()));
+        scene.step(5);
+        EXPECT_EQ(1u, scene.world.getRigidBodies().size());
+        EXPECT_GT(scene.world.getContactStats().contactCount, 0u);
+
+        if (i == 0)
+        {
+            first = body;
+            firstSphere = sphere;
+            firstId = id;
+        }
+        else
+        {
+            // The same slots are used again, ids of the primitives removed
+            // from them don't find the new one
+            EXPECT_EQ(first, body);
+            EXPECT_EQ(firstSphere, sphere);
+            EXPECT_NE(firstId, id);
+            EXPECT_EQ(nullptr, scene.world.getCollisionPrimitive(firstId));
+        }
+
+        scene.world.destroyRigidBody(body);
+        EXPECT_EQ(nullptr, scene.world.getCollisionPrimitive(id));
+        EXPECT_EQ(0u, scene.world.getRigidBodies().size());
+
+        // Nothing is left touching the ground
+        scene.step(1);
+        EXPECT_EQ(0u, scene.world.getContactStats().contactCount);
+    }
+}
+
+// Expect math objects to be made of exactly the same scalars
+template <typename T>
+static void PhysicsWorldExpectIdentical(const T &expected, const T &actual)
+{
+    const ds_math::scalar *a =
+        reinterpret_cast<const ds_math::scalar *>(&expected);
+    const ds_math::scalar *b =
+        reinterpret_cast<const ds_math::scalar *>(&actual);
+    for (unsigned int i = 0; i < sizeof(T) / sizeof(ds_math::scalar); ++i)
+    {
+        EXPECT_EQ(a[i], b[i]);
+    }
+}
+
+TEST(PhysicsWorld, TestRigidBodyPoolBatchMatchesBodies)
+{
+    // Enough bodies for several groups of four and a remainder, with some
+    // bodies asleep in the middle of a group
+    const unsigned int count = 11;
+    std::vector<std::unique_ptr<ds_phys::RigidBody>> pooled;
+    std::vector<std::unique_ptr<ds_phys::RigidBody>> standalone;
+    for (unsigned int i = 0; i < 2 * count; ++i)
+    {
+        unsigned int n = i % count;
+        ds_phys::RigidBody *body = new ds_phys::RigidBody();
+        body->setMass(1.0f + n * 0.5f);
+        body->setInertiaTensor(ds_math::Vector3(1.0f + n, 2.0f, 0.5f + n));
+        body->setOrientation(ds_math::Quaternion::CreateFromAxisAngle(
+            ds_math::Vector3::Normalize(ds_math::Vector3(1.0f, n, 2.0f)),
+            0.3f * n));
+        body->setPosition(ds_math::Vector3(n * 1.5f, 2.0f, -(float)n));
+        body->setCenterOfMassLocalSpace(ds_math::Vector3(0, 0.1f * n, 0));
+        body->setVelocity(ds_math::Vector3(0, n * 0.25f, 1));
+        body->setRotation(ds_math::Vector3(0.5f, -0.1f * n, 0.25f));
+        body->setAcceleration(ds_math::Vector3(0, -9.8f, 0));
+        body->setDamping(0.99f - n * 0.01f, 0.8f + n * 0.01f);
+        body->setCanSleep(false);
+        body->calculateDerivedData();
+        if (n % 3 == 1)
+        {
+            body->setAwake(false);
+        }
+
+        (i < count ? pooled : standalone)
+            .push_back(std::unique_ptr<ds_phys::RigidBody>(body));
+    }
+
+    ds_phys::RigidBodyPool pool;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        pool.add(pooled[i].get());
+    }
+
+    for (unsigned int step = 0; step < 60; ++step)
+    {
+        for (unsigned int i = 0; i < 2 * count; ++i)
+        {
+            ds_phys::RigidBody *body =
+                i < count ? pooled[i].get() : standalone[i - count].get();
+            body->addForceAtBodyPoint(ds_math::Vector3(1, 0, 0.5f),
+                                      ds_math::Vector3(0, 1, 0));
+        }
+
+        pool.integrate(1.0f / 60.0f);
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            standalone[i]->integrate(1.0f / 60.0f, false);
+        }
+    }
+
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        const ds_phys::RigidBody &a = *standalone[i];
+        const ds_phys::RigidBody &b = *pooled[i];
+
+        PhysicsWorldExpectIdentical(a.getPosition(), b.getPosition());
+        PhysicsWorldExpectIdentical(a.getVelocity(), b.getVelocity());
+        PhysicsWorldExpectIdentical(a.getRotation(), b.getRotation());
+        PhysicsWorldExpectIdentical(a.getOrientation(), b.getOrientation());
+        PhysicsWorldExpectIdentical(a.getTransform(), b.getTransform());
+        PhysicsWorldExpectIdentical(a.getInverseInertiaTensorWorld(),
+                                    b.getInverseInertiaTensorWorld());
+    }
+}
+
+TEST(PhysicsWorld, TestForceFieldsMatchBodies)
+{
+    const ds_phys::ForceField fields[] = {
+        ds_phys::ForceField::uniform(ds_math::Vector3(0, -9.8f, 0)),
+        ds_phys::ForceField::directional(ds_math::Vector3(3, 0, -1)),
+        ds_phys::ForceField::radial(ds_math::Vector3(4, 2, -3), 20.0f, 6.0f),
+        ds_phys::ForceField::radial(ds_math::Vector3(0, 2, 0), -5.0f, 3.0f)};
+    const unsigned int fieldCount = sizeof(fields) / sizeof(fields[0]);
+
+    // Several groups of four and a remainder, with sleeping and immovable
+    // bodies, bodies outside the radial fields and one at a centre
+    const unsigned int count = 11;
+    std::vector<std::unique_ptr<ds_phys::RigidBody>> pooled;
+    std::vector<std::unique_ptr<ds_phys::RigidBody>> standalone;
+    for (unsigned int i = 0; i < 2 * count; ++i)
+    {
+        unsigned int n = i % count;
+        ds_phys::RigidBody *body = new ds_phys::RigidBody();
+        body->setMass(1.0f + n * 0.5f);
+        if (n == 5)
+        {
+            body->setInverseMass(0);
+        }
+        body->setInertiaTensor(ds_math::Vector3(1, 1, 1));
+        body->setOrientation(ds_math::Quaternion(0, 0, 0, 1));
+        body->setPosition(ds_math::Vector3(n * 1.5f, 2.0f, -(float)n));
+        body->setCanSleep(false);
+        body->calculateDerivedData();
+        if (n % 4 == 2)
+        {
+            body->setAwake(false);
+        }
+
+        (i < count ? pooled : standalone)
+            .push_back(std::unique_ptr<ds_phys::RigidBody>(body));
+    }
+
+    ds_phys::RigidBodyPool pool;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        pool.add(pooled[i].get());
+    }
+
+    for (unsigned int step = 0; step < 60; ++step)
+    {
+        pool.applyForceFields(fields, fieldCount);
+        pool.integrate(1.0f / 60.0f);
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            ds_phys::RigidBody *body = standalone[i].get();
+            if (!body->getAwake() || !body->hasFiniteMass())
+            {
+                continue;
+            }
+
+            ds_math::scalar mass = 1.0f / body->getInverseMass();
+            ds_math::Vector3 force;
+            for (const ds_phys::ForceField &field : fields)
+            {
+                if (field.type == ds_phys::ForceFieldType::Uniform)
+                {
+                    force += field.vector * mass;
+                }
+                else if (field.type == ds_phys::ForceFieldType::Directional)
+                {
+                    force += field.vector;
+                }
+                else
+                {
+                    ds_math::Vector3 offset =
+                        field.centre - body->getPosition();
+                    ds_math::scalar distance =
+                        sqrtf(offset.x * offset.x + offset.y * offset.y +
+                              offset.z * offset.z);
+                    if (distance > 0 && distance < field.radius)
+                    {
+                        force += offset *
+                                 (field.strength *
+                                  (1.0f - distance / field.radius) * mass /
+                                  distance);
+                    }
+                }
+            }
+            body->addForce(force);
+            body->integrate(1.0f / 60.0f, false);
+        }
+    }
+
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        PhysicsWorldExpectIdentical(standalone[i]->getPosition(),
+                                    pooled[i]->getPosition());
+        PhysicsWorldExpectIdentical(standalone[i]->getVelocity(),
+                                    pooled[i]->getVelocity());
+    }
+
+    // Sleeping and immovable bodies never move
+    EXPECT_EQ(ds_math::Vector3(3, 2, -2), pooled[2]->getPosition());
+    EXPECT_EQ(ds_math::Vector3(7.5f, 2, -5), pooled[5]->getPosition());
+}
+
+TEST(PhysicsWorld, TestRadialForceFieldAttracts)
+{
+    PhysicsWorldTestScene scene;
+    scene.world.removeForceField(scene.gravity);
+    EXPECT_EQ(nullptr, scene.world.getForceField(scene.gravity));
+
+    ds_phys::RigidBody *near = scene.addSphere(ds_math::Vector3(3, 5, 0), 0.5f);
+    ds_phys::RigidBody *far = scene.addSphere(ds_math::Vector3(-9, 5, 0), 0.5f);
+    for (ds_phys::RigidBody *body : {near, far})
+    {
+        body->setCanSleep(false);
+    }
+
+    ds_phys::ForceFieldID attractor = scene.world.addForceField(
+        ds_phys::ForceField::radial(ds_math::Vector3(0, 5, 0), 10.0f, 5.0f));
+    scene.step(30);
+
+    // Pulled towards the centre, the far body is outside the radius
+    EXPECT_LT(near->getPosition().x, 3.0f);
+    EXPECT_GT(near->getPosition().x, 0.0f);
+    EXPECT_FLOAT_EQ(5.0f, near->getPosition().y);
+    EXPECT_EQ(ds_math::Vector3(-9, 5, 0), far->getPosition());
+
+    // Moving the field's centre beyond the far body pulls it the other way
+    scene.world.setForceField(
+        attractor,
+        ds_phys::ForceField::radial(ds_math::Vector3(-12, 5, 0), 10.0f, 5.0f));
+    scene.step(10);
+    EXPECT_LT(far->getPosition().x, -9.0f);
+}
+
+// Sphere and box resting on the ground, stepped once so that the queries
+// see them
+static void PhysicsWorldAddQueryBodies(PhysicsWorldTestScene &scene,
+                                       ds_phys::RigidBody **sphere,
+                                       ds_phys::RigidBody **box)
+{
+    *sphere = scene.addSphere(ds_math::Vector3(0, 0.5f, 0), 0.5f);
+    *box = scene.addBox(ds_math::Vector3(3, 0.5f, 0),
+                        ds_math::Vector3(0.5f, 0.5f, 0.5f));
+    scene.step(1);
+}
+
+TEST(PhysicsWorld, TestRaycastFindsNearest)
+{
+    PhysicsWorldTestScene scene;
+    ds_phys::RigidBody *sphere, *box;
+    PhysicsWorldAddQueryBodies(scene, &sphere, &box);
+
+    ds_phys::QueryHit hit;
+    ASSERT_TRUE(scene.world.raycast(ds_math::Vector3(-5, 0.5f, 0),
+                                    ds_math::Vector3(2, 0, 0), 20, &hit));
+    EXPECT_EQ(sphere, hit.body);
+    EXPECT_NEAR(4.5f, hit.distance, 0.01f);
+    EXPECT_NEAR(-1.0f, hit.normal.x, 0.01f);
+    EXPECT_NEAR(-0.5f, hit.point.x, 0.01f);
+
+    // Skipping the sphere finds the box behind it
+    ASSERT_TRUE(scene.world.raycast(ds_math::Vector3(-5, 0.5f, 0),
+                                    ds_math::Vector3(1, 0, 0), 20, &hit,
+                                    sphere));
+    EXPECT_EQ(box, hit.body);
+    EXPECT_NEAR(7.5f, hit.distance, 0.01f);
+    EXPECT_NEAR(-1.0f, hit.normal.x, 0.01f);
+
+    // The ground has no body
+    ASSERT_TRUE(scene.world.raycast(ds_math::Vector3(10, 5, 0),
+                                    ds_math::Vector3(0, -1, 0), 20, &hit));
+    EXPECT_EQ(nullptr, hit.body);
+    EXPECT_NE(nullptr, hit.primitive);
+    EXPECT_NEAR(5.0f, hit.distance, 0.001f);
+    EXPECT_NEAR(1.0f, hit.normal.y, 0.001f);
+
+    EXPECT_FALSE(scene.world.raycast(ds_math::Vector3(10, 1, 0),
+                                     ds_math::Vector3(0, 1, 0), 20, &hit));
+    EXPECT_FALSE(scene.world.raycast(ds_math::Vector3(-5, 0.5f, 0),
+                                     ds_math::Vector3(1, 0, 0), 4, &hit));
+}
+
+TEST(PhysicsWorld, TestSweepSphereTouchesRoundedEdges)
+{
+    PhysicsWorldTestScene scene;
+    ds_phys::RigidBody *sphere, *box;
+    PhysicsWorldAddQueryBodies(scene, &sphere, &box);
+
+    ds_phys::QueryHit hit;
+    ASSERT_TRUE(scene.world.sweepSphere(ds_math::Vector3(-5, 0.5f, 0), 0.25f,
+                                        ds_math::Vector3(1, 0, 0), 20, &hit));
+    EXPECT_EQ(sphere, hit.body);
+    EXPECT_NEAR(4.25f, hit.distance, 0.01f);
+    EXPECT_NEAR(-0.5f, hit.point.x, 0.01f);
+
+    // Passing just beyond the top edge of the box, the swept sphere
+    // catches the edge rather than the face
+    ASSERT_TRUE(scene.world.sweepSphere(ds_math::Vector3(3, 5, 0.7f), 0.25f,
+                                        ds_math::Vector3(0, -1, 0), 20, &hit));
+    EXPECT_EQ(box, hit.body);
+    EXPECT_NEAR(3.85f, hit.distance, 0.01f);
+    EXPECT_NEAR(1.0f, hit.point.y, 0.01f);
+    EXPECT_NEAR(0.5f, hit.point.z, 0.01f);
+}
+
+TEST(PhysicsWorld, TestOverlapQueries)
+{
+    PhysicsWorldTestScene scene;
+    ds_phys::RigidBody *sphere, *box;
+    PhysicsWorldAddQueryBodies(scene, &sphere, &box);
+
+    std::vector<ds_phys::CollisionPrimitive *> results;
+    EXPECT_EQ(1u, scene.world.overlapSphere(ds_math::Vector3(0, 1, 0.5f),
+                                            0.6f, &results));
+    ASSERT_EQ(1u, results.size());
+    EXPECT_EQ(sphere, results[0]->body);
+
+    // The box overlaps the body and the ground
+    results.clear();
+    ds_math::Quaternion identity(0, 0, 0, 1);
+    EXPECT_EQ(2u, scene.world.overlapBox(ds_math::Vector3(3, 0.5f, 0),
+                                         ds_math::Vector3(1, 1, 1), identity,
+                                         &results));
+    results.clear();
+    EXPECT_EQ(1u, scene.world.overlapBox(ds_math::Vector3(3, 0.5f, 0),
+                                         ds_math::Vector3(1, 1, 1), identity,
+                                         &results, box));
+    ASSERT_EQ(1u, results.size());
+    EXPECT_EQ(nullptr, results[0]->body);
+
+    results.clear();
+    EXPECT_EQ(0u, scene.world.overlapSphere(ds_math::Vector3(0, 5, 5), 1.0f,
+                                            &results));
+}
+
+TEST(PhysicsWorld, TestRaycastBatchMatchesSingle)
+{
+    PhysicsWorldTestScene scene;
+    scene.world.setWorkerCount(4);
+    for (int i = 0; i < 16; ++i)
+    {
+        scene.addSphere(ds_math::Vector3((ds_math::scalar)(i % 4) * 2.0f, 0.5f,
+                                         (ds_math::scalar)(i / 4) * 2.0f),
+                        0.5f);
+    }
+    scene.step(1);
+
+    std::vector<ds_phys::RaycastQuery> queries(500);
+    for (unsigned int i = 0; i < queries.size(); ++i)
+    {
+        ds_phys::RaycastQuery &query = queries[i];
+        query.origin =
+            ds_math::Vector3(-2.0f, 0.1f + (i % 10) * 0.1f, (i % 50) * 0.15f);
+        query.direction = ds_math::Vector3(1, -0.05f * (i % 3), 0);
+        query.maxDistance = 5.0f + (i % 7);
+        query.radius = i % 2 ? 0.1f : 0.0f;
+    }
+
+    std::vector<ds_phys::QueryHit> hits(queries.size());
+    unsigned int hitCount = scene.world.raycastBatch(
+        queries.data(), (unsigned int)queries.size(), hits.data());
+
+    unsigned int expectedHits = 0;
+    for (unsigned int i = 0; i < queries.size(); ++i)
+    {
+        const ds_phys::RaycastQuery &query = queries[i];
+        ds_phys::QueryHit hit;
+        bool found =
+            scene.world.sweepSphere(query.origin, query.radius,
+                                    query.direction, query.maxDistance, &hit);
+        if (found)
+        {
+            ++expectedHits;
+            EXPECT_EQ(hit.id, hits[i].id);
+            EXPECT_EQ(hit.distance, hits[i].distance);
+        }
+        else
+        {
+            EXPECT_EQ(nullptr, hits[i].primitive);
+        }
+    }
+    EXPECT_EQ(expectedHits, hitCount);
+    EXPECT_GT(hitCount, 0u);
+}
+
+/**
+ * Add a 9 by 9 heightfield to a scene, with a sample every unit and heights
+ * following a plane through (0, height, 0) with the given slopes.
+ */
+static void PhysicsWorldAddHeightfield(PhysicsWorldTestScene *scene,
+                                       ds_math::scalar height,
+                                       ds_math::scalar slopeX,
+                                       ds_math::scalar slopeZ)
+{
+    std::vector<float> heights(9 * 9);
+    for (int z = 0; z < 9; ++z)
+    {
+        for (int x = 0; x < 9; ++x)
+        {
+            heights[z * 9 + x] = height + slopeX * (x - 4) + slopeZ * (z - 4);
+        }
+    }
+
+    ds_phys::CollisionHeightfield *field = new ds_phys::CollisionHeightfield();
+    field->setHeights(heights, 9, 9);
+    scene->world.addCollisionPrimitive(
+        std::unique_ptr<ds_phys::CollisionPrimitive>(field));
+}
+
+TEST(PhysicsWorld, TestSphereRestsOnHeightfield)
+{
+    PhysicsWorldTestScene scene;
+    PhysicsWorldAddHeightfield(&scene, 1.0f, 0.0f, 0.0f);
+
+    ds_phys::RigidBody *sphere =
+        scene.addSphere(ds_math::Vector3(0.3f, 3.0f, 0.2f), 0.5f);
+    scene.step(180);
+
+    EXPECT_NEAR(1.5f, sphere->getPosition().y, 0.05f);
+    EXPECT_NEAR(0.3f, sphere->getPosition().x, 0.05f);
+    EXPECT_NEAR(0.2f, sphere->getPosition().z, 0.05f);
+}
+
+TEST(PhysicsWorld, TestBoxRestsOnHeightfield)
+{
+    PhysicsWorldTestScene scene;
+    PhysicsWorldAddHeightfield(&scene, 1.0f, 0.0f, 0.0f);
+
+    ds_phys::RigidBody *box = scene.addBox(ds_math::Vector3(0.2f, 3.0f, -0.3f),
+                                           ds_math::Vector3(0.5f, 0.5f, 0.5f));
+    scene.step(240);
+
+    EXPECT_NEAR(1.5f, box->getPosition().y, 0.05f);
+    EXPECT_LT(box->getVelocity().Magnitude(), 0.1f);
+}
+
+TEST(PhysicsWorld, TestSphereRollsDownHeightfield)
+{
+    PhysicsWorldTestScene scene;
+    PhysicsWorldAddHeightfield(&scene, 2.0f, 0.25f, 0.0f);
+
+    ds_phys::RigidBody *sphere =
+        scene.addSphere(ds_math::Vector3(1.0f, 4.0f, 0.0f), 0.5f);
+    scene.step(60);
+
+    // Stays on the slope, rolling towards -x
+    ds_math::Vector3 position = sphere->getPosition();
+    EXPECT_LT(position.x, 1.0f);
+    EXPECT_GT(position.y, 2.0f + 0.25f * position.x);
+}
+
+TEST(PhysicsWorld, TestRaycastHeightfield)
+{
+    PhysicsWorldTestScene scene;
+    PhysicsWorldAddHeightfield(&scene, 1.0f, 0.25f, 0.1f);
+    scene.step(1);
+
+    ds_math::Vector3 normal =
+        ds_math::Vector3::Normalize(ds_math::Vector3(-0.25f, 1, -0.1f));
+    for (int i = 0; i < 20; ++i)
+    {
+        ds_math::scalar x = -3.7f + i * 0.37f;
+        ds_math::scalar z = 3.1f - i * 0.29f;
+        ds_math::scalar height = 1.0f + 0.25f * x + 0.1f * z;
+
+        ds_phys::QueryHit hit;
+        ASSERT_TRUE(scene.world.raycast(ds_math::Vector3(x, 10, z),
+                                        ds_math::Vector3(0, -1, 0), 20.0f,
+                                        &hit));
+        EXPECT_EQ(nullptr, hit.body);
+        EXPECT_NEAR(10.0f - height, hit.distance, 1e-3f);
+        EXPECT_NEAR(normal.x, hit.normal.x, 1e-3f);
+        EXPECT_NEAR(normal.y, hit.normal.y, 1e-3f);
+        EXPECT_NEAR(normal.z, hit.normal.z, 1e-3f);
+    }
+
+    // A ray skimming across the slope hits where it first dips under it
+    ds_phys::QueryHit hit;
+    ASSERT_TRUE(scene.world.raycast(ds_math::Vector3(-6, 1.5f, 0),
+                                    ds_math::Vector3(1, 0, 0), 20.0f, &hit));
+    EXPECT_NEAR(8.0f, hit.distance, 1e-3f);
+
+    // Outside the heightfield only the ground is hit
+    ASSERT_TRUE(scene.world.raycast(ds_math::Vector3(6, 10, 0),
+                                    ds_math::Vector3(0, -1, 0), 20.0f, &hit));
+    EXPECT_NEAR(10.0f, hit.distance, 1e-3f);
+
+    // Swept spheres stop a radius above the surface
+    ASSERT_TRUE(scene.world.sweepSphere(ds_math::Vector3(0, 10, 0), 0.5f,
+                                        ds_math::Vector3(0, -1, 0), 20.0f,
+                                        &hit));
+    EXPECT_NEAR(9.0f - 0.5f / normal.y, hit.distance, 1e-3f);
+}
+
+/**
+ * Fire a small sphere at a thin static wall, returning where it is once it
+ * has had time to pass through.
+ */
+static ds_math::Vector3 PhysicsWorldFireAtWall(bool continuous)
+{
+    PhysicsWorldTestScene scene;
+
+    ds_phys::CollisionBox *wall = new ds_phys::CollisionBox();
+    wall->halfSize = ds_math::Vector3(0.05f, 2, 2);
+    scene.world.addCollisionPrimitive(
+        std::unique_ptr<ds_phys::CollisionPrimitive>(wall));
+
+    ds_phys::RigidBody *bullet =
+        scene.addSphere(ds_math::Vector3(-3, 1, 0), 0.1f);
+    scene.step(1);
+    bullet->setVelocity(ds_math::Vector3(200, 0, 0));
+    bullet->setContinuousCollision(continuous);
+    scene.step(10);
+
+    return bullet->getPosition();
+}
+
+TEST(PhysicsWorld, TestContinuousCollisionStopsTunnelling)
+{
+    // A step moves the bullet further than the wall and bullet are thick
+    EXPECT_GT(PhysicsWorldFireAtWall(false).x, 0.05f);
+    EXPECT_LT(PhysicsWorldFireAtWall(true).x, 0.0f);
+}
+
+TEST(PhysicsWorld, TestContinuousCollisionKeepsResting)
+{
+    PhysicsWorldTestScene scene;
+
+    // Dropped from high enough to be moving faster than its size by the
+    // time it lands, and then has to come to rest as a normal box would
+    ds_phys::RigidBody *box = scene.addBox(ds_math::Vector3(0, 10, 0),
+                                           ds_math::Vector3(0.2f, 0.2f, 0.2f));
+    box->setContinuousCollision();
+    scene.step(600);
+
+    EXPECT_NEAR(0.2f, box->getPosition().y, 0.02f);
+    EXPECT_LT(box->getVelocity().Magnitude(), 0.1f);
+}
+
+TEST(PhysicsWorld, TestCollisionLayersFilterPairs)
+{
+    PhysicsWorldTestScene scene;
+
+    // Debris collides with the world but not with other debris, so the
+    // upper piece falls through the lower one
+    const uint32_t debrisLayer = 2;
+    ds_phys::RigidBody *bodies[2] = {
+        scene.addSphere(ds_math::Vector3(0, 0.5f, 0), 0.5f),
+        scene.addSphere(ds_math::Vector3(0, 1.4f, 0), 0.5f)};
+    for (ds_phys::RigidBody *body : bodies)
+    {
+        ds_phys::CollisionPrimitive *primitive =
+            body->getCollisionPrimitive(0);
+        primitive->layer = debrisLayer;
+        primitive->mask = ~debrisLayer;
+    }
+
+    // A sphere in the default layer still lands on top of both
+    ds_phys::RigidBody *ball =
+        scene.addSphere(ds_math::Vector3(0, 3.0f, 0), 0.5f);
+
+    scene.step(240);
+
+    EXPECT_NEAR(0.5f, bodies[0]->getPosition().y, 0.05f);
+    EXPECT_NEAR(0.5f, bodies[1]->getPosition().y, 0.05f);
+    EXPECT_NEAR(1.5f, ball->getPosition().y, 0.05f);
+}
+
+TEST(PhysicsWorld, TestCollisionEventsBeginStayEnd)
+{
+    PhysicsWorldTestScene scene;
+    ds_phys::RigidBody *ball =
+        scene.addSphere(ds_math::Vector3(0, 0.5f, 0), 0.5f);
+
+    // Count each type of event, and check there's never more than one per
+    // pair in a frame however many steps it took
+    unsigned int counts[3] = {0, 0, 0};
+    std::vector<ds_phys::CollisionEvent> events;
+    auto frame = [&](unsigned int steps) {
+        scene.step(steps);
+        events.clear();
+        scene.world.collectCollisionEvents(&events);
+        EXPECT_LE(events.size(), 2u);
+        for (const ds_phys::CollisionEvent &event : events)
+        {
+            ++counts[(int)event.type];
+            EXPECT_EQ(nullptr, event.body[0]);
+            EXPECT_EQ(ball, event.body[1]);
+            // From the ball to the ground
+            EXPECT_LT(event.normal.y, -0.9f);
+        }
+    };
+
+    for (unsigned int i = 0; i < 60; ++i)
+    {
+        frame(4);
+    }
+    EXPECT_EQ(1u, counts[(int)ds_phys::CollisionEventType::Begin]);
+    EXPECT_GT(counts[(int)ds_phys::CollisionEventType::Stay], 50u);
+    EXPECT_EQ(0u, counts[(int)ds_phys::CollisionEventType::End]);
+
+    // Still touching once asleep
+    EXPECT_FALSE(ball->getAwake());
+    frame(1);
+    ASSERT_EQ(1u, events.size());
+    EXPECT_EQ(ds_phys::CollisionEventType::Stay, events[0].type);
+
+    ball->setAwake();
+    ball->setVelocity(ds_math::Vector3(0, 10, 0));
+    frame(1);
+    ASSERT_EQ(1u, events.size());
+    EXPECT_EQ(ds_phys::CollisionEventType::End, events[0].type);
+
+    frame(1);
+    EXPECT_TRUE(events.empty());
+}
+
+TEST(PhysicsWorld, TestCollisionEventsFilterByLayer)
+{
+    PhysicsWorldTestScene scene;
+    scene.world.setCollisionEventLayers(2);
+
+    scene.addSphere(ds_math::Vector3(-2, 0.5f, 0), 0.5f);
+    ds_phys::RigidBody *reported =
+        scene.addSphere(ds_math::Vector3(2, 0.5f, 0), 0.5f);
+    reported->getCollisionPrimitive(0)->layer = 2;
+
+    scene.step(2);
+
+    // Both touch the ground, only the sphere in layer 2 is reported and it
+    // touched and began within the same frame
+    std::vector<ds_phys::CollisionEvent> events;
+    scene.world.collectCollisionEvents(&events);
+    ASSERT_EQ(1u, events.size());
+    EXPECT_EQ(ds_phys::CollisionEventType::Begin, events[0].type);
+    EXPECT_EQ(reported, events[0].body[1]);
+}
+
+TEST(PhysicsWorld, TestCollisionEventsEndOnRemoval)
+{
+    PhysicsWorldTestScene scene;
+    ds_phys::RigidBody *ball =
+        scene.addSphere(ds_math::Vector3(0, 0.5f, 0), 0.5f);
+    ds_phys::RigidBody *other =
+        scene.addSphere(ds_math::Vector3(4, 0.5f, 0), 0.5f);
+
+    std::vector<ds_phys::CollisionEvent> events;
+    scene.step(2);
+    scene.world.collectCollisionEvents(&events);
+    ASSERT_EQ(2u, events.size());
+    ds_phys::CollisionPrimitive *ground = events[0].primitive[0];
+
+    // Removed while touching, the pair ends with the primitive left out
+    scene.world.removeRigidBody(ball);
+    events.clear();
+    scene.world.collectCollisionEvents(&events);
+    ASSERT_EQ(2u, events.size());
+    EXPECT_EQ(ds_phys::CollisionEventType::End, events[0].type);
+    EXPECT_EQ(ground, events[0].primitive[0]);
+    EXPECT_EQ(nullptr, events[0].primitive[1]);
+    EXPECT_EQ(ball, events[0].body[1]);
+    EXPECT_EQ(ds_phys::CollisionEventType::Stay, events[1].type);
+
+    // A pair removed before its begin event is reported isn't reported
+    ds_phys::RigidBody *dropped =
+        scene.addSphere(ds_math::Vector3(-4, 0.5f, 0), 0.5f);
+    scene.step(1);
+    scene.world.removeRigidBody(dropped);
+    events.clear();
+    scene.world.collectCollisionEvents(&events);
+    ASSERT_EQ(1u, events.size());
+    EXPECT_EQ(other, events[0].body[1]);
+}
+
+/**
+ * Add a unit mass body created by the world at a position.
+ */
+static ds_phys::RigidBody *
+PhysicsWorldCreateBody(PhysicsWorldTestScene *scene,
+                       const ds_math::Vector3 &position)
+{
+    ds_phys::RigidBody *body = scene->world.createRigidBody();
+    body->setMass(1.0f);
+    body->setInertiaTensor(ds_math::Vector3(1, 1, 1) * (1.0f / 6.0f));
+    body->setOrientation(ds_math::Quaternion(0, 0, 0, 1));
+    body->setPosition(position);
+    body->calculateDerivedData();
+    return body;
+}
+
+TEST(PhysicsWorld, TestCompoundRestsOnPlane)
+{
+    PhysicsWorldTestScene scene;
+
+    // A bench of a seat and two legs, resting on the legs
+    ds_phys::RigidBody *body =
+        PhysicsWorldCreateBody(&scene, ds_math::Vector3(0, 2, 0));
+    ds_phys::CollisionCompound *compound = scene.world.createCompound();
+    compound->body = body;
+    body->addCollisionPrimitive(compound);
+
+    const ds_math::Vector3 offsets[3] = {ds_math::Vector3(0, 0.5f, 0),
+                                         ds_math::Vector3(-1, 0, 0),
+                                         ds_math::Vector3(1, 0, 0)};
+    const ds_math::Vector3 halfSizes[3] = {ds_math::Vector3(1.5f, 0.1f, 0.5f),
+                                           ds_math::Vector3(0.1f, 0.4f, 0.5f),
+                                           ds_math::Vector3(0.1f, 0.4f, 0.5f)};
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        std::unique_ptr<ds_phys::CollisionBox> box(new ds_phys::CollisionBox());
+        box->halfSize = halfSizes[i];
+        box->offset = ds_math::Matrix4::CreateTranslationMatrix(offsets[i]);
+        compound->addChild(std::move(box));
+    }
+
+    // A box resting on the seat, paired with the compound as a whole
+    ds_phys::RigidBody *box = scene.addBox(ds_math::Vector3(0.5f, 2.9f, 0),
+                                           ds_math::Vector3(0.2f, 0.2f, 0.2f));
+
+    scene.step(600);
+
+    EXPECT_NEAR(0.4f, body->getPosition().y, 0.05f);
+    EXPECT_NEAR(1.0f, body->getTransform()[1][1], 0.01f);
+    EXPECT_NEAR(1.2f, box->getPosition().y, 0.05f);
+    EXPECT_NEAR(0.6f, box->getPosition().x - body->getPosition().x, 0.2f);
+}
+
+TEST(PhysicsWorld, TestConvexHullStacksOnBox)
+{
+    PhysicsWorldTestScene scene;
+    ds_phys::RigidBody *box = scene.addBox(ds_math::Vector3(0, 0.5f, 0),
+                                           ds_math::Vector3(0.5f, 0.5f, 0.5f));
+
+    // Hull of a box's corners, resting on the box by GJK and EPA contacts,
+    // one point a step, so it may slide a little as it settles
+    ds_phys::RigidBody *body =
+        PhysicsWorldCreateBody(&scene, ds_math::Vector3(0.1f, 1.6f, 0));
+    ds_phys::CollisionConvexHull *hull = scene.world.createConvexHull();
+    std::vector<ds_math::Vector3> corners;
+    for (unsigned int i = 0; i < 8; ++i)
+    {
+        corners.push_back(ds_math::Vector3(i & 1 ? 0.5f : -0.5f,
+                                           i & 2 ? 0.5f : -0.5f,
+                                           i & 4 ? 0.5f : -0.5f));
+    }
+    hull->setVertices(corners);
+    hull->body = body;
+    body->addCollisionPrimitive(hull);
+
+    scene.step(600);
+
+    EXPECT_NEAR(0.5f, box->getPosition().y, 0.05f);
+    EXPECT_NEAR(1.5f, body->getPosition().y, 0.05f);
+    EXPECT_NEAR(0.1f, body->getPosition().x, 0.15f);
+    EXPECT_NEAR(1.0f, body->getTransform()[1][1], 0.01f);
+
+    // Rays find the hull through the broadphase
+    ds_phys::QueryHit hit;
+    ASSERT_TRUE(scene.world.raycast(ds_math::Vector3(0.1f, 5, 0),
+                                    ds_math::Vector3(0, -1, 0), 20, &hit));
+    EXPECT_EQ(body, hit.body);
+    EXPECT_NEAR(3.0f, hit.distance, 0.06f);
+}
@@ -0,0 +1,94 @@
+#include "gtest/gtest.h"
+
+#include "engine/system/physics/StepScheduler.h"
+
+/**
+ * Run a frame, pretending each step costs the given CPU time.
+ */
+static unsigned int StepSchedulerRunFrame(ds_phys::StepScheduler *scheduler,
+                                          float deltaTime,
+                                          double cost)
+{
+    unsigned int steps = 0;
+    scheduler->beginFrame(deltaTime);
+    while (scheduler->nextStep())
+    {
+        scheduler->recordStep(cost);
+        ++steps;
+    }
+    return steps;
+}
+
+TEST(StepScheduler, TestAccumulatesPartialSteps)
+{
+    ds_phys::StepScheduler scheduler(0.01f, 0, 0);
+
+    EXPECT_EQ(0u, StepSchedulerRunFrame(&scheduler, 0.006f, 1.0));
+    EXPECT_EQ(1u, StepSchedulerRunFrame(&scheduler, 0.006f, 1.0));
+    EXPECT_EQ(3u, StepSchedulerRunFrame(&scheduler, 0.028f, 1.0));
+    EXPECT_FLOAT_EQ(0.0f, scheduler.getStats().droppedTime);
+    EXPECT_FLOAT_EQ(0.03f, scheduler.getStats().simulatedTime);
+}
+
+TEST(StepScheduler, TestMaxStepsDropsTime)
+{
+    ds_phys::StepScheduler scheduler(0.01f, 0, 2);
+
+    EXPECT_EQ(2u, StepSchedulerRunFrame(&scheduler, 0.055f, 1.0));
+
+    const ds_phys::StepSchedulerStats &stats = scheduler.getStats();
+    EXPECT_NEAR(0.03f, stats.droppedTime, 1e-5f);
+    EXPECT_NEAR(0.03, stats.totalDroppedTime, 1e-5);
+    EXPECT_NEAR(0.02f / 0.055f, stats.timeScale, 1e-4f);
+
+    // The half step left over carries into the next frame
+    EXPECT_EQ(1u, StepSchedulerRunFrame(&scheduler, 0.005f, 1.0));
+}
+
+TEST(StepScheduler, TestBudgetLimitsSteps)
+{
+    ds_phys::StepScheduler scheduler(0.01f, 5.0, 0);
+
+    // Steps of 2ms, the third would go over the 5ms budget
+    EXPECT_EQ(2u, StepSchedulerRunFrame(&scheduler, 0.05f, 2.0));
+    EXPECT_NEAR(0.03f, scheduler.getStats().droppedTime, 1e-5f);
+    EXPECT_DOUBLE_EQ(4.0, scheduler.getStats().frameCost);
+
+    // Steps over budget on their own still move the simulation on
+    scheduler.reset();
+    EXPECT_EQ(1u, StepSchedulerRunFrame(&scheduler, 0.05f, 20.0));
+    EXPECT_EQ(1u, StepSchedulerRunFrame(&scheduler, 0.05f, 20.0));
+    EXPECT_NEAR(0.08, scheduler.getStats().totalDroppedTime, 1e-5);
+}
+
+TEST(StepScheduler, TestStepCostFollowsMeasurements)
+{
+    ds_phys::StepScheduler scheduler(0.01f, 10.0, 0);
+
+    // Cheap steps catch up on the whole frame
+    EXPECT_EQ(5u, StepSchedulerRunFrame(&scheduler, 0.05f, 1.0));
+    EXPECT_DOUBLE_EQ(1.0, scheduler.getStats().stepCost);
+
+    // Costlier steps take a few frames to be trusted, then fewer are taken
+    unsigned int steps = 0;
+    for (unsigned int i = 0; i < 10; ++i)
+    {
+        steps = StepSchedulerRunFrame(&scheduler, 0.05f, 4.0);
+    }
+    EXPECT_NEAR(4.0, scheduler.getStats().stepCost, 0.1);
+    EXPECT_EQ(2u, steps);
+    EXPECT_LE(scheduler.getStats().frameCost, 10.0);
+}
+
+TEST(StepScheduler, TestUnfinishedFrameDropsSteps)
+{
+    ds_phys::StepScheduler scheduler(0.01f, 0, 0);
+
+    // Only one of three steps is asked for
+    scheduler.beginFrame(0.03f);
+    ASSERT_TRUE(scheduler.nextStep());
+    scheduler.recordStep(1.0);
+
+    EXPECT_EQ(0u, StepSchedulerRunFrame(&scheduler, 0.0f, 1.0));
+    EXPECT_NEAR(0.02, scheduler.getStats().totalDroppedTime, 1e-5);
+}
@@ -0,0 +1,151 @@
+#include <cmath>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "engine/system/render/BoundingVolume.h"
+#include "engine/system/render/Frustum.h"
+#include "math/MathHelper.h"
+
+/**
+ * Bounds of a cube of the given half size centred on a point.
+ */
+static ds_render::BoundingVolume FrustumCube(const ds_math::Vector3 &centre,
+                                             ds_math::scalar halfSize)
+{
+    std::vector<ds_math::Vector3> points;
+    points.push_back(centre - ds_math::Vector3(halfSize, halfSize, halfSize));
+    points.push_back(centre + ds_math::Vector3(halfSize, halfSize, halfSize));
+    return ds_render::BoundingVolume::FromPoints(points);
+}
+
+/**
+ * Frustum of a camera at the origin looking down -z.
+ */
+static ds_render::Frustum FrustumCamera()
+{
+    return ds_render::Frustum(ds_math::Matrix4::CreatePerspectiveFieldOfView(
+        ds_math::MathHelper::ToRadians(90.0f), 1.0f, 1.0f, 100.0f));
+}
+
+TEST(BoundingVolume, TestFromPoints)
+{
+    std::vector<ds_math::Vector3> points;
+    EXPECT_FALSE(ds_render::BoundingVolume::FromPoints(points).valid);
+
+    points.push_back(ds_math::Vector3(-1.0f, 0.0f, 2.0f));
+    points.push_back(ds_math::Vector3(3.0f, -2.0f, 2.0f));
+    points.push_back(ds_math::Vector3(1.0f, 2.0f, 4.0f));
+    ds_render::BoundingVolume volume =
+        ds_render::BoundingVolume::FromPoints(points);
+
+    ASSERT_TRUE(volume.valid);
+    EXPECT_EQ(ds_math::Vector3(-1.0f, -2.0f, 2.0f), volume.min);
+    EXPECT_EQ(ds_math::Vector3(3.0f, 2.0f, 4.0f), volume.max);
+    EXPECT_EQ(ds_math::Vector3(1.0f, 0.0f, 3.0f), volume.centre);
+    for (const auto &point : points)
+    {
+        EXPECT_LE(ds_math::Vector3::Magnitude(point - volume.centre),
+                  volume.radius + 1e-5f);
+    }
+}
+
+TEST(BoundingVolume, TestMerge)
+{
+    ds_render::BoundingVolume first =
+        FrustumCube(ds_math::Vector3(-2.0f, 0.0f, 0.0f), 1.0f);
+    ds_render::BoundingVolume second =
+        FrustumCube(ds_math::Vector3(2.0f, 0.0f, 0.0f), 1.0f);
+
+    ds_render::BoundingVolume merged =
+        ds_render::BoundingVolume::Merge(first, ds_render::BoundingVolume());
+    EXPECT_EQ(first.min, merged.min);
+
+    merged = ds_render::BoundingVolume::Merge(first, second);
+    EXPECT_EQ(ds_math::Vector3(-3.0f, -1.0f, -1.0f), merged.min);
+    EXPECT_EQ(ds_math::Vector3(3.0f, 1.0f, 1.0f), merged.max);
+    EXPECT_NEAR(0.0f, merged.centre.x, 1e-5f);
+    EXPECT_NEAR(2.0f + first.radius, merged.radius, 1e-5f);
+}
+
+TEST(BoundingVolume, TestTransform)
+{
+    ds_render::BoundingVolume cube =
+        FrustumCube(ds_math::Vector3(0.0f, 0.0f, 0.0f), 1.0f);
+
+    // Rotated 45 degrees about y, scaled by 2 and moved along x
+    ds_math::Matrix4 transform =
+        ds_math::Matrix4::CreateTranslationMatrix(10.0f, 0.0f, 0.0f) *
+        ds_math::Matrix4::CreateFromQuaternion(
+            ds_math::Quaternion::CreateFromAxisAngle(
+                ds_math::Vector3::UnitY, ds_math::MathHelper::PI / 4.0f)) *
+        ds_math::Matrix4::CreateScaleMatrix(2.0f, 2.0f, 2.0f);
+    ds_render::BoundingVolume moved =
+        ds_render::BoundingVolume::Transform(transform, cube);
+
+    const ds_math::scalar halfDiagonal = 2.0f * std::sqrt(2.0f);
+    EXPECT_NEAR(10.0f - halfDiagonal, moved.min.x, 1e-4f);
+    EXPECT_NEAR(10.0f + halfDiagonal, moved.max.x, 1e-4f);
+    EXPECT_NEAR(-2.0f, moved.min.y, 1e-4f);
+    EXPECT_NEAR(halfDiagonal, moved.max.z, 1e-4f);
+    EXPECT_NEAR(10.0f, moved.centre.x, 1e-4f);
+    EXPECT_NEAR(cube.radius * 2.0f, moved.radius, 1e-4f);
+}
+
+TEST(Frustum, TestCullsOutsideBounds)
+{
+    ds_render::Frustum frustum = FrustumCamera();
+
+    // In front, behind, past the far plane and off to the sides
+    EXPECT_TRUE(
+        frustum.Intersects(FrustumCube(ds_math::Vector3(0, 0, -10), 1.0f)));
+    EXPECT_FALSE(
+        frustum.Intersects(FrustumCube(ds_math::Vector3(0, 0, 10), 1.0f)));
+    EXPECT_FALSE(
+        frustum.Intersects(FrustumCube(ds_math::Vector3(0, 0, -110), 1.0f)));
+    EXPECT_FALSE(
+        frustum.Intersects(FrustumCube(ds_math::Vector3(-30, 0, -10), 1.0f)));
+    EXPECT_FALSE(
+        frustum.Intersects(FrustumCube(ds_math::Vector3(0, 30, -10), 1.0f)));
+
+    // Straddling the left plane, x = z
+    EXPECT_TRUE(
+        frustum.Intersects(FrustumCube(ds_math::Vector3(-10, 0, -10), 1.0f)));
+
+    // Unknown bounds are never culled
+    EXPECT_TRUE(frustum.Intersects(ds_render::BoundingVolume()));
+    EXPECT_TRUE(ds_render::Frustum().Intersects(
+        FrustumCube(ds_math::Vector3(0, 0, 10), 1.0f)));
+}
+
+TEST(Frustum, TestBoxTestedAfterSphere)
+{
+    ds_render::Frustum frustum = FrustumCamera();
+
+    // A long thin box just outside the near plane's corner, its sphere
+    // reaches into the frustum but the box doesn't
+    std::vector<ds_math::Vector3> points;
+    points.push_back(ds_math::Vector3(-20.0f, 0.0f, 0.5f));
+    points.push_back(ds_math::Vector3(20.0f, 0.1f, 0.6f));
+    ds_render::BoundingVolume volume =
+        ds_render::BoundingVolume::FromPoints(points);
+    ASSERT_GT(volume.radius, 1.0f);
+
+    EXPECT_FALSE(frustum.Intersects(volume));
+}
+
+TEST(Frustum, TestViewMatrix)
+{
+    // Camera moved to z = 20, still looking down -z
+    ds_math::Matrix4 view = ds_math::Matrix4::AffineInverse(
+        ds_math::Matrix4::CreateTranslationMatrix(0.0f, 0.0f, 20.0f));
+    ds_render::Frustum frustum(
+        ds_math::Matrix4::CreatePerspectiveFieldOfView(
+            ds_math::MathHelper::ToRadians(90.0f), 1.0f, 1.0f, 100.0f) *
+        view);
+
+    EXPECT_TRUE(
+        frustum.Intersects(FrustumCube(ds_math::Vector3(0, 0, 10), 1.0f)));
+    EXPECT_FALSE(
+        frustum.Intersects(FrustumCube(ds_math::Vector3(0, 0, 30), 1.0f)));
+}
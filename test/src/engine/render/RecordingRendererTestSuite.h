@@ -0,0 +1,117 @@
+#include <sstream>
+
+#include "gtest/gtest.h"
+
+#include "engine/system/render/RecordingRenderer.h"
+
+// Draw calls, state changes and uploads are counted
+TEST(RecordingRenderer, TestCountsWork)
+{
+    ds_render::RecordingRenderer renderer;
+    ASSERT_TRUE(renderer.Init(640, 480));
+
+    const unsigned int indices[3] = {0, 1, 2};
+    ds_render::VertexBufferHandle vertices = renderer.CreateVertexBuffer(
+        ds_render::BufferUsageType::Static,
+        ds_render::VertexBufferDescription(), 96, nullptr);
+    ds_render::IndexBufferHandle indexBuffer = renderer.CreateIndexBuffer(
+        ds_render::BufferUsageType::Static, sizeof(indices), indices);
+    ds_render::RenderTextureHandle texture = renderer.Create2DTexture(
+        ds_render::ImageFormat::RGBA, ds_render::RenderDataType::UnsignedByte,
+        ds_render::InternalImageFormat::RGBA8, false, 4, 2, nullptr);
+    ds_render::ShaderHandle shader = renderer.CreateShaderObject(
+        ds_render::ShaderType::VertexShader, 10, "void main;");
+    ds_render::ProgramHandle program =
+        renderer.CreateProgram(std::vector<ds_render::ShaderHandle>(1, shader));
+
+    EXPECT_EQ(5u, renderer.GetStats().objectsCreated);
+    EXPECT_EQ(96u + sizeof(indices) + 4 * 2 * 4 + 10,
+              renderer.GetStats().bytesUploaded);
+
+    renderer.ResetStats();
+    for (unsigned int i = 0; i < 2; ++i)
+    {
+        renderer.SetProgram(program);
+        renderer.BindTextureToSampler(program, "diffuse",
+                                      ds_render::TextureType::TwoDimensional,
+                                      texture);
+        renderer.DrawVerticesIndexed(vertices, indexBuffer,
+                                     ds_render::PrimitiveType::Triangles, 0, 3);
+    }
+    renderer.DrawVertices(vertices, ds_render::PrimitiveType::Points, 0, 4);
+
+    const ds_render::RenderStats &stats = renderer.GetStats();
+    EXPECT_EQ(3u, stats.drawCalls);
+    EXPECT_EQ(10u, stats.verticesDrawn);
+    EXPECT_EQ(4u, stats.stateChanges);
+    EXPECT_EQ(2u, stats.redundantStateChanges);
+    EXPECT_EQ(0u, stats.bytesUploaded);
+    EXPECT_EQ(0u, stats.invalidHandles);
+}
+
+// Handles of the wrong type aren't drawn with
+TEST(RecordingRenderer, TestInvalidHandles)
+{
+    ds_render::RecordingRenderer renderer;
+
+    ds_render::IndexBufferHandle indexBuffer = renderer.CreateIndexBuffer(
+        ds_render::BufferUsageType::Static, 12, nullptr);
+    renderer.DrawVertices(indexBuffer, ds_render::PrimitiveType::Triangles, 0,
+                          3);
+    renderer.SetProgram(ds_render::ProgramHandle());
+
+    EXPECT_EQ(0u, renderer.GetStats().drawCalls);
+    EXPECT_EQ(2u, renderer.GetStats().invalidHandles);
+}
+
+// Constant buffer members are given offsets within the buffer
+TEST(RecordingRenderer, TestConstantBufferDescription)
+{
+    ds_render::RecordingRenderer renderer;
+    ds_render::ProgramHandle program =
+        renderer.CreateProgram(std::vector<ds_render::ShaderHandle>());
+
+    ds_render::ConstantBufferDescription description(2 * sizeof(float));
+    description.AddMember("Scene.a");
+    description.AddMember("Scene.b");
+    renderer.GetConstantBufferDescription(program, "Scene", &description);
+
+    const float value = 1.0f;
+    description.InsertMemberData("Scene.b", sizeof(float), &value);
+    EXPECT_FLOAT_EQ(value, *(const float *)description.GetDataPtr());
+
+    ds_render::ConstantBufferHandle buffer =
+        renderer.CreateConstantBuffer(description);
+    renderer.UpdateConstantBufferData(buffer, description);
+    EXPECT_EQ(4 * sizeof(float), renderer.GetStats().bytesUploaded);
+}
+
+// Commands are only recorded when asked for, and written one per line
+TEST(RecordingRenderer, TestWritesCommands)
+{
+    ds_render::RecordingRenderer renderer;
+    renderer.SetBlending(true);
+    EXPECT_TRUE(renderer.GetCommands().empty());
+
+    renderer.SetRecording(true);
+    renderer.ClearBuffers(true, true, false);
+    ds_render::VertexBufferHandle vertices = renderer.CreateVertexBuffer(
+        ds_render::BufferUsageType::Dynamic,
+        ds_render::VertexBufferDescription(), 48, nullptr);
+    renderer.DrawVertices(vertices, ds_render::PrimitiveType::Lines, 0, 2);
+    ASSERT_EQ(3u, renderer.GetCommands().size());
+    EXPECT_EQ(ds_render::RecordedCommandType::DrawVertices,
+              renderer.GetCommands()[2].type);
+
+    std::ostringstream expected;
+    expected << "ClearBuffers count=3\n"
+             << "CreateVertexBuffer handle=" << (uint32_t)vertices
+             << " bytes=48\n"
+             << "DrawVertices handle=" << (uint32_t)vertices << " count=2\n";
+    std::ostringstream out;
+    renderer.WriteCommands(out);
+    EXPECT_EQ(expected.str(), out.str());
+
+    renderer.ClearCommands();
+    EXPECT_TRUE(renderer.GetCommands().empty());
+}
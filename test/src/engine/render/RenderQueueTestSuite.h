@@ -0,0 +1,195 @@
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "engine/system/render/RecordingRenderer.h"
+#include "engine/system/render/RenderQueue.h"
+
+/**
+ * Count the commands of a type a recording renderer was given.
+ */
+static unsigned int
+RenderQueueCount(const ds_render::RecordingRenderer &renderer,
+                 ds_render::RecordedCommandType type)
+{
+    unsigned int count = 0;
+    for (const auto &command : renderer.GetCommands())
+    {
+        if (command.type == type)
+        {
+            ++count;
+        }
+    }
+    return count;
+}
+
+/**
+ * Get the number of indices of each draw a recording renderer was given, in
+ * the order drawn.
+ */
+static std::vector<size_t>
+RenderQueueDraws(const ds_render::RecordingRenderer &renderer)
+{
+    std::vector<size_t> draws;
+    for (const auto &command : renderer.GetCommands())
+    {
+        if (command.type ==
+            ds_render::RecordedCommandType::DrawVerticesIndexed)
+        {
+            draws.push_back(command.count);
+        }
+    }
+    return draws;
+}
+
+/**
+ * Create a material with the given program and one texture.
+ */
+static ds_render::RenderQueueMaterial
+RenderQueueMaterial(ds_render::ProgramHandle program,
+                    ds_render::RenderTextureHandle texture,
+                    const std::vector<ds_render::ShaderParameter> *parameters)
+{
+    ds_render::RenderQueueTexture queueTexture;
+    queueTexture.samplerName = "diffuse";
+    queueTexture.textureType = ds_render::TextureType::TwoDimensional;
+    queueTexture.textureHandle = texture;
+
+    ds_render::RenderQueueMaterial material;
+    material.program = program;
+    material.textures.push_back(queueTexture);
+    material.parameters = parameters;
+    return material;
+}
+
+// Draws sharing a program and textures are grouped, and state that hasn't
+// changed isn't set again
+TEST(RenderQueue, TestSkipsRedundantState)
+{
+    ds_render::RecordingRenderer renderer;
+    ds_render::VertexBufferHandle vertices = renderer.CreateVertexBuffer(
+        ds_render::BufferUsageType::Static,
+        ds_render::VertexBufferDescription(), 96, nullptr);
+    ds_render::IndexBufferHandle indices = renderer.CreateIndexBuffer(
+        ds_render::BufferUsageType::Static, 12, nullptr);
+    ds_render::ProgramHandle programs[2] = {
+        renderer.CreateProgram(std::vector<ds_render::ShaderHandle>()),
+        renderer.CreateProgram(std::vector<ds_render::ShaderHandle>())};
+    ds_render::RenderTextureHandle textures[2];
+    for (unsigned int i = 0; i < 2; ++i)
+    {
+        textures[i] = renderer.Create2DTexture(
+            ds_render::ImageFormat::RGBA,
+            ds_render::RenderDataType::UnsignedByte,
+            ds_render::InternalImageFormat::RGBA8, false, 1, 1, nullptr);
+    }
+
+    const float shininess = 1.0f;
+    std::vector<ds_render::ShaderParameter> parameters(
+        1, ds_render::ShaderParameter(
+               "shininess",
+               ds_render::ShaderParameter::ShaderParameterType::Float,
+               sizeof(float), &shininess));
+
+    // Materials 0 and 2 share a program and texture, 1 has its own
+    ds_render::RenderQueue queue;
+    unsigned int materials[3] = {
+        queue.AddMaterial(ds::Handle(0, 1, 0),
+                          RenderQueueMaterial(programs[0], textures[0],
+                                              &parameters)),
+        queue.AddMaterial(ds::Handle(1, 1, 0),
+                          RenderQueueMaterial(programs[1], textures[1],
+                                              nullptr)),
+        queue.AddMaterial(ds::Handle(2, 1, 0),
+                          RenderQueueMaterial(programs[0], textures[0],
+                                              &parameters))};
+
+    unsigned int material;
+    ASSERT_TRUE(queue.GetMaterial(ds::Handle(1, 1, 0), &material));
+    EXPECT_EQ(materials[1], material);
+    EXPECT_FALSE(queue.GetMaterial(ds::Handle(3, 1, 0), &material));
+
+    // Interleaved, each draw of an object of its own
+    for (unsigned int i = 0; i < 6; ++i)
+    {
+        queue.Add(ds_render::RenderPass::Opaque, materials[i % 3], vertices,
+                  indices, 0, 3 + i, i, 1.0f);
+    }
+    EXPECT_EQ(6u, queue.GetNumDraws());
+
+    std::vector<unsigned int> objects;
+    renderer.SetRecording(true);
+    queue.Submit(&renderer, [&](unsigned int object)
+                 {
+                     objects.push_back(object);
+                 });
+
+    // Program 0's materials in the order added, then program 1's
+    std::vector<size_t> expected = {3, 6, 5, 8, 4, 7};
+    EXPECT_EQ(expected, RenderQueueDraws(renderer));
+    EXPECT_EQ(6u, objects.size());
+
+    const ds_render::RenderStats &stats = renderer.GetStats();
+    EXPECT_EQ(0u, stats.redundantStateChanges);
+    EXPECT_EQ(0u, stats.invalidHandles);
+    EXPECT_EQ(2u, RenderQueueCount(
+                      renderer, ds_render::RecordedCommandType::SetProgram));
+    EXPECT_EQ(2u, RenderQueueCount(
+                      renderer,
+                      ds_render::RecordedCommandType::BindTextureToSampler));
+    EXPECT_EQ(2u,
+              RenderQueueCount(
+                  renderer,
+                  ds_render::RecordedCommandType::UnbindTextureFromSampler));
+    // Given once for each of the two materials using program 0
+    EXPECT_EQ(2u, RenderQueueCount(
+                      renderer,
+                      ds_render::RecordedCommandType::UpdateProgramParameter));
+}
+
+// Draws with the same state are drawn nearest first, and ordered draws keep
+// the order they were added in after the rest
+TEST(RenderQueue, TestDrawOrder)
+{
+    ds_render::RecordingRenderer renderer;
+    ds_render::VertexBufferHandle vertices = renderer.CreateVertexBuffer(
+        ds_render::BufferUsageType::Static,
+        ds_render::VertexBufferDescription(), 96, nullptr);
+    ds_render::IndexBufferHandle indices = renderer.CreateIndexBuffer(
+        ds_render::BufferUsageType::Static, 12, nullptr);
+    ds_render::ProgramHandle program =
+        renderer.CreateProgram(std::vector<ds_render::ShaderHandle>());
+
+    ds_render::RenderQueue queue;
+    ds_render::RenderQueueMaterial state;
+    state.program = program;
+    state.parameters = nullptr;
+    unsigned int material = queue.AddMaterial(ds::Handle(0, 1, 0), state);
+
+    queue.Add(ds_render::RenderPass::Ordered, material, vertices,
+              indices, 0, 1, 0, 0.0f);
+    queue.Add(ds_render::RenderPass::Opaque, material, vertices,
+              indices, 0, 2, 1, 50.0f);
+    queue.Add(ds_render::RenderPass::Ordered, material, vertices,
+              indices, 0, 3, 2, 0.0f);
+    queue.Add(ds_render::RenderPass::Opaque, material, vertices,
+              indices, 0, 4, 3, 0.5f);
+    queue.Add(ds_render::RenderPass::Opaque, material, vertices,
+              indices, 0, 5, 4, 3.0f);
+
+    renderer.SetRecording(true);
+    queue.Submit(&renderer, [](unsigned int)
+                 {
+                 });
+
+    std::vector<size_t> expected = {4, 5, 2, 1, 3};
+    EXPECT_EQ(expected, RenderQueueDraws(renderer));
+    EXPECT_EQ(1u, RenderQueueCount(
+                      renderer, ds_render::RecordedCommandType::SetProgram));
+    EXPECT_EQ(0u, renderer.GetStats().invalidHandles);
+
+    // Cleared queues draw nothing
+    queue.Clear();
+    EXPECT_EQ(0u, queue.GetNumDraws());
+    EXPECT_FALSE(queue.GetMaterial(ds::Handle(0, 1, 0), &material));
+}
@@ -3,6 +3,14 @@
 #include "engine/ConfigTestSuite.h"
 #include "engine/common/CommonTestSuite.h"
 #include "engine/common/StreamBufferTestSuite.h"
+#include "engine/physics/CollisionCoarseTestSuite.h"
+#include "engine/physics/CollisionFineTestSuite.h"
+#include "engine/physics/PhysicsWorldTestSuite.h"
+#include "engine/physics/StepSchedulerTestSuite.h"
+#include "engine/render/FrustumTestSuite.h"
+#include "engine/render/RecordingRendererTestSuite.h"
+#include "engine/render/RenderQueueTestSuite.h"
+#include "math/MathBatchTestSuite.h"
 #include "math/Matrix4TestSuite.h"
 #include "math/QuaternionTestSuite.h"
 #include "math/Vector3TestSuite.h"
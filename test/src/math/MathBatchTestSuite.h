@@ -0,0 +1,162 @@
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "math/MathBatch.h"
+
+// Odd number of elements so both the vectorised and the remainder paths are
+// exercised.
+static const unsigned int MATH_BATCH_COUNT = 7;
+
+static ds_math::Matrix4 MathBatchTestMatrix()
+{
+    return ds_math::Matrix4::CreateTranslationMatrix(1.5f, -2.0f, 3.25f) *
+           ds_math::Matrix4::CreateFromQuaternion(
+               ds_math::Quaternion::CreateFromAxisAngle(
+                   ds_math::Vector3::Normalize(
+                       ds_math::Vector3(1.0f, 2.0f, -0.5f)),
+                   0.7f)) *
+           ds_math::Matrix4::CreateScaleMatrix(2.0f, 0.5f, 1.25f);
+}
+
+TEST(MathBatch, TestTransformPoints)
+{
+    ds_math::Matrix4 mat = MathBatchTestMatrix();
+
+    std::vector<ds_math::Vector3> points;
+    for (unsigned int i = 0; i < MATH_BATCH_COUNT; ++i)
+    {
+        points.push_back(ds_math::Vector3(i * 1.5f, -(float)i, 10.0f - i));
+    }
+
+    std::vector<ds_math::Vector3> result(MATH_BATCH_COUNT);
+    ds_math::MathBatch::TransformPoints(mat, &points[0], &result[0],
+                                        MATH_BATCH_COUNT);
+
+    for (unsigned int i = 0; i < MATH_BATCH_COUNT; ++i)
+    {
+        ds_math::Vector3 expected = ds_math::Matrix4::Transform(mat, points[i]);
+
+        EXPECT_EQ(expected.x, result[i].x);
+        EXPECT_EQ(expected.y, result[i].y);
+        EXPECT_EQ(expected.z, result[i].z);
+    }
+}
+
+TEST(MathBatch, TestTransformPointsSoA)
+{
+    ds_math::Matrix4 mat = MathBatchTestMatrix();
+
+    float x[MATH_BATCH_COUNT], y[MATH_BATCH_COUNT], z[MATH_BATCH_COUNT];
+    for (unsigned int i = 0; i < MATH_BATCH_COUNT; ++i)
+    {
+        x[i] = i * 1.5f;
+        y[i] = -(float)i;
+        z[i] = 10.0f - i;
+    }
+
+    float rx[MATH_BATCH_COUNT], ry[MATH_BATCH_COUNT], rz[MATH_BATCH_COUNT];
+    ds_math::ConstVector3SoA in = {x, y, z};
+    ds_math::Vector3SoA out = {rx, ry, rz};
+    ds_math::MathBatch::TransformPoints(mat, in, out, MATH_BATCH_COUNT);
+
+    for (unsigned int i = 0; i < MATH_BATCH_COUNT; ++i)
+    {
+        ds_math::Vector3 expected =
+            ds_math::Matrix4::Transform(mat, ds_math::Vector3(x[i], y[i], z[i]));
+
+        EXPECT_EQ(expected.x, rx[i]);
+        EXPECT_EQ(expected.y, ry[i]);
+        EXPECT_EQ(expected.z, rz[i]);
+    }
+}
+
+TEST(MathBatch, TestMultiply)
+{
+    std::vector<ds_math::Matrix4> lhs, rhs;
+    for (unsigned int i = 0; i < MATH_BATCH_COUNT; ++i)
+    {
+        lhs.push_back(MathBatchTestMatrix() * (float)(i + 1));
+        rhs.push_back(ds_math::Matrix4::CreateTranslationMatrix(
+            (float)i, 2.0f, -(float)i));
+    }
+
+    std::vector<ds_math::Matrix4> result(MATH_BATCH_COUNT);
+    ds_math::MathBatch::Multiply(&lhs[0], &rhs[0], &result[0],
+                                 MATH_BATCH_COUNT);
+
+    for (unsigned int i = 0; i < MATH_BATCH_COUNT; ++i)
+    {
+        EXPECT_EQ(lhs[i] * rhs[i], result[i]);
+    }
+}
+
+TEST(MathBatch, TestNormalizeQuaternions)
+{
+    std::vector<ds_math::Quaternion> quaternions;
+    for (unsigned int i = 0; i < MATH_BATCH_COUNT; ++i)
+    {
+        quaternions.push_back(
+            ds_math::Quaternion(i + 1.0f, -2.0f * i, 0.5f, 3.0f - i));
+    }
+
+    std::vector<ds_math::Quaternion> result(MATH_BATCH_COUNT);
+    ds_math::MathBatch::NormalizeQuaternions(&quaternions[0], &result[0],
+                                             MATH_BATCH_COUNT);
+
+    float x[MATH_BATCH_COUNT], y[MATH_BATCH_COUNT], z[MATH_BATCH_COUNT],
+        w[MATH_BATCH_COUNT];
+    for (unsigned int i = 0; i < MATH_BATCH_COUNT; ++i)
+    {
+        x[i] = quaternions[i].x;
+        y[i] = quaternions[i].y;
+        z[i] = quaternions[i].z;
+        w[i] = quaternions[i].w;
+    }
+    ds_math::QuaternionSoA soa = {x, y, z, w};
+    ds_math::MathBatch::NormalizeQuaternions(soa, MATH_BATCH_COUNT);
+
+    for (unsigned int i = 0; i < MATH_BATCH_COUNT; ++i)
+    {
+        ds_math::Quaternion expected =
+            ds_math::Quaternion::Normalize(quaternions[i]);
+
+        EXPECT_EQ(expected.x, result[i].x);
+        EXPECT_EQ(expected.y, result[i].y);
+        EXPECT_EQ(expected.z, result[i].z);
+        EXPECT_EQ(expected.w, result[i].w);
+
+        EXPECT_EQ(expected.x, x[i]);
+        EXPECT_EQ(expected.y, y[i]);
+        EXPECT_EQ(expected.z, z[i]);
+        EXPECT_EQ(expected.w, w[i]);
+    }
+}
+
+TEST(MathBatch, TestComposeTransforms)
+{
+    std::vector<ds_math::Vector3> translations, scales;
+    std::vector<ds_math::Quaternion> orientations;
+    for (unsigned int i = 0; i < MATH_BATCH_COUNT; ++i)
+    {
+        translations.push_back(ds_math::Vector3(i * 2.0f, -1.0f, 0.5f * i));
+        orientations.push_back(ds_math::Quaternion::CreateFromAxisAngle(
+            ds_math::Vector3::UnitY, 0.3f * i));
+        scales.push_back(ds_math::Vector3(1.0f + i, 2.0f, 0.5f));
+    }
+
+    std::vector<ds_math::Matrix4> result(MATH_BATCH_COUNT);
+    ds_math::MathBatch::ComposeTransforms(&translations[0], &orientations[0],
+                                          &scales[0], &result[0],
+                                          MATH_BATCH_COUNT);
+
+    for (unsigned int i = 0; i < MATH_BATCH_COUNT; ++i)
+    {
+        ds_math::Matrix4 expected =
+            ds_math::Matrix4::CreateTranslationMatrix(translations[i]) *
+            ds_math::Matrix4::CreateFromQuaternion(orientations[i]) *
+            ds_math::Matrix4::CreateScaleMatrix(scales[i]);
+
+        EXPECT_EQ(expected, result[i]);
+    }
+}
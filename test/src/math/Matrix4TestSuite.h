@@ -216,6 +216,41 @@ TEST(Matrix4, TestInverse)
     EXPECT_EQ(result, inv);
 }
 
+TEST(Matrix4, TestAffineInverse)
+{
+    ds_math::Matrix4 identity = ds_math::Matrix4();
+
+    EXPECT_EQ(identity, ds_math::Matrix4::AffineInverse(identity));
+
+    ds_math::Matrix4 mat =
+        ds_math::Matrix4::CreateTranslationMatrix(1.0f, -2.0f, 3.5f) *
+        ds_math::Matrix4::CreateFromQuaternion(
+            ds_math::Quaternion::CreateFromAxisAngle(ds_math::Vector3::UnitZ,
+                                                     0.6f)) *
+        ds_math::Matrix4::CreateScaleMatrix(2.0f, 0.5f, 4.0f);
+    mat[1].x = 0.25f;
+
+    EXPECT_EQ(ds_math::Matrix4::Inverse(mat),
+              ds_math::Matrix4::AffineInverse(mat));
+}
+
+TEST(Matrix4, TestRigidInverse)
+{
+    ds_math::Matrix4 identity = ds_math::Matrix4();
+
+    EXPECT_EQ(identity, ds_math::Matrix4::RigidInverse(identity));
+
+    ds_math::Matrix4 mat =
+        ds_math::Matrix4::CreateTranslationMatrix(1.0f, -2.0f, 3.5f) *
+        ds_math::Matrix4::CreateFromQuaternion(
+            ds_math::Quaternion::CreateFromAxisAngle(
+                ds_math::Vector3::Normalize(ds_math::Vector3(1.0f, 1.0f, 0.0f)),
+                1.2f));
+
+    EXPECT_EQ(ds_math::Matrix4::Inverse(mat),
+              ds_math::Matrix4::RigidInverse(mat));
+}
+
 TEST(Matrix4, TestTransformVector3)
 {
     ds_math::Vector3 v(0.0f, 0.0f, 0.0f);